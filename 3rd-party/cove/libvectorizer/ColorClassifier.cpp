@@ -0,0 +1,371 @@
+/*
+ * Copyright 2021 The OpenOrienteering developers
+ *
+ * This file is part of CoVe.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ColorClassifier.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <iterator>
+
+#include <QtGlobal>
+#include <QRgb>
+
+#include "Concurrency.h"
+#include "KohonenMap.h"
+#include "MapColor.h"
+#include "ParallelImageProcessing.h"
+#include "ProgressObserver.h"
+
+namespace cove {
+
+namespace {
+
+/**
+ * A progress observer which only forwards interruption requests.
+ *
+ * Batch learning reports its own progress after each pass.
+ */
+class InterruptionObserver final : public ProgressObserver
+{
+	const ProgressObserver* observer;
+
+public:
+	explicit InterruptionObserver(const ProgressObserver* observer)
+	    : observer(observer)
+	{}
+
+	void setPercentage(int /*percentage*/) final {}
+
+	bool isInterruptionRequested() const final
+	{
+		return observer && observer->isInterruptionRequested();
+	}
+};
+
+/// Returns the number of class slots, padded for vectorized loops.
+constexpr std::size_t paddedSize(std::size_t size)
+{
+	return (size + 7) & ~std::size_t(7);
+}
+
+}  // namespace
+
+
+
+/**
+ * A functor for processing image stripes concurrently.
+ */
+class ColorClassifier::StripeMapper
+{
+	const ColorClassifier& classifier;
+	const bool learning;
+	const bool first_pass;
+
+public:
+	StripeMapper(const ColorClassifier& classifier, bool learning, bool first_pass)
+	    : classifier(classifier)
+	    , learning(learning)
+	    , first_pass(first_pass)
+	{}
+
+	PassResult operator()(const QImage& source, QImage& classified, ProgressObserver& observer) const
+	{
+		return classifier.classifyStripe(source, classified, observer, learning, first_pass);
+	}
+
+	using concurrent_processing = HorizontalStripes;
+};
+
+
+
+ColorClassifier::ColorClassifier(const MapColor& prototype)
+    : prototype(dynamic_cast<MapColor*>(prototype.clone()))
+{
+	p = float(this->prototype->getP());
+	if (p == 1)
+		metric = Hamming;
+	else if (p == 2)
+		metric = Euclid;
+	else if (std::isinf(p))
+		metric = Chebyshev;
+	else
+		metric = Minkowski;
+}
+
+ColorClassifier::~ColorClassifier() = default;
+
+
+void ColorClassifier::setClasses(const std::vector<std::shared_ptr<MapColor>>& colors)
+{
+	Q_ASSERT(colors.size() <= max_classes);
+	num_classes = std::min(colors.size(), max_classes);
+	classes.resize(num_classes);
+	x1.assign(paddedSize(num_classes), 0.0f);
+	x2.assign(paddedSize(num_classes), 0.0f);
+	x3.assign(paddedSize(num_classes), 0.0f);
+	for (std::size_t i = 0; i < num_classes; ++i)
+	{
+		classes[i] = colors[i]->getCoordinates();
+		updateSearchCoordinates(i);
+	}
+}
+
+std::vector<std::shared_ptr<MapColor>> ColorClassifier::getClasses() const
+{
+	std::vector<std::shared_ptr<MapColor>> colors(num_classes);
+	for (std::size_t i = 0; i < num_classes; ++i)
+	{
+		colors[i] = std::shared_ptr<MapColor>(dynamic_cast<MapColor*>(prototype->clone()));
+		colors[i]->setCoordinates(classes[i]);
+	}
+	return colors;
+}
+
+void ColorClassifier::updateSearchCoordinates(std::size_t index)
+{
+	x1[index] = float(classes[index][0]);
+	x2[index] = float(classes[index][1]);
+	x3[index] = float(classes[index][2]);
+}
+
+
+int ColorClassifier::findClosest(const Coordinates& coordinates) const
+{
+	auto const y1 = float(coordinates[0]);
+	auto const y2 = float(coordinates[1]);
+	auto const y3 = float(coordinates[2]);
+	switch (metric)
+	{
+	case Hamming:
+		return findClosestImpl<Hamming>(y1, y2, y3);
+	case Euclid:
+		return findClosestImpl<Euclid>(y1, y2, y3);
+	case Chebyshev:
+		return findClosestImpl<Chebyshev>(y1, y2, y3);
+	case Minkowski:
+		break;
+	}
+	return findClosestImpl<Minkowski>(y1, y2, y3);
+}
+
+template <ColorClassifier::Metric m>
+int ColorClassifier::findClosestImpl(float y1, float y2, float y3) const
+{
+	// The metric is a template parameter, so this loop can be vectorized.
+	float distances[max_classes];
+	auto const size = x1.size();
+	auto const* a1 = x1.data();
+	auto const* a2 = x2.data();
+	auto const* a3 = x3.data();
+	for (std::size_t i = 0; i < size; ++i)
+	{
+		auto const d1 = a1[i] - y1;
+		auto const d2 = a2[i] - y2;
+		auto const d3 = a3[i] - y3;
+		switch (m)
+		{
+		case Hamming:
+			distances[i] = std::abs(d1) + std::abs(d2) + std::abs(d3);
+			break;
+		case Euclid:
+			distances[i] = d1 * d1 + d2 * d2 + d3 * d3;
+			break;
+		case Chebyshev:
+			distances[i] = std::max(std::abs(d1), std::max(std::abs(d2), std::abs(d3)));
+			break;
+		case Minkowski:
+			distances[i] = std::pow(std::abs(d1), p) + std::pow(std::abs(d2), p) + std::pow(std::abs(d3), p);
+			break;
+		}
+	}
+
+	int best = 0;
+	for (std::size_t i = 1; i < num_classes; ++i)
+	{
+		if (distances[i] < distances[best])
+			best = int(i);
+	}
+	return best;
+}
+
+double ColorClassifier::squares(const Coordinates& coordinates, int index) const
+{
+	auto const& c = classes[std::size_t(index)];
+	auto const d1 = coordinates[0] - c[0];
+	auto const d2 = coordinates[1] - c[1];
+	auto const d3 = coordinates[2] - c[2];
+	return d1 * d1 + d2 * d2 + d3 * d3;
+}
+
+
+void ColorClassifier::learn(const Coordinates& coordinates, double alpha)
+{
+	auto const index = std::size_t(findClosest(coordinates));
+	auto& c = classes[index];
+	for (std::size_t j = 0; j < c.size(); ++j)
+		c[j] += (coordinates[j] - c[j]) * alpha;
+	updateSearchCoordinates(index);
+}
+
+void ColorClassifier::performLearning(KohonenAlphaGetter& alpha_getter, KohonenPatternGetter& pattern_getter)
+{
+	if (num_classes == 0)
+		return;
+
+	auto alpha = alpha_getter.getAlpha();
+	auto e = alpha_getter.getE();
+	while (alpha > 0)
+	{
+		for (unsigned int i = 0; i < e; ++i)
+		{
+			auto const* pattern = static_cast<const MapColor*>(pattern_getter.getPattern());
+			learn(pattern->getCoordinates(), alpha);
+		}
+		alpha = alpha_getter.getAlpha();
+		e = alpha_getter.getE();
+	}
+}
+
+
+ColorClassifier::PassResult ColorClassifier::classifyStripe(
+        const QImage& source, QImage& classified, ProgressObserver& observer,
+        bool learning, bool first_pass) const
+{
+	PassResult result;
+	result.sums.assign(3 * num_classes, 0.0);
+	result.counts.assign(num_classes, 0);
+
+	// Conversion to the color space of the prototype,
+	// with a shortcut for runs of identical pixels
+	auto color = std::unique_ptr<MapColor>(dynamic_cast<MapColor*>(prototype->clone()));
+	auto last_rgb = QRgb(0);
+	Coordinates coordinates;
+	int index = 0;
+	bool have_last = false;
+
+	auto const direct_access = source.format() == QImage::Format_RGB32
+	                           || source.format() == QImage::Format_ARGB32;
+	auto const width = source.width();
+	auto const height = source.height();
+	for (int y = 0; y < height && !observer.isInterruptionRequested(); ++y)
+	{
+		auto const* source_line = direct_access ? reinterpret_cast<const QRgb*>(source.constScanLine(y)) : nullptr;
+		auto* classified_line = classified.scanLine(y);
+		for (int x = 0; x < width; ++x)
+		{
+			auto const rgb = direct_access ? source_line[x] : source.pixel(x, y);
+			if (!have_last || rgb != last_rgb)
+			{
+				color->setRGBTriplet(rgb);
+				coordinates = color->getCoordinates();
+				index = findClosest(coordinates);
+				last_rgb = rgb;
+				have_last = true;
+			}
+
+			if (learning)
+			{
+				if (first_pass || classified_line[x] != index)
+					++result.changes;
+				auto* sum = &result.sums[3 * std::size_t(index)];
+				sum[0] += coordinates[0];
+				sum[1] += coordinates[1];
+				sum[2] += coordinates[2];
+				++result.counts[std::size_t(index)];
+			}
+			classified_line[x] = uchar(index);
+			result.quality += squares(coordinates, index);
+		}
+		observer.setPercentage((100 * y) / height);
+	}
+	return result;
+}
+
+
+double ColorClassifier::performBatchLearning(const QImage& source, QImage& classified, ProgressObserver* observer)
+{
+	classified = QImage(source.size(), QImage::Format_Indexed8);
+	classified.setColorCount(int(num_classes));
+	if (num_classes == 0 || source.isNull())
+		return 0;
+
+	auto const num_pixels = double(source.width()) * source.height();
+	auto interruption_observer = InterruptionObserver(observer);
+	double quality = 0;
+	for (bool first_pass = true; ; first_pass = false)
+	{
+		auto mapper = StripeMapper(*this, true, first_pass);
+		auto results = Concurrency::process<PassResult>(&interruption_observer, mapper, source, classified);
+		if (interruption_observer.isInterruptionRequested())
+		{
+			classified = QImage();
+			return quality;
+		}
+
+		std::vector<double> sums(3 * num_classes, 0.0);
+		std::vector<unsigned int> counts(num_classes, 0);
+		long long changes = 0;
+		quality = 0;
+		for (auto& job : results)
+		{
+			auto const result = job.future.result();
+			std::transform(begin(sums), end(sums), begin(result.sums), begin(sums), std::plus<double>());
+			std::transform(begin(counts), end(counts), begin(result.counts), begin(counts), std::plus<unsigned int>());
+			changes += result.changes;
+			quality += result.quality;
+		}
+
+		for (std::size_t i = 0; i < num_classes; ++i)
+		{
+			// Like KohonenMap, classes without pixels are reset to zero.
+			auto const factor = counts[i] ? 1.0 / counts[i] : 0.0;
+			classes[i] = { sums[3 * i] * factor, sums[3 * i + 1] * factor, sums[3 * i + 2] * factor };
+			updateSearchCoordinates(i);
+		}
+
+		if (observer)
+			observer->setPercentage(100 - static_cast<int>(100 * std::pow(changes / num_pixels, 0.2)));
+		if (changes == 0)
+			break;
+	}
+
+	auto color = std::unique_ptr<MapColor>(dynamic_cast<MapColor*>(prototype->clone()));
+	for (std::size_t i = 0; i < num_classes; ++i)
+	{
+		color->setCoordinates(classes[i]);
+		classified.setColor(int(i), color->getRGBTriplet());
+	}
+	return quality;
+}
+
+double ColorClassifier::classify(const QImage& source, QImage& classified, ProgressObserver* observer) const
+{
+	if (num_classes == 0 || source.isNull())
+		return 0;
+
+	auto mapper = StripeMapper(*this, false, false);
+	auto results = Concurrency::process<PassResult>(observer, mapper, source, classified);
+	double quality = 0;
+	for (auto& job : results)
+		quality += job.future.result().quality;
+	return quality;
+}
+
+}  // namespace cove
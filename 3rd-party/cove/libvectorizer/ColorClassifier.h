@@ -0,0 +1,157 @@
+/*
+ * Copyright 2021 The OpenOrienteering developers
+ *
+ * This file is part of CoVe.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef COVE_COLORCLASSIFIER_H
+#define COVE_COLORCLASSIFIER_H
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include <QImage>
+
+namespace cove {
+
+class KohonenAlphaGetter;
+class KohonenPatternGetter;
+class MapColor;
+class ProgressObserver;
+
+/**
+ * A Kohonen map specialized for MapColor classes.
+ *
+ * This class implements the learning and classification algorithms of
+ * KohonenMap, but it avoids virtual function calls and heap allocations in the
+ * inner loops: The class coordinates are kept in contiguous single precision
+ * arrays, one array per coordinate, so that the distances to all classes can
+ * be computed in a vectorized loop. The search for the closest class uses the
+ * metric of the prototype MapColor, without the final root which does not
+ * affect the order of distances. Learning accumulates in double precision.
+ *
+ * Batch learning and classification process horizontal stripes of the image
+ * concurrently.
+ */
+class ColorClassifier
+{
+public:
+	using Coordinates = std::array<double, 3>;
+
+	/// The maximum number of classes, limited by QImage::Format_Indexed8.
+	static constexpr std::size_t max_classes = 256;
+
+	/**
+	 * Constructs a classifier.
+	 *
+	 * The prototype determines the color space and the metric.
+	 */
+	explicit ColorClassifier(const MapColor& prototype);
+
+	ColorClassifier(const ColorClassifier&) = delete;
+	ColorClassifier& operator=(const ColorClassifier&) = delete;
+
+	~ColorClassifier();
+
+	/**
+	 * Sets the initial classes.
+	 */
+	void setClasses(const std::vector<std::shared_ptr<MapColor>>& colors);
+
+	/**
+	 * Returns the resulting classes, as clones of the prototype.
+	 */
+	std::vector<std::shared_ptr<MapColor>> getClasses() const;
+
+	/**
+	 * Returns the index of the class which is closest to the given coordinates.
+	 */
+	int findClosest(const Coordinates& coordinates) const;
+
+	/**
+	 * Moves the closest class towards the given coordinates.
+	 */
+	void learn(const Coordinates& coordinates, double alpha);
+
+	/**
+	 * Performs classic Kohonen learning.
+	 *
+	 * The pattern getter must return MapColor objects.
+	 */
+	void performLearning(KohonenAlphaGetter& alpha_getter, KohonenPatternGetter& pattern_getter);
+
+	/**
+	 * Performs batch learning on the given image.
+	 *
+	 * Returns the quality of learning, i.e. the sum of squares of the
+	 * differences between the pixels and their classes. The classified image
+	 * is stored in the given output image, or set to null when interrupted.
+	 */
+	double performBatchLearning(const QImage& source, QImage& classified, ProgressObserver* observer);
+
+	/**
+	 * Assigns each pixel of the source image to its closest class.
+	 *
+	 * The classified image must be an indexed image of the size of the source.
+	 * Returns the quality of the classification.
+	 */
+	double classify(const QImage& source, QImage& classified, ProgressObserver* observer) const;
+
+private:
+	enum Metric
+	{
+		Hamming,
+		Euclid,
+		Chebyshev,
+		Minkowski
+	};
+
+	/// The per-stripe result of a batch learning pass.
+	struct PassResult
+	{
+		std::vector<double> sums;          ///< Three coordinate sums per class
+		std::vector<unsigned int> counts;  ///< Number of pixels per class
+		double quality = 0;
+		long long changes = 0;
+	};
+
+	class StripeMapper;
+
+	void updateSearchCoordinates(std::size_t index);
+
+	template <Metric metric>
+	int findClosestImpl(float y1, float y2, float y3) const;
+
+	double squares(const Coordinates& coordinates, int index) const;
+
+	PassResult classifyStripe(const QImage& source, QImage& classified, ProgressObserver& observer,
+	                          bool learning, bool first_pass) const;
+
+	std::unique_ptr<MapColor> prototype;
+	Metric metric;
+	float p;
+	std::size_t num_classes = 0;
+	std::vector<Coordinates> classes;  ///< The class coordinates, in double precision
+	std::vector<float> x1;             ///< The first coordinates of all classes, padded
+	std::vector<float> x2;             ///< The second coordinates of all classes, padded
+	std::vector<float> x3;             ///< The third coordinates of all classes, padded
+};
+
+}  // namespace cove
+
+#endif  // COVE_COLORCLASSIFIER_H
@@ -19,14 +19,176 @@
 
 #include "FIRFilter.h"
 
-#include <memory>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <vector>
 
+#include <QtConcurrent>
+#include <QtGlobal>
+#include <QFuture>
 #include <QImage>
+#include <QThreadPool>
 
 #include "MapColor.h"
 #include "ProgressObserver.h"
 
 namespace cove {
+
+namespace {
+
+/// The largest binomic filter dimension which doesn't overflow the integer sums.
+constexpr unsigned max_separable_binomic_dimension = 23;
+
+/// The minimum number of rows per concurrently processed stripe.
+constexpr int min_stripe_height = 32;
+
+/**
+ * Convolves a padded row of channel values with a 1D kernel.
+ *
+ * The input must have width + kernel.size() - 1 values. The loops have no
+ * branches, so that the compiler can vectorize them.
+ */
+void convolveRow(const std::int32_t* input, int width, const std::vector<int>& kernel, std::int32_t* output)
+{
+	std::fill(output, output + width, 0);
+	for (std::size_t i = 0; i < kernel.size(); ++i)
+	{
+		auto const k = kernel[i];
+		auto const* in = input + i;
+		for (int x = 0; x < width; ++x)
+			output[x] += k * in[x];
+	}
+}
+
+/**
+ * Applies a separable filter to the rows [first, last) of the source image.
+ *
+ * The horizontal pass works on rows of channel values which are padded with
+ * the border color, and rows outside of the image have constant sums, so
+ * that the inner loops do not need bounds checks. The horizontal sums of the
+ * last kernel.size() rows are kept in a ring buffer for the vertical pass.
+ *
+ * All arithmetic is done in integers, and the final division rounds half up,
+ * like the matrix implementation does for exact binomic and box weights.
+ *
+ * Returns false if processing was canceled.
+ */
+bool applySeparableRows(const QImage& source, QRgb border, const std::vector<int>& kernel,
+                        uchar* target_bits, int target_bytes_per_line, int first, int last,
+                        ProgressObserver* observer, std::atomic<bool>& canceled)
+{
+	auto const width = source.width();
+	auto const height = source.height();
+	auto const dimension = int(kernel.size());
+	auto const radius = dimension / 2;
+	auto const kernel_sum = std::accumulate(begin(kernel), end(kernel), 0);
+	auto const divisor = std::int64_t(kernel_sum) * kernel_sum;
+	auto const border_channels = std::array<std::int32_t, 3> { qRed(border), qGreen(border), qBlue(border) };
+	// Not for premultiplied formats: QImage::pixel() returns unpremultiplied colors.
+	auto const direct_access = source.format() == QImage::Format_RGB32
+	                           || source.format() == QImage::Format_ARGB32;
+	auto const progress_how_often = std::max(1, (last - first) / 75);
+
+	auto const padded_width = width + 2 * radius;
+	std::vector<std::int32_t> padded(3 * std::size_t(padded_width));
+	for (int c = 0; c < 3; ++c)
+	{
+		auto* channel = padded.data() + c * padded_width;
+		std::fill(channel, channel + radius, border_channels[c]);
+		std::fill(channel + radius + width, channel + padded_width, border_channels[c]);
+	}
+
+	std::vector<std::int32_t> row_sums(3 * std::size_t(dimension) * std::size_t(width));
+	auto horizontal_sums = [&](int y, int c) {
+		auto const slot = (y - first + radius) % dimension;
+		return row_sums.data() + (std::size_t(slot) * 3 + std::size_t(c)) * std::size_t(width);
+	};
+
+	auto horizontal_pass = [&](int y) {
+		if (y < 0 || y >= height)
+		{
+			for (int c = 0; c < 3; ++c)
+				std::fill(horizontal_sums(y, c), horizontal_sums(y, c) + width, border_channels[c] * kernel_sum);
+			return;
+		}
+
+		auto* red = padded.data() + radius;
+		auto* green = red + padded_width;
+		auto* blue = green + padded_width;
+		if (direct_access)
+		{
+			auto const* line = reinterpret_cast<const QRgb*>(source.constScanLine(y));
+			for (int x = 0; x < width; ++x)
+			{
+				red[x] = qRed(line[x]);
+				green[x] = qGreen(line[x]);
+				blue[x] = qBlue(line[x]);
+			}
+		}
+		else
+		{
+			for (int x = 0; x < width; ++x)
+			{
+				auto const rgb = source.pixel(x, y);
+				red[x] = qRed(rgb);
+				green[x] = qGreen(rgb);
+				blue[x] = qBlue(rgb);
+			}
+		}
+		for (int c = 0; c < 3; ++c)
+			convolveRow(padded.data() + c * padded_width, width, kernel, horizontal_sums(y, c));
+	};
+
+	for (int y = first - radius; y < first + radius; ++y)
+		horizontal_pass(y);
+
+	std::vector<std::int64_t> sums(3 * std::size_t(width));
+	for (int y = first; y < last; ++y)
+	{
+		if (canceled)
+			return false;
+
+		horizontal_pass(y + radius);
+		std::fill(begin(sums), end(sums), 0);
+		for (int c = 0; c < 3; ++c)
+		{
+			auto* s = sums.data() + c * width;
+			for (int j = 0; j < dimension; ++j)
+			{
+				auto const k = std::int64_t(kernel[std::size_t(j)]);
+				auto const* h = horizontal_sums(y - radius + j, c);
+				for (int x = 0; x < width; ++x)
+					s[x] += k * h[x];
+			}
+		}
+
+		auto const* red = sums.data();
+		auto const* green = red + width;
+		auto const* blue = green + width;
+		auto* line = reinterpret_cast<QRgb*>(target_bits + std::ptrdiff_t(y) * target_bytes_per_line);
+		for (int x = 0; x < width; ++x)
+		{
+			line[x] = qRgb(int((2 * red[x] + divisor) / (2 * divisor)),
+			               int((2 * green[x] + divisor) / (2 * divisor)),
+			               int((2 * blue[x] + divisor) / (2 * divisor)));
+		}
+
+		if (observer && !((y - first) % progress_how_often))
+		{
+			observer->setPercentage((y - first) * 100 / (last - first));
+			if (observer->isInterruptionRequested())
+				canceled = true;
+		}
+	}
+	return true;
+}
+
+}  // namespace
+
 //@{
 //! \ingroup libvectorizer
 
@@ -42,6 +204,12 @@ namespace cove {
 /*! \var double** FIRFilter::matrix
   FIR filter matrix. */
 
+/*! \var std::vector<int> FIRFilter::kernel
+  Integer 1D kernel of separable filters, or empty.
+
+  The matrix of binomic and box filters is the normalized outer product of
+  this kernel with itself. */
+
 /*! Constructor, allocates \a matrix.
   \param[in] radius Filter radius. 1 => matrix size 1x1, 2 => 3x3, 3 => 5x5, ...
   */
@@ -77,6 +245,13 @@ FIRFilter& FIRFilter::binomic()
 			matrix[0][i] = temprow[i] + temprow[i + 1];
 	}
 
+	kernel.clear();
+	if (dimension <= max_separable_binomic_dimension)
+	{
+		for (unsigned i = 0; i < dimension; i++)
+			kernel.push_back(int(matrix[0][i]));
+	}
+
 	// create other elements
 	double divisor = 0;
 	for (unsigned i = 0; i < dimension; i++)
@@ -104,6 +279,8 @@ FIRFilter& FIRFilter::box()
 		for (unsigned j = 0; j < dimension; j++)
 			matrix[i][j] = q;
 
+	kernel.assign(dimension, 1);
+
 	return *this;
 }
 
@@ -120,6 +297,9 @@ FIRFilter& FIRFilter::a(double /*center*/)
 QImage FIRFilter::apply(const QImage& source, QRgb outOfBoundsColor,
 						ProgressObserver* progressObserver)
 {
+	if (!kernel.empty())
+		return applySeparable(source, outOfBoundsColor, progressObserver);
+
 	int imwidth = source.width(), imheight = source.height();
 	bool cancel = false;
 	int progressHowOften = (imheight > 100) ? imheight / 75 : 1;
@@ -154,6 +334,43 @@ QImage FIRFilter::apply(const QImage& source, QRgb outOfBoundsColor,
 	}
 	return cancel ? QImage() : retimage;
 }
+
+/*! Applies this separable FIR filter in two 1D passes.
+
+  Stripes of rows are processed concurrently. The result is identical to the
+  result of the matrix implementation.  */
+QImage FIRFilter::applySeparable(const QImage& source, QRgb outOfBoundsColor,
+                                 ProgressObserver* progressObserver) const
+{
+	auto const height = source.height();
+	QImage retimage(source.width(), height, QImage::Format_RGB32);
+	if (retimage.isNull())
+		return retimage;
+
+	// Get the bits before concurrent access, so that there is no detaching.
+	auto* bits = retimage.bits();
+	auto const bytes_per_line = retimage.bytesPerLine();
+	std::atomic<bool> canceled { false };
+
+	auto const num_stripes = std::max(1, std::min(QThreadPool::globalInstance()->maxThreadCount(),
+	                                              height / min_stripe_height));
+	auto const stripe_height = (height + num_stripes - 1) / num_stripes;
+	std::vector<QFuture<bool>> futures;
+	futures.reserve(std::size_t(num_stripes));
+	for (int first = stripe_height; first < height; first += stripe_height)
+	{
+		auto const last = std::min(first + stripe_height, height);
+		futures.push_back(QtConcurrent::run([this, &source, outOfBoundsColor, bits, bytes_per_line, first, last, &canceled]() {
+			return applySeparableRows(source, outOfBoundsColor, kernel, bits, bytes_per_line, first, last, nullptr, canceled);
+		}));
+	}
+	// The first stripe is processed in the calling thread, with progress.
+	auto completed = applySeparableRows(source, outOfBoundsColor, kernel, bits, bytes_per_line,
+	                                    0, std::min(stripe_height, height), progressObserver, canceled);
+	for (auto& future : futures)
+		completed = future.result() && completed;
+	return completed ? retimage : QImage();
+}
 } // cove
 
 //@}
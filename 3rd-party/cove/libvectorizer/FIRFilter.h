@@ -32,6 +32,10 @@ class FIRFilter
 {
 protected:
 	std::vector<std::vector<double>> matrix;
+	std::vector<int> kernel;  ///< The integer 1D kernel of a separable filter, or empty
+
+	QImage applySeparable(const QImage& source, QRgb outOfBoundsColor,
+	                      ProgressObserver* progressObserver) const;
 
 public:
 	FIRFilter(unsigned radius = 0);
@@ -176,6 +176,20 @@ void MapColor::multiply(const double y)
 	x3 *= y;
 }
 
+/*! \brief Returns the coordinates x1, x2, x3. */
+std::array<double, 3> MapColor::getCoordinates() const
+{
+	return {x1, x2, x3};
+}
+
+/*! \brief Sets the coordinates x1, x2, x3. */
+void MapColor::setCoordinates(const std::array<double, 3>& coordinates)
+{
+	x1 = coordinates[0];
+	x2 = coordinates[1];
+	x3 = coordinates[2];
+}
+
 /*! \fn virtual QRgb MapColor::getRGBTriplet() const = 0;
  * \brief Returns RGB representation of this color. */
 
@@ -20,6 +20,8 @@
 #ifndef COVE_MAPCOLOR_H
 #define COVE_MAPCOLOR_H
 
+#include <array>
+
 #include <QRgb>
 
 #include "KohonenMap.h"
@@ -52,6 +54,8 @@ public:
 	virtual void setRGBTriplet(QRgb i) = 0;
 	void setP(double p);
 	double getP();
+	std::array<double, 3> getCoordinates() const;
+	void setCoordinates(const std::array<double, 3>& coordinates);
 };
 
 class MapColorRGB : public MapColor
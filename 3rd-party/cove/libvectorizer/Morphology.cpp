@@ -19,14 +19,288 @@
 
 #include "Morphology.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cmath>  // IWYU pragma: keep
+#include <cstddef>
+#include <utility>
 #include <vector>
 
+#include <QtAlgorithms>
+#include <QtConcurrent>
 #include <QtGlobal>
+#include <QFuture>
+#include <QThreadPool>
 
 #include "ProgressObserver.h"
 
 namespace cove {
+
+namespace {
+
+/**
+ * A binary image with 64 pixels packed into each word.
+ *
+ * Bit i of word w of a row is the pixel at x = 64 * w + i. Bits beyond the
+ * width of the image are always zero.
+ */
+struct BitImage
+{
+	using Word = quint64;
+	static constexpr int word_bits = 64;
+
+	int width = 0;
+	int height = 0;
+	int stride = 0;  ///< Words per row
+	std::vector<Word> words;
+
+	BitImage(int width, int height)
+	    : width(width)
+	    , height(height)
+	    , stride((width + word_bits - 1) / word_bits)
+	    , words(std::size_t(stride) * std::size_t(height), 0)
+	{}
+
+	/// Constructs a bit image with the non-zero pixel indices of the image.
+	explicit BitImage(const QImage& image);
+
+	/// Writes the pixels which differ from the image to the image.
+	void writeTo(QImage& image) const;
+
+	const Word* row(int y) const { return words.data() + std::size_t(y) * std::size_t(stride); }
+	Word* row(int y) { return words.data() + std::size_t(y) * std::size_t(stride); }
+
+	/// Returns the mask of the valid bits in the last word of a row.
+	Word lastWordMask() const
+	{
+		auto const valid_bits = width - (stride - 1) * word_bits;
+		return valid_bits == word_bits ? ~Word(0) : (Word(1) << valid_bits) - 1;
+	}
+};
+
+/// Returns the byte with the order of bits reversed.
+uchar reversed(uchar byte)
+{
+	byte = uchar((byte & 0xF0) >> 4 | (byte & 0x0F) << 4);
+	byte = uchar((byte & 0xCC) >> 2 | (byte & 0x33) << 2);
+	return uchar((byte & 0xAA) >> 1 | (byte & 0x55) << 1);
+}
+
+BitImage::BitImage(const QImage& image)
+    : BitImage(image.width(), image.height())
+{
+	auto const format = image.format();
+	if (format == QImage::Format_Mono || format == QImage::Format_MonoLSB)
+	{
+		auto const bytes = (width + 7) / 8;
+		for (int y = 0; y < height; ++y)
+		{
+			auto const* line = image.constScanLine(y);
+			auto* out = row(y);
+			for (int b = 0; b < bytes; ++b)
+			{
+				auto const byte = format == QImage::Format_Mono ? reversed(line[b]) : line[b];
+				out[b / 8] |= Word(byte) << (8 * (b % 8));
+			}
+			if (stride > 0)
+				out[stride - 1] &= lastWordMask();
+		}
+	}
+	else
+	{
+		for (int y = 0; y < height; ++y)
+		{
+			auto* out = row(y);
+			for (int x = 0; x < width; ++x)
+			{
+				if (image.pixelIndex(x, y))
+					out[x / word_bits] |= Word(1) << (x % word_bits);
+			}
+		}
+	}
+}
+
+void BitImage::writeTo(QImage& image) const
+{
+	auto const format = image.format();
+	if (format == QImage::Format_Mono || format == QImage::Format_MonoLSB)
+	{
+		auto const bytes = (width + 7) / 8;
+		for (int y = 0; y < height; ++y)
+		{
+			auto* line = image.scanLine(y);
+			auto const* in = row(y);
+			for (int b = 0; b < bytes; ++b)
+			{
+				auto byte = uchar(in[b / 8] >> (8 * (b % 8)));
+				auto mask = uchar(b + 1 < bytes || width % 8 == 0 ? 0xFF : (1 << (width % 8)) - 1);
+				if (format == QImage::Format_Mono)
+				{
+					byte = reversed(byte);
+					mask = reversed(mask);
+				}
+				line[b] = uchar((line[b] & ~mask) | (byte & mask));
+			}
+		}
+	}
+	else
+	{
+		auto const original = BitImage(image);
+		for (int y = 0; y < height; ++y)
+		{
+			auto const* in = row(y);
+			auto const* old = original.row(y);
+			for (int w = 0; w < stride; ++w)
+			{
+				for (auto changes = in[w] ^ old[w]; changes; changes &= changes - 1)
+				{
+					auto const i = int(qCountTrailingZeroBits(changes));
+					image.setPixel(w * word_bits + i, y, uint((in[w] >> i) & 1));
+				}
+			}
+		}
+	}
+}
+
+
+/// Loads the left, center and right neighbors of the pixels of word w.
+void loadNeighbors(const BitImage::Word* row, int w, int stride,
+                   BitImage::Word& left, BitImage::Word& center, BitImage::Word& right)
+{
+	if (!row)
+	{
+		left = center = right = 0;
+		return;
+	}
+	center = row[w];
+	auto const previous = w > 0 ? row[w - 1] : 0;
+	auto const next = w + 1 < stride ? row[w + 1] : 0;
+	left = (center << 1) | (previous >> (BitImage::word_bits - 1));
+	right = (center >> 1) | (next << (BitImage::word_bits - 1));
+}
+
+/**
+ * Applies a neighborhood table to the rows [first, last) of the source.
+ *
+ * The neighborhood p of a pixel is built as documented for
+ * Morphology::todelete, with zero pixels outside of the image. Where
+ * table[p] is true and (p & mask) is zero, the target pixel is set to value.
+ * All other target pixels are copied from the source.
+ *
+ * The source is only read, so the rows above and below the range are
+ * available as halo rows when stripes are processed concurrently.
+ *
+ * Progress is reported to the observer if it is not null. A cancellation
+ * request is passed to the other stripes via the canceled flag.
+ *
+ * Returns the number of matching pixels, or -1 when canceled.
+ */
+long long applyTable(const BitImage& source, BitImage& target, int first, int last,
+                     const bool* table, unsigned int mask, bool value,
+                     ProgressObserver* observer, std::atomic<bool>& canceled)
+{
+	using Word = BitImage::Word;
+	auto const stride = source.stride;
+	auto const last_word_mask = source.lastWordMask();
+	auto const progress_how_often = std::max(1, (last - first) / 75);
+	long long count = 0;
+	for (int y = first; y < last; ++y)
+	{
+		if (canceled)
+			return -1;
+
+		auto const* above = y > 0 ? source.row(y - 1) : nullptr;
+		auto const* center = source.row(y);
+		auto const* below = y + 1 < source.height ? source.row(y + 1) : nullptr;
+		auto* out = target.row(y);
+		for (int w = 0; w < stride; ++w)
+		{
+			// n[k] holds bit k of the neighborhoods of all pixels of the word.
+			Word n[9];
+			loadNeighbors(above, w, stride, n[8], n[7], n[6]);
+			loadNeighbors(center, w, stride, n[5], n[4], n[3]);
+			loadNeighbors(below, w, stride, n[2], n[1], n[0]);
+
+			auto candidates = table[0] ? ~Word(0)
+			                           : n[0] | n[1] | n[2] | n[3] | n[4] | n[5] | n[6] | n[7] | n[8];
+			if (w + 1 == stride)
+				candidates &= last_word_mask;
+
+			auto result = center[w];
+			for (; candidates; candidates &= candidates - 1)
+			{
+				auto const i = int(qCountTrailingZeroBits(candidates));
+				unsigned int p = 0;
+				for (int k = 8; k >= 0; --k)
+					p = (p << 1) | unsigned((n[k] >> i) & 1);
+				if ((p & mask) == 0 && table[p])
+				{
+					++count;
+					if (value)
+						result |= Word(1) << i;
+					else
+						result &= ~(Word(1) << i);
+				}
+			}
+			out[w] = result;
+		}
+
+		if (observer && !((y - first) % progress_how_often))
+		{
+			observer->setPercentage((y - first) * 100 / (last - first));
+			if (observer->isInterruptionRequested())
+				canceled = true;
+		}
+	}
+	return count;
+}
+
+/// The minimum number of rows to be processed in a concurrent job.
+constexpr int min_stripe_height = 32;
+
+/**
+ * Applies a neighborhood table to the whole source, processing horizontal
+ * stripes concurrently.
+ *
+ * The first stripe is processed in the calling thread, reporting progress
+ * to the observer if it is not null.
+ *
+ * Returns the number of matching pixels, or -1 when canceled.
+ *
+ * \sa applyTable()
+ */
+long long applyTableConcurrently(const BitImage& source, BitImage& target,
+                                 const bool* table, unsigned int mask, bool value,
+                                 ProgressObserver* progressObserver = nullptr)
+{
+	std::atomic<bool> canceled { false };
+	auto const height = source.height;
+	auto const num_stripes = std::max(1, std::min(QThreadPool::globalInstance()->maxThreadCount(),
+	                                              height / min_stripe_height));
+	auto const stripe_height = (height + num_stripes - 1) / num_stripes;
+
+	std::vector<QFuture<long long>> futures;
+	futures.reserve(std::size_t(num_stripes));
+	for (int first = stripe_height; first < height; first += stripe_height)
+	{
+		auto const last = std::min(first + stripe_height, height);
+		futures.push_back(QtConcurrent::run([&source, &target, first, last, table, mask, value, &canceled]() {
+			return applyTable(source, target, first, last, table, mask, value, nullptr, canceled);
+		}));
+	}
+	// The first stripe is processed in the calling thread, with progress.
+	auto count = applyTable(source, target, 0, std::min(stripe_height, height), table, mask, value,
+	                        progressObserver, canceled);
+	for (auto& future : futures)
+	{
+		auto const stripe_count = future.result();
+		count = (count < 0 || stripe_count < 0) ? -1 : count + stripe_count;
+	}
+	return count;
+}
+
+}  // namespace
+
 //@{
 //!\ingroup libvectorizer
 
@@ -123,89 +397,43 @@ bool Morphology::todelete[512] = {
 	false, true,  true,  false, false, true,  true,  true,  true,  true,  true,
 	false, false, true,  true,  false, false};
 
-//! Rosenfeld thinning.
+/*! Rosenfeld thinning.
+
+  Each pass deletes the pixels which match the todelete table and which do
+  not have a neighbor in the direction of the pass mask. The neighborhoods
+  are taken from the state before the pass.
+  */
 bool Morphology::rosenfeld(ProgressObserver* progressObserver)
 {
 	bool cancel = false; // whether the thinning was canceled
-	unsigned int x, y;   // Pixel coordinates
-	unsigned int count;  // Deleted pixel count
-	unsigned int p, q;   // Neighborhood maps of adjacent cells
+	long long count;     // Deleted pixel count
 
 	thinnedImage = image;
 	thinnedImage.detach();
-	unsigned int xsize = thinnedImage.width();
-	unsigned int ysize = thinnedImage.height();
-	// Neighborhood maps of previous scanline
-	std::vector<unsigned char> qb(xsize);
-
-	qb[xsize - 1] = false; // Used for lower-right pixel
+	auto current = BitImage(thinnedImage);
+	auto next = BitImage(current.width, current.height);
+	auto const num_pixels = static_cast<float>(current.width) * current.height;
 
 	do
-	{ // Thin image lines until there are no deletions
+	{ // Thin image until there are no deletions
 		count = 0;
 
 		for (auto const m : masks)
 		{
-			// Build initial previous scan buffer.
-			p = !!thinnedImage.pixelIndex(0, 0);
-			for (x = 0; x < xsize - 1; x++)
-				qb[x] =
-					(unsigned char)(p = ((p << 1) & 0006) |
-										(!!thinnedImage.pixelIndex(x + 1, 0)));
-
-			// Scan image for pixel deletion candidates.
-			for (y = 0; y < ysize - 1; y++)
-			{
-				q = qb[0];
-				p = ((q << 2) & 0330) | (!!thinnedImage.pixelIndex(0, y + 1));
-
-				for (x = 0; x < xsize - 1; x++)
-				{
-					q = qb[x];
-					p = ((p << 1) & 0666) | ((q << 3) & 0110) |
-						(!!thinnedImage.pixelIndex(x + 1, y + 1));
-					qb[x] = (unsigned char)p;
-					if (((p & m) == 0) && todelete[p])
-					{
-						count++;
-						thinnedImage.setPixel(x, y, 0); // delete the pixel
-					}
-				}
-
-				// Process right edge pixel.
-				p = (p << 1) & 0666;
-				if ((p & m) == 0 && todelete[p])
-				{
-					count++;
-					thinnedImage.setPixel(x, y, 0); // delete the pixel
-				}
-			}
-
-			// Process bottom scan line.
-			q = qb[0];
-			p = ((q << 2) & 0330);
-
-			for (x = 0; x < xsize; x++)
-			{
-				q = qb[x];
-				p = ((p << 1) & 0666) | ((q << 3) & 0110);
-				if ((p & m) == 0 && todelete[p])
-				{
-					count++;
-					thinnedImage.setPixel(x, y, 0); // delete the pixel
-				}
-			}
+			count += applyTableConcurrently(current, next, todelete, m, false);
+			std::swap(current, next);
 		}
 		if (progressObserver)
 			progressObserver->setPercentage(
 				100 -
 				static_cast<int>(
-					100 * std::pow(static_cast<float>(count) / (xsize * ysize),
+					100 * std::pow(static_cast<float>(count) / num_pixels,
 								   0.2)));
 	} while (
 		count &&
 		!(progressObserver && (cancel = progressObserver->isInterruptionRequested())));
 
+	current.writeTo(thinnedImage);
 	return !cancel;
 }
 
@@ -388,107 +616,25 @@ bool Morphology::runMorpholo(bool* table, bool insert,
 
 /*! Modifies thinnedImage according to given table.  Builds 3x3 neighborhood for
   every pixel and sets/resets (according to insert) the pixel in case the table
-  contains true.
+  contains true. The neighborhoods are taken from the unmodified image, and
+  horizontal stripes of the image are processed concurrently.
   \param[in] table Neighborhood table, e.g. isDeletable or isInsertable
   \param[in] insert Whether the pixel should be set or reset when the table
   contains true.
   \param[in] progressObserver Progress observer.
+  \return The number of modified pixels, or -1 when canceled.
   */
 int Morphology::modifyImage(bool* table, bool insert,
 							ProgressObserver* progressObserver)
 {
-	int xSize = thinnedImage.width();
-	int ySize = thinnedImage.height();
-	int progressHowOften = (ySize > 100) ? ySize / 75 : 1;
-	std::vector<bool> topScanLine(xSize);
-	std::vector<bool> midScanLine(xSize);
-	std::vector<bool> botScanLine(xSize);
-	int p, modifications;
-	bool cancel = false;
-
-	modifications = 0;
-	// prepare buffers
-	for (int x = 0; x < xSize; x++)
-	{
-		midScanLine[x] = false;
-		botScanLine[x] = !!thinnedImage.pixelIndex(x, 0);
-	}
-
-	for (int y = 0; y < ySize - 1 && !cancel; y++)
-	{
-		// rotate buffers
-		auto& temp = topScanLine;
-		topScanLine = midScanLine;
-		midScanLine = botScanLine;
-		botScanLine = temp;
-		// initialize bottom line
-		botScanLine[0] = !!thinnedImage.pixelIndex(0, y + 1);
-		// create neighborhood
-		p = topScanLine[0] << 6 | topScanLine[1] << 5 | midScanLine[0] << 3 |
-			midScanLine[1] << 2 | botScanLine[0];
-
-		// process line
-		for (int x = 0; x < xSize - 1; x++)
-		{
-			botScanLine[x + 1] = !!thinnedImage.pixelIndex(x + 1, y + 1);
-			p = ((p << 1) & 0666) | (topScanLine[x + 1] << 6) |
-				(midScanLine[x + 1] << 3) | (botScanLine[x + 1]);
-			if (table[p])
-			{
-				thinnedImage.setPixel(x, y, insert ? 1 : 0); // set the pixel
-				// TTR midScanLine[x] = false;
-				modifications++;
-			}
-		}
-
-		// right margin line processing
-		p = (p << 1) & 0666;
-		if (table[p])
-		{
-			thinnedImage.setPixel(xSize - 1, y,
-								  insert ? 1 : 0); // set the pixel
-			// TTR midScanLine[xSize-1] = false;
-			modifications++;
-		}
-
-		if (progressObserver && !(y % progressHowOften))
-		{
-			progressObserver->setPercentage(y * 100 / ySize);
-			cancel = progressObserver->isInterruptionRequested();
-		}
-	}
-
-	// bottom margin line processing
-	auto& temp = topScanLine;
-	topScanLine = midScanLine;
-	midScanLine = botScanLine;
-	botScanLine = temp;
-	p = topScanLine[0] << 7 | topScanLine[1] << 6 | midScanLine[0] << 4 |
-		midScanLine[1] << 3;
-	for (int x = 0; x < xSize - 1 && !cancel; x++)
-	{
-		p = ((p << 1) & 0666) | (topScanLine[x + 1] << 6) |
-			(midScanLine[x + 1] << 3);
-		if (table[p])
-		{
-			thinnedImage.setPixel(x, ySize - 1,
-								  insert ? 1 : 0); // set the pixel
-			// TTR midScanLine[x] = false;
-			modifications++;
-		}
-	}
-
-	// bottom right pixel
-	p = (p << 1) & 0666;
-	if (table[p])
-	{
-		thinnedImage.setPixel(xSize - 1, ySize - 1,
-							  insert ? 1 : 0); // set the pixel
-		// TTR midScanLine[xSize-1] = false;
-		modifications++;
-	}
-
-	return cancel ? -1 : modifications;
+	auto const source = BitImage(thinnedImage);
+	auto target = BitImage(source.width, source.height);
+	auto const modifications = applyTableConcurrently(source, target, table, 0, insert, progressObserver);
+	if (modifications < 0)
+		return -1;
+
+	target.writeTo(thinnedImage);
+	return int(modifications);
 }
 } // cove
 
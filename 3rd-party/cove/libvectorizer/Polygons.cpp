@@ -29,15 +29,20 @@
 #include <limits>
 #include <memory>
 #include <stdexcept>
+#include <tuple>
 #include <utility>
+#include <vector>
 
+#include <QtConcurrent>
 #include <QtGlobal>
 #include <QByteArray>
+#include <QFuture>
 #include <QPointF>
 #include <QString>
 
 #include <QImage>
 #include <QRectF>
+#include <QThreadPool>
 
 #include "ProgressObserver.h"
 
@@ -53,7 +58,14 @@ do                                       \
 using namespace std;
 
 namespace cove {
-const int Polygons::NPOINTS_MAX = 350;
+
+namespace {
+
+/// The minimum number of end points which justifies another join search thread.
+constexpr std::size_t MIN_POINTS_PER_RANGE = 2000;
+
+}  // namespace
+
 
 //@{
 //! \ingroup libvectorizer
@@ -622,173 +634,200 @@ inline double Polygons::dstfun(const dpoint_t* a, const dpoint_t* b,
 					   : ((j) == BB ? "BB" : ((j) == NOJOIN ? "NOJOIN" \
 															: "!!invalid")))))
 
-// FIXME !!! - remove the recursion, then lower the NPOINTS_MAX to its optimal
-// value 35
-// stack is not always big enough...
-bool Polygons::splitlist(JOINENDPOINTLIST& pl, JOINOPLIST& ops,
-						 const dpoint_t& min, const dpoint_t& max,
-						 bool vertical, ProgressObserver* progressObserver,
-						 const double pBase, const double piece) const
+/*! \class Polygons::EndPointGrid
+  \brief A uniform grid index over the end points of paths.
+
+  The cell size is the maximum join distance, so all end points which are
+  closer than this distance to a given point are in the 3x3 cells around the
+  point's cell. The cells are not stored as an array but as a list of point
+  indices which is sorted by cell row and column, so that the memory doesn't
+  depend on the extent of the points. The columns of a row are consecutive in
+  this list. */
+class Polygons::EndPointGrid
 {
-	dpoint_t min1, max1, min2, max2;
-	JOINENDPOINTLIST pl1, pl2;
+	struct Entry
+	{
+		long long row, column;
+		std::size_t index;
 
-	pl1.reserve(pl.size() / 2);
-	pl2.reserve(pl.size() / 2);
+		bool operator<(const Entry& other) const
+		{
+			return std::tie(row, column, index) < std::tie(other.row, other.column, other.index);
+		}
+	};
 
-	if (vertical)
-	{
-		min1.x = min.x;
-		max1.x = min2.x = min.x + (max.x - min.x) / 2;
-		max2.x = max.x;
-		min1.y = min2.y = min.y;
-		max1.y = max2.y = max.y;
-	}
-	else
+	double cellSize;
+	std::vector<Entry> entries;
+
+	Entry entryAt(const dpoint_t& p, std::size_t index) const
 	{
-		min1.y = min.y;
-		max1.y = min2.y = min.y + (max.y - min.y) / 2;
-		max2.y = max.y;
-		min1.x = min2.x = min.x;
-		max1.x = max2.x = max.x;
+		return { static_cast<long long>(std::floor(p.y / cellSize)),
+		         static_cast<long long>(std::floor(p.x / cellSize)),
+		         index };
 	}
 
-	if (vertical)
+public:
+	EndPointGrid(const JOINENDPOINTLIST& pl, double cellSize)
+		: cellSize(cellSize)
 	{
-		double x1bound = max1.x + maxdist / 2, x2bound = min2.x - maxdist / 2;
-		for (JOINENDPOINTLIST::const_iterator i = pl.begin(); i != pl.end();
-			 ++i)
-		{
-			if (i->coords.x <= x1bound) pl1.push_back(*i);
-			if (i->coords.x >= x2bound) pl2.push_back(*i);
-		}
+		entries.reserve(pl.size());
+		for (std::size_t i = 0; i < pl.size(); ++i)
+			entries.push_back(entryAt(pl[i].coords, i));
+		sort(entries.begin(), entries.end());
 	}
-	else
+
+	/*! Calls function for the index of every point in the cells around p. */
+	template <typename Function>
+	void forEachNeighbor(const dpoint_t& p, Function function) const
 	{
-		double y1bound = max1.y + maxdist / 2, y2bound = min2.y - maxdist / 2;
-		for (JOINENDPOINTLIST::const_iterator i = pl.begin(); i != pl.end();
-			 ++i)
+		auto const cell = entryAt(p, 0);
+		for (auto row = cell.row - 1; row <= cell.row + 1; ++row)
 		{
-			if (i->coords.y <= y1bound) pl1.push_back(*i);
-			if (i->coords.y >= y2bound) pl2.push_back(*i);
+			auto entry = lower_bound(entries.begin(), entries.end(),
+			                         Entry { row, cell.column - 1, 0 });
+			for (; entry != entries.end() && entry->row == row &&
+			       entry->column <= cell.column + 1;
+			     ++entry)
+				function(entry->index);
 		}
 	}
+};
 
-	JOIN_DEBUG_PRINT(
-		"[%f, %f, %f, %f] -> [%f, %f, %f, %f]v[%f, %f, %f, %f] %d=>%d+%d",
-		min.x, min.y, max.x, max.y, min1.x, min1.y, max1.x, max1.y, min2.x,
-		min2.y, max2.x, max2.y, int(pl.size()), int(pl1.size()),
-		int(pl2.size()));
+/*! Finds the candidate joins of all end points in pl.
 
-	pl.clear();
+  The candidates of an end point are the end points which come later in the
+  list and which are closer than maxdist. Ranges of end points are processed
+  concurrently, and the operations are appended to ops in the order of the
+  list. Returns false when the operation was canceled. */
+bool Polygons::findJoins(const JOINENDPOINTLIST& pl, JOINOPLIST& ops,
+						 ProgressObserver* progressObserver) const
+{
+	EndPointGrid grid(pl, maxdist);
+
+	auto const npoints = pl.size();
+	auto const nranges = std::size_t(std::max(
+		1, std::min(QThreadPool::globalInstance()->maxThreadCount(),
+					int(npoints / MIN_POINTS_PER_RANGE))));
+	auto const rangeSize = (npoints + nranges - 1) / nranges;
+
+	std::atomic<bool> canceled(false);
+	vector<JOINOPLIST> rangeOps(nranges);
+	vector<QFuture<bool>> futures;
+	futures.reserve(nranges);
+	for (std::size_t r = 1; r < nranges; ++r)
+	{
+		auto const first = std::min(r * rangeSize, npoints);
+		auto const last = std::min(first + rangeSize, npoints);
+		auto* result = &rangeOps[r];
+		futures.push_back(QtConcurrent::run(
+			[this, &pl, &grid, first, last, result, &canceled]() {
+				return findJoins(pl, grid, first, last, *result, nullptr,
+								 canceled);
+			}));
+	}
+	// The first range is processed in the calling thread, with progress.
+	auto completed = findJoins(pl, grid, 0, std::min(rangeSize, npoints), ops,
+							   progressObserver, canceled);
+	for (std::size_t r = 1; r < nranges; ++r)
+	{
+		completed = futures[r - 1].result() && completed;
+		ops.insert(ops.end(), rangeOps[r].begin(), rangeOps[r].end());
+	}
 
-	vertical = !vertical;
-	return compdists(pl1, ops, min1, max1, vertical, progressObserver, pBase,
-					 piece > 1 ? piece / 2 : 1) &&
-		   compdists(pl2, ops, min2, max2, vertical, progressObserver,
-					 pBase + piece / 2.0, piece > 1 ? piece / 2 : 1);
+	if (progressObserver)
+	{
+		progressObserver->setPercentage(62);
+	}
+	return completed;
 }
 
-bool Polygons::compdists(JOINENDPOINTLIST& pl, JOINOPLIST& ops,
-						 const dpoint_t& min, const dpoint_t& max,
-						 bool vertical, ProgressObserver* progressObserver,
-						 const double pBase, const double piece) const
+/*! Finds the candidate joins of the end points [first, last) of pl. */
+bool Polygons::findJoins(const JOINENDPOINTLIST& pl, const EndPointGrid& grid,
+						 std::size_t first, std::size_t last, JOINOPLIST& ops,
+						 ProgressObserver* progressObserver,
+						 std::atomic<bool>& canceled) const
 {
-	int cntr = 0, npoints = pl.size();
-	int progressHowOften = (npoints / piece >= 1) ? int(npoints / piece) : 1;
-	bool cancel = false;
+	double maxDistSqr = maxdist * maxdist;
+	auto progressHowOften = std::max<std::size_t>((last - first) / 12, 1);
+	vector<std::size_t> neighbors;
 
-	// split the list whenever it's too long
-	if (npoints > NPOINTS_MAX)
+	JOIN_DEBUG_PRINT("computing points %d to %d", int(first), int(last));
+	for (auto i = first; i < last; ++i)
 	{
-		JOIN_DEBUG_PRINT("splitting");
-		splitlist(pl, ops, min, max, vertical, progressObserver, pBase, piece);
-	}
-	else
-	{
-		double maxDistSqr = maxdist * maxdist;
-		vector<bool> alreadyUsed(npoints, false);
-		vector<bool>::iterator ai = alreadyUsed.begin(), aj;
-
-		JOIN_DEBUG_PRINT("computing set of %d points", npoints);
-		for (JOINENDPOINTLIST::const_iterator i = pl.begin();
-			 i != pl.end() && !cancel; ++i, ++ai)
+		if (canceled) return false;
+
+		privcurve_t* curve = &pl[i].path->priv->curve;
+		const dpoint_t* start = &pl[i].coords;
+
+		// Closed curves cannot be joined.
+		if (curve->closed) continue;
+
+		// A join is simple when no other unclosed curve end is close enough.
+		// Ends which come earlier in the list have already been considered.
+		bool alreadyUsed = false;
+		neighbors.clear();
+		grid.forEachNeighbor(*start, [&](std::size_t j) {
+			if (j == i || distSqr(start, &pl[j].coords) >= maxDistSqr)
+				return;
+			if (j > i)
+				neighbors.push_back(j);
+			else if (!pl[j].path->priv->curve.closed)
+				alreadyUsed = true;
+		});
+		sort(neighbors.begin(), neighbors.end());
+
+		for (auto j : neighbors)
 		{
-			privcurve_t* curve = &i->path->priv->curve;
-			const dpoint_t* start = &i->coords;
-			int nJoins = 0;
-
-			// Closed curves cannot be joined. Points outside the bounding
-			// rectangle
-			// are not considered for joining.
-			if (curve->closed || start->x < min.x || start->x > max.x ||
-				start->y < min.y || start->y > max.y)
-				continue;
+			dpoint_t *a, *b, *c, *d;
+			privcurve_t* pp_curve = &pl[j].path->priv->curve;
 
-			aj = ai + 1;
-			for (JOINENDPOINTLIST::const_iterator j = i + 1; j != pl.end();
-				 ++j, ++aj)
+			switch (pl[i].end)
 			{
-				if (distSqr(start, &j->coords) < maxDistSqr)
-				{
-					dpoint_t *a, *b, *c, *d;
-					privcurve_t* pp_curve = &j->path->priv->curve;
-
-					switch (i->end)
-					{
-					case FRONT:
-						b = &curve->vertex[0];
-						a = b + 1;
-						break;
-					case BACK:
-						b = &curve->vertex[curve->n - 1];
-						a = b - 1;
-						break;
-					default:
-						throw logic_error("NOEND in JOINENDPOINT list");
-					}
-					switch (j->end)
-					{
-					case FRONT:
-						c = &pp_curve->vertex[0];
-						d = c + 1;
-						break;
-					case BACK:
-						c = &pp_curve->vertex[pp_curve->n - 1];
-						d = c - 1;
-						break;
-					default:
-						throw logic_error("NOEND in JOINENDPOINT list");
-					}
-
-					ops.push_back(JOINOP(float(dstfun(a, b, c, d)
-					                           // self-connection penalization
-					                           - (i->path == j->path)),
-					                     endsToType(i->end, j->end), i->path,
-					                     j->path));
-					nJoins++;
-					*aj = true;
-				}
+			case FRONT:
+				b = &curve->vertex[0];
+				a = b + 1;
+				break;
+			case BACK:
+				b = &curve->vertex[curve->n - 1];
+				a = b - 1;
+				break;
+			default:
+				throw logic_error("NOEND in JOINENDPOINT list");
 			}
-
-			if (nJoins == 1 && !*ai)
+			switch (pl[j].end)
 			{
-				// simple connection
-				ops.back().simple = true;
+			case FRONT:
+				c = &pp_curve->vertex[0];
+				d = c + 1;
+				break;
+			case BACK:
+				c = &pp_curve->vertex[pp_curve->n - 1];
+				d = c - 1;
+				break;
+			default:
+				throw logic_error("NOEND in JOINENDPOINT list");
 			}
 
-			if (progressObserver && !(++cntr % progressHowOften))
-			{
-				progressObserver->setPercentage(
-					int(cntr * piece / npoints + pBase));
-				cancel = progressObserver->isInterruptionRequested();
-			}
-			if (cancel) return false;
+			ops.push_back(JOINOP(float(dstfun(a, b, c, d)
+			                           // self-connection penalization
+			                           - (pl[i].path == pl[j].path)),
+			                     endsToType(pl[i].end, pl[j].end), pl[i].path,
+			                     pl[j].path));
+		}
+
+		if (neighbors.size() == 1 && !alreadyUsed)
+		{
+			// simple connection
+			ops.back().simple = true;
+		}
+
+		if (progressObserver && !((i - first + 1) % progressHowOften))
+		{
+			progressObserver->setPercentage(
+				int(50 + 12 * (i - first) / (last - first)));
+			if (progressObserver->isInterruptionRequested())
+				canceled = true;
 		}
-	}
-	if (progressObserver)
-	{
-		progressObserver->setPercentage(int(piece + pBase));
 	}
 	return true;
 }
@@ -804,27 +843,16 @@ bool Polygons::joinPolygons(path_t*& plist,
 	path_t* p;
 	int nops, cntr, progressHowOften;
 	bool cancel = false;
-	double inf = std::numeric_limits<double>::infinity();
-	dpoint_t min = {inf, inf}, max = {-inf, -inf};
 
 	list_forall(p, plist)
 	{
 		privcurve_t* p_curve = &p->priv->curve;
 		int p_n = p_curve->n;
-		dpoint_t f = p_curve->vertex[0], b = p_curve->vertex[p_n - 1];
-		pointlist.push_back(JOINENDPOINT(f, FRONT, p));
-		pointlist.push_back(JOINENDPOINT(b, BACK, p));
-		if (f.x > max.x) max.x = f.x;
-		if (f.x < min.x) min.x = f.x;
-		if (f.y > max.y) max.y = f.y;
-		if (f.y < min.y) min.y = f.y;
-		if (b.x > max.x) max.x = b.x;
-		if (b.x < min.x) min.x = b.x;
-		if (b.y > max.y) max.y = b.y;
-		if (b.y < min.y) min.y = b.y;
+		pointlist.push_back(JOINENDPOINT(p_curve->vertex[0], FRONT, p));
+		pointlist.push_back(JOINENDPOINT(p_curve->vertex[p_n - 1], BACK, p));
 	}
 
-	compdists(pointlist, ops, min, max, true, progressObserver, 50, 12);
+	if (!findJoins(pointlist, ops, progressObserver)) return false;
 
 	sort(ops.begin(), ops.end(), greater_weight());
 
@@ -22,6 +22,8 @@
 #define COVE_POLYGONS_H
 
 #include <algorithm>
+#include <atomic>
+#include <cstddef>
 #include <functional>
 #include <limits>
 #include <vector>
@@ -31,6 +33,7 @@
 
 #include "cove-potrace.h"
 
+class PolygonTest;
 class QImage;
 // IWYU pragma: no_forward_declare QPointF
 class QRectF;
@@ -152,17 +155,14 @@ private:
 		}
 	};
 
-	// implementation dependent value...
-	static const int NPOINTS_MAX;
-
-	bool compdists(JOINENDPOINTLIST& pl, JOINOPLIST& ops, const dpoint_t& min,
-	               const dpoint_t& max, bool vertical,
-	               ProgressObserver* progressObserver, double pBase,
-	               double piece) const;
-	bool splitlist(JOINENDPOINTLIST& pl, JOINOPLIST& ops, const dpoint_t& min,
-	               const dpoint_t& max, bool vertical,
-	               ProgressObserver* progressObserver, double pBase,
-	               double piece) const;
+	class EndPointGrid;
+
+	bool findJoins(const JOINENDPOINTLIST& pl, JOINOPLIST& ops,
+	               ProgressObserver* progressObserver) const;
+	bool findJoins(const JOINENDPOINTLIST& pl, const EndPointGrid& grid,
+	               std::size_t first, std::size_t last, JOINOPLIST& ops,
+	               ProgressObserver* progressObserver,
+	               std::atomic<bool>& canceled) const;
 	inline double distSqr(const dpoint_t* a, const dpoint_t* b) const;
 	inline JOINEND joinEndA(JOINTYPE j) const;
 	inline JOINEND joinEndB(JOINTYPE j) const;
@@ -197,8 +197,9 @@ public:
 	PolygonList
 	createPolygonsFromImage(const QImage& image,
 	                        ProgressObserver* progressObserver = nullptr) const;
-	// search for best value of NPOINTS_MAX - optinpoints.cpp
-	friend void perfcheck();
+
+	// compares findJoins() with a brute-force search
+	friend class ::PolygonTest;
 };
 } // cove
 
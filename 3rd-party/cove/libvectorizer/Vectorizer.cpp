@@ -24,7 +24,6 @@
 #include <cstdlib>
 #include <iosfwd>
 #include <iterator>
-#include <numeric>
 #include <utility>
 #include <type_traits>
 
@@ -36,6 +35,7 @@
 #include <QVector>
 
 #include "AlphaGetter.h"
+#include "ColorClassifier.h"
 #include "Concurrency.h"
 #include "ProgressObserver.h"
 #include "KohonenMap.h"
@@ -314,12 +314,8 @@ bool Vectorizer::performClassification(ProgressObserver* progressObserver)
 	// if no initial colors have been set, select random ones
 	if (sourceImageColors.empty()) setInitColors({});
 
-	std::vector<OrganizableElement*> classes(sourceImageColors.size());
-	for (std::size_t i = 0; i < sourceImageColors.size(); i++)
-		classes[i] = sourceImageColors[i].get();
-
-	KohonenMap km;
-	km.setClasses(classes);
+	ColorClassifier classifier(*mc);
+	classifier.setClasses(sourceImageColors);
 
 	switch (learnMethod)
 	{
@@ -345,17 +341,12 @@ bool Vectorizer::performClassification(ProgressObserver* progressObserver)
 			qWarning("UNIMPLEMENTED alpha getter");
 		}
 
-		km.performLearning(*ag, *pg);
+		classifier.performLearning(*ag, *pg);
 	}
 	break;
 	case KOHONEN_BATCH:
-	{
-		auto bg = std::make_unique<SequentialPatternGetter>(
-			sourceImage, mc.get(), progressObserver);
-		quality = km.performBatchLearning(*bg);
-		classifiedImage = *bg->getClassifiedImage();
-	}
-	break;
+		quality = classifier.performBatchLearning(sourceImage, classifiedImage, progressObserver);
+		break;
 	default:
 		qWarning("UNIMPLEMENTED classification method");
 	}
@@ -367,11 +358,7 @@ bool Vectorizer::performClassification(ProgressObserver* progressObserver)
 	}
 	else
 	{
-		auto classes = km.getClasses();
-
-		for (std::size_t i = 0; i < sourceImageColors.size(); i++)
-			sourceImageColors[i] = std::shared_ptr<MapColor>(
-				dynamic_cast<MapColor*>(classes[i]->clone()));
+		sourceImageColors = classifier.getClasses();
 	}
 
 	return !cancel;
@@ -394,47 +381,6 @@ std::vector<QRgb> Vectorizer::getClassifiedColors()
  * \param qualityPtr Pointer to double where quality of learning will be stored.
  * \param progressObserver Optional progress observer.
  * \return New image. */
-
-class ClassificationMapper
-{
-	const std::vector<std::shared_ptr<MapColor>>& sourceImageColors;
-	const KohonenMap& km;
-
-public:
-	ClassificationMapper(const std::vector<std::shared_ptr<MapColor>>& sic, KohonenMap& km)
-		: sourceImageColors(sic)
-		, km(km)
-	{}
-
-	double operator()(const QImage& sourceImage, QImage& outputImage, ProgressObserver& observer) const
-	{
-		auto const width = outputImage.width();
-		auto const height = outputImage.height();
-
-		auto color = std::unique_ptr<MapColor>(
-			dynamic_cast<MapColor*>(sourceImageColors[0]->clone()));
-
-		double quality = 0;
-		for (int y = 0; y < height && !observer.isInterruptionRequested(); y++)
-		{
-			for (int x = 0; x < width; x++)
-			{
-				double distance;
-				color->setRGBTriplet(sourceImage.pixel(x, y));
-				int index = km.findClosest(*color, distance);
-				outputImage.setPixel(x, y, index);
-				quality += color->squares(*sourceImageColors[index]);
-			}
-			observer.setPercentage((100*y) / height);
-		}
-		return quality;
-	}
-
-	using concurrent_processing = HorizontalStripes;
-};
-Q_STATIC_ASSERT((Concurrency::supported<ClassificationMapper>::value));
-
-
 QImage Vectorizer::getClassifiedImage(double* qualityPtr,
 									  ProgressObserver* progressObserver)
 {
@@ -447,24 +393,14 @@ QImage Vectorizer::getClassifiedImage(double* qualityPtr,
 			classifiedImage.setColor(i, sourceImageColors[i]->getRGBTriplet());
 		}
 
-		std::vector<OrganizableElement*> classes(sourceImageColors.size());
-		for (std::size_t i = 0; i < sourceImageColors.size(); i++)
-			classes[i] = sourceImageColors[i].get();
-
-		KohonenMap km;
-		km.setClasses(classes);
-
-		auto mapFunctor = ClassificationMapper(sourceImageColors, km);
-		auto results = Concurrency::process<double>(progressObserver, mapFunctor, sourceImage, classifiedImage);
+		ColorClassifier classifier(*mc);
+		classifier.setClasses(sourceImageColors);
+		quality = classifier.classify(sourceImage, classifiedImage, progressObserver);
 		if (progressObserver && progressObserver->isInterruptionRequested())
 		{
 			classifiedImage = QImage();
 			quality = 0;
 		}
-		else
-		{
-			quality = std::accumulate(begin(results), end(results), 0.0, [](auto a, auto& b) { return a + b.future.result(); });
-		}
 	}
 
 	if (qualityPtr) *qualityPtr = quality;
@@ -0,0 +1,220 @@
+/*
+ * Copyright 2021 The OpenOrienteering developers
+ *
+ * This file is part of CoVe.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include <QtGlobal>
+#include <QtTest>
+#include <QImage>
+#include <QObject>
+#include <QRgb>
+#include <QThreadPool>
+
+#include "libvectorizer/ColorClassifier.h"
+#include "libvectorizer/KohonenMap.h"
+#include "libvectorizer/MapColor.h"
+
+using namespace cove;
+
+class ColorClassifierTest : public QObject
+{
+	Q_OBJECT
+
+private slots:
+	void classifyTest_data()
+	{
+		QTest::addColumn<double>("p");
+		QTest::newRow("Hamming")   << 1.0;
+		QTest::newRow("Euclid")    << 2.0;
+		QTest::newRow("Chebyshev") << qInf();
+	}
+
+	void classifyTest()
+	{
+		QFETCH(double, p);
+
+		auto const prototype = MapColorRGB(p);
+		std::vector<std::shared_ptr<MapColor>> colors;
+		std::vector<OrganizableElement*> elements;
+		for (auto rgb : { qRgb(0, 0, 0), qRgb(255, 255, 255), qRgb(200, 30, 30), qRgb(30, 200, 30), qRgb(30, 30, 200) })
+		{
+			colors.push_back(std::make_shared<MapColorRGB>(rgb, p));
+			elements.push_back(colors.back().get());
+		}
+
+		auto image = QImage(97, 61, QImage::Format_RGB32);
+		for (int y = 0; y < image.height(); ++y)
+		{
+			for (int x = 0; x < image.width(); ++x)
+				image.setPixel(x, y, qRgb((x * 7 + y) % 256, (y * 5) % 256, (x * y) % 256));
+		}
+
+		ColorClassifier classifier(prototype);
+		classifier.setClasses(colors);
+		auto classified = QImage(image.size(), QImage::Format_Indexed8);
+		classified.setColorCount(int(colors.size()));
+		auto const quality = classifier.classify(image, classified, nullptr);
+
+		// The reference implementation
+		KohonenMap km;
+		km.setClasses(elements);
+		auto color = MapColorRGB(p);
+		double expected_quality = 0;
+		for (int y = 0; y < image.height(); ++y)
+		{
+			for (int x = 0; x < image.width(); ++x)
+			{
+				double distance;
+				color.setRGBTriplet(image.pixel(x, y));
+				auto const index = km.findClosest(color, distance);
+				QCOMPARE(classified.pixelIndex(x, y), index);
+				expected_quality += color.squares(*colors[std::size_t(index)]);
+			}
+		}
+		QCOMPARE(quality, expected_quality);
+	}
+
+	void classifyColorSpacesTest_data()
+	{
+		QTest::addColumn<bool>("hsv");
+		QTest::addColumn<double>("p");
+		QTest::addColumn<int>("numClasses");
+
+		for (auto hsv : { false, true })
+		{
+			for (auto p : { 1.0, 2.0, 3.0, qInf() })
+			{
+				// Class counts below, at and above the padding of the class arrays
+				for (auto numClasses : { 1, 7, 8, 9, 33 })
+				{
+					auto const name = QString::fromLatin1("%1, p=%2, %3 classes")
+					                  .arg(QLatin1String(hsv ? "HSV" : "RGB")).arg(p).arg(numClasses);
+					QTest::newRow(qPrintable(name)) << hsv << p << numClasses;
+				}
+			}
+		}
+	}
+
+	void classifyColorSpacesTest()
+	{
+		QFETCH(bool, hsv);
+		QFETCH(double, p);
+		QFETCH(int, numClasses);
+
+		auto makeColor = [hsv, p](QRgb rgb) -> std::shared_ptr<MapColor> {
+			if (hsv)
+				return std::make_shared<MapColorHSV>(rgb, p);
+			return std::make_shared<MapColorRGB>(rgb, p);
+		};
+
+		std::vector<std::shared_ptr<MapColor>> colors;
+		std::vector<OrganizableElement*> elements;
+		for (int i = 0; i < numClasses; ++i)
+		{
+			colors.push_back(makeColor(qRgb((i * 97 + 13) % 256, (i * 59 + 200) % 256, (i * 31 + 90) % 256)));
+			elements.push_back(colors.back().get());
+		}
+
+		// Tall enough for several stripes
+		auto image = QImage(83, 301, QImage::Format_RGB32);
+		for (int y = 0; y < image.height(); ++y)
+		{
+			for (int x = 0; x < image.width(); ++x)
+				image.setPixel(x, y, qRgb((x * 3 + y) % 256, (y * 7 + x * x) % 256, (x * y + 50) % 256));
+		}
+
+		auto* threadPool = QThreadPool::globalInstance();
+		auto const maxThreadCount = threadPool->maxThreadCount();
+		threadPool->setMaxThreadCount(4);
+		ColorClassifier classifier(*makeColor(qRgb(0, 0, 0)));
+		classifier.setClasses(colors);
+		auto classified = QImage(image.size(), QImage::Format_Indexed8);
+		classified.setColorCount(numClasses);
+		auto const quality = classifier.classify(image, classified, nullptr);
+		threadPool->setMaxThreadCount(maxThreadCount);
+
+		// The reference implementation, in double precision. The classifier
+		// searches in single precision, so it may choose another class when
+		// the distances are almost equal.
+		KohonenMap km;
+		km.setClasses(elements);
+		auto color = makeColor(qRgb(0, 0, 0));
+		double expected_quality = 0;
+		for (int y = 0; y < image.height(); ++y)
+		{
+			for (int x = 0; x < image.width(); ++x)
+			{
+				double distance;
+				color->setRGBTriplet(image.pixel(x, y));
+				auto const expected = km.findClosest(*color, distance);
+				auto const actual = classified.pixelIndex(x, y);
+				QVERIFY(actual >= 0 && actual < numClasses);
+				if (actual != expected)
+				{
+					auto const actual_distance = color->distance(*colors[std::size_t(actual)]);
+					QVERIFY(actual_distance - distance <= 1e-5 * std::max(1.0, distance));
+				}
+				expected_quality += color->squares(*colors[std::size_t(actual)]);
+			}
+		}
+		QVERIFY(qAbs(quality - expected_quality) <= 1e-9 * std::max(1.0, expected_quality));
+	}
+
+
+	void batchLearningTest()
+	{
+		auto const expected = std::vector<QRgb> { qRgb(250, 250, 250), qRgb(20, 20, 20), qRgb(200, 40, 40) };
+		auto image = QImage(64, 64, QImage::Format_RGB32);
+		image.fill(expected[0]);
+		for (int y = 0; y < 32; ++y)
+		{
+			for (int x = 0; x < 64; ++x)
+				image.setPixel(x, y, expected[std::size_t(1 + x % 2)]);
+		}
+
+		auto const prototype = MapColorRGB(2.0);
+		std::vector<std::shared_ptr<MapColor>> colors;
+		for (auto rgb : { qRgb(200, 200, 200), qRgb(60, 60, 60), qRgb(150, 60, 60) })
+			colors.push_back(std::make_shared<MapColorRGB>(rgb, 2.0));
+
+		ColorClassifier classifier(prototype);
+		classifier.setClasses(colors);
+		QImage classified;
+		auto const quality = classifier.performBatchLearning(image, classified, nullptr);
+		QVERIFY(qFuzzyIsNull(quality));
+		QCOMPARE(classified.size(), image.size());
+		QCOMPARE(classified.pixelIndex(0, 0), 1);
+		QCOMPARE(classified.pixelIndex(1, 0), 2);
+		QCOMPARE(classified.pixelIndex(0, 63), 0);
+
+		auto const result = classifier.getClasses();
+		QCOMPARE(int(result.size()), int(expected.size()));
+		for (std::size_t i = 0; i < expected.size(); ++i)
+		{
+			QCOMPARE(result[i]->getRGBTriplet(), expected[i]);
+			QCOMPARE(classified.color(int(i)), expected[i]);
+		}
+	}
+
+};
+
+QTEST_GUILESS_MAIN(ColorClassifierTest)
+#include "ColorClassifierTest.moc"  // IWYU pragma: keep
@@ -0,0 +1,127 @@
+/*
+ * Copyright 2021 The OpenOrienteering developers
+ *
+ * This file is part of CoVe.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QtGlobal>
+#include <QtTest>
+#include <QImage>
+#include <QObject>
+#include <QRgb>
+#include <QSize>
+#include <QString>
+
+#include "libvectorizer/FIRFilter.h"
+
+using namespace cove;
+
+namespace {
+
+/**
+ * A filter which uses the matrix implementation, as a reference.
+ */
+class MatrixFIRFilter : public FIRFilter
+{
+public:
+	explicit MatrixFIRFilter(const FIRFilter& filter)
+	    : FIRFilter(filter)
+	{
+		kernel.clear();
+	}
+};
+
+QImage makeImage(const QSize& size, QImage::Format format)
+{
+	// Translucent pixels for formats with an alpha channel
+	auto const translucent = QImage(1, 1, format).hasAlphaChannel();
+	auto image = QImage(size, translucent ? QImage::Format_ARGB32 : QImage::Format_RGB32);
+	for (int y = 0; y < image.height(); ++y)
+	{
+		for (int x = 0; x < image.width(); ++x)
+		{
+			auto const alpha = translucent ? (x * 29 + y * 17) % 256 : 255;
+			image.setPixel(x, y, qRgba((x * 37 + y * 11) % 256, (x * y + 7 * y) % 256, (x % 3) ? 255 : (y * 53) % 256, alpha));
+		}
+	}
+	return image.convertToFormat(format);
+}
+
+}  // namespace
+
+
+class FIRFilterTest : public QObject
+{
+	Q_OBJECT
+
+private slots:
+	void applyTest_data()
+	{
+		QTest::addColumn<bool>("binomic");
+		QTest::addColumn<unsigned>("radius");
+		QTest::addColumn<QSize>("size");
+		QTest::addColumn<int>("format");
+
+		for (auto binomic : { true, false })
+		{
+			for (auto radius : { 1u, 2u, 3u, 5u })
+			{
+				for (auto size : { QSize(1, 1), QSize(3, 2), QSize(97, 61), QSize(40, 150) })
+				{
+					auto const name = QString::fromLatin1("%1 %2, %3x%4")
+					                  .arg(QLatin1String(binomic ? "binomic" : "box"))
+					                  .arg(radius).arg(size.width()).arg(size.height());
+					QTest::newRow(qPrintable(name)) << binomic << radius << size << int(QImage::Format_RGB32);
+				}
+			}
+		}
+		QTest::newRow("binomic 3, ARGB32") << true << 3u << QSize(50, 70) << int(QImage::Format_ARGB32);
+		QTest::newRow("binomic 3, ARGB32_Premultiplied") << true << 3u << QSize(50, 70) << int(QImage::Format_ARGB32_Premultiplied);
+		QTest::newRow("box 2, ARGB32_Premultiplied")     << false << 2u << QSize(50, 70) << int(QImage::Format_ARGB32_Premultiplied);
+		QTest::newRow("box 3, RGB888")     << false << 3u << QSize(50, 70) << int(QImage::Format_RGB888);
+		QTest::newRow("box 2, Indexed8")   << false << 2u << QSize(50, 70) << int(QImage::Format_Indexed8);
+	}
+
+	void applyTest()
+	{
+		QFETCH(bool, binomic);
+		QFETCH(unsigned, radius);
+		QFETCH(QSize, size);
+		QFETCH(int, format);
+
+		auto const image = makeImage(size, QImage::Format(format));
+		auto const border = qRgb(127, 127, 127);
+
+		auto filter = FIRFilter(radius);
+		if (binomic)
+			filter.binomic();
+		else
+			filter.box();
+		auto const result = filter.apply(image, border);
+		auto const expected = MatrixFIRFilter(filter).apply(image, border);
+		QCOMPARE(result.format(), expected.format());
+		QCOMPARE(result.size(), expected.size());
+		for (int y = 0; y < expected.height(); ++y)
+		{
+			for (int x = 0; x < expected.width(); ++x)
+				QCOMPARE(result.pixel(x, y), expected.pixel(x, y));
+		}
+	}
+
+};
+
+QTEST_GUILESS_MAIN(FIRFilterTest)
+#include "FIRFilterTest.moc"  // IWYU pragma: keep
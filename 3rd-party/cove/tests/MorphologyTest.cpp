@@ -0,0 +1,245 @@
+/*
+ * Copyright 2021 The OpenOrienteering developers
+ *
+ * This file is part of CoVe.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <vector>
+
+#include <QtGlobal>
+#include <QtTest>
+#include <QImage>
+#include <QObject>
+#include <QRgb>
+#include <QSize>
+#include <QString>
+
+#include "libvectorizer/Morphology.h"
+#include "libvectorizer/ProgressObserver.h"
+
+using namespace cove;
+
+namespace {
+
+/**
+ * Provides a straightforward reference implementation of the operations,
+ * using the tables of Morphology.
+ */
+class MorphologyReference : public Morphology
+{
+public:
+	using Morphology::Morphology;
+
+	/// A single pass, with all neighborhoods taken from the input.
+	static QImage pass(const QImage& input, const bool* table, unsigned int mask, bool value, int& count)
+	{
+		auto output = input.copy();
+		auto pixel = [&input](int x, int y) -> unsigned int {
+			return x >= 0 && y >= 0 && x < input.width() && y < input.height() && input.pixelIndex(x, y) ? 1 : 0;
+		};
+		for (int y = 0; y < input.height(); ++y)
+		{
+			for (int x = 0; x < input.width(); ++x)
+			{
+				unsigned int p = 0;
+				for (int dy = -1; dy <= 1; ++dy)
+				{
+					for (int dx = -1; dx <= 1; ++dx)
+						p = (p << 1) | pixel(x + dx, y + dy);
+				}
+				if ((p & mask) == 0 && table[p])
+				{
+					++count;
+					output.setPixel(x, y, value ? 1 : 0);
+				}
+			}
+		}
+		return output;
+	}
+
+	static QImage erosion(const QImage& input)
+	{
+		int count = 0;
+		return pass(input, isDeletable, 0, false, count);
+	}
+
+	static QImage dilation(const QImage& input)
+	{
+		int count = 0;
+		return pass(input, isInsertable, 0, true, count);
+	}
+
+	static QImage pruning(const QImage& input)
+	{
+		int count = 0;
+		return pass(input, isPrunable, 0, false, count);
+	}
+
+	static QImage rosenfeld(const QImage& input)
+	{
+		auto output = input;
+		int count;
+		do
+		{
+			count = 0;
+			for (auto const m : masks)
+				output = pass(output, todelete, m, false, count);
+		}
+		while (count);
+		return output;
+	}
+};
+
+/**
+ * Records the reported progress, and optionally requests cancellation.
+ */
+class TestObserver : public ProgressObserver
+{
+public:
+	explicit TestObserver(bool cancel) : cancel(cancel) {}
+
+	void setPercentage(int percentage) override
+	{
+		percentages.push_back(percentage);
+	}
+
+	bool isInterruptionRequested() const override
+	{
+		return cancel;
+	}
+
+	std::vector<int> percentages;
+	bool cancel;
+};
+
+}  // namespace
+
+
+class MorphologyTest : public QObject
+{
+	Q_OBJECT
+
+	static QImage makeImage(int width, int height, QImage::Format format)
+	{
+		auto image = QImage(width, height, format);
+		image.setColorCount(2);
+		image.setColor(0, qRgb(255, 255, 255));
+		image.setColor(1, qRgb(0, 0, 0));
+		image.fill(0);
+		for (int y = 0; y < height; ++y)
+		{
+			for (int x = 0; x < width; ++x)
+			{
+				// Noise, a thick diagonal band, and a filled rectangle
+				auto const set = (x * x * 7 + y * 13 + x * y) % 23 < 3
+				                 || std::abs(x - y) < 6
+				                 || (x > width / 2 && y > height / 3 && x < width - 3 && y < height - 4);
+				image.setPixel(x, y, set ? 1 : 0);
+			}
+		}
+		return image;
+	}
+
+	static bool equalPixels(const QImage& actual, const QImage& expected)
+	{
+		if (actual.size() != expected.size() || actual.format() != expected.format())
+			return false;
+		for (int y = 0; y < expected.height(); ++y)
+		{
+			for (int x = 0; x < expected.width(); ++x)
+			{
+				if (actual.pixelIndex(x, y) != expected.pixelIndex(x, y))
+				{
+					qWarning("Pixel (%d, %d) differs", x, y);
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+
+private slots:
+	void operationsTest_data()
+	{
+		QTest::addColumn<int>("width");
+		QTest::addColumn<int>("height");
+		QTest::addColumn<int>("format");
+
+		for (auto format : { QImage::Format_Mono, QImage::Format_MonoLSB })
+		{
+			for (auto size : { QSize(1, 1), QSize(5, 3), QSize(63, 40), QSize(64, 64), QSize(65, 70), QSize(130, 97) })
+			{
+				auto const name = QString::fromLatin1("%1x%2, format %3").arg(size.width()).arg(size.height()).arg(int(format));
+				QTest::newRow(qPrintable(name)) << size.width() << size.height() << int(format);
+			}
+		}
+	}
+
+	void operationsTest()
+	{
+		QFETCH(int, width);
+		QFETCH(int, height);
+		QFETCH(int, format);
+
+		auto const image = makeImage(width, height, QImage::Format(format));
+
+		Morphology erosion(image);
+		QVERIFY(erosion.erosion());
+		QVERIFY(equalPixels(erosion.getImage(), MorphologyReference::erosion(image)));
+
+		Morphology dilation(image);
+		QVERIFY(dilation.dilation());
+		QVERIFY(equalPixels(dilation.getImage(), MorphologyReference::dilation(image)));
+
+		Morphology pruning(image);
+		QVERIFY(pruning.pruning());
+		QVERIFY(equalPixels(pruning.getImage(), MorphologyReference::pruning(image)));
+
+		Morphology thinning(image);
+		QVERIFY(thinning.rosenfeld());
+		QVERIFY(equalPixels(thinning.getImage(), MorphologyReference::rosenfeld(image)));
+
+		// The input is not modified.
+		QVERIFY(equalPixels(image, makeImage(width, height, QImage::Format(format))));
+	}
+
+	void progressTest()
+	{
+		// Tall enough for several concurrent stripes
+		auto const image = makeImage(130, 400, QImage::Format_Mono);
+
+		TestObserver observer(false);
+		Morphology erosion(image);
+		QVERIFY(erosion.erosion(&observer));
+		QVERIFY(!observer.percentages.empty());
+		QVERIFY(std::all_of(begin(observer.percentages), end(observer.percentages), [](int percentage) {
+			return percentage >= 0 && percentage <= 100;
+		}));
+		QVERIFY(equalPixels(erosion.getImage(), MorphologyReference::erosion(image)));
+
+		TestObserver canceling_observer(true);
+		Morphology canceled(image);
+		QVERIFY(!canceled.erosion(&canceling_observer));
+		QCOMPARE(canceling_observer.percentages.size(), std::size_t(1));
+	}
+
+};
+
+QTEST_GUILESS_MAIN(MorphologyTest)
+#include "MorphologyTest.moc"  // IWYU pragma: keep
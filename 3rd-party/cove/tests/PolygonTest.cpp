@@ -24,7 +24,11 @@
 #include <functional>
 #include <iterator>
 #include <limits>
+#include <memory>
 #include <numeric>
+#include <random>
+#include <tuple>
+#include <vector>
 
 #include <QtGlobal>
 #include <QtMath>
@@ -36,6 +40,7 @@
 #include <QIODevice>
 #include <QImage>
 #include <QPointF>
+#include <QThreadPool>
 
 #include "libvectorizer/Polygons.h"
 
@@ -97,6 +102,90 @@ void PolygonTest::testJoins()
 	compareResults(polys, resultFile);
 }
 
+void PolygonTest::testJoinCandidates()
+{
+	using cove::Polygons;
+
+	auto const maxDistance = 5.0;
+	auto const maxDistSqr = maxDistance * maxDistance;
+
+	// Open paths with end points on a half-unit lattice around the origin,
+	// so that there are negative coordinates, points on cell borders, and
+	// points exactly maxDistance apart. 6000 end points are enough for
+	// three search ranges.
+	std::mt19937 generator(20210315);
+	std::uniform_int_distribution<int> lattice(-1000, 1000);
+	auto randomPoint = [&generator, &lattice]() {
+		auto const x = 0.5 * lattice(generator);
+		auto const y = 0.5 * lattice(generator);
+		return dpoint_t { x, y };
+	};
+
+	std::vector<std::unique_ptr<path_t, decltype(&path_free)>> paths;
+	Polygons::JOINENDPOINTLIST pointList;
+	for (int i = 0; i < 3000; ++i)
+	{
+		paths.emplace_back(path_new(), &path_free);
+		auto* path = paths.back().get();
+		QVERIFY(path);
+		QCOMPARE(privcurve_init(&path->priv->curve, 2), 0);
+		path->priv->curve.vertex[0] = randomPoint();
+		path->priv->curve.vertex[1] = randomPoint();
+		pointList.emplace_back(path->priv->curve.vertex[0], Polygons::FRONT, path);
+		pointList.emplace_back(path->priv->curve.vertex[1], Polygons::BACK, path);
+	}
+
+	auto* threadPool = QThreadPool::globalInstance();
+	auto const maxThreadCount = threadPool->maxThreadCount();
+	threadPool->setMaxThreadCount(4);
+	Polygons polygons;
+	polygons.setMaxDistance(maxDistance);
+	Polygons::JOINOPLIST ops;
+	auto const completed = polygons.findJoins(pointList, ops, nullptr);
+	threadPool->setMaxThreadCount(maxThreadCount);
+	QVERIFY(completed);
+
+	// The brute-force search compares all pairs of end points.
+	auto joinType = [](Polygons::JOINEND a, Polygons::JOINEND b) {
+		if (a == Polygons::FRONT)
+			return b == Polygons::FRONT ? Polygons::FF : Polygons::FB;
+		return b == Polygons::FRONT ? Polygons::BF : Polygons::BB;
+	};
+	using Candidate = std::tuple<path_t*, int, path_t*, bool>;
+	std::vector<Candidate> expected;
+	int exactlyMaxDistance = 0;
+	for (std::size_t i = 0; i < pointList.size(); ++i)
+	{
+		auto const first = expected.size();
+		auto alreadyUsed = false;
+		for (std::size_t j = 0; j < pointList.size(); ++j)
+		{
+			auto const dx = pointList[i].coords.x - pointList[j].coords.x;
+			auto const dy = pointList[i].coords.y - pointList[j].coords.y;
+			auto const dSqr = dx * dx + dy * dy;
+			if (dSqr == maxDistSqr)
+				++exactlyMaxDistance;
+			if (j == i || dSqr >= maxDistSqr)
+				continue;
+			if (j < i)
+				alreadyUsed = true;
+			else
+				expected.emplace_back(pointList[i].path, joinType(pointList[i].end, pointList[j].end),
+				                      pointList[j].path, false);
+		}
+		if (expected.size() == first + 1 && !alreadyUsed)
+			std::get<3>(expected.back()) = true;
+	}
+	QVERIFY(exactlyMaxDistance > 0);
+
+	std::vector<Candidate> actual;
+	actual.reserve(ops.size());
+	for (auto const& op : ops)
+		actual.emplace_back(op.a, int(op.joinType), op.b, op.simple);
+	QCOMPARE(actual.size(), expected.size());
+	QVERIFY(actual == expected);
+}
+
 void PolygonTest::saveResults(const cove::PolygonList& polys,
                               const QString& filename) const
 {
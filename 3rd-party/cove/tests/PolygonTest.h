@@ -31,6 +31,8 @@ private slots:
 	void testJoins_data();
 	void testJoins();
 
+	void testJoinCandidates();
+
 private:
 	void saveResults(const cove::PolygonList& polys,
 	                 const QString& filename) const;
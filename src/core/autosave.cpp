@@ -19,8 +19,17 @@
 
 #include "autosave.h"
 
+#include <utility>
+
 #include <QtGlobal>
+#include <QByteArray>
+#include <QCoreApplication>
+#include <QEvent>
+#include <QIODevice>
 #include <QLatin1String>
+#include <QMetaObject>
+#include <QRunnable>
+#include <QSaveFile>
 #include <QString>
 #include <QVariant>
 
@@ -29,9 +38,42 @@
 
 namespace OpenOrienteering {
 
+/**
+ * A runnable which writes an autosave file.
+ */
+class AutosavePrivate::WriteJob : public QRunnable
+{
+public:
+	WriteJob(AutosavePrivate* receiver, QString path, QByteArray data)
+	: receiver(receiver)
+	, path(std::move(path))
+	, data(std::move(data))
+	{
+		setAutoDelete(true);
+	}
+	
+	void run() override
+	{
+		QSaveFile file(path);
+		auto const success = file.open(QIODevice::WriteOnly)
+		                     && file.write(data) == data.size()
+		                     && file.commit();
+		QMetaObject::invokeMethod(receiver, "writeFinished", Qt::QueuedConnection,
+		                          Q_ARG(QString, path), Q_ARG(bool, success));
+	}
+	
+private:
+	AutosavePrivate* receiver;
+	QString path;
+	QByteArray data;
+};
+
+
+
 AutosavePrivate::AutosavePrivate(Autosave& autosave)
 : document(autosave)
 {
+	writer_pool.setMaxThreadCount(1);
 #ifdef QT_TESTLIB_LIB
 	// The AutosaveTest uses a very short interval. By using a precise timer,
 	// we try to avoid occasional AutosaveTest failures on macOS.
@@ -43,7 +85,11 @@ AutosavePrivate::AutosavePrivate(Autosave& autosave)
 	settingsChanged();
 }
 
-AutosavePrivate::~AutosavePrivate() = default;
+AutosavePrivate::~AutosavePrivate()
+{
+	// Pending notifications are discarded with this object.
+	writer_pool.waitForDone();
+}
 
 void AutosavePrivate::settingsChanged()
 {
@@ -87,6 +133,43 @@ void AutosavePrivate::setAutosaveNeeded(bool needed)
 	}
 }
 
+bool AutosavePrivate::writePending() const
+{
+	return write_pending;
+}
+
+void AutosavePrivate::write(const QString& path, const QByteArray& data)
+{
+	if (write_pending)
+		waitForWrite();
+	write_pending = true;
+	writer_pool.start(new WriteJob(this, path, data));
+}
+
+void AutosavePrivate::waitForWrite()
+{
+	if (write_pending)
+	{
+		writer_pool.waitForDone();
+		QCoreApplication::sendPostedEvents(this, QEvent::MetaCall);
+	}
+}
+
+void AutosavePrivate::writeFinished(const QString& path, bool success)
+{
+	write_pending = false;
+	document.autosaveFileWritten(path, success);
+	// autosave() returned Success when it started the write.
+	if (!success && autosave_interval && autosave_needed)
+		retryAutosave();
+}
+
+void AutosavePrivate::retryAutosave()
+{
+	autosave_timer.setInterval(5000);
+	autosave_timer.start();
+}
+
 void AutosavePrivate::autosave()
 {
 	Autosave::AutosaveResult result = document.autosave();
@@ -95,8 +178,7 @@ void AutosavePrivate::autosave()
 		switch (result)
 		{
 		case Autosave::TemporaryFailure:
-			autosave_timer.setInterval(5000);
-			autosave_timer.start();
+			retryAutosave();
 			return;
 		case Autosave::Success:
 		case Autosave::PermanentFailure:
@@ -135,6 +217,26 @@ bool Autosave::autosaveNeeded() const
 	return autosave_controller.autosaveNeeded();
 }
 
+void Autosave::writeAutosaveFile(const QString& path, const QByteArray& data)
+{
+	autosave_controller.write(path, data);
+}
+
+bool Autosave::isWritingAutosaveFile() const
+{
+	return autosave_controller.writePending();
+}
+
+void Autosave::waitForAutosaveFile()
+{
+	autosave_controller.waitForWrite();
+}
+
+void Autosave::autosaveFileWritten(const QString& /*path*/, bool /*success*/)
+{
+	// nothing
+}
+
 
 }  // namespace OpenOrienteering
 
@@ -21,8 +21,10 @@
 #define OPENORIENTEERING_AUTOSAVE_H
 
 #include <QObject>
+#include <QThreadPool>
 #include <QTimer>
 
+class QByteArray;
 class QString;
 
 namespace OpenOrienteering {
@@ -52,18 +54,34 @@ public:
 	
 	void setAutosaveNeeded(bool needed);
 	
+	bool writePending() const;
+	
+	void write(const QString& path, const QByteArray& data);
+	
+	void waitForWrite();
+	
 public slots:
 	void autosave();
 	
 	void settingsChanged();
 	
+private slots:
+	void writeFinished(const QString& path, bool success);
+	
 private:
 	Q_DISABLE_COPY(AutosavePrivate)
 	
+	class WriteJob;
+	
+	/** Schedules the next attempt after a temporary failure. */
+	void retryAutosave();
+	
 	Autosave& document;
 	QTimer autosave_timer;
+	QThreadPool writer_pool;
 	int  autosave_interval = 0;
 	bool autosave_needed = false;
+	bool write_pending = false;
 };
 
 
@@ -88,6 +106,10 @@ private:
  * 
  * The autosave period (in minutes) is taken from the setting
  * Settings::General_AutosaveInterval.
+ * 
+ * Implementations of autosave() may serialize the data on the calling thread,
+ * and leave the writing of the file to writeAutosaveFile() which runs in a
+ * background thread.
  */
 class Autosave
 {
@@ -116,9 +138,36 @@ protected:
 	/** @brief Initializes the autosave feature. */
 	Autosave();
 	
-	/** @brief Destructs the autosave feature. */
+	/** @brief Destructs the autosave feature, waiting for pending writes. */
 	virtual ~Autosave();
 	
+	/**
+	 * @brief Writes the given data to the given path in a background thread.
+	 * 
+	 * The file is replaced atomically. A pending write is completed before
+	 * the new one is started. When writing has finished, autosaveFileWritten()
+	 * is called in the thread of this object.
+	 */
+	void writeAutosaveFile(const QString& path, const QByteArray& data);
+	
+	/** @brief Returns true while writing an autosave file is in progress. */
+	bool isWritingAutosaveFile() const;
+	
+	/**
+	 * @brief Waits for a pending write of an autosave file to finish.
+	 * 
+	 * This must be called before removing the autosave file.
+	 */
+	void waitForAutosaveFile();
+	
+	/**
+	 * @brief Informs about the result of writeAutosaveFile().
+	 * 
+	 * A failed write is handled like a TemporaryFailure result of autosave():
+	 * autosaving is retried soon. The default implementation does nothing.
+	 */
+	virtual void autosaveFileWritten(const QString& path, bool success);
+	
 private:
 	friend class AutosavePrivate;
 	
@@ -22,8 +22,10 @@
 
 #include <algorithm>
 #include <cmath> // IWYU pragma: keep
+#include <cstddef>
 #include <iterator>
 #include <utility>
+#include <vector>
 
 #include <QtGlobal>
 #include <QtMath>
@@ -340,6 +342,40 @@ LatLon ProjTransform::inverse(const QPointF& projected_coords, bool* ok) const
 	return isGeographic() ? LatLon{northing, easting} : LatLon::fromRadiant(northing, easting);
 }
 
+bool ProjTransform::forward(const LatLon* lat_lon, QPointF* projected, std::size_t count) const
+{
+	static auto const geographic_crs = ProjTransform(Georeferencing::geographic_crs_spec);
+	
+	if (count == 0)
+		return true;
+	
+	auto const is_geographic = isGeographic();
+	std::transform(lat_lon, lat_lon + count, projected, [is_geographic](const LatLon& c) {
+		return is_geographic
+		       ? QPointF{c.longitude(), c.latitude()}
+		       : QPointF{qDegreesToRadians(c.longitude()), qDegreesToRadians(c.latitude())};
+	});
+	return geographic_crs.isValid()
+	       && pj_transform(geographic_crs.pj, pj, long(count), 2, &projected->rx(), &projected->ry(), nullptr) == 0;
+}
+
+bool ProjTransform::inverse(const QPointF* projected, LatLon* lat_lon, std::size_t count) const
+{
+	static auto const geographic_crs = ProjTransform(Georeferencing::geographic_crs_spec);
+	
+	if (count == 0)
+		return true;
+	
+	auto points = std::vector<QPointF>(projected, projected + count);
+	auto const ok = geographic_crs.isValid()
+	                && pj_transform(pj, geographic_crs.pj, long(count), 2, &points.front().rx(), &points.front().ry(), nullptr) == 0;
+	auto const is_geographic = isGeographic();
+	std::transform(begin(points), end(points), lat_lon, [is_geographic](const QPointF& p) {
+		return is_geographic ? LatLon{p.y(), p.x()} : LatLon::fromRadiant(p.y(), p.x());
+	});
+	return ok;
+}
+
 QString ProjTransform::errorText() const
 {
 	auto err_no = *pj_get_errno_ref();
@@ -459,6 +495,42 @@ LatLon ProjTransform::inverse(const QPointF& projected_coords, bool* ok) const
 	return {pj_coord.lp.phi, pj_coord.lp.lam};
 }
 
+bool ProjTransform::forward(const LatLon* lat_lon, QPointF* projected, std::size_t count) const
+{
+	if (count == 0)
+		return true;
+	
+	std::transform(lat_lon, lat_lon + count, projected, [](const LatLon& c) {
+		return QPointF{c.longitude(), c.latitude()};
+	});
+	proj_errno_reset(pj);
+	proj_trans_generic(pj, PJ_FWD,
+	                   &projected->rx(), sizeof(QPointF), count,
+	                   &projected->ry(), sizeof(QPointF), count,
+	                   nullptr, 0, 0,
+	                   nullptr, 0, 0);
+	return proj_errno(pj) == 0;
+}
+
+bool ProjTransform::inverse(const QPointF* projected, LatLon* lat_lon, std::size_t count) const
+{
+	if (count == 0)
+		return true;
+	
+	auto points = std::vector<QPointF>(projected, projected + count);
+	proj_errno_reset(pj);
+	proj_trans_generic(pj, PJ_INV,
+	                   &points.front().rx(), sizeof(QPointF), count,
+	                   &points.front().ry(), sizeof(QPointF), count,
+	                   nullptr, 0, 0,
+	                   nullptr, 0, 0);
+	auto const ok = proj_errno(pj) == 0;
+	std::transform(begin(points), end(points), lat_lon, [](const QPointF& p) {
+		return LatLon{p.y(), p.x()};
+	});
+	return ok;
+}
+
 QString ProjTransform::errorText() const
 {
 	auto err_no = proj_errno(pj);
@@ -1182,6 +1254,31 @@ MapCoordF Georeferencing::toMapCoordF(const LatLon& lat_lon, bool* ok) const
 	return toMapCoordF(toProjectedCoords(lat_lon, ok));
 }
 
+bool Georeferencing::toMapCoordF(const LatLon* lat_lon, MapCoordF* map_coords, std::size_t count) const
+{
+	auto projected = std::vector<QPointF>(count);
+	auto const ok = proj_transform.isValid() && proj_transform.forward(lat_lon, projected.data(), count);
+	std::transform(begin(projected), end(projected), map_coords, [this](const QPointF& p) {
+		return MapCoordF(from_projected.map(p));
+	});
+	return ok;
+}
+
+bool Georeferencing::toGeographicCoords(const MapCoordF* map_coords, LatLon* lat_lon, std::size_t count) const
+{
+	if (!proj_transform.isValid())
+	{
+		std::fill(lat_lon, lat_lon + count, LatLon{});
+		return false;
+	}
+	
+	auto projected = std::vector<QPointF>(count);
+	std::transform(map_coords, map_coords + count, begin(projected), [this](const MapCoordF& c) {
+		return to_projected.map(c);
+	});
+	return proj_transform.inverse(projected.data(), lat_lon, count);
+}
+
 MapCoordF Georeferencing::toMapCoordF(const Georeferencing* other, const MapCoordF& map_coords, bool* ok) const
 {
 	if (!other)
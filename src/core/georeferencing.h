@@ -22,6 +22,7 @@
 #define OPENORIENTEERING_GEOREFERENCING_H
 
 #include <cmath>
+#include <cstddef>
 #include <vector>
 
 #include <QObject>
@@ -69,6 +70,11 @@ struct ProjTransform
 	QPointF forward(const LatLon& lat_lon, bool* ok) const;
 	LatLon inverse(const QPointF& projected, bool* ok) const;
 	
+	/// Transforms count points at once. Returns false if any point failed.
+	bool forward(const LatLon* lat_lon, QPointF* projected, std::size_t count) const;
+	/// Transforms count points at once. Returns false if any point failed.
+	bool inverse(const QPointF* projected, LatLon* lat_lon, std::size_t count) const;
+	
 	QString errorText() const;
 	
 private:
@@ -499,6 +505,22 @@ public:
 	 */
 	MapCoordF toMapCoordF(const LatLon& lat_lon, bool* ok = nullptr) const;
 	
+	/**
+	 * Transforms an array of geographic coordinates (lat/lon) to map coordinates.
+	 * 
+	 * This is much faster than transforming the coordinates one by one.
+	 * Returns false if any of the coordinates could not be transformed.
+	 */
+	bool toMapCoordF(const LatLon* lat_lon, MapCoordF* map_coords, std::size_t count) const;
+	
+	/**
+	 * Transforms an array of map coordinates to geographic coordinates (lat/lon).
+	 * 
+	 * This is much faster than transforming the coordinates one by one.
+	 * Returns false if any of the coordinates could not be transformed.
+	 */
+	bool toGeographicCoords(const MapCoordF* map_coords, LatLon* lat_lon, std::size_t count) const;
+	
 	
 	/**
 	 * Transforms map coordinates from the other georeferencing to
@@ -67,6 +67,7 @@
 #include "undo/object_undo.h"
 #include "undo/undo.h"
 #include "undo/undo_manager.h"
+#include "util/concurrency.h"
 #include "util/util.h"
 #include "util/transformation.h"
 
@@ -852,6 +853,56 @@ void Map::drawTemplates(QPainter* painter, const QRectF& bounding_box, int first
 	}
 }
 
+std::shared_ptr<const MapRenderablesSnapshot> Map::renderablesSnapshot(const QRectF& bounding_box)
+{
+	// Update the renderables of all objects marked as dirty
+	updateObjects();
+	
+	return renderables->snapshot(bounding_box);
+}
+
+Map::TemplatesDrawFunction Map::concurrentTemplatesDrawFunction(int first_template, int last_template, const MapView* view, bool on_screen) const
+{
+	struct Item
+	{
+		Template::DrawFunction draw;
+		double scale;
+		qreal opacity;
+	};
+	std::vector<Item> items;
+	for (int i = first_template; i <= last_template; ++i)
+	{
+		const Template* temp = getTemplate(i);
+		if (temp->getTemplateState() != Template::Loaded)
+			continue;
+		
+		double scale  = std::max(temp->getTemplateScaleX(), temp->getTemplateScaleY());
+		auto visibility = TemplateVisibility{ 1, true };
+		if (view)
+		{
+			visibility = view->getTemplateVisibility(temp);
+			visibility.visible &= visibility.opacity > 0;
+			scale *= view->getZoom();
+		}
+		if (visibility.visible)
+		{
+			auto draw = temp->concurrentDrawFunction();
+			if (!draw)
+				return {};
+			items.push_back({ std::move(draw), scale, visibility.opacity });
+		}
+	}
+	
+	return [items, on_screen](QPainter* painter, const QRectF& bounding_box) {
+		for (auto const& item : items)
+		{
+			painter->save();
+			item.draw(painter, bounding_box, item.scale, on_screen, item.opacity);
+			painter->restore();
+		}
+	};
+}
+
 void Map::updateObjects()
 {
 	// TODO: It maybe would be better if the objects entered themselves into a separate list when they get dirty so not all objects have to be traversed here
@@ -871,6 +922,31 @@ void Map::insertRenderablesOfObject(const Object* object)
 		addSelectionRenderables(object);
 }
 
+void Map::updateObjectIndex(const Object* object)
+{
+	// Most objects which are modified are in the current part.
+	auto const* current_part = current_part_index < parts.size() ? parts[current_part_index] : nullptr;
+	if (current_part && current_part->updateObjectIndex(object))
+		return;
+	for (const MapPart* part : parts)
+	{
+		if (part != current_part && part->updateObjectIndex(object))
+			return;
+	}
+}
+
+void Map::invalidateObjectIndex(const Object* object)
+{
+	auto const* current_part = current_part_index < parts.size() ? parts[current_part_index] : nullptr;
+	if (current_part && current_part->invalidateObjectIndex(object))
+		return;
+	for (const MapPart* part : parts)
+	{
+		if (part != current_part && part->invalidateObjectIndex(object))
+			return;
+	}
+}
+
 
 void Map::markAsIrregular(Object* object)
 {
@@ -963,13 +1039,14 @@ void Map::includeSelectionRect(QRectF& rect) const
 		rectIncludeSafe(rect, object->getExtent());
 }
 
-void Map::drawSelection(QPainter* painter, bool force_min_size, MapWidget* widget, MapRenderables* replacement_renderables, bool draw_normal)
+void Map::drawSelection(QPainter* painter, bool force_min_size, MapWidget* widget, MapRenderables* replacement_renderables, bool draw_normal, const QTransform& transform)
 {
 	MapView* view = widget->getMapView();
 	
 	painter->save();
 	painter->translate(widget->width() / 2.0 + view->panOffset().x(), widget->height() / 2.0 + view->panOffset().y());
 	painter->setWorldTransform(view->worldTransform(), true);
+	painter->setWorldTransform(transform, true);
 	
 	if (!replacement_renderables)
 		replacement_renderables = selection_renderables.data();
@@ -983,7 +1060,8 @@ void Map::drawSelection(QPainter* painter, bool force_min_size, MapWidget* widge
 		options |= RenderConfig::Highlighted;
 		selection_opacity = 0.4;
 	}
-	RenderConfig config = { *this, view->calculateViewedRect(widget->viewportToView(widget->rect())), view->calculateFinalZoomFactor(), options, selection_opacity };
+	auto const viewed_rect = view->calculateViewedRect(widget->viewportToView(widget->rect()));
+	RenderConfig config = { *this, transform.inverted().mapRect(viewed_rect), view->calculateFinalZoomFactor(), options, selection_opacity };
 	replacement_renderables->draw(painter, config);
 	
 	painter->restore();
@@ -2315,11 +2393,42 @@ void Map::rotateAllObjects(double rotation, const MapCoord& center)
 
 void Map::updateAllObjects()
 {
+	PointSymbol::InstancingScope instancing_scope;
 	applyOnAllObjects(&Object::forceUpdate);
 }
 
+void Map::updateAllObjectsConcurrently()
+{
+	// Text objects depend on font handling which is left to the GUI thread.
+	std::vector<const Object*> objects;
+	objects.reserve(std::size_t(getNumObjects()));
+	applyOnAllObjects([this, &objects](Object* object) {
+		if (object->getType() == Object::Text)
+			return;
+		if (object->getExtent().isValid())
+			setObjectAreaDirty(object->getExtent());
+		objects.push_back(object);
+	});
+	
+	Util::forEachRangeConcurrently(objects.size(), [&objects](std::size_t first, std::size_t last) {
+		PointSymbol::InstancingScope instancing_scope;
+		for (auto i = first; i < last; ++i)
+			objects[i]->prepareUpdate();
+	}, 128);
+	
+	// Publishes the prepared output, and updates the remaining objects.
+	PointSymbol::InstancingScope instancing_scope;
+	applyOnAllObjects([](Object* object) {
+		if (object->getType() == Object::Text)
+			object->forceUpdate();
+		else
+			object->update();
+	});
+}
+
 void Map::updateAllObjectsWithSymbol(const Symbol* symbol)
 {
+	PointSymbol::InstancingScope instancing_scope;
 	applyOnMatchingObjects(&Object::forceUpdate, ObjectOp::HasSymbol{symbol});
 }
 
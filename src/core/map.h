@@ -62,6 +62,7 @@ class MapColor;
 class MapColorMap;
 class MapPrinterConfig;
 class MapRenderables;
+class MapRenderablesSnapshot;
 class MapView;
 class MapWidget;
 class Object;
@@ -72,6 +73,7 @@ class Template;  // IWYU pragma: keep
 class TextSymbol;
 class UndoManager;
 class UndoStep;
+class XmlObjectCache;
 
 
 /**
@@ -294,6 +296,31 @@ public:
 	void drawTemplates(QPainter* painter, const QRectF& bounding_box, int first_template,
 					   int last_template, const MapView* view, bool on_screen) const;
 	
+	/**
+	 * Returns an immutable snapshot of the part of the map which is visible
+	 * in the bounding box.
+	 * 
+	 * Unlike draw(), the snapshot can be drawn from another thread.
+	 * 
+	 * @param bounding_box Bounding box of area to draw, given in map coordinates.
+	 */
+	std::shared_ptr<const MapRenderablesSnapshot> renderablesSnapshot(const QRectF& bounding_box);
+	
+	/**
+	 * A function which draws templates, given a painter and a bounding box.
+	 */
+	using TemplatesDrawFunction = std::function<void (QPainter* painter, const QRectF& bounding_box)>;
+	
+	/**
+	 * Returns a function which draws the given range of templates like
+	 * drawTemplates(), but which may be called from another thread.
+	 * 
+	 * Returns an empty function if some of the visible templates do not
+	 * support this (cf. Template::concurrentDrawFunction()).
+	 */
+	TemplatesDrawFunction concurrentTemplatesDrawFunction(int first_template, int last_template,
+	                                                      const MapView* view, bool on_screen) const;
+	
 	
 	/**
 	 * Updates the renderables and extent of all objects which have changed.
@@ -1004,6 +1031,15 @@ public:
 	/** Forces an update of all objects, i.e. calls update(true) on each map object. */
 	void updateAllObjects();
 	
+	/**
+	 * Forces an update of all objects, like updateAllObjects(), but generates
+	 * the renderables of path and point objects in multiple threads.
+	 * 
+	 * The prepared output is published to the map from the calling thread,
+	 * without generating it again.
+	 */
+	void updateAllObjectsConcurrently();
+	
 	/** Forces an update of all objects with the given symbol. */
 	void updateAllObjectsWithSymbol(const Symbol* symbol);
 	
@@ -1036,6 +1072,20 @@ public:
 	 */
 	void insertRenderablesOfObject(const Object* object);
 	
+	/**
+	 * Updates the spatial index entry of the given object in its map part.
+	 * 
+	 * This is called by Object::update() when the extent may have changed.
+	 */
+	void updateObjectIndex(const Object* object);
+	
+	/**
+	 * Marks the spatial index entry of the given object as outdated.
+	 * 
+	 * This is called when the object's output becomes dirty.
+	 */
+	void invalidateObjectIndex(const Object* object);
+	
 	
 	/**
 	 * Marks an object as irregular.
@@ -1117,9 +1167,12 @@ public:
 	 *     Of the selection renderables. TODO: HACK
 	 * @param draw_normal If set to true, draws the objects like normal objects,
 	 *     otherwise draws transparent highlights.
+	 * @param transform A transformation to be applied to the renderables,
+	 *     in map coordinates.
 	 */
 	void drawSelection(QPainter* painter, bool force_min_size, MapWidget* widget,
-		MapRenderables* replacement_renderables = nullptr, bool draw_normal = false);
+		MapRenderables* replacement_renderables = nullptr, bool draw_normal = false,
+		const QTransform& transform = {});
 	
 	/**
 	 * Adds the given object to the selection.
@@ -1605,6 +1658,8 @@ private:
 	
 	QScopedPointer<MapPrinterConfig> printer_config;
 	
+	mutable QScopedPointer<XmlObjectCache> xml_object_cache;
+	
 	bool image_template_use_meters_per_pixel;
 	double image_template_meters_per_pixel;
 	double image_template_dpi;
@@ -467,6 +467,15 @@ public:
 	
 	static MapCoord load(const QPointF& p, int flags) = delete;
 	
+	/** Creates a MapCoord from raw native coordinates, with offset handling.
+	 * 
+	 * This is the counterpiece to nativeX() and nativeY() for binary encodings.
+	 * This will initialize the boundsOffset() if necessary. Otherwise it will
+	 * apply the BoundsOffset() and throw a std::range_error if the adjusted
+	 * coordinates are out of bounds for qint32.
+	 */
+	static MapCoord loadNative(qint64 x64, qint64 y64, MapCoord::Flags flags);
+	
 	
 	friend constexpr bool operator==(const MapCoord& lhs, const MapCoord& rhs);
 	friend constexpr MapCoord operator+(const MapCoord& lhs, const MapCoord& rhs);
@@ -22,11 +22,14 @@
 #include "map_part.h"
 
 #include <algorithm>
+#include <cmath>
 #include <iterator>
+#include <limits>
 
 #include <QtGlobal>
 #include <QLatin1String>
 #include <QObject>
+#include <QPointF>
 #include <QStringRef>
 #include <QTransform>
 #include <QXmlStreamReader>
@@ -53,6 +56,36 @@ namespace literal
 
 namespace OpenOrienteering {
 
+namespace {
+
+/**
+ * Returns the rectangle which is used for an object in the spatial index.
+ * 
+ * In addition to the extent, this covers the coordinates of paths and points,
+ * so that the index returns a superset of the objects matched by the exact
+ * tests in the find functions.
+ */
+QRectF indexExtent(const Object* object)
+{
+	auto extent = object->getExtent();
+	if (object->getType() != Object::Text)
+	{
+		for (auto const& coord : object->getRawCoordinateVector())
+			rectIncludeSafe(extent, QPointF(coord));
+	}
+	if (!extent.isValid())
+	{
+		// Without a location, the object is a candidate for any query.
+		auto const max = qreal(std::numeric_limits<float>::max());
+		extent = QRectF(QPointF(-max, -max), QPointF(max, max));
+	}
+	return extent;
+}
+
+}  // namespace
+
+
+
 MapPart::MapPart(const QString& name, Map* map)
 : name(name)
 , map(map)
@@ -113,7 +146,12 @@ MapPart* MapPart::load(QXmlStreamReader& xml, Map& map, SymbolDictionary& symbol
 			while (xml.readNextStartElement())
 			{
 				if (xml.name() == literal::object)
+				{
+					// The object's output is generated lazily, so the index entry is, too.
 					part->objects.push_back(Object::load(xml, &map, symbol_dict));
+					part->stale_objects.insert(part->objects.back());
+					part->sequenceObject(part->objects.size() - 1);
+				}
 				else
 					xml.skipCurrentElement(); // unknown
 			}
@@ -146,12 +184,19 @@ int MapPart::findObjectIndex(const Object* object) const
 void MapPart::setObject(Object* object, int pos, bool delete_old)
 {
 	map->removeRenderablesOfObject(objects[pos], true);
+	object_index.remove(objects[pos]);
+	stale_objects.erase(objects[pos]);
+	auto sequence = object_sequence.find(objects[pos]);
+	auto const sequence_number = sequence->second;
+	object_sequence.erase(sequence);
 	if (delete_old)
 		delete objects[pos];
 	
 	objects[pos] = object;
+	object_sequence[object] = sequence_number;
 	object->setMap(map);
 	object->update();
+	indexObject(object);
 	map->setObjectsDirty(); // TODO: remove from here, dirty state handling should be separate
 }
 
@@ -163,8 +208,10 @@ void MapPart::addObject(Object* object)
 void MapPart::addObject(Object* object, int pos)
 {
 	objects.insert(objects.begin() + pos, object);
+	sequenceObject(std::size_t(pos));
 	object->setMap(map);
 	object->update();
+	indexObject(object);
 	
 	if (objects.size() == 1 && map->getNumObjects() == 1)
 		map->updateAllMapWidgets();
@@ -188,6 +235,9 @@ Object* MapPart::releaseObject(int pos)
 	map->removeRenderablesOfObject(objects[pos], true);
 	auto object_to_return = objects[pos];
 	objects.erase(objects.begin() + pos);
+	object_index.remove(object_to_return);
+	stale_objects.erase(object_to_return);
+	object_sequence.erase(object_to_return);
 	
 	if (objects.empty() && map->getNumObjects() == 0)
 		map->updateAllMapWidgets();
@@ -227,8 +277,10 @@ std::unique_ptr<UndoStep> MapPart::importPart(const MapPart* other, const QHash<
 		new_object->transform(transform);
 		
 		objects.push_back(new_object);
+		sequenceObject(objects.size() - 1);
 		new_object->setMap(map);
 		new_object->update();
+		indexObject(new_object);
 		
 		undo_step->addObject((int)objects.size() - 1);
 		if (select_new_objects)
@@ -257,14 +309,17 @@ void MapPart::findObjectsAt(
         bool include_protected_objects,
         SelectionInfoVector& out ) const
 {
-	for (Object* object : objects)
+	// Point objects are tested against the squared tolerance.
+	auto const margin = std::max(tolerance, std::sqrt(tolerance));
+	ObjectList candidates;
+	queryObjectIndex(QRectF(coord.x() - margin, coord.y() - margin, 2 * margin, 2 * margin), candidates);
+	for (Object* object : candidates)
 	{
 		if (!include_hidden_objects && object->getSymbol()->isHidden())
 			continue;
 		if (!include_protected_objects && object->getSymbol()->isProtected())
 			continue;
 		
-		object->update();
 		int selected_type = object->isPointOnObject(coord, tolerance, treat_areas_as_paths, extended_selection);
 		if (selected_type != (int)Symbol::NoSymbol)
 			out.emplace_back(selected_type, object);
@@ -279,14 +334,15 @@ void MapPart::findObjectsAtBox(
         std::vector< Object* >& out ) const
 {
 	auto rect = QRectF(corner1, corner2).normalized();
-	for (Object* object : objects)
+	ObjectList candidates;
+	queryObjectIndex(rect, candidates);
+	for (Object* object : candidates)
 	{
 		if (!include_hidden_objects && object->getSymbol()->isHidden())
 			continue;
 		if (!include_protected_objects && object->getSymbol()->isProtected())
 			continue;
 		
-		object->update();
 		if (rect.intersects(object->getExtent()) && object->intersectsBox(rect))
 			out.push_back(object);
 	}
@@ -295,17 +351,93 @@ void MapPart::findObjectsAtBox(
 int MapPart::countObjectsInRect(const QRectF& map_coord_rect, bool include_hidden_objects) const
 {
 	int count = 0;
-	for (const Object* object : objects)
-	{
+	updateStaleObjects();
+	object_index.query(map_coord_rect, [&](const Object* object) {
 		if (object->getSymbol()->isHidden() && !include_hidden_objects)
-			continue;
-		object->update();
+			return;
 		if (object->getExtent().intersects(map_coord_rect))
 			++count;
-	}
+	});
 	return count;
 }
 
+
+bool MapPart::updateObjectIndex(const Object* object) const
+{
+	auto* key = const_cast<Object*>(object);
+	if (stale_objects.erase(key) || object_index.contains(key))
+	{
+		object_index.insert(key, indexExtent(object));
+		return true;
+	}
+	return object_sequence.count(object) > 0;
+}
+
+bool MapPart::invalidateObjectIndex(const Object* object) const
+{
+	auto* key = const_cast<Object*>(object);
+	if (object_index.contains(key))
+	{
+		stale_objects.insert(key);
+		return true;
+	}
+	return object_sequence.count(object) > 0;
+}
+
+void MapPart::indexObject(Object* object) const
+{
+	stale_objects.erase(object);
+	object_index.insert(object, indexExtent(object));
+}
+
+void MapPart::updateStaleObjects() const
+{
+	if (stale_objects.empty())
+		return;
+	
+	auto stale = std::unordered_set<Object*>();
+	stale.swap(stale_objects);
+	for (auto* object : stale)
+	{
+		object->update();
+		indexObject(object);
+	}
+}
+
+void MapPart::sequenceObject(std::size_t pos)
+{
+	constexpr auto step = std::uint64_t(1) << 16;
+	
+	auto const previous = pos > 0 ? object_sequence[objects[pos - 1]] : 0;
+	auto const next = pos + 1 < objects.size() ? object_sequence[objects[pos + 1]] : previous + 2 * step;
+	if (next - previous > 1)
+	{
+		object_sequence[objects[pos]] = previous + (next - previous) / 2;
+		return;
+	}
+	
+	// No gap left: Renumber all objects.
+	auto sequence_number = std::uint64_t(0);
+	for (const auto* object : objects)
+	{
+		sequence_number += step;
+		object_sequence[object] = sequence_number;
+	}
+}
+
+void MapPart::queryObjectIndex(const QRectF& rect, ObjectList& out) const
+{
+	updateStaleObjects();
+	object_index.query(rect, out);
+	if (out.size() > 1)
+	{
+		// Restore the order of the objects in this part.
+		std::sort(begin(out), end(out), [this](const Object* a, const Object* b) {
+			return object_sequence.at(a) < object_sequence.at(b);
+		});
+	}
+}
+
 QRectF MapPart::calculateExtent(bool include_helper_symbols) const
 {
 	QRectF rect;
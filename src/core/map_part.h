@@ -23,8 +23,11 @@
 #define OPENORIENTEERING_MAP_PART_H
 
 #include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <memory>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 #include <utility>
 
@@ -32,6 +35,8 @@
 #include <QRectF>
 #include <QString>
 
+#include "core/spatial_index.h"
+
 class QIODevice;
 class QTransform;
 class QXmlStreamReader;
@@ -213,6 +218,25 @@ public:
 	 */
 	int countObjectsInRect(const QRectF& map_coord_rect, bool include_hidden_objects) const;
 	
+	/**
+	 * Updates the spatial index entry of the given object from its extent.
+	 * 
+	 * Does nothing if the object is not contained in this part.
+	 * Returns true if the object is contained in this part.
+	 * This is called from Object::update().
+	 */
+	bool updateObjectIndex(const Object* object) const;
+	
+	/**
+	 * Marks the spatial index entry of the given object as outdated.
+	 * 
+	 * Outdated objects are updated before the next spatial query.
+	 * Does nothing if the object is not contained in this part.
+	 * Returns true if the object is contained in this part.
+	 * This is called when an object's output becomes dirty.
+	 */
+	bool invalidateObjectIndex(const Object* object) const;
+	
 	/**
 	 * Calculates and returns the bounding box of all objects in this map part.
 	 */
@@ -265,9 +289,35 @@ public:
 	
 private:
 	typedef std::vector<Object*> ObjectList;
-
+	
+	/**
+	 * Adds the object to the spatial index, using its current extent.
+	 */
+	void indexObject(Object* object) const;
+	
+	/**
+	 * Updates the outdated entries of the spatial index.
+	 */
+	void updateStaleObjects() const;
+	
+	/**
+	 * Assigns a sequence number to the object at the given position.
+	 * 
+	 * Sequence numbers increase with the position in the part. They are left
+	 * with gaps so that most insertions do not need to renumber the objects.
+	 */
+	void sequenceObject(std::size_t pos);
+	
+	/**
+	 * Collects the index candidates for the given rect, in the order of the part.
+	 */
+	void queryObjectIndex(const QRectF& rect, ObjectList& out) const;
+	
 	QString name;
-	ObjectList objects;  ///< @todo This could be a spatial representation optimized for quick access
+	ObjectList objects;
+	mutable SpatialIndex<Object*> object_index;       ///< Spatial index of the object extents
+	mutable std::unordered_set<Object*> stale_objects;  ///< Objects with outdated index entries
+	std::unordered_map<const Object*, std::uint64_t> object_sequence;  ///< Order of the objects for index queries
 	Map* const map;
 };
 
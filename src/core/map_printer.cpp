@@ -21,8 +21,11 @@
 
 #include "map_printer.h"
 
+#include <algorithm>
 #include <cmath>
 #include <cstddef>
+#include <utility>
+#include <vector>
 
 #include <Qt>
 #include <QtMath>
@@ -41,6 +44,7 @@
 #include <QRgb>
 #include <QSize>
 #include <QStringRef>
+#include <QThread>
 #include <QTransform>
 #include <QXmlStreamReader>
 
@@ -61,6 +65,7 @@
 #include "core/map_view.h"
 #include "core/renderables/renderable.h"
 #include "templates/template.h"
+#include "util/concurrency.h"
 #include "util/xml_stream_util.h"
 
 
@@ -100,6 +105,13 @@ namespace literal {
 }  // namespace literal
 
 
+/// The minimum height of image stripes which are drawn concurrently, in pixels.
+constexpr std::size_t min_stripe_height = 128;
+
+/// The maximum memory for the page buffers which are drawn concurrently, in bytes.
+constexpr qint64 max_concurrent_page_buffers_size = qint64(512) << 20;
+
+
 }  // namespace
 
 
@@ -944,7 +956,7 @@ void MapPrinter::takePrinterSettings(const QPrinter* printer)
 }
 
 
-void MapPrinter::drawPage(QPainter* device_painter, const QRectF& page_extent, QImage* page_buffer) const
+QTransform MapPrinter::pageTransform(const QRectF& page_extent) const
 {
 	// Determine transformation and clipping for page extent and region
 	const qreal units_per_mm = options.resolution / 25.4;
@@ -955,10 +967,42 @@ void MapPrinter::drawPage(QPainter* device_painter, const QRectF& page_extent, Q
 	transform.scale(scale_adjustment, scale_adjustment);
 	// Translate and clip for margins and print area
 	transform.translate(-page_extent.left(), -page_extent.top());
-	drawPage(device_painter, page_extent, transform, page_buffer);
+	return transform;
+}
+
+QSize MapPrinter::pageBufferSize(const QPainter* device_painter) const
+{
+	const qreal units_per_mm = options.resolution / 25.4;
+	int w = qCeil(page_format.paper_dimensions.width() * units_per_mm);
+	int h = qCeil(page_format.paper_dimensions.height() * units_per_mm);
+#if defined (Q_OS_MACOS)
+	if (device_painter->device()->physicalDpiX() == 0)
+	{
+		// Possible Qt bug, since according to QPaintDevice documentation,
+		// "if the physicalDpiX() doesn't equal the logicalDpiX(),
+		// the corresponding QPaintEngine must handle the resolution mapping"
+		// which doesn't seem to happen here.
+		qreal corr = device_painter->device()->logicalDpiX() / 72.0;
+		w = qCeil(page_format.paper_dimensions.width() * units_per_mm * corr);
+		h = qCeil(page_format.paper_dimensions.height() * units_per_mm * corr);
+	}
+#else
+	Q_UNUSED(device_painter)
+#endif
+	return { w, h };
+}
+
+void MapPrinter::drawPage(QPainter* device_painter, const QRectF& page_extent, QImage* page_buffer) const
+{
+	drawPage(device_painter, page_extent, pageTransform(page_extent), page_buffer);
 }
 
 void MapPrinter::drawPage(QPainter* device_painter, const QRectF& page_extent, const QTransform& page_extent_transform, QImage* page_buffer) const
+{
+	drawPage(device_painter, page_extent, page_extent_transform, page_buffer, nullptr);
+}
+
+void MapPrinter::drawPage(QPainter* device_painter, const QRectF& page_extent, const QTransform& page_extent_transform, QImage* page_buffer, const TemplateDrawFunctions* templates) const
 {
 	// Logical units per mm
 	const qreal units_per_mm = options.resolution / 25.4;
@@ -970,6 +1014,16 @@ void MapPrinter::drawPage(QPainter* device_painter, const QRectF& page_extent, c
 	
 	const auto page_region_used = page_extent.intersected(print_area);
 	
+	auto draw_templates = [this, templates](QPainter* painter, const QRectF& bounding_box, int first_template, int last_template) {
+		if (!templates)
+		{
+			map.drawTemplates(painter, bounding_box, first_template, last_template, view, false);
+			return;
+		}
+		for (int i = first_template; i <= last_template; ++i)
+			(*templates)[std::size_t(i)](painter, bounding_box);
+	};
+	
 	
 	/*
 	 * Analyse need for page buffer
@@ -1023,22 +1077,7 @@ void MapPrinter::drawPage(QPainter* device_painter, const QRectF& page_extent, c
 	QPainter local_page_painter;
 	if (use_page_buffer && !page_buffer)
 	{
-		int w = qCeil(page_format.paper_dimensions.width() * units_per_mm);
-		int h = qCeil(page_format.paper_dimensions.height() * units_per_mm);
-#if defined (Q_OS_MACOS)
-		if (device_painter->device()->physicalDpiX() == 0)
-		{
-			// Possible Qt bug, since according to QPaintDevice documentation,
-			// "if the physicalDpiX() doesn't equal the logicalDpiX(),
-			// the corresponding QPaintEngine must handle the resolution mapping"
-			// which doesn't seem to happen here.
-			qreal corr = device_painter->device()->logicalDpiX() / 72.0;
-			w = qCeil(page_format.paper_dimensions.width() * units_per_mm * corr);
-			h = qCeil(page_format.paper_dimensions.height() * units_per_mm * corr);
-		}
-#endif
-		
-		local_page_buffer = QImage(w, h, QImage::Format_RGB32);
+		local_page_buffer = QImage(pageBufferSize(device_painter), QImage::Format_RGB32);
 		if (local_page_buffer.isNull())
 		{
 			// Allocation failed
@@ -1064,7 +1103,7 @@ void MapPrinter::drawPage(QPainter* device_painter, const QRectF& page_extent, c
 		page_painter->setTransform(page_extent_transform, /*combine*/ true);
 		page_painter->setClipRect(page_region_used, Qt::ReplaceClip);
 		
-		map.drawTemplates(page_painter, page_region_used, 0, first_front_template - 1, view, false);
+		draw_templates(page_painter, page_region_used, 0, first_front_template - 1);
 		
 		page_painter->restore();
 	}
@@ -1203,7 +1242,7 @@ void MapPrinter::drawPage(QPainter* device_painter, const QRectF& page_extent, c
 		painter->setTransform(page_extent_transform, /*combine*/ true);
 		painter->setClipRect(page_region_used, Qt::ReplaceClip);
 		
-		map.drawTemplates(painter, page_region_used, first_front_template, map.getNumTemplates() - 1, view, false);
+		draw_templates(painter, page_region_used, first_front_template, map.getNumTemplates() - 1);
 		
 		if (local_buffer_painter.isActive())
 		{
@@ -1236,6 +1275,68 @@ void MapPrinter::drawPage(QPainter* device_painter, const QRectF& page_extent, c
 	device_painter->setRenderHints(saved_hints);
 }
 
+MapPrinter::PageDrawFunction MapPrinter::concurrentPageDrawFunction() const
+{
+	// Separations are drawn directly to the printer, and the overprinting
+	// simulation uses buffers which are shared by the map's renderables.
+	if (separationsModeSelected()
+	    || (rasterModeSelected() && options.simulate_overprinting))
+	{
+		return {};
+	}
+	
+	TemplateDrawFunctions templates;
+	if (options.show_templates)
+	{
+		templates.reserve(std::size_t(map.getNumTemplates()));
+		for (int i = 0; i < map.getNumTemplates(); ++i)
+		{
+			auto draw = map.concurrentTemplatesDrawFunction(i, i, view, false);
+			if (!draw)
+				return {};
+			templates.push_back(std::move(draw));
+		}
+	}
+	
+	// Drawing the map from other threads must not update any objects.
+	map.updateObjects();
+	
+	return [this, templates](QPainter* device_painter, const QRectF& page_extent, const QTransform& page_extent_transform, QImage* page_buffer) {
+		drawPage(device_painter, page_extent, page_extent_transform, page_buffer, &templates);
+	};
+}
+
+void MapPrinter::drawPageToImage(QImage& image, const QRectF& page_extent) const
+{
+	auto const transform = pageTransform(page_extent);
+	auto const draw_page = concurrentPageDrawFunction();
+	if (!draw_page)
+	{
+		QPainter painter(&image);
+		drawPage(&painter, page_extent, transform, &image);
+		return;
+	}
+	
+	// Each stripe is drawn to an image which shares the memory of the target
+	// image. Neighbouring stripes are included in the clip region, so that
+	// there are no antialiasing artifacts at the borders of the stripes.
+	auto* const bits = image.bits();
+	auto const bytes_per_line = image.bytesPerLine();
+	auto const inverted_transform = transform.inverted();
+	auto const margin = 2;  // pixels
+	Util::forEachRangeConcurrently(std::size_t(image.height()), [&](std::size_t first, std::size_t last) {
+		auto const top = int(first);
+		auto const height = int(last - first);
+		QImage stripe(bits + top * bytes_per_line, image.width(), height, bytes_per_line, image.format());
+		stripe.setDotsPerMeterX(image.dotsPerMeterX());
+		stripe.setDotsPerMeterY(image.dotsPerMeterY());
+		auto const stripe_extent = inverted_transform.mapRect(QRectF(0, top - margin, image.width(), height + 2 * margin))
+		                           .intersected(page_extent);
+		QPainter painter(&stripe);
+		draw_page(&painter, stripe_extent, transform * QTransform::fromTranslate(0, -top), &stripe);
+	}, min_stripe_height);
+}
+
 void MapPrinter::drawSeparationPages(QPrinter* printer, QPainter* device_painter, const QRectF& page_extent) const
 {
 	Q_ASSERT(printer->colorMode() == QPrinter::GrayScale);
@@ -1355,47 +1456,58 @@ bool MapPrinter::printMap(QPrinter* printer)
 	auto message = message_template.arg(1);
 	emit printProgress(0, message);
 	
-	bool need_new_page = false;
-	for (auto vpos : v_page_pos)
+	// Raster mode pages may be rendered concurrently.
+	auto const draw_page = (rasterModeSelected() && printer->outputFormat() == QPrinter::PdfFormat)
+	                       ? concurrentPageDrawFunction()
+	                       : PageDrawFunction();
+	if (draw_page)
 	{
-		if (!painter.isActive())
-		{
-			break;
-		}
-		
-		for (auto hpos : h_page_pos)
+		printPagesConcurrently(printer, painter, draw_page, message_template);
+	}
+	else
+	{
+		bool need_new_page = false;
+		for (auto vpos : v_page_pos)
 		{
 			if (!painter.isActive())
 			{
 				break;
 			}
 			
-			++step;
-			auto progress = qMin(99, qMax(1, int((100 * static_cast<decltype(num_steps)>(step) - 50) / num_steps)));
-			emit printProgress(progress, message_template.arg(step));
-			
-			if (cancel_print_map) /* during printProgress handling */
+			for (auto hpos : h_page_pos)
 			{
-				painter.end();
-				break;
-			}
+				if (!painter.isActive())
+				{
+					break;
+				}
 				
-			if (need_new_page)
-			{
-				printer->newPage();
-			}
-			
-			QRectF page_extent = QRectF(QPointF(hpos, vpos), extent_size);
-			if (separationsModeSelected())
-			{
-				drawSeparationPages(printer, &painter, page_extent);
-			}
-			else
-			{
-				drawPage(&painter, page_extent);
+				++step;
+				auto progress = qMin(99, qMax(1, int((100 * static_cast<decltype(num_steps)>(step) - 50) / num_steps)));
+				emit printProgress(progress, message_template.arg(step));
+				
+				if (cancel_print_map) /* during printProgress handling */
+				{
+					painter.end();
+					break;
+				}
+					
+				if (need_new_page)
+				{
+					printer->newPage();
+				}
+				
+				QRectF page_extent = QRectF(QPointF(hpos, vpos), extent_size);
+				if (separationsModeSelected())
+				{
+					drawSeparationPages(printer, &painter, page_extent);
+				}
+				else
+				{
+					drawPage(&painter, page_extent);
+				}
+				
+				need_new_page = true;
 			}
-			
-			need_new_page = true;
 		}
 	}
 	
@@ -1415,6 +1527,81 @@ bool MapPrinter::printMap(QPrinter* printer)
 	return true;
 }
 
+void MapPrinter::printPagesConcurrently(QPrinter* printer, QPainter& painter, const PageDrawFunction& draw_page, const QString& message_template)
+{
+	QSizeF extent_size = page_format.page_rect.size() / scale_adjustment;
+	std::vector<QRectF> page_extents;
+	page_extents.reserve(v_page_pos.size() * h_page_pos.size());
+	for (auto vpos : v_page_pos)
+	{
+		for (auto hpos : h_page_pos)
+			page_extents.emplace_back(QPointF(hpos, vpos), extent_size);
+	}
+	
+	// Pages are rendered in batches, and printed in order.
+	// The batch size is limited by the memory needed for the page buffers.
+	auto const num_steps = page_extents.size();
+	auto const buffer_size = pageBufferSize(&painter);
+	auto const buffer_bytes = std::max(qint64(1), qint64(buffer_size.width()) * buffer_size.height() * 4);
+	auto const batch_size = std::size_t(qBound(qint64(1), max_concurrent_page_buffers_size / buffer_bytes, qint64(QThread::idealThreadCount())));
+	std::vector<QImage> page_buffers(std::min(batch_size, num_steps));
+	bool need_new_page = false;
+	for (std::size_t batch_start = 0; batch_start < num_steps && painter.isActive(); batch_start += batch_size)
+	{
+		auto const batch_end = std::min(batch_start + batch_size, num_steps);
+		Util::forEachRangeConcurrently(batch_end - batch_start, [&](std::size_t first, std::size_t last) {
+			for (auto i = first; i < last; ++i)
+			{
+				auto& page_buffer = page_buffers[i];
+				if (page_buffer.isNull())
+					page_buffer = QImage(buffer_size, QImage::Format_RGB32);
+				if (page_buffer.isNull())
+					continue;  // Allocation failed
+				
+				page_buffer.fill(QColor(Qt::white));
+				auto const& page_extent = page_extents[batch_start + i];
+				QPainter page_painter(&page_buffer);
+				draw_page(&page_painter, page_extent, pageTransform(page_extent), &page_buffer);
+			}
+		}, 1);
+		
+		for (auto step = batch_start + 1; step <= batch_end; ++step)
+		{
+			auto progress = qMin(99, qMax(1, int((100 * step - 50) / num_steps)));
+			emit printProgress(progress, message_template.arg(step));
+			
+			if (cancel_print_map) // during printProgress handling
+			{
+				painter.end();
+				break;
+			}
+			
+			if (need_new_page)
+			{
+				printer->newPage();
+			}
+			
+			auto const& page_buffer = page_buffers[step - 1 - batch_start];
+			if (page_buffer.isNull())
+			{
+				// Allocation failed: Draw this page without concurrency.
+				drawPage(&painter, page_extents[step - 1]);
+				if (!painter.isActive())
+					break;
+			}
+			else
+			{
+				const auto saved_hints = painter.renderHints();
+				painter.setRenderHint(QPainter::SmoothPixmapTransform, false);
+				painter.drawImage(0, 0, page_buffer);
+				painter.setRenderHints(saved_hints);
+			}
+			
+			need_new_page = true;
+		}
+	}
+}
+
 void MapPrinter::cancelPrintMap()
 {
 	cancel_print_map = true;
@@ -22,6 +22,7 @@
 #ifndef OPENORIENTEERING_MAP_PRINTER_H
 #define OPENORIENTEERING_MAP_PRINTER_H
 
+#include <functional>
 #include <memory>
 #include <vector>
 
@@ -45,6 +46,7 @@ class QImage;
 class QPainter;
 class QPrinter;
 class QRectF;
+class QSize;
 class QSizeF;
 class QXmlStreamReader;
 class QXmlStreamWriter;
@@ -371,6 +373,34 @@ public:
 	
 	void drawPage(QPainter* device_painter, const QRectF& page_extent, const QTransform& page_extent_transform, QImage* page_buffer = nullptr) const;
 	
+	/**
+	 * A function which draws a page like drawPage().
+	 */
+	using PageDrawFunction = std::function<void (QPainter* device_painter, const QRectF& page_extent, const QTransform& page_extent_transform, QImage* page_buffer)>;
+	
+	/**
+	 * Returns a function which draws pages like drawPage(), but which may be
+	 * called from multiple threads at the same time.
+	 * 
+	 * The device painters must paint on QImages which are passed as
+	 * page_buffer. The function refers to this map printer and to the map,
+	 * so they must not be modified while the function is in use.
+	 * 
+	 * Returns an empty function if the current configuration does not support
+	 * this, e.g. for separations, for the overprinting simulation in raster
+	 * mode, or for visible templates which can be drawn only by
+	 * Template::drawTemplate() (cf. Map::concurrentTemplatesDrawFunction()).
+	 */
+	PageDrawFunction concurrentPageDrawFunction() const;
+	
+	/**
+	 * Draws a single page to an image.
+	 * 
+	 * This is equivalent to drawPage(&painter, page_extent, &image), but
+	 * horizontal stripes of the image are drawn concurrently when possible.
+	 */
+	void drawPageToImage(QImage& image, const QRectF& page_extent) const;
+	
 	/** Draws the separations as distinct pages to the printer. */
 	void drawSeparationPages(QPrinter* printer, QPainter* device_painter, const QRectF& page_extent) const;
 	
@@ -484,6 +514,21 @@ protected:
 	/** Updates the scale adjustment and page breaks. */
 	void mapScaleChanged();
 	
+	/** Returns the transformation from map coordinates to the page. */
+	QTransform pageTransform(const QRectF& page_extent) const;
+	
+	/** Returns the size of a raster buffer for a page on the given device. */
+	QSize pageBufferSize(const QPainter* device_painter) const;
+	
+	/** Draws the pages in raster mode, rendering multiple pages concurrently. */
+	void printPagesConcurrently(QPrinter* printer, QPainter& painter, const PageDrawFunction& draw_page, const QString& message_template);
+	
+	/** Functions for drawing each template, cf. Map::concurrentTemplatesDrawFunction(). */
+	using TemplateDrawFunctions = std::vector<std::function<void (QPainter* painter, const QRectF& bounding_box)>>;
+	
+	/** Draws a single page, optionally drawing templates by the given functions. */
+	void drawPage(QPainter* device_painter, const QRectF& page_extent, const QTransform& page_extent_transform, QImage* page_buffer, const TemplateDrawFunctions* templates) const;
+	
 	Map& map;
 	const MapView* view;
 	const QPrinterInfo* target = nullptr;
@@ -22,6 +22,7 @@
 #include "object.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cmath>
 #include <cstddef>
 #include <iterator>
@@ -82,11 +83,26 @@ namespace literal
 
 namespace OpenOrienteering {
 
+namespace {
+
+/// The last revision which was assigned to an object.
+std::atomic<quint64> last_revision{0};
+
+quint64 nextRevision() noexcept
+{
+	return ++last_revision;
+}
+
+}  // namespace
+
+
+
 // ### Object implementation ###
 
 Object::Object(Object::Type type, const Symbol* symbol)
 : type(type)
 , symbol(symbol)
+, object_revision(nextRevision())
 , output(*this)
 {
 	// nothing
@@ -97,6 +113,7 @@ Object::Object(Object::Type type, const Symbol* symbol, MapCoordVector coords, M
 , symbol(symbol)
 , coords(std::move(coords))
 , map(map)
+, object_revision(nextRevision())
 , output(*this)
 {
 	// nothing
@@ -108,6 +125,7 @@ Object::Object(const Object& proto)
  , coords(proto.coords)
  , object_tags(proto.object_tags)
  , rotation(proto.rotation)
+ , object_revision(nextRevision())
  , extent(proto.extent)
  , output(*this)
 {
@@ -129,7 +147,7 @@ void Object::copyFrom(const Object& other)
 	rotation = other.rotation;
 	// map unchanged!
 	object_tags = other.object_tags;
-	output_dirty = true;
+	setOutputDirty();
 	extent = other.extent;
 }
 
@@ -280,7 +298,10 @@ void Object::save(QXmlStreamWriter& xml) const
 	{
 		// Scope of coords XML element
 		XmlElementWriter coords_element(xml, literal::coords);
-		coords_element.write(coords);
+		if (type == Path)
+			coords_element.writeCompact(coords);
+		else
+			coords_element.write(coords);
 	}
 	
 	if (type == Path)
@@ -473,7 +494,8 @@ void Object::setRotation(qreal new_rotation)
 
 void Object::forceUpdate() const
 {
-	output_dirty = true;
+	// Like any change, this discards output from prepareUpdate().
+	const_cast<Object*>(this)->setOutputDirty();
 	update();
 }
 
@@ -482,15 +504,35 @@ bool Object::update() const
 	if (!output_dirty)
 		return false;
 	
-	Symbol::RenderableOptions options = Symbol::RenderNormal;
+	if (!output_prepared)
+	{
+		if (map && extent.isValid())
+			map->setObjectAreaDirty(extent);
+		prepareUpdate();
+	}
+	output_prepared = false;
+	output_dirty = false;
+	
 	if (map)
 	{
-		options = QFlag(map->renderableOptions());
+		map->insertRenderablesOfObject(this);
+		map->updateObjectIndex(this);
 		if (extent.isValid())
 			map->setObjectAreaDirty(extent);
 	}
 	
-	output.deleteRenderables();
+	return true;
+}
+
+void Object::prepareUpdate() const
+{
+	Symbol::RenderableOptions options = Symbol::RenderNormal;
+	if (map)
+		options = QFlag(map->renderableOptions());
+	
+	// Replace the renderables instead of modifying them in place:
+	// They may still be in use by a MapRenderablesSnapshot.
+	output.takeRenderables();
 	
 	extent = QRectF();
 	
@@ -499,16 +541,20 @@ bool Object::update() const
 	createRenderables(output, options);
 	
 	Q_ASSERT(extent.right() < 60000000);	// assert if bogus values are returned
-	output_dirty = false;
-	
-	if (map)
+	output_prepared = true;
+	output_dirty = true;
+}
+
+void Object::setOutputDirty(bool dirty)
+{
+	if (dirty && !output_dirty && map)
+		map->invalidateObjectIndex(this);
+	output_dirty = dirty;
+	if (dirty)
 	{
-		map->insertRenderablesOfObject(this);
-		if (extent.isValid())
-			map->setObjectAreaDirty(extent);
+		output_prepared = false;
+		object_revision = nextRevision();
 	}
-	
-	return true;
 }
 
 void Object::updateEvent() const
@@ -695,6 +741,7 @@ void Object::setTags(const KeyValueContainer& tags)
 	if (object_tags != tags)
 	{
 		object_tags = tags;
+		object_revision = nextRevision();
 		if (map)
 		{
 			map->setObjectsDirty();
@@ -716,6 +763,7 @@ void Object::setTag(const QString& key, const QString& value)
 	if (it == object_tags.end() || it->value != value)
 	{
 		object_tags.insert_or_assign(it, key, value);
+		object_revision = nextRevision();
 		if (map)
 		{
 			map->setObjectsDirty();
@@ -731,6 +779,7 @@ void Object::removeTag(const QString& key)
 	if (it != object_tags.end())
 	{
 		object_tags.erase(it);
+		object_revision = nextRevision();
 		if (map)
 			map->setObjectsDirty();
 	}
@@ -3117,6 +3166,23 @@ void PathObject::assignCoordinates(const PathObject& proto, MapCoordVector::size
 	setOutputDirty();
 }
 
+void PathObject::replaceCoordinates(MapCoordVector::size_type index, MapCoordVector::size_type count,
+                                    MapCoordVector::const_iterator first, MapCoordVector::const_iterator last)
+{
+	Q_ASSERT(index + count <= coords.size());
+	
+	auto const size = MapCoordVector::size_type(std::distance(first, last));
+	auto const common = std::min(count, size);
+	auto const pos = coords.begin() + MapCoordVector::difference_type(index);
+	std::copy(first, first + MapCoordVector::difference_type(common), pos);
+	if (size > count)
+		coords.insert(pos + MapCoordVector::difference_type(common), first + MapCoordVector::difference_type(common), last);
+	else if (count > size)
+		coords.erase(pos + MapCoordVector::difference_type(common), pos + MapCoordVector::difference_type(count));
+	
+	recalculateParts();
+}
+
 void PathObject::updatePathCoords() const
 {
 	auto part_start = VirtualPath::size_type { 0 };
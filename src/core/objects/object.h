@@ -190,6 +190,19 @@ public:
 	 */
 	void forceUpdate() const;
 	
+	/**
+	 * Regenerates output and extent, but does not update the object's map.
+	 * 
+	 * This function does not modify shared state, so it may be called for
+	 * different objects in parallel, e.g. from worker threads. The prepared
+	 * output is published to the map by the next call to update(), which must
+	 * happen in the map's thread. Changing the object in between, or calling
+	 * forceUpdate(), discards the prepared output.
+	 * 
+	 * The caller is responsible for marking the old extent as dirty.
+	 */
+	void prepareUpdate() const;
+	
 	
 	/** Moves the whole object
 	 * @param dx X offset in native map coordinates.
@@ -268,6 +281,15 @@ public:
 	/** Returns if the object's output must be regenerated. */
 	bool isOutputDirty() const;
 	
+	/**
+	 * Returns a number which identifies the current state of the object.
+	 * 
+	 * The revision changes when the output is marked dirty, or when the tags
+	 * are changed. Revisions are unique across all objects, so they can be
+	 * used to validate cached data which is derived from objects.
+	 */
+	quint64 revision() const { return object_revision; }
+	
 	/**
 	 * Changes the object's symbol, returns if successful.
 	 * 
@@ -330,7 +352,9 @@ protected:
 	
 private:
 	qreal rotation = 0;               ///< The object's rotation (in radians).
+	quint64 object_revision;          ///< The object's revision, cf. revision().
 	mutable bool output_dirty = true; // does the output have to be re-generated because of changes?
+	mutable bool output_prepared = false; // was the output re-generated by prepareUpdate()?
 	mutable QRectF extent;            // only valid after calling update()
 	mutable ObjectRenderables output; // only valid after calling update()
 };
@@ -604,6 +628,17 @@ public:
 	 */
 	void assignCoordinates(const PathObject& proto, MapCoordVector::size_type first, MapCoordVector::size_type last);
 	
+	/**
+	 * Replaces a range of coordinates by the given coordinates.
+	 * 
+	 * Replaces count coordinates, beginning at index, and recalculates the
+	 * parts. Unlike setCoordinate(), this function takes the coordinates as
+	 * they are: It doesn't keep the first and last point of closed parts in
+	 * sync. This is meant for restoring a previous state, e.g. by undo steps.
+	 */
+	void replaceCoordinates(MapCoordVector::size_type index, MapCoordVector::size_type count,
+	                        MapCoordVector::const_iterator first, MapCoordVector::const_iterator last);
+	
 	
 	/** Finds the path part containing the given coord index. */
 	PathPartVector::const_iterator findPartForIndex(MapCoordVector::size_type coords_index) const;
@@ -1127,12 +1162,6 @@ const MapCoordVector& Object::getRawCoordinateVector() const
 	return coords;
 }
 
-inline
-void Object::setOutputDirty(bool dirty)
-{
-	output_dirty = dirty;
-}
-
 inline
 bool Object::isOutputDirty() const
 {
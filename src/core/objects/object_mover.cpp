@@ -183,6 +183,18 @@ void ObjectMover::move(qint32 dx, qint32 dy, HandleOpMode move_opposite_handles)
 }
 
 
+bool ObjectMover::movesObjectsOnly() const
+{
+	return points.empty() && text_handles.empty();
+}
+
+
+MapCoordF ObjectMover::offset() const
+{
+	return MapCoordF(MapCoord::fromNative(prev_drag_x, prev_drag_y));
+}
+
+
 ObjectMover::CoordIndexSet* ObjectMover::insertPointObject(PathObject* object)
 {
 	return &points.insert({object, CoordIndexSet()}).first->second;
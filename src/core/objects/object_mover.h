@@ -92,6 +92,12 @@ public:
 	/** Overload of move() taking delta values. */
 	void move(qint32 dx, qint32 dy, HandleOpMode move_opposite_handles);
 	
+	/** Returns true if only whole objects are moved, but no single points or handles. */
+	bool movesObjectsOnly() const;
+	
+	/** Returns the total offset of the moves to cursor positions. */
+	MapCoordF offset() const;
+	
 private:
 	using ObjectSet = std::unordered_set<Object*>;
 	using CoordIndexSet = std::unordered_set<MapCoordVector::size_type>;
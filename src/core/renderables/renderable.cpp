@@ -21,24 +21,29 @@
 #include "renderable.h"
 
 #include <algorithm>
+#include <cstddef>
 #include <iterator>
+#include <memory>
 #include <utility>
 
 #include <Qt>
 #include <QBrush>
 #include <QColor>
 #include <QImage>
+#include <QMutexLocker>
 #include <QPainter>
 #include <QPainterPath>
 #include <QPen>
+#include <QRect>
 #include <QRgb>
+#include <QThread>
 #include <QTransform>
 
-#include "core/image_transparency_fixup.h"
 #include "core/map_color.h"
 #include "core/map.h"
 #include "core/objects/object.h"
 #include "core/symbols/symbol.h"
+#include "util/concurrency.h"
 #include "util/util.h"
 
 #if defined(Q_OS_ANDROID) && defined(QT_PRINTSUPPORT_LIB)
@@ -153,6 +158,9 @@ void ObjectRenderables::draw(int map_color, const QColor& color, QPainter* paint
 	painter->save();
 	for (const auto& config_renderables : *(color_renderables->second))
 	{
+		if (config_renderables.second.empty())
+			continue;
+		
 		const PainterConfig& state = config_renderables.first;
 		if (!state.activate(painter, current_clip, config, color, initial_clip))
 			continue;
@@ -202,15 +210,39 @@ void ObjectRenderables::takeRenderables()
 	{
 		auto new_container = new SharedRenderables();
 		
-		// Pre-allocate as much space as in the original container
+		// Pre-allocate as much space as in the original container.
+		// Clip path keys refer to the old renderables and must not be copied.
 		for (const auto& renderables : *color.second)
 		{
-			(*new_container)[renderables.first].reserve(renderables.second.size());
+			if (!renderables.first.clip_path)
+				(*new_container)[renderables.first].reserve(renderables.second.size());
 		}
 		color.second = new_container;
 	}
 }
 
+bool ObjectRenderables::releaseRenderables(RenderableVector& out)
+{
+	for (const auto& color : *this)
+	{
+		for (const auto& renderables : *color.second)
+		{
+			if (renderables.first.clip_path && !renderables.second.empty())
+				return false;
+		}
+	}
+	
+	for (auto& color : *this)
+	{
+		for (auto& renderables : *color.second)
+		{
+			out.insert(out.end(), renderables.second.begin(), renderables.second.end());
+			renderables.second.clear();
+		}
+	}
+	return true;
+}
+
 void ObjectRenderables::deleteRenderables()
 {
 	for (auto& color : *this)
@@ -223,6 +255,80 @@ void ObjectRenderables::deleteRenderables()
 
 // ### MapRenderables ###
 
+namespace {
+
+/**
+ * Returns a QImage which shares the pixels of the given rect of the image.
+ */
+QImage imageSection(QImage& image, const QRect& rect)
+{
+	if (rect.isEmpty())
+		return {};
+	return QImage(image.scanLine(rect.top()) + rect.left() * 4,
+	              rect.width(), rect.height(), image.bytesPerLine(), image.format());
+}
+
+inline
+unsigned int div255(unsigned int value)
+{
+	return (value + (value >> 8) + 0x80) >> 8;
+}
+
+/**
+ * Multiplies a row of source pixels into the target pixels.
+ * 
+ * This gives the same result as QPainter::CompositionMode_Multiply
+ * followed by ImageTransparencyFixup. It is written without branches
+ * so that the compiler may vectorize it.
+ */
+void multiplyPixels(QRgb* target, const QRgb* source, int count)
+{
+	for (int i = 0; i < count; ++i)
+	{
+		auto const s = source[i];
+		auto const d = target[i];
+		auto const sa = qAlpha(s);
+		auto const da = qAlpha(d);
+		auto const multiply = [sa, da](unsigned int dst, unsigned int src) {
+			return div255(src * dst + src * (255 - da) + dst * (255 - sa));
+		};
+		auto const a = sa + da - div255(sa * da);
+		auto const r = multiply(qRed(d), qRed(s));
+		auto const g = multiply(qGreen(d), qGreen(s));
+		auto const b = multiply(qBlue(d), qBlue(s));
+		auto const result = (a << 24) | (r << 16) | (g << 8) | b;
+		target[i] = (result == 0x01000000) ? 0u : result;
+	}
+}
+
+/**
+ * Multiplies the source image into the target image of the same size,
+ * processing rows concurrently.
+ * 
+ * Both images must be of Format_ARGB32_Premultiplied.
+ */
+void multiplyImage(QImage& target, const QImage& source)
+{
+	Q_ASSERT(target.size() == source.size());
+	Q_ASSERT(target.format() == QImage::Format_ARGB32_Premultiplied);
+	Q_ASSERT(source.format() == QImage::Format_ARGB32_Premultiplied);
+	// Non-const QImage functions must not be called concurrently.
+	auto* const bits = target.bits();
+	auto const bytes_per_line = std::size_t(target.bytesPerLine());
+	auto const width = target.width();
+	Util::forEachRangeConcurrently(std::size_t(target.height()), [&](std::size_t first, std::size_t last) {
+		for (auto y = first; y < last; ++y)
+		{
+			multiplyPixels(reinterpret_cast<QRgb*>(bits + y * bytes_per_line),
+			               reinterpret_cast<const QRgb*>(source.constScanLine(int(y))),
+			               width);
+		}
+	}, 64);
+}
+
+}  // namespace
+
+
 void MapRenderables::ObjectDeleter::operator()(Object* object) const
 {
 	renderables.removeRenderablesOfObject(object, false);
@@ -235,16 +341,44 @@ MapRenderables::MapRenderables(Map* map)
 	; // nothing
 }
 
-void MapRenderables::draw(QPainter *painter, const RenderConfig &config) const
+void MapRenderables::collectObjects(int color_priority, const ObjectRenderablesMap& objects, const QRectF& rect, std::vector<const ObjectRenderablesItem*>& out) const
 {
-	// TODO: improve performance by using some spatial acceleration structure?
+	out.clear();
+	
+	auto const index = color_indexes.find(color_priority);
+	if (index != color_indexes.end())
+	{
+		std::vector<const Object*> candidates;
+		index->second.query(rect, candidates);
+		// When most objects are candidates, plain iteration is faster than lookup.
+		if (candidates.size() < objects.size() / 4)
+		{
+			std::sort(begin(candidates), end(candidates));
+			out.reserve(candidates.size());
+			for (const auto* object : candidates)
+			{
+				auto const item = objects.find(object);
+				if (item != objects.end())
+					out.push_back(&*item);
+			}
+			return;
+		}
+	}
 	
+	out.reserve(objects.size());
+	for (const auto& item : objects)
+		out.push_back(&item);
+}
+
+void MapRenderables::draw(QPainter *painter, const RenderConfig &config) const
+{
 #ifdef Q_OS_ANDROID
 	const qreal min_dimension = 1.0/config.scaling;
 #endif
 	
 	QPainterPath initial_clip = painter->clipPath();
 	const QPainterPath* current_clip = nullptr;
+	std::vector<const ObjectRenderablesItem*> objects;
 	
 	painter->save();
 	auto end_of_colors = rend();
@@ -261,20 +395,25 @@ void MapRenderables::draw(QPainter *painter, const RenderConfig &config) const
 			continue;
 		}
 		
-		for (const auto& object : color->second)
+		collectObjects(color->first, color->second, config.bounding_box, objects);
+		for (const auto* object : objects)
 		{
 			// Settings check
-			const Symbol* symbol = object.first->getSymbol();
+			const Symbol* symbol = object->first->getSymbol();
 			if (!config.testFlag(RenderConfig::HelperSymbols) && symbol->isHelperSymbol())
 				continue;
 			if (symbol->isHidden())
 				continue;
 			
-			if (!object.first->getExtent().intersects(config.bounding_box))
+			if (!object->first->getExtent().intersects(config.bounding_box))
 				continue;
 			
-			for (const auto& renderables : *object.second)
+			for (const auto& renderables : *object->second)
 			{
+				// Empty entries may refer to a clip path which no longer exists.
+				if (renderables.second.empty())
+					continue;
+				
 				// Render the renderables
 				const PainterConfig& state = renderables.first;
 				const MapColor* map_color = map->getColor(state.color_priority);
@@ -315,41 +454,79 @@ void MapRenderables::drawOverprintingSimulation(QPainter* painter, const RenderC
 {
 	// NOTE: painter must be a QPainter on a QImage of Format_ARGB32_Premultiplied.
 	QImage* image = static_cast<QImage*>(painter->device());
-	ImageTransparencyFixup image_fixup(image);
 	
 	QPainter::RenderHints hints = painter->renderHints();
 	QTransform t = painter->worldTransform();
 	painter->save();
 	
 	painter->resetTransform();
-	painter->setCompositionMode(QPainter::CompositionMode_Multiply); // Alternative: CompositionMode_Darken
 	
-	QImage separation(image->size(), QImage::Format_ARGB32_Premultiplied);
+	// Only the clipped area needs to be drawn.
+	auto target_rect = image->rect();
+	if (painter->hasClipping())
+		target_rect &= painter->clipBoundingRect().toAlignedRect();
 	
+	std::vector<const MapColor*> spot_colors;
 	for (auto map_color = map->color_set->colors.rbegin();
 	     map_color != map->color_set->colors.rend();
 	     map_color++)
 	{
 		if ((*map_color)->getSpotColorMethod() == MapColor::SpotColor)
+			spot_colors.push_back(*map_color);
+	}
+	
+	// The composition is done in place, unless QPainter must apply a clip.
+	QImage composition;
+	if (painter->hasClipping())
+		composition = image->copy(target_rect);
+	else
+		composition = imageSection(*image, target_rect);
+	
+	// Buffers for concurrently drawn separations, from a set which is not
+	// in use by another thread. Buffers are reallocated on size changes only.
+	std::vector<QImage> separation_buffers;
+	{
+		QMutexLocker locker(&separation_buffer_mutex);
+		if (!separation_buffer_sets.empty())
 		{
-			separation.fill(Qt::GlobalColor(Qt::transparent));
-			
-			// Collect all halftones and knockouts of a single color
-			QPainter p(&separation);
-			p.setRenderHints(hints);
-			p.setWorldTransform(t, false);
-			drawColorSeparation(&p, config, *map_color, true);
-			p.end();
-			
-			// Add this separation to the composition with multiplication.
-			painter->setCompositionMode(QPainter::CompositionMode_Multiply);
-			painter->drawImage(0, 0, separation);
-			image_fixup();
+			separation_buffers = std::move(separation_buffer_sets.back());
+			separation_buffer_sets.pop_back();
+		}
+	}
+	auto const batch_size = std::max(std::size_t(1), std::min(spot_colors.size(), std::size_t(QThread::idealThreadCount())));
+	for (auto batch_start = std::size_t(0); batch_start < spot_colors.size() && !target_rect.isEmpty(); batch_start += batch_size)
+	{
+		auto const batch_end = std::min(batch_start + batch_size, spot_colors.size());
+		if (separation_buffers.size() < batch_end - batch_start)
+			separation_buffers.resize(batch_end - batch_start);
+		
+		// Collect all halftones and knockouts of each color, concurrently.
+		auto const offset = QTransform::fromTranslate(-target_rect.left(), -target_rect.top());
+		Util::forEachRangeConcurrently(batch_end - batch_start, [&](std::size_t first, std::size_t last) {
+			for (auto i = first; i < last; ++i)
+			{
+				auto& separation = separation_buffers[i];
+				if (separation.size() != target_rect.size())
+					separation = QImage(target_rect.size(), QImage::Format_ARGB32_Premultiplied);
+				separation.fill(Qt::GlobalColor(Qt::transparent));
+				
+				QPainter p(&separation);
+				p.setRenderHints(hints);
+				p.setWorldTransform(t * offset, false);
+				drawColorSeparation(&p, config, spot_colors[batch_start + i], true);
+			}
+		}, 1);
+		
+		// Add the separations to the composition with multiplication.
+		for (auto i = batch_start; i < batch_end; ++i)
+		{
+			auto const& separation = separation_buffers[i - batch_start];
+			multiplyImage(composition, separation);
 			
 #if MAPPER_OVERPRINTING_CORRECTION == -1
 			// Add some opacity to the multiplication, but not for black,
 			// since halftones (i.e. grey) might unduly lighten the composition.
-			if (static_cast<QRgb>(**map_color) != 0xff000000)
+			if (static_cast<QRgb>(*spot_colors[i]) != 0xff000000)
 			{
 				// FIXME: Implement this for Format_ARGB32_Premultiplied,
 				//        if efficiently possible.
@@ -365,47 +542,66 @@ void MapRenderables::drawOverprintingSimulation(QPainter* painter, const RenderC
 					const unsigned int alpha = qAlpha(*px) * ((255-qGray(*px)) << 16) & 0xff000000;
 					*px = alpha | (*px & 0xffffff);
 				}
-				painter->setCompositionMode(QPainter::CompositionMode_SourceOver);
-				painter->drawImage(0, 0, copy);
+				QPainter p(&composition);
+				p.drawImage(0, 0, copy);
 			}
 #endif
 		}
 	}
 	
+	if (painter->hasClipping())
+	{
+		painter->setCompositionMode(QPainter::CompositionMode_Source);
+		painter->drawImage(target_rect.topLeft(), composition);
+	}
+	
 	painter->setCompositionMode(QPainter::CompositionMode_SourceOver);
 	
 #if MAPPER_OVERPRINTING_CORRECTION > 0
-	separation.fill(Qt::GlobalColor(Qt::transparent));
-	QPainter p(&separation);
-	p.setRenderHints(hints);
-	p.setWorldTransform(t, false);
-	RenderConfig config_copy = config;
-	config_copy.options |= RenderConfig::RequireSpotColor;
-	draw(&p, config_copy);
-	p.end();
-	QRgb* dest = reinterpret_cast<QRgb*>(separation.bits());
+	if (!target_rect.isEmpty())
+	{
+		if (separation_buffers.empty())
+			separation_buffers.resize(1);
+		auto& separation = separation_buffers.front();
+		if (separation.size() != target_rect.size())
+			separation = QImage(target_rect.size(), QImage::Format_ARGB32_Premultiplied);
+		separation.fill(Qt::GlobalColor(Qt::transparent));
+		QPainter p(&separation);
+		p.setRenderHints(hints);
+		p.setWorldTransform(t * QTransform::fromTranslate(-target_rect.left(), -target_rect.top()), false);
+		RenderConfig config_copy = config;
+		config_copy.options |= RenderConfig::RequireSpotColor;
+		draw(&p, config_copy);
+		p.end();
+		QRgb* dest = reinterpret_cast<QRgb*>(separation.bits());
 #if QT_VERSION >= QT_VERSION_CHECK(5, 10, 0)
-	const QRgb* dest_end = dest + separation.sizeInBytes() / sizeof(QRgb);
+		const QRgb* dest_end = dest + separation.sizeInBytes() / sizeof(QRgb);
 #else
-	const QRgb* dest_end = dest + separation.byteCount() / sizeof(QRgb);
+		const QRgb* dest_end = dest + separation.byteCount() / sizeof(QRgb);
 #endif
-	for (QRgb* px = dest; px < dest_end; ++px)
-	{
-		/* Each pixel is a premultipled RGBA, so the alpha value is adjusted
-		 * by applying the same factor to all 4 channels (bytes).
-		 * Implemented by bitwise operators for efficiency.
-		 */
+		for (QRgb* px = dest; px < dest_end; ++px)
+		{
+			/* Each pixel is a premultipled RGBA, so the alpha value is adjusted
+			 * by applying the same factor to all 4 channels (bytes).
+			 * Implemented by bitwise operators for efficiency.
+			 */
 #if MAPPER_OVERPRINTING_CORRECTION == 1
-		*px = (*px >> 3) & 0x1f1f1f1f;
+			*px = (*px >> 3) & 0x1f1f1f1f;
 #elif MAPPER_OVERPRINTING_CORRECTION == 2
-		*px = (*px >> 2) & 0x3f3f3f3f;
+			*px = (*px >> 2) & 0x3f3f3f3f;
 #else /* MAPPER_OVERPRINTING_CORRECTION == 3 or stronger */
-		*px = (*px >> 1) & 0x7f7f7f7f;
+			*px = (*px >> 1) & 0x7f7f7f7f;
 #endif
+		}
+		painter->drawImage(target_rect.topLeft(), separation);
 	}
-	painter->drawImage(0, 0, separation);
 #endif
 	
+	{
+		QMutexLocker locker(&separation_buffer_mutex);
+		separation_buffer_sets.push_back(std::move(separation_buffers));
+	}
+	
 	painter->restore();
 	
 	if (config.testFlag(RenderConfig::Screen))
@@ -426,6 +622,8 @@ void MapRenderables::drawColorSeparation(QPainter* painter, const RenderConfig&
 	// we need to take care of knockouts.
 	bool drawing_started = false;
 	
+	std::vector<const ObjectRenderablesItem*> objects;
+	
 	// For each pair of color priority and its renderables collection...
 	auto end_of_colors = rend();
 	auto color = rbegin();
@@ -526,21 +724,25 @@ void MapRenderables::drawColorSeparation(QPainter* painter, const RenderConfig&
 		}
 		
 		// For each pair of object and its renderables [states] for a particular map color...
-		for (const auto& object : color->second)
+		collectObjects(color->first, color->second, config.bounding_box, objects);
+		for (const auto* object : objects)
 		{
 			// Check whether the symbol and object is to be drawn at all.
-			const Symbol* symbol = object.first->getSymbol();
+			const Symbol* symbol = object->first->getSymbol();
 			if (!config.testFlag(RenderConfig::HelperSymbols) && symbol->isHelperSymbol())
 				continue;
 			if (symbol->isHidden())
 				continue;
 			
-			if (!object.first->getExtent().intersects(config.bounding_box))
+			if (!object->first->getExtent().intersects(config.bounding_box))
 				continue;
 			
 			// For each pair of common rendering attributes and collection of renderables...
-			for (const auto& renderables : *object.second)
+			for (const auto& renderables : *object->second)
 			{
+				if (renderables.second.empty())
+					continue;
+				
 				const PainterConfig& state = renderables.first;
 				
 				QColor color = *drawing_color.spot_color;
@@ -585,6 +787,45 @@ void MapRenderables::drawColorSeparation(QPainter* painter, const RenderConfig&
 	painter->restore();
 }
 
+std::shared_ptr<const MapRenderablesSnapshot> MapRenderables::snapshot(const QRectF& rect) const
+{
+	auto snapshot = std::make_shared<MapRenderablesSnapshot>();
+	std::vector<const ObjectRenderablesItem*> objects;
+	
+	for (auto color = rbegin(); color != rend(); ++color)
+	{
+		// Layers which are not drawn are still captured: Their renderables
+		// may provide the clip paths for other layers.
+		MapRenderablesSnapshot::Layer layer;
+		const MapColor* map_color = map->getColor(color->first);
+		layer.visible = map_color && color->first < map->getNumColors();
+		if (layer.visible)
+		{
+			layer.color = *map_color;
+			if (color->first >= 0 && map_color->getOpacity() < 1)
+				layer.color.setAlphaF(map_color->getOpacity());
+			layer.spot_color = color->first >= 0 && map_color->getSpotColorMethod() != MapColor::UndefinedMethod;
+		}
+		
+		collectObjects(color->first, color->second, rect, objects);
+		layer.items.reserve(objects.size());
+		for (const auto* object : objects)
+		{
+			const Symbol* symbol = object->first->getSymbol();
+			if (symbol->isHidden())
+				continue;
+			if (!object->first->getExtent().intersects(rect))
+				continue;
+			layer.items.push_back({ object->first->getExtent(), object->second, symbol->isHelperSymbol() });
+		}
+		
+		if (!layer.items.empty())
+			snapshot->layers.push_back(std::move(layer));
+	}
+	
+	return snapshot;
+}
+
 void MapRenderables::insertRenderablesOfObject(const Object* object)
 {
 	auto end_of_colors = object->renderables().end();
@@ -592,6 +833,13 @@ void MapRenderables::insertRenderablesOfObject(const Object* object)
 	for (; color != end_of_colors; ++color)
 	{
 		operator[](color->first)[object] = color->second;
+		
+		// Objects with invalid extent are never drawn.
+		auto& index = color_indexes[color->first];
+		if (object->getExtent().isValid())
+			index.insert(object, object->getExtent());
+		else
+			index.remove(object);
 	}
 }
 
@@ -621,6 +869,7 @@ void MapRenderables::removeRenderablesOfObject(const Object* object, bool mark_a
 			}
 			
 			color.second.erase(obj);
+			color_indexes[color.first].remove(object);
 		}
 	}
 }
@@ -644,8 +893,62 @@ void MapRenderables::clear(bool mark_area_as_dirty)
 		}
 	}
 	std::map<int, ObjectRenderablesMap>::clear();
+	color_indexes.clear();
 }
 
+// ### MapRenderablesSnapshot ###
+
+void MapRenderablesSnapshot::draw(QPainter* painter, const RenderConfig& config) const
+{
+#ifdef Q_OS_ANDROID
+	const qreal min_dimension = 1.0/config.scaling;
+#endif
+	
+	QPainterPath initial_clip = painter->clipPath();
+	const QPainterPath* current_clip = nullptr;
+	
+	painter->save();
+	for (const auto& layer : layers)
+	{
+		if (!layer.visible)
+			continue;
+		if (config.testFlag(RenderConfig::RequireSpotColor) && !layer.spot_color)
+			continue;
+		
+		for (const auto& item : layer.items)
+		{
+			if (!config.testFlag(RenderConfig::HelperSymbols) && item.helper_symbol)
+				continue;
+			if (!item.extent.intersects(config.bounding_box))
+				continue;
+			
+			for (const auto& renderables : *item.renderables)
+			{
+				if (renderables.second.empty())
+					continue;
+				
+				const PainterConfig& state = renderables.first;
+				if (!state.activate(painter, current_clip, config, layer.color, initial_clip))
+					continue;
+				
+				for (const auto* renderable : renderables.second)
+				{
+#ifdef Q_OS_ANDROID
+					const QRectF& extent = renderable->getExtent();
+					if (extent.width() < min_dimension && extent.height() < min_dimension)
+						continue;
+#endif
+					if (renderable->intersects(config.bounding_box))
+						renderable->render(*painter, config);
+				}
+			}
+		}
+	}
+	painter->restore();
+}
+
+
+
 // ### PainterConfig ###
 
 namespace {
@@ -22,17 +22,21 @@
 #define OPENORIENTEERING_RENDERABLE_H
 
 #include <map>
+#include <memory>
 #include <vector>
 
 #include <QtGlobal>
+#include <QColor>
 #include <QFlags>
+#include <QImage>
+#include <QMutex>
 #include <QRectF>
 #include <QSharedData>
 #include <QExplicitlySharedDataPointer>
 
 #include "core/map_color.h"
+#include "core/spatial_index.h"
 
-class QColor;
 class QPainter;
 class QPainterPath;
 // IWYU pragma: no_forward_declare QRectF
@@ -40,6 +44,7 @@ class QPainterPath;
 namespace OpenOrienteering {
 
 class Map;
+class MapRenderablesSnapshot;
 class Object;
 class PainterConfig;
 
@@ -120,6 +125,9 @@ protected:
 	/** The constructor for new renderables. */
 	explicit Renderable(const MapColor* color);
 	
+	/** The constructor for new renderables with a known color priority. */
+	explicit Renderable(int color_priority);
+	
 public:
 	Renderable(const Renderable&) = delete;
 	Renderable(Renderable&&) = delete;
@@ -271,6 +279,14 @@ public:
 	void deleteRenderables();
 	void takeRenderables();
 	
+	/**
+	 * Moves all renderables to the given vector, transferring ownership.
+	 * 
+	 * Fails, leaving everything unchanged, if some of the renderables
+	 * are inserted with a clip path.
+	 */
+	bool releaseRenderables(RenderableVector& out);
+	
 	/**
 	 * Draws all renderables matching the given map color with the given color.
 	 * 
@@ -339,6 +355,8 @@ public:
 	/**
 	 * Draws the renderables in a spot color overprinting simulation.
 	 * 
+	 * The separations are drawn concurrently, limited to the painter's clip.
+	 * 
 	 * @param painter Must be a QPainter on a QImage of Format_ARGB32_Premultiplied.
 	 * @param config  The rendering configuration
 	 */
@@ -359,6 +377,14 @@ public:
 	void drawColorSeparation(QPainter* painter, const RenderConfig& config,
 		const MapColor* separation, bool use_color = false) const;
 	
+	/**
+	 * Returns an immutable snapshot of the renderables which may intersect
+	 * the given rect.
+	 * 
+	 * Hidden symbols are skipped. The snapshot may be drawn in another thread.
+	 */
+	std::shared_ptr<const MapRenderablesSnapshot> snapshot(const QRectF& rect) const;
+	
 	void insertRenderablesOfObject(const Object* object);
 	
 	/* NOTE: does not delete the renderables, just removes them from display */
@@ -369,11 +395,74 @@ public:
 	inline bool empty() const;
 	
 private:
+	using ObjectRenderablesItem = ObjectRenderablesMap::value_type;
+	
+	/**
+	 * Collects the objects of the given color priority which may intersect
+	 * the given rect, in the order of the ObjectRenderablesMap.
+	 * 
+	 * This uses the spatial index when the rect covers only a part of the
+	 * objects.
+	 */
+	void collectObjects(int color_priority, const ObjectRenderablesMap& objects, const QRectF& rect,
+	                    std::vector<const ObjectRenderablesItem*>& out) const;
+	
+	/// For each color priority, a spatial index of the objects' extents
+	std::map<int, SpatialIndex<const Object*>> color_indexes;
+	
+	/// Buffers for concurrently drawn separations, reused across frames.
+	/// Each running drawOverprintingSimulation() takes one set of buffers.
+	mutable std::vector<std::vector<QImage>> separation_buffer_sets;
+	mutable QMutex separation_buffer_mutex;
+	
 	Map* const map;
 };
 
 
 
+/**
+ * An immutable snapshot of a part of MapRenderables.
+ * 
+ * The snapshot shares the renderables with the map, and it captures the
+ * colors and symbol properties which are needed for drawing. It does not
+ * refer to the map's objects, symbols or colors. Objects do not modify
+ * renderables which are in use, but replace them when they are updated
+ * (cf. ObjectRenderables::takeRenderables()). So a snapshot can be drawn in
+ * another thread while the map is edited.
+ */
+class MapRenderablesSnapshot
+{
+public:
+	/**
+	 * Draws the renderables normally, like MapRenderables::draw().
+	 * 
+	 * This function does not access the map in the config.
+	 */
+	void draw(QPainter* painter, const RenderConfig& config) const;
+	
+private:
+	friend class MapRenderables;
+	
+	struct Item
+	{
+		QRectF extent;
+		SharedRenderables::Pointer renderables;
+		bool helper_symbol;
+	};
+	
+	struct Layer
+	{
+		QColor color;
+		bool visible = false;
+		bool spot_color = false;
+		std::vector<Item> items;
+	};
+	
+	std::vector<Layer> layers;  ///< The color layers, in drawing order.
+};
+
+
+
 // ### RenderConfig ###
 
 inline
@@ -393,6 +482,13 @@ Renderable::Renderable(const MapColor* color)
 	; // nothing
 }
 
+inline
+Renderable::Renderable(int color_priority)
+ : color_priority(color_priority)
+{
+	; // nothing
+}
+
 inline
 const QRectF&Renderable::getExtent() const
 {
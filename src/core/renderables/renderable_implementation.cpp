@@ -20,9 +20,12 @@
 
 #include "renderable_implementation.h"
 
+#include <algorithm>
+#include <cmath>
 #include <cstddef>
 #include <iterator>
 #include <memory>
+#include <utility>
 #include <vector>
 
 #include <QtMath>
@@ -43,6 +46,7 @@
 #include "core/objects/object.h"
 #include "core/objects/text_object.h"
 #include "core/renderables/renderable.h"
+#include "core/renderables/text_path_cache.h"
 #include "core/symbols/area_symbol.h"
 #include "core/symbols/line_symbol.h"
 #include "core/symbols/point_symbol.h"
@@ -693,6 +697,114 @@ void AreaRenderable::render(QPainter &painter, const RenderConfig &/*config*/) c
 
 
 
+// ### PatternLattice ###
+
+void PatternLattice::addRow(QPointF start, QPointF step, int count)
+{
+	if (count <= 0)
+		return;
+	
+	rows.push_back({start, step, count});
+	rectIncludeSafe(extent, start);
+	rectIncludeSafe(extent, start + (count - 1) * step);
+}
+
+
+
+// ### InstancedPatternRenderable ###
+
+InstancedPatternRenderable::InstancedPatternRenderable(std::shared_ptr<const PatternLattice> lattice, std::unique_ptr<const Renderable> prototype)
+: Renderable(prototype->getPainterConfig().color_priority)
+, lattice(std::move(lattice))
+, prototype(std::move(prototype))
+{
+	auto const& prototype_extent = this->prototype->getExtent();
+	extent = this->lattice->extent.adjusted(prototype_extent.left(), prototype_extent.top(),
+	                                        prototype_extent.right(), prototype_extent.bottom());
+}
+
+InstancedPatternRenderable::~InstancedPatternRenderable() = default;
+
+PainterConfig InstancedPatternRenderable::getPainterConfig(const QPainterPath* clip_path) const
+{
+	return prototype->getPainterConfig(clip_path);
+}
+
+void InstancedPatternRenderable::render(QPainter& painter, const RenderConfig& config) const
+{
+	// The region of positions where the prototype's extent intersects the bounding box
+	auto const& prototype_extent = prototype->getExtent();
+	auto const region = config.bounding_box.adjusted(-prototype_extent.right(), -prototype_extent.bottom(),
+	                                                 -prototype_extent.left(), -prototype_extent.top());
+	
+	auto const transform = painter.worldTransform();
+	auto instance_config = config;
+	for (auto const& row : lattice->rows)
+	{
+		// Clip the row's parameter range [0, count-1] to the region.
+		auto first = qreal(0);
+		auto last = qreal(row.count - 1);
+		auto clip = [&first, &last](qreal start, qreal step, qreal min, qreal max) {
+			if (qIsNull(step))
+			{
+				if (start < min || start > max)
+					last = -1;
+				return;
+			}
+			auto t0 = (min - start) / step;
+			auto t1 = (max - start) / step;
+			if (t0 > t1)
+				std::swap(t0, t1);
+			first = std::max(first, t0);
+			last = std::min(last, t1);
+		};
+		clip(row.start.x(), row.step.x(), region.left(), region.right());
+		clip(row.start.y(), row.step.y(), region.top(), region.bottom());
+		if (last < first)
+			continue;
+		
+		for (auto i = int(std::ceil(first)), end = int(std::floor(last)); i <= end; ++i)
+		{
+			auto const position = row.start + i * row.step;
+			painter.setWorldTransform(QTransform::fromTranslate(position.x(), position.y()) * transform);
+			instance_config.bounding_box = config.bounding_box.translated(-position);
+			prototype->render(painter, instance_config);
+		}
+	}
+	painter.setWorldTransform(transform);
+}
+
+
+
+// ### InstancedRenderable ###
+
+InstancedRenderable::InstancedRenderable(std::shared_ptr<const Renderable> prototype, const QPointF& position)
+: Renderable(prototype->getPainterConfig().color_priority)
+, prototype(std::move(prototype))
+, position(position)
+{
+	extent = this->prototype->getExtent().translated(position);
+}
+
+InstancedRenderable::~InstancedRenderable() = default;
+
+PainterConfig InstancedRenderable::getPainterConfig(const QPainterPath* clip_path) const
+{
+	return prototype->getPainterConfig(clip_path);
+}
+
+void InstancedRenderable::render(QPainter& painter, const RenderConfig& config) const
+{
+	auto const transform = painter.worldTransform();
+	painter.setWorldTransform(QTransform::fromTranslate(position.x(), position.y()) * transform);
+	auto instance_config = config;
+	instance_config.bounding_box = config.bounding_box.translated(-position);
+	prototype->render(painter, instance_config);
+	painter.setWorldTransform(transform);
+}
+
+
+
 // ### TextRenderable ###
 
 TextRenderable::TextRenderable(const TextSymbol* symbol, const TextObject* text_object, const MapColor* color, double anchor_x, double anchor_y)
@@ -708,35 +820,46 @@ TextRenderable::TextRenderable(const TextSymbol* symbol, const TextObject* text_
 	const QFontMetricsF& metrics(symbol->getFontMetrics());
 	
 	int num_lines = text_object->getNumLines();
-	for (int i=0; i < num_lines; i++)
+	if (num_lines == 1 && text_object->getLineInfo(0)->part_infos.size() == 1)
 	{
-		const TextObjectLineInfo* line_info = text_object->getLineInfo(i);
-		
-		double line_y = line_info->line_y;
-		
-		double underline_x0 = 0.0;
-		double underline_y0 = line_info->line_y + metrics.underlinePos();
-		double underline_y1 = underline_y0 + metrics.lineWidth();
-		
-		auto num_parts = line_info->part_infos.size();
-		for (std::size_t j=0; j < num_parts; j++)
+		// A single part can share the cached path.
+		const TextObjectLineInfo* line_info = text_object->getLineInfo(0);
+		const TextObjectPartInfo& part(line_info->part_infos.front());
+		path = TextPathCache::path(font, part.part_text);
+		path_offset = { part.part_x, line_info->line_y };
+	}
+	else
+	{
+		for (int i=0; i < num_lines; i++)
 		{
-			const TextObjectPartInfo& part(line_info->part_infos.at(j));
-			if (font.underline())
+			const TextObjectLineInfo* line_info = text_object->getLineInfo(i);
+			
+			double line_y = line_info->line_y;
+			
+			double underline_x0 = 0.0;
+			double underline_y0 = line_info->line_y + metrics.underlinePos();
+			double underline_y1 = underline_y0 + metrics.lineWidth();
+			
+			auto num_parts = line_info->part_infos.size();
+			for (std::size_t j=0; j < num_parts; j++)
 			{
-				if (j > 0)
+				const TextObjectPartInfo& part(line_info->part_infos.at(j));
+				if (font.underline())
 				{
-					// draw underline for gap between parts as rectangle
-					// TODO: watch out for inconsistency between text and gap underline
-					path.moveTo(underline_x0, underline_y0);
-					path.lineTo(part.part_x,  underline_y0);
-					path.lineTo(part.part_x,  underline_y1);
-					path.lineTo(underline_x0, underline_y1);
-					path.closeSubpath();
+					if (j > 0)
+					{
+						// draw underline for gap between parts as rectangle
+						// TODO: watch out for inconsistency between text and gap underline
+						path.moveTo(underline_x0, underline_y0);
+						path.lineTo(part.part_x,  underline_y0);
+						path.lineTo(part.part_x,  underline_y1);
+						path.lineTo(underline_x0, underline_y1);
+						path.closeSubpath();
+					}
+					underline_x0 = part.part_x;
 				}
-				underline_x0 = part.part_x;
+				path.addPath(TextPathCache::path(font, part.part_text).translated(part.part_x, line_y));
 			}
-			path.addText(part.part_x, line_y, font, part.part_text);
 		}
 	}
 	
@@ -749,6 +872,7 @@ TextRenderable::TextRenderable(const TextSymbol* symbol, const TextObject* text_
 		rotation = -qRadiansToDegrees(rotation_rad);
 		t.rotate(rotation);
 	}
+	t.translate(path_offset.x(), path_offset.y());
 	
 	extent = t.mapRect(path.controlPointRect());
 }
@@ -778,6 +902,7 @@ void TextRenderable::renderCommon(QPainter& painter, const RenderConfig& config)
 	if (rotation != 0.0)
 		painter.rotate(rotation);
 	painter.scale(scale_factor, scale_factor);
+	painter.translate(path_offset);
 	painter.drawPath(path);
 }
 
@@ -22,6 +22,9 @@
 #ifndef OPENORIENTEERING_RENDERABLE_IMPLENTATION_H
 #define OPENORIENTEERING_RENDERABLE_IMPLENTATION_H
 
+#include <memory>
+#include <vector>
+
 #include <Qt>
 #include <QtGlobal>
 #include <QPainterPath>
@@ -117,12 +120,78 @@ protected:
 	void renderCommon(QPainter& painter, const RenderConfig& config) const;
 	
 	QPainterPath path;
+	QPointF path_offset;  ///< The position of the path in text object coordinates
 	qreal anchor_x;
 	qreal anchor_y;
 	qreal rotation;
 	qreal scale_factor;
 };
 
+/**
+ * The positions of the points of a point pattern fill.
+ * 
+ * The positions are organized in rows, matching the lines of the pattern.
+ * Each row has a start position, a step between adjacent points, and
+ * a number of points.
+ */
+struct PatternLattice
+{
+	struct Row
+	{
+		QPointF start;
+		QPointF step;
+		int count;
+	};
+	
+	std::vector<Row> rows;
+	QRectF extent;  ///< The bounding box of all positions
+	
+	/** Adds a row, and updates the extent. */
+	void addRow(QPointF start, QPointF step, int count);
+};
+
+/**
+ * Renderable for displaying a prototype renderable at each position of a
+ * point pattern lattice.
+ * 
+ * The instances are not stored but generated during rendering, limited to
+ * the positions which affect the bounding box of the render configuration.
+ * The prototype is rendered with a translated painter transform, so this
+ * works for all types of paint devices.
+ */
+class InstancedPatternRenderable : public Renderable
+{
+public:
+	InstancedPatternRenderable(std::shared_ptr<const PatternLattice> lattice, std::unique_ptr<const Renderable> prototype);
+	~InstancedPatternRenderable() override;
+	PainterConfig getPainterConfig(const QPainterPath* clip_path = nullptr) const override;
+	void render(QPainter& painter, const RenderConfig& config) const override;
+	
+protected:
+	std::shared_ptr<const PatternLattice> lattice;
+	std::unique_ptr<const Renderable> prototype;
+};
+
+/**
+ * Renderable for displaying a shared prototype renderable at a single position.
+ * 
+ * The prototype is rendered with a translated painter transform.
+ * 
+ * \see PointSymbol::InstancingScope
+ */
+class InstancedRenderable : public Renderable
+{
+public:
+	InstancedRenderable(std::shared_ptr<const Renderable> prototype, const QPointF& position);
+	~InstancedRenderable() override;
+	PainterConfig getPainterConfig(const QPainterPath* clip_path = nullptr) const override;
+	void render(QPainter& painter, const RenderConfig& config) const override;
+	
+protected:
+	std::shared_ptr<const Renderable> prototype;
+	QPointF position;
+};
+
 /** Renderable for displaying framing line for text. */
 class TextFramingRenderable : public TextRenderable
 {
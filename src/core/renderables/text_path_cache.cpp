@@ -0,0 +1,186 @@
+/*
+ *    Copyright 2021 The OpenOrienteering developers
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "text_path_cache.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <vector>
+
+#include <Qt>
+#include <QtGlobal>
+#include <QFont>
+#include <QGlyphRun>
+#include <QHash>
+#include <QLatin1Char>
+#include <QList>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QPointF>
+#include <QRawFont>
+#include <QString>
+#include <QTextLayout>
+#include <QTextLine>
+#include <QVector>
+
+
+namespace OpenOrienteering {
+
+namespace {
+
+/// The maximum number of texts in the cache.
+constexpr int max_texts = 10000;
+
+/// The maximum number of glyphs per raw font in the cache.
+constexpr int max_glyphs = 10000;
+
+/// The maximum number of raw fonts in the cache.
+constexpr std::size_t max_fonts = 100;
+
+struct GlyphCache
+{
+	QRawFont raw_font;
+	QHash<quint32, QPainterPath> glyphs;
+};
+
+struct Cache
+{
+	QMutex mutex;
+	QHash<QString, QPainterPath> texts;
+	std::vector<GlyphCache> fonts;
+	
+	/**
+	 * Returns the outline of a glyph.
+	 * 
+	 * The mutex must be locked.
+	 */
+	QPainterPath glyphPath(const QRawFont& raw_font, quint32 glyph_index)
+	{
+		auto font = std::find_if(begin(fonts), end(fonts), [&raw_font](const GlyphCache& entry) {
+			return entry.raw_font == raw_font;
+		});
+		if (font == end(fonts))
+		{
+			if (fonts.size() >= max_fonts)
+				fonts.clear();
+			fonts.push_back({raw_font, {}});
+			font = end(fonts) - 1;
+		}
+		else if (font->glyphs.size() > max_glyphs)
+		{
+			font->glyphs.clear();
+		}
+		
+		auto glyph = font->glyphs.find(glyph_index);
+		if (glyph == font->glyphs.end())
+			glyph = font->glyphs.insert(glyph_index, raw_font.pathForGlyph(glyph_index));
+		return *glyph;
+	}
+	
+};
+
+Cache& cache()
+{
+	static Cache instance;
+	return instance;
+}
+
+/**
+ * Returns a key which covers all font properties affecting the outline.
+ * 
+ * QFont::key() does not cover spacing, kerning and hinting.
+ */
+QString cacheKey(const QFont& font, const QString& text)
+{
+	return font.key()
+	       + QLatin1Char('|') + QString::number(font.letterSpacing(), 'g', 17)
+	       + QLatin1Char('|') + QString::number(font.letterSpacingType())
+	       + QLatin1Char('|') + QString::number(font.wordSpacing(), 'g', 17)
+	       + QLatin1Char('|') + QString::number(font.kerning())
+	       + QLatin1Char('|') + QString::number(font.capitalization())
+	       + QLatin1Char('|') + QString::number(font.hintingPreference())
+	       + QLatin1Char('|') + QString::number(font.styleStrategy())
+	       + QLatin1Char('|') + text;
+}
+
+}  // namespace
+
+
+
+// static
+QPainterPath TextPathCache::path(const QFont& font, const QString& text)
+{
+	auto& c = cache();
+	auto const key = cacheKey(font, text);
+	{
+		QMutexLocker lock(&c.mutex);
+		auto cached = c.texts.constFind(key);
+		if (cached != c.texts.constEnd())
+			return *cached;
+	}
+	
+	QPainterPath path;
+	path.setFillRule(Qt::WindingFill);
+	if (font.underline() || font.overline() || font.strikeOut())
+	{
+		path.addText(0, 0, font, text);
+	}
+	else
+	{
+		// Shaping is done outside of the lock.
+		QTextLayout layout(text, font);
+		layout.beginLayout();
+		auto line = layout.createLine();
+		layout.endLayout();
+		auto const glyph_runs = line.isValid() ? line.glyphRuns() : QList<QGlyphRun>();
+		auto const baseline = line.isValid() ? line.y() + line.ascent() : 0.0;
+		
+		QMutexLocker lock(&c.mutex);
+		for (auto const& glyph_run : glyph_runs)
+		{
+			auto const raw_font = glyph_run.rawFont();
+			auto const glyph_indexes = glyph_run.glyphIndexes();
+			auto const positions = glyph_run.positions();
+			for (int i = 0; i < glyph_indexes.size(); ++i)
+			{
+				auto const position = positions[i];
+				path.addPath(c.glyphPath(raw_font, glyph_indexes[i]).translated(position.x(), position.y() - baseline));
+			}
+		}
+	}
+	
+	QMutexLocker lock(&c.mutex);
+	if (c.texts.size() > max_texts)
+		c.texts.clear();
+	c.texts.insert(key, path);
+	return path;
+}
+
+// static
+void TextPathCache::clear()
+{
+	auto& c = cache();
+	QMutexLocker lock(&c.mutex);
+	c.texts.clear();
+	c.fonts.clear();
+}
+
+
+}  // namespace OpenOrienteering
@@ -0,0 +1,67 @@
+/*
+ *    Copyright 2021 The OpenOrienteering developers
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OPENORIENTEERING_TEXT_PATH_CACHE_H
+#define OPENORIENTEERING_TEXT_PATH_CACHE_H
+
+#include <QPainterPath>
+
+class QFont;
+class QString;
+
+namespace OpenOrienteering {
+
+
+/**
+ * A shared cache for the outlines of text.
+ * 
+ * Maps often contain many identical labels, such as spot heights or control
+ * numbers. This cache keeps the outline of each text per font, so that
+ * identical strings share one (implicitly shared) QPainterPath. The outlines
+ * of new strings are assembled from the glyph outlines of the shaped text,
+ * and the glyph outlines are cached per raw font and glyph index.
+ * 
+ * Fonts with underline, overline or strike-out are outlined by
+ * QPainterPath::addText, for the decorations.
+ * 
+ * The cache may be used from multiple threads. It is cleared when it grows
+ * beyond a fixed number of entries.
+ */
+class TextPathCache
+{
+public:
+	/**
+	 * Returns the outline of the given single line text.
+	 * 
+	 * The path's origin is the left end of the baseline, as for
+	 * QPainterPath::addText(). The fill rule is Qt::WindingFill.
+	 */
+	static QPainterPath path(const QFont& font, const QString& text);
+	
+	/**
+	 * Removes all entries from the cache.
+	 */
+	static void clear();
+	
+};
+
+
+}  // namespace OpenOrienteering
+
+#endif // OPENORIENTEERING_TEXT_PATH_CACHE_H
@@ -0,0 +1,344 @@
+/*
+ *    Copyright 2021 The OpenOrienteering developers
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef OPENORIENTEERING_SPATIAL_INDEX_H
+#define OPENORIENTEERING_SPATIAL_INDEX_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <QtGlobal>
+#include <QRectF>
+
+// IWYU pragma: no_forward_declare QRectF
+
+
+namespace OpenOrienteering {
+
+/**
+ * A spatial index of items with rectangular extents, in map coordinates.
+ *
+ * The index is implemented as a loose quadtree: Each item is stored in exactly
+ * one node. The node's depth is determined by the size of the item's extent,
+ * and the node's cell is determined by the center of the extent. The bounds of
+ * each node are enlarged by half the cell size in each direction, so that any
+ * item fits into the node which contains its center. This makes insertion and
+ * removal O(1) operations (plus the depth of the tree), and it avoids the
+ * rebalancing of R-trees.
+ *
+ * The root node covers the full range of native map coordinates. Items which
+ * do not fit into the root's loose bounds are stored at the root, where they
+ * are always tested.
+ *
+ * Queries return a superset of the items whose extent intersects the query
+ * rectangle. Degenerated rectangles (e.g. points) are valid query input.
+ * Callers are expected to apply the exact test for the candidates.
+ *
+ * T must be a hashable, cheaply copyable type, typically a pointer.
+ */
+template <class T>
+class SpatialIndex
+{
+public:
+	SpatialIndex();
+	SpatialIndex(const SpatialIndex&) = delete;
+	SpatialIndex(SpatialIndex&&) = default;
+	~SpatialIndex() = default;
+
+	SpatialIndex& operator=(const SpatialIndex&) = delete;
+	SpatialIndex& operator=(SpatialIndex&&) = default;
+
+	/**
+	 * Returns the number of items in the index.
+	 */
+	std::size_t size() const { return locations.size(); }
+
+	/**
+	 * Returns true if the index has no items.
+	 */
+	bool empty() const { return locations.empty(); }
+
+	/**
+	 * Tests if the item is contained in the index.
+	 */
+	bool contains(T item) const { return locations.find(item) != locations.end(); }
+
+	/**
+	 * Removes all items.
+	 */
+	void clear();
+
+	/**
+	 * Inserts the item with the given extent, or updates its extent.
+	 */
+	void insert(T item, const QRectF& extent);
+
+	/**
+	 * Removes the item.
+	 *
+	 * Returns true if the item was found in the index.
+	 */
+	bool remove(T item);
+
+	/**
+	 * Calls the function for every item whose extent may intersect the rect.
+	 *
+	 * The function must not modify the index.
+	 */
+	template <class Function>
+	void query(const QRectF& rect, Function&& function) const;
+
+	/**
+	 * Appends all items whose extent may intersect the rect to out.
+	 */
+	void query(const QRectF& rect, std::vector<T>& out) const;
+
+
+private:
+	/// The half size of the root node, a power of two greater than the
+	/// range of native map coordinates (in mm).
+	static constexpr qreal root_half_size = 4194304.0;
+
+	/// The maximum depth of the tree. At this depth, cells are 0.5 mm wide.
+	static constexpr int max_depth = 24;
+
+	struct Entry
+	{
+		T item;
+		QRectF extent;
+	};
+
+	struct Node
+	{
+		std::vector<Entry> entries;
+		std::size_t subtree_size = 0;
+		int children[4] = { -1, -1, -1, -1 };
+	};
+
+	struct Cell
+	{
+		int depth;
+		std::uint32_t x;
+		std::uint32_t y;
+	};
+
+	struct Location
+	{
+		Cell cell;
+		int node;
+		std::size_t slot;
+	};
+
+	static Cell cellFor(const QRectF& extent);
+
+	static bool intersects(const QRectF& a, const QRectF& b);
+
+	int findOrCreateNode(Cell cell);
+
+	template <class Function>
+	void queryNode(int node, int depth, qreal x0, qreal y0, qreal half_size, const QRectF& rect, Function& function) const;
+
+	std::vector<Node> nodes;
+	std::unordered_map<T, Location> locations;
+};
+
+
+
+// ### SpatialIndex template implementation ###
+
+template <class T>
+SpatialIndex<T>::SpatialIndex()
+: nodes(1)
+{
+	// nothing else
+}
+
+template <class T>
+void SpatialIndex<T>::clear()
+{
+	nodes.clear();
+	nodes.resize(1);
+	locations.clear();
+}
+
+template <class T>
+typename SpatialIndex<T>::Cell SpatialIndex<T>::cellFor(const QRectF& extent)
+{
+	auto const cx = extent.center().x();
+	auto const cy = extent.center().y();
+	auto const size = std::max(extent.width(), extent.height());
+	if (!(std::abs(cx) < root_half_size && std::abs(cy) < root_half_size && size < 2 * root_half_size))
+		return { 0, 0, 0 };  // NaN, or not fitting into the root: stored at the root
+
+	// With the loose bounds, an item fits into every cell at least half as wide as the item.
+	int depth = 0;
+	auto half_size = root_half_size;
+	while (depth < max_depth && half_size >= size)
+	{
+		half_size /= 2;
+		++depth;
+	}
+
+	auto const cell_size = 2 * half_size;
+	auto const max_index = (std::uint32_t(1) << depth) - 1;
+	auto const x = std::min(std::uint32_t((cx + root_half_size) / cell_size), max_index);
+	auto const y = std::min(std::uint32_t((cy + root_half_size) / cell_size), max_index);
+	return { depth, x, y };
+}
+
+template <class T>
+bool SpatialIndex<T>::intersects(const QRectF& a, const QRectF& b)
+{
+	// Closed intervals: Unlike QRectF::intersects(), this handles empty rects.
+	return a.left() <= b.right() && b.left() <= a.right()
+	       && a.top() <= b.bottom() && b.top() <= a.bottom();
+}
+
+template <class T>
+int SpatialIndex<T>::findOrCreateNode(Cell cell)
+{
+	auto node = 0;
+	++nodes[0].subtree_size;
+	for (auto level = cell.depth - 1; level >= 0; --level)
+	{
+		auto const quadrant = ((cell.x >> level) & 1) + 2 * ((cell.y >> level) & 1);
+		auto child = nodes[std::size_t(node)].children[quadrant];
+		if (child < 0)
+		{
+			child = int(nodes.size());
+			nodes[std::size_t(node)].children[quadrant] = child;
+			nodes.emplace_back();  // invalidates references
+		}
+		node = child;
+		++nodes[std::size_t(node)].subtree_size;
+	}
+	return node;
+}
+
+template <class T>
+void SpatialIndex<T>::insert(T item, const QRectF& extent)
+{
+	auto const cell = cellFor(extent);
+	auto found = locations.find(item);
+	if (found != locations.end())
+	{
+		auto& location = found->second;
+		if (location.cell.depth == cell.depth && location.cell.x == cell.x && location.cell.y == cell.y)
+		{
+			// Same cell, only the extent changed.
+			nodes[std::size_t(location.node)].entries[location.slot].extent = extent;
+			return;
+		}
+		remove(item);
+	}
+
+	auto const node = findOrCreateNode(cell);
+	auto& entries = nodes[std::size_t(node)].entries;
+	entries.push_back({ item, extent });
+	locations.emplace(item, Location{ cell, node, entries.size() - 1 });
+}
+
+template <class T>
+bool SpatialIndex<T>::remove(T item)
+{
+	auto found = locations.find(item);
+	if (found == locations.end())
+		return false;
+
+	auto const location = found->second;
+	locations.erase(found);
+
+	auto& entries = nodes[std::size_t(location.node)].entries;
+	if (location.slot + 1 != entries.size())
+	{
+		entries[location.slot] = std::move(entries.back());
+		locations[entries[location.slot].item].slot = location.slot;
+	}
+	entries.pop_back();
+
+	// Update the subtree sizes along the path.
+	auto node = 0;
+	--nodes[0].subtree_size;
+	for (auto level = location.cell.depth - 1; level >= 0; --level)
+	{
+		auto const quadrant = ((location.cell.x >> level) & 1) + 2 * ((location.cell.y >> level) & 1);
+		node = nodes[std::size_t(node)].children[quadrant];
+		Q_ASSERT(node > 0);
+		--nodes[std::size_t(node)].subtree_size;
+	}
+	return true;
+}
+
+template <class T>
+template <class Function>
+void SpatialIndex<T>::query(const QRectF& rect, Function&& function) const
+{
+	queryNode(0, 0, -root_half_size, -root_half_size, root_half_size, rect, function);
+}
+
+template <class T>
+void SpatialIndex<T>::query(const QRectF& rect, std::vector<T>& out) const
+{
+	query(rect, [&out](T item) { out.push_back(item); });
+}
+
+template <class T>
+template <class Function>
+void SpatialIndex<T>::queryNode(int node, int depth, qreal x0, qreal y0, qreal half_size, const QRectF& rect, Function& function) const
+{
+	auto const& current = nodes[std::size_t(node)];
+	if (current.subtree_size == 0)
+		return;
+
+	// The loose bounds extend by half a cell in each direction.
+	if (depth > 0)
+	{
+		auto const loose = QRectF(x0 - half_size, y0 - half_size, 4 * half_size, 4 * half_size);
+		if (!intersects(loose, rect))
+			return;
+	}
+
+	for (auto const& entry : current.entries)
+	{
+		if (intersects(entry.extent, rect))
+			function(entry.item);
+	}
+
+	auto const child_half_size = half_size / 2;
+	for (int quadrant = 0; quadrant < 4; ++quadrant)
+	{
+		auto const child = current.children[quadrant];
+		if (child < 0)
+			continue;
+		auto const child_x0 = x0 + (quadrant & 1) * half_size;
+		auto const child_y0 = y0 + (quadrant >> 1) * half_size;
+		queryNode(child, depth + 1, child_x0, child_y0, child_half_size, rect, function);
+	}
+}
+
+
+}  // namespace OpenOrienteering
+
+#endif
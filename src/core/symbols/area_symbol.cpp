@@ -232,7 +232,7 @@ const MapColor* AreaSymbol::FillPattern::guessDominantColor() const
 
 template <>
 inline
-void AreaSymbol::FillPattern::createLine<AreaSymbol::FillPattern::LinePattern>(
+void AreaSymbol::FillPattern::createLine<AreaSymbol::FillPattern::LinePattern, LineSymbol>(
         MapCoordF first, MapCoordF second,
         qreal,
         LineSymbol* line,
@@ -247,16 +247,16 @@ void AreaSymbol::FillPattern::createLine<AreaSymbol::FillPattern::LinePattern>(
 
 template <>
 inline
-void AreaSymbol::FillPattern::createLine<AreaSymbol::FillPattern::PointPattern>(
+void AreaSymbol::FillPattern::createLine<AreaSymbol::FillPattern::PointPattern, PatternLattice>(
         MapCoordF first, MapCoordF second,
         qreal delta_offset,
-        LineSymbol*,
+        PatternLattice* lattice,
         qreal rotation,
         const AreaRenderable& outline,
         ObjectRenderables& output ) const
 {
 	// out of inlining
-	createPointPatternLine(first, second, delta_offset, rotation, outline, output);
+	createPointPatternLine(first, second, delta_offset, lattice, rotation, outline, output);
 }
 
 
@@ -266,13 +266,13 @@ void AreaSymbol::FillPattern::createLine<AreaSymbol::FillPattern::PointPattern>(
 // instantiation independently, with regard to unused parameters in
 // createLine(), and to eliminate any runtime checks for pattern type
 // outside of non-template createRenderables().
-template <int T>
+template <int T, class Context>
 void AreaSymbol::FillPattern::createRenderables(
         const AreaRenderable& outline,
         qreal delta_rotation,
         const MapCoord& pattern_origin,
         const QRectF& point_extent,
-        LineSymbol* line,
+        Context* context,
         qreal rotation,
         ObjectRenderables& output ) const
 {
@@ -312,7 +312,7 @@ void AreaSymbol::FillPattern::createRenderables(
 		{
 			first = MapCoordF(cur, canvas.top());
 			second = MapCoordF(cur, canvas.bottom());
-			createLine<T>(first, second, delta_along_line_offset, line, delta_rotation, outline, output);
+			createLine<T, Context>(first, second, delta_along_line_offset, context, delta_rotation, outline, output);
 		}
 	}
 	else if (qAbs(rotation - 0) < 0.0001)
@@ -323,7 +323,7 @@ void AreaSymbol::FillPattern::createRenderables(
 		{
 			first = MapCoordF(canvas.left(), cur);
 			second = MapCoordF(canvas.right(), cur);
-			createLine<T>(first, second, delta_along_line_offset, line, delta_rotation, outline, output);
+			createLine<T, Context>(first, second, delta_along_line_offset, context, delta_rotation, outline, output);
 		}
 	}
 	else
@@ -370,7 +370,7 @@ void AreaSymbol::FillPattern::createRenderables(
 				// Create the renderable(s)
 				first = MapCoordF(start_x, start_y);
 				second = MapCoordF(end_x, end_y);
-				createLine<T>(first, second, delta_along_line_offset, line, delta_rotation, outline, output);
+				createLine<T, Context>(first, second, delta_along_line_offset, context, delta_rotation, outline, output);
 				
 				// Move to next position
 				start_x += dist_x;
@@ -407,7 +407,7 @@ void AreaSymbol::FillPattern::createRenderables(
 				// Create the renderable(s)
 				first = MapCoordF(start_x, start_y);
 				second = MapCoordF(end_x, end_y);
-				createLine<T>(first, second, delta_along_line_offset, line, delta_rotation, outline, output);
+				createLine<T, Context>(first, second, delta_along_line_offset, context, delta_rotation, outline, output);
 				
 				// Move to next position
 				start_x += dist_x;
@@ -462,7 +462,11 @@ void AreaSymbol::FillPattern::createRenderables(const AreaRenderable& outline, q
 			point_object.setRotation(delta_rotation);
 			point_object.update();
 			auto point_extent = point_object.getExtent();
-			createRenderables<PointPattern>(outline, delta_rotation, pattern_origin, point_extent, nullptr, rotation, output);
+			if ((flags & Option::AlternativeToClipping) != Option::Default
+			    || !createInstancedPointPattern(outline, delta_rotation, pattern_origin, point_extent, rotation, output))
+			{
+				createRenderables<PointPattern>(outline, delta_rotation, pattern_origin, point_extent, static_cast<PatternLattice*>(nullptr), rotation, output);
+			}
 		}
 		break;
 	}
@@ -471,9 +475,38 @@ void AreaSymbol::FillPattern::createRenderables(const AreaRenderable& outline, q
 }
 
 
+bool AreaSymbol::FillPattern::createInstancedPointPattern(
+        const AreaRenderable& outline,
+        qreal delta_rotation,
+        const MapCoord& pattern_origin,
+        const QRectF& point_extent,
+        qreal rotation,
+        ObjectRenderables& output ) const
+{
+	// The prototype renderables, at the origin, with the rotation used in createPointPatternLine().
+	PointObject prototype_object(point);
+	ObjectRenderables prototypes(prototype_object);
+	point->createRenderablesScaled(MapCoordF(0, 0), -delta_rotation, prototypes);
+	RenderableVector renderables;
+	if (!prototypes.releaseRenderables(renderables))
+		return false;  // Nested clipping cannot be instanced.
+	
+	auto lattice = std::make_shared<PatternLattice>();
+	createRenderables<PointPattern>(outline, delta_rotation, pattern_origin, point_extent, lattice.get(), rotation, output);
+	for (auto* renderable : renderables)
+	{
+		auto prototype = std::unique_ptr<const Renderable>(renderable);
+		if (!lattice->rows.empty())
+			output.insertRenderable(new InstancedPatternRenderable(lattice, std::move(prototype)));
+	}
+	return true;
+}
+
+
 void AreaSymbol::FillPattern::createPointPatternLine(
         MapCoordF first, MapCoordF second,
         qreal delta_offset,
+        PatternLattice* lattice,
         qreal rotation,
         const AreaRenderable& outline,
         ObjectRenderables& output ) const
@@ -501,6 +534,13 @@ void AreaSymbol::FillPattern::createPointPatternLine(
 			point->createRenderablesIfCompletelyInside(coord, -rotation, outline.painterPath(), output);
 		break;
 	case Option::Default:
+		if (lattice)
+		{
+			// Only the positions, the renderables are instanced at draw time.
+			if (start_length < length)
+				lattice->addRow(coord, to_next, int(std::ceil((length - start_length) / step_length)));
+			break;
+		}
 #if 1
 		// Avoids expensive check, but may create objects which won't be rendered.
 		for (auto cur = start_length; cur < length; cur += step_length, coord += to_next)
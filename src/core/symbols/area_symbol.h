@@ -51,6 +51,7 @@ class ObjectRenderables;
 class PathObject;
 class PathPartVector;
 class PointSymbol;
+struct PatternLattice;
 class SymbolPropertiesWidget;
 class SymbolSettingDialog;
 class VirtualCoordVector;
@@ -191,38 +192,65 @@ public:
 			ObjectRenderables& output
 		) const;
 		
-		/** Does the heavy-lifting in loops over lines. */
-		template <int type>
+		/**
+		 * Does the heavy-lifting in loops over lines.
+		 * 
+		 * The context is the line symbol for a LinePattern, and the
+		 * (optional) lattice to be filled for a PointPattern.
+		 */
+		template <int type, class Context>
 		void createRenderables(
 			const AreaRenderable& outline,
 			qreal delta_rotation,
 			const MapCoord& pattern_origin,
 			const QRectF& point_extent,
-			LineSymbol* line,
+			Context* context,
 			qreal rotation,
 			ObjectRenderables& output
 		) const;
 		
 		/** Creates one line of renderables, called by createRenderables(). */
-		template <int type>
+		template <int type, class Context>
 		void createLine(
 			MapCoordF first, MapCoordF second,
 			qreal delta_offset,
-			LineSymbol* line,
+			Context* context,
 			qreal rotation,
 			const AreaRenderable& outline,
 			ObjectRenderables& output
 		) const;
 		
-		/** Creates a single line of renderables for a PointPattern. */
+		/**
+		 * Creates a single line of renderables for a PointPattern.
+		 * 
+		 * If a lattice is given and the pattern uses default clipping,
+		 * only the positions are added to the lattice.
+		 */
 		void createPointPatternLine(
 			MapCoordF first, MapCoordF second,
 			qreal delta_offset,
+			PatternLattice* lattice,
 			qreal rotation,
 			const AreaRenderable& outline,
 			ObjectRenderables& output
 		) const;
 		
+		/**
+		 * Creates instanced renderables for a PointPattern with default clipping.
+		 * 
+		 * Instead of individual renderables for each point, this creates one
+		 * InstancedPatternRenderable for each renderable of the point symbol.
+		 * Returns false if the point symbol is not suitable for instancing.
+		 */
+		bool createInstancedPointPattern(
+			const AreaRenderable& outline,
+			qreal delta_rotation,
+			const MapCoord& pattern_origin,
+			const QRectF& point_extent,
+			qreal rotation,
+			ObjectRenderables& output
+		) const;
+		
 		
 		/** Spatially scales the pattern settings by the given factor. */
 		void scale(double factor);
@@ -258,6 +258,8 @@ void LineSymbol::createRenderables(
         ObjectRenderables& output,
         RenderableOptions /*options*/) const
 {
+	// Repeated point symbols share their renderables.
+	PointSymbol::InstancingScope instancing_scope { hasPointSymbols() };
 	const auto path_parts = PathPart::calculatePathParts(coords);
 	createStartEndSymbolRenderables(path_parts, output);
 	for (const auto& part : path_parts)
@@ -278,6 +280,8 @@ void LineSymbol::createRenderables(
 	}
 	else
 	{
+		// Repeated point symbols share their renderables.
+		PointSymbol::InstancingScope instancing_scope { hasPointSymbols() };
 		createStartEndSymbolRenderables(path_parts, output);
 		for (const auto& part : path_parts)
 		{
@@ -812,7 +816,7 @@ void LineSymbol::processContinuousLine(
 		{
 			if (mid_symbol_rotatable)
 				orientation = split.tangentVector().angle();
-			mid_symbol->createRenderablesScaled(split.pos, orientation, output);
+			mid_symbol->createInstancedRenderables(split.pos, orientation, output);
 			
 			if (i > 1)
 			{
@@ -1108,7 +1112,7 @@ SplitPathCoord LineSymbol::createDashGroups(
 					auto next_split = SplitPathCoord::at(position, split);
 					if (mid_symbol_rotatable)
 						orientation = next_split.tangentVector().angle();
-					mid_symbol->createRenderablesScaled(next_split.pos, orientation, output);
+					mid_symbol->createInstancedRenderables(next_split.pos, orientation, output);
 					split = next_split;
 				}
 				position  += mid_symbol_distance_f;
@@ -1125,7 +1129,7 @@ SplitPathCoord LineSymbol::createDashGroups(
 				auto next_split = SplitPathCoord::at(position, split);
 				if (mid_symbol_rotatable)
 					orientation = next_split.tangentVector().angle();
-				mid_symbol->createRenderablesScaled(next_split.pos, orientation, output);
+				mid_symbol->createInstancedRenderables(next_split.pos, orientation, output);
 				
 				position  += mid_symbol_distance_f;
 				split = next_split;
@@ -1191,7 +1195,7 @@ SplitPathCoord LineSymbol::createDashGroups(
 					split = SplitPathCoord::at(position, split);
 					if (mid_symbol_rotatable)
 						orientation = split.tangentVector().angle();
-					mid_symbol->createRenderablesScaled(split.pos, orientation, output);
+					mid_symbol->createInstancedRenderables(split.pos, orientation, output);
 				}
 			}
 			
@@ -1249,7 +1253,7 @@ SplitPathCoord LineSymbol::createDashGroups(
 						split = SplitPathCoord::at(position, split);
 						if (mid_symbol_rotatable)
 							orientation = split.tangentVector().angle();
-						mid_symbol->createRenderablesScaled(split.pos, orientation, output);
+						mid_symbol->createInstancedRenderables(split.pos, orientation, output);
 					}
 				}
 				
@@ -1268,7 +1272,7 @@ SplitPathCoord LineSymbol::createDashGroups(
 				auto next_split = SplitPathCoord::at(position, split);
 				if (mid_symbol_rotatable)
 					orientation = next_split.tangentVector().angle();
-				mid_symbol->createRenderablesScaled(next_split.pos, orientation, output);
+				mid_symbol->createInstancedRenderables(next_split.pos, orientation, output);
 				
 				position  += mid_symbol_distance_f;
 				split = next_split;
@@ -1310,7 +1314,7 @@ void LineSymbol::createDashSymbolRenderables(
 			//params.first.perpRight();
 			auto rotation = dash_symbol->isRotatable() ? params.first.angle() : 0.0;
 			auto scale = scale_dash_symbol ? qMin(params.second, 2.0 * LineSymbol::miterLimit()) : 1.0;
-			dash_symbol->createRenderablesScaled(coords[i], rotation, output, scale);
+			dash_symbol->createInstancedRenderables(coords[i], rotation, output, scale);
 		}
 	}
 }
@@ -1342,7 +1346,7 @@ void LineSymbol::createMidSymbolRenderables(
 		// Insert point at start coordinate
 		if (mid_symbol_rotatable)
 			orientation = start.tangentVector().angle();
-		mid_symbol->createRenderablesScaled(start.pos, orientation, output);
+		mid_symbol->createInstancedRenderables(start.pos, orientation, output);
 	}
 	
 	auto groups_start = start;
@@ -1370,12 +1374,12 @@ void LineSymbol::createMidSymbolRenderables(
 					// Insert point at start coordinate
 					if (mid_symbol_rotatable)
 						orientation = groups_start.tangentVector().angle();
-					mid_symbol->createRenderablesScaled(groups_start.pos, orientation, output);
+					mid_symbol->createInstancedRenderables(groups_start.pos, orientation, output);
 					
 					// Insert point at end coordinate
 					if (mid_symbol_rotatable)
 						orientation = groups_end.tangentVector().angle();
-					mid_symbol->createRenderablesScaled(groups_end.pos, orientation, output);
+					mid_symbol->createInstancedRenderables(groups_end.pos, orientation, output);
 				}
 			}
 			else
@@ -1403,7 +1407,7 @@ void LineSymbol::createMidSymbolRenderables(
 							split = SplitPathCoord::at(position, split);
 							if (mid_symbol_rotatable)
 								orientation = split.tangentVector().angle();
-							mid_symbol->createRenderablesScaled(split.pos, orientation, output);
+							mid_symbol->createInstancedRenderables(split.pos, orientation, output);
 						}
 					}
 				}
@@ -1439,7 +1443,7 @@ void LineSymbol::createMidSymbolRenderables(
 							split = SplitPathCoord::at(position, split);
 							if (mid_symbol_rotatable)
 								orientation = split.tangentVector().angle();
-							mid_symbol->createRenderablesScaled(split.pos, orientation, output);
+							mid_symbol->createInstancedRenderables(split.pos, orientation, output);
 						}
 					}
 				}
@@ -1448,7 +1452,7 @@ void LineSymbol::createMidSymbolRenderables(
 			// Insert point at end coordinate
 			if (mid_symbol_rotatable)
 				orientation = groups_end.tangentVector().angle();
-			mid_symbol->createRenderablesScaled(groups_end.pos, orientation, output);
+			mid_symbol->createInstancedRenderables(groups_end.pos, orientation, output);
 		}
 		
 		groups_start = groups_end; // Search then next split (node) after groups_end (current node).
@@ -1456,6 +1460,15 @@ void LineSymbol::createMidSymbolRenderables(
 }
 
 
+bool LineSymbol::hasPointSymbols() const
+{
+	auto const has_symbol = [](const PointSymbol* symbol) {
+		return symbol && !symbol->isEmpty();
+	};
+	return has_symbol(start_symbol) || has_symbol(mid_symbol)
+	       || has_symbol(end_symbol) || has_symbol(dash_symbol);
+}
+
 void LineSymbol::createStartEndSymbolRenderables(
             const PathPartVector& path_parts,
             ObjectRenderables& output) const
@@ -1474,7 +1487,7 @@ void LineSymbol::createStartEndSymbolRenderables(
 			if (ok)
 				orientation = tangent.angle();
 		}
-		start_symbol->createRenderablesScaled(path.coords[path.first_index], orientation, output);
+		start_symbol->createInstancedRenderables(path.coords[path.first_index], orientation, output);
 	}
 	
 	if (end_symbol && !end_symbol->isEmpty())
@@ -1488,7 +1501,7 @@ void LineSymbol::createStartEndSymbolRenderables(
 			if (ok)
 				orientation = tangent.angle();
 		}				
-		end_symbol->createRenderablesScaled(path.coords[path.last_index], orientation, output);
+		end_symbol->createInstancedRenderables(path.coords[path.last_index], orientation, output);
 	}
 }
 
@@ -427,6 +427,11 @@ protected:
 	        ObjectRenderables& output
 	) const;
 	
+	/**
+	 * Returns true if any of the start, mid, end or dash symbols is not empty.
+	 */
+	bool hasPointSymbols() const;
+	
 	
 	void replaceSymbol(PointSymbol*& old_symbol, PointSymbol* replace_with, const QString& name);
 	
@@ -25,8 +25,12 @@
 #include <cmath>
 #include <cstddef>
 #include <iterator>
+#include <map>
 #include <memory>
+#include <set>
+#include <tuple>
 #include <utility>
+#include <vector>
 
 #include <QtMath>
 #include <QLatin1String>
@@ -55,6 +59,61 @@
 
 namespace OpenOrienteering {
 
+// ### PointSymbol::InstancingScope ###
+
+struct PointSymbol::InstancingScope::Cache
+{
+	/// The maximum number of prototypes, and of keys seen once, per cache.
+	static constexpr std::size_t max_size = 1000;
+	
+	struct Key
+	{
+		const PointSymbol* symbol;
+		qreal rotation;
+		qreal coord_scale;
+		
+		bool operator<(const Key& other) const
+		{
+			return std::tie(symbol, rotation, coord_scale) < std::tie(other.symbol, other.rotation, other.coord_scale);
+		}
+	};
+	
+	struct Prototypes
+	{
+		std::vector<std::shared_ptr<const Renderable>> renderables;
+		bool instanced;  ///< False if the renderables cannot be instanced
+	};
+	
+	std::map<Key, Prototypes> prototypes;
+	std::set<Key> seen_once;  ///< Keys without prototypes yet
+};
+
+namespace {
+
+thread_local PointSymbol::InstancingScope::Cache* current_cache = nullptr;
+
+}  // namespace
+
+
+PointSymbol::InstancingScope::InstancingScope(bool enabled)
+{
+	if (enabled && !current_cache)
+	{
+		cache = std::make_unique<Cache>();
+		current_cache = cache.get();
+	}
+}
+
+PointSymbol::InstancingScope::~InstancingScope()
+{
+	if (cache)
+		current_cache = nullptr;
+}
+
+
+
+// ### PointSymbol ###
+
 PointSymbol::PointSymbol() noexcept
 : Symbol { Symbol::Point }
 , inner_color { nullptr }
@@ -127,7 +186,7 @@ void PointSymbol::createRenderables(
 	}
 	else
 	{
-		createRenderablesScaled(coords[0], rotation, output);
+		createInstancedRenderables(coords[0], rotation, output);
 	}
 }
 
@@ -175,6 +234,57 @@ void PointSymbol::createRenderablesScaled(const MapCoordF& coord, qreal rotation
 	}
 }
 
+void PointSymbol::createInstancedRenderables(const MapCoordF& coord, qreal rotation, ObjectRenderables& output, qreal coord_scale) const
+{
+	auto* cache = current_cache;
+	if (!cache)
+	{
+		createRenderablesScaled(coord, rotation, output, coord_scale);
+		return;
+	}
+	
+	auto const key = InstancingScope::Cache::Key { this, rotation, coord_scale };
+	auto entry = cache->prototypes.find(key);
+	if (entry == cache->prototypes.end())
+	{
+		// Rotations are continuous, e.g. for mid symbols on curved lines.
+		// Prototypes are created only for keys which occur again.
+		if (cache->seen_once.insert(key).second
+		    || cache->prototypes.size() >= InstancingScope::Cache::max_size)
+		{
+			if (cache->seen_once.size() > InstancingScope::Cache::max_size)
+				cache->seen_once.clear();
+			createRenderablesScaled(coord, rotation, output, coord_scale);
+			return;
+		}
+		cache->seen_once.erase(key);
+		
+		// The prototype renderables, at the origin. Elements are not instanced
+		// on their own, so the cache is disabled while creating them.
+		InstancingScope::Cache::Prototypes prototypes;
+		PointObject prototype_object(this);
+		ObjectRenderables prototype_renderables(prototype_object);
+		current_cache = nullptr;
+		createRenderablesScaled(MapCoordF(0, 0), rotation, prototype_renderables, coord_scale);
+		current_cache = cache;
+		RenderableVector renderables;
+		prototypes.instanced = prototype_renderables.releaseRenderables(renderables);  // Not with nested clipping
+		prototypes.renderables.reserve(renderables.size());
+		for (auto* renderable : renderables)
+			prototypes.renderables.emplace_back(renderable);
+		entry = cache->prototypes.emplace(key, std::move(prototypes)).first;
+	}
+	
+	if (!entry->second.instanced)
+	{
+		createRenderablesScaled(coord, rotation, output, coord_scale);
+		return;
+	}
+	
+	for (auto const& prototype : entry->second.renderables)
+		output.insertRenderable(new InstancedRenderable(prototype, coord));
+}
+
 
 void PointSymbol::createRenderablesIfCenterInside(const MapCoordF& point_coord, qreal rotation, const QPainterPath* outline, ObjectRenderables& output) const
 {
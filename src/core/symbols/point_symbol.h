@@ -64,6 +64,33 @@ friend class PointSymbolSettings;
 friend class PointSymbolEditorWidget;
 friend class XMLImportExport;
 public:
+	/**
+	 * Enables the sharing of point symbol renderables in the current thread.
+	 * 
+	 * While an object of this class exists, createInstancedRenderables()
+	 * creates the renderables of a point symbol only once per rotation and
+	 * scale, as shared prototypes, when this combination occurs repeatedly.
+	 * The output receives instances which only store the position. Nested
+	 * scopes use the cache of the outermost scope.
+	 * 
+	 * Point symbols must not be modified while a scope exists.
+	 * A scope constructed with enabled set to false has no effect.
+	 */
+	class InstancingScope
+	{
+	public:
+		explicit InstancingScope(bool enabled = true);
+		InstancingScope(const InstancingScope&) = delete;
+		InstancingScope& operator=(const InstancingScope&) = delete;
+		~InstancingScope();
+		
+		struct Cache;
+		
+	private:
+		std::unique_ptr<Cache> cache;
+	};
+	
+	
 	/** Constructs an empty point symbol. */
 	PointSymbol() noexcept;
 	~PointSymbol() override;
@@ -83,6 +110,12 @@ public:
 	
 	void createRenderablesScaled(const MapCoordF& coord, qreal rotation, ObjectRenderables& output, qreal coord_scale = 1) const;
 	
+	/**
+	 * Creates renderables like createRenderablesScaled(), but shares the
+	 * renderables with other objects when an InstancingScope is active.
+	 */
+	void createInstancedRenderables(const MapCoordF& coord, qreal rotation, ObjectRenderables& output, qreal coord_scale = 1) const;
+	
 	void createRenderablesIfCenterInside(const MapCoordF& point_coord, qreal rotation, const QPainterPath* outline, ObjectRenderables& output) const;
 	void createPrimitivesIfCompletelyInside(const MapCoordF& point_coord, const QPainterPath* outline, ObjectRenderables& output) const;
 	void createRenderablesIfCompletelyInside(const MapCoordF& point_coord, qreal rotation, const QPainterPath* outline, ObjectRenderables& output) const;
@@ -21,7 +21,9 @@
 
 #include "track.h"
 
+#include <cstddef>
 #include <memory>
+#include <vector>
 
 #include <Qt>
 #include <QtGlobal>
@@ -367,10 +369,18 @@ bool Track::loadGpxFrom(QIODevice& device, bool project_points)
 void Track::projectPoints()
 {
 	/// \todo Check for errors from Georeferencing::toMapCoordF()
-	for (auto& waypoint : waypoints)
-		waypoint.map_coord = map_georef.toMapCoordF(waypoint.latlon, nullptr); 
-	for (auto& segment_point : segment_points)
-		segment_point.map_coord = map_georef.toMapCoordF(segment_point.latlon, nullptr); 
+	auto project = [this](std::vector<TrackPoint>& points) {
+		std::vector<LatLon> lat_lon;
+		lat_lon.reserve(points.size());
+		for (auto const& point : points)
+			lat_lon.push_back(point.latlon);
+		std::vector<MapCoordF> map_coords(points.size());
+		map_georef.toMapCoordF(lat_lon.data(), map_coords.data(), map_coords.size());
+		for (std::size_t i = 0; i < points.size(); ++i)
+			points[i].map_coord = map_coords[i];
+	};
+	project(waypoints);
+	project(segment_points);
 }
 
 
@@ -268,7 +268,8 @@ void Importer::validate()
 	}
 
 	// Update all objects without trying to remove their renderables first, this gives a significant speedup when loading large files
-	map->updateAllObjects(); // TODO: is the comment above still applicable?
+	// The renderables are generated in multiple threads.
+	map->updateAllObjectsConcurrently(); // TODO: is the comment above still applicable?
 }
 
 
@@ -25,6 +25,7 @@
 #include <algorithm>
 #include <array>
 #include <cstddef>
+#include <cstring>
 #include <iterator>
 #include <memory>
 #include <utility>
@@ -51,6 +52,7 @@
 #include <QTextDecoder>
 #include <QTextEncoder>
 #include <QTextStream>
+#include <QThread>
 #include <QTransform>
 #include <QVarLengthArray>
 #include <QVariant>
@@ -84,6 +86,7 @@
 #include "fileformats/ocd_types_v12.h"  // IWYU pragma: keep
 #include "templates/template.h"
 #include "templates/template_map.h"
+#include "util/concurrency.h"
 #include "util/encoding.h"
 #include "util/util.h"
 
@@ -570,6 +573,21 @@ QString stringForViewPar(const MapView& view, const MapCoord& area_offset, quint
 	return string_1030;
 }
 
+
+
+/// The name of the option which enables concurrent serialization of objects.
+QString concurrentExportOption()
+{
+	return QString::fromLatin1("Concurrent export");
+}
+
+/// The minimum number of objects for concurrent serialization.
+constexpr std::size_t min_concurrent_objects = 1024;
+
+/// The number of objects which are serialized to a single arena.
+constexpr std::size_t objects_per_arena = 256;
+
+
 } // namespace
 
 
@@ -604,6 +622,7 @@ OcdFileExport::OcdFileExport(const QString& path, const Map* map, const MapView*
 	if (!ocd_version)
 		ocd_version = default_version;
 	
+	setOption(concurrentExportOption(), true);
 }
 
 
@@ -2430,50 +2449,122 @@ QByteArray OcdFileExport::exportCombinedLineSymbol(
 template<class Format>
 void OcdFileExport::exportObjects(OcdFile<Format>& file)
 {
+	std::vector<const Object*> objects;
+	objects.reserve(std::size_t(map->getNumObjects()));
 	for (int l = 0; l < map->getNumParts(); ++l)
 	{
 		auto part = map->getPart(std::size_t(l));
 		for (int o = 0; o < part->getNumObjects(); ++o)
 		{
 			const auto* object = part->getObject(o);
-			
-			std::unique_ptr<Object> duplicate;
-			if (area_offset.nativeX() != 0 || area_offset.nativeY() != 0)
-			{
-				// Create a safely managed duplicate and move it as needed.
-				duplicate.reset(object->duplicate());
-				duplicate->move(-area_offset);  /// \todo move pattern origin etc.
-				object = duplicate.get();
-			}
 			object->update();
-			
-			QByteArray ocd_object;
-			auto entry = typename Format::Object::IndexEntryType {};
-			
-			switch (object->getType())
+			objects.push_back(object);
+		}
+	}
+	
+	auto const num_arenas = (objects.size() + objects_per_arena - 1) / objects_per_arena;
+	auto export_arena = [this, &objects](ObjectArena<Format>& arena, std::size_t index) {
+		auto const first = index * objects_per_arena;
+		auto const last = std::min(first + objects_per_arena, objects.size());
+		exportObjects(arena, objects.data() + first, objects.data() + last);
+	};
+	
+	if (objects.size() >= min_concurrent_objects
+	    && QThread::idealThreadCount() > 1
+	    && option(concurrentExportOption()).toBool())
+	{
+		std::vector<ObjectArena<Format>> arenas(num_arenas);
+		Util::forEachRangeConcurrently(num_arenas, [&arenas, &export_arena](std::size_t first, std::size_t last) {
+			for (auto i = first; i < last; ++i)
+				export_arena(arenas[i], i);
+		}, 1);
+		
+		auto size = file.byteArray().size();
+		for (auto const& arena : arenas)
+			size += arena.data.size() + int(arena.records.size() * sizeof(typename Format::Object::IndexEntryType));
+		file.byteArray().reserve(size);
+		
+		for (auto& arena : arenas)
+			insertObjects(file, arena);
+	}
+	else
+	{
+		for (std::size_t i = 0; i < num_arenas; ++i)
+		{
+			ObjectArena<Format> arena;
+			export_arena(arena, i);
+			insertObjects(file, arena);
+		}
+	}
+}
+
+
+/**
+ * Serializes point and path objects to the arena.
+ * 
+ * This function may run in a worker thread. Text objects depend on font
+ * handling which is left to the main thread, so they are only recorded for
+ * serialization during insertion.
+ */
+template<class Format>
+void OcdFileExport::exportObjects(ObjectArena<Format>& arena, const Object* const* first, const Object* const* last)
+{
+	for (auto current = first; current != last; ++current)
+	{
+		const auto* object = *current;
+		switch (object->getType())
+		{
+		case Object::Point:
 			{
-			case Object::Point:
-				ocd_object = exportPointObject<typename Format::Object>(static_cast<const PointObject*>(object), entry);
-				FILEFORMAT_ASSERT(!ocd_object.isEmpty());
-				file.objects().insert(ocd_object, entry);
-				break;
-				
-			case Object::Path:
-				exportPathObject<Format>(file, static_cast<const PathObject*>(object));
-				break;
-				
-			case Object::Text:
-				ocd_object = exportTextObject<typename Format::Object>(static_cast<const TextObject*>(object), entry);
-				FILEFORMAT_ASSERT(!ocd_object.isEmpty());
-				file.objects().insert(ocd_object, entry);
-				break;
+				auto const pos = arena.data.size();
+				auto entry = typename Format::Object::IndexEntryType {};
+				exportPointObject<typename Format::Object>(static_cast<const PointObject*>(object), entry, arena.data);
+				FILEFORMAT_ASSERT(arena.data.size() > pos);
+				arena.records.push_back({ entry, pos, arena.data.size() - pos });
 			}
+			break;
+			
+		case Object::Path:
+			exportPathObject<Format>(arena, static_cast<const PathObject*>(object));
+			break;
 			
+		case Object::Text:
+			arena.records.push_back({ {}, 0, 0, static_cast<const TextObject*>(object) });
+			break;
 		}
 	}
 }
 
 
+/**
+ * Inserts the objects from the arena into the file, and releases the arena.
+ */
+template<class Format>
+void OcdFileExport::insertObjects(OcdFile<Format>& file, ObjectArena<Format>& arena)
+{
+	for (auto const& warning : arena.warnings)
+		addWarning(warning);
+	
+	for (auto const& record : arena.records)
+	{
+		if (record.text)
+		{
+			QByteArray data;
+			auto entry = typename Format::Object::IndexEntryType {};
+			exportTextObject<typename Format::Object>(record.text, entry, data);
+			FILEFORMAT_ASSERT(!data.isEmpty());
+			file.objects().insert(data, entry);
+		}
+		else
+		{
+			file.objects().insert(QByteArray::fromRawData(arena.data.constData() + record.pos, record.size), record.entry);
+		}
+	}
+	
+	arena = {};
+}
+
+
 /**
  * Object setup which depends on the type features, not on minor type variations of members.
  */
@@ -2503,18 +2594,18 @@ void OcdFileExport::handleObjectExtras<Ocd::ObjectV8>(const Object* /*object*/,
 
 
 template< class OcdObject >
-QByteArray OcdFileExport::exportPointObject(const PointObject* point, typename OcdObject::IndexEntryType& entry)
+void OcdFileExport::exportPointObject(const PointObject* point, typename OcdObject::IndexEntryType& entry, QByteArray& data)
 {
 	OcdObject ocd_object = {};
 	ocd_object.type = 1;
-	ocd_object.symbol = entry.symbol = decltype(entry.symbol)(symbol_numbers[point->getSymbol()]);
+	ocd_object.symbol = entry.symbol = decltype(entry.symbol)(symbolNumber(point->getSymbol()));
 	ocd_object.angle = decltype(ocd_object.angle)(convertRotation(point->getRotation()));
-	return exportObjectCommon(point, ocd_object, entry);
+	exportObjectCommon(point, ocd_object, entry, data);
 }
 
 
 template< class Format >
-void OcdFileExport::exportPathObject(OcdFile<Format>& file, const PathObject* path, bool lines_only)
+void OcdFileExport::exportPathObject(ObjectArena<Format>& arena, const PathObject* path, bool lines_only)
 {
 	typename Format::Object ocd_object = {};
 	typename Format::Object::IndexEntryType entry = {};
@@ -2531,7 +2622,7 @@ void OcdFileExport::exportPathObject(OcdFile<Format>& file, const PathObject* pa
 			if (static_cast<const AreaSymbol*>(symbol)->hasRotatableFillPattern())
 				ocd_object.angle = decltype(ocd_object.angle)(convertRotation(path->getPatternRotation()));
 			if (path->getPatternOrigin() != MapCoord(0, 0))
-				addWarning(::OpenOrienteering::OcdFileExport::tr("Unable to export fill pattern shift for an area object"));
+				arena.warnings.push_back(::OpenOrienteering::OcdFileExport::tr("Unable to export fill pattern shift for an area object"));
 		}
 	}
 	else
@@ -2543,22 +2634,26 @@ void OcdFileExport::exportPathObject(OcdFile<Format>& file, const PathObject* pa
 	
 	if (!need_split_lines)
 	{
-		ocd_object.symbol = entry.symbol = decltype(entry.symbol)(symbol_numbers[symbol]);
-		auto data = exportObjectCommon(path, ocd_object, entry);
-		FILEFORMAT_ASSERT(!data.isEmpty());
+		ocd_object.symbol = entry.symbol = decltype(entry.symbol)(symbolNumber(symbol));
+		auto const pos = arena.data.size();
+		exportObjectCommon(path, ocd_object, entry, arena.data);
+		auto const size = arena.data.size() - pos;
+		FILEFORMAT_ASSERT(size > 0);
 		
 		auto breakdown_index_entry = breakdown_index.find(quint32(entry.symbol));
 		if (breakdown_index_entry == end(breakdown_index))
 		{
 			// Regular symbol which does not need to be split
-			file.objects().insert(data, entry);
+			arena.records.push_back({ entry, pos, size });
 			return;
 		}
 		
-		// Combined symbol
+		// Combined symbol: The first record reuses the exported data,
+		// each further record is a copy with modified symbol and type.
 		auto backlog = std::vector<quint32>();
 		auto offset = quint32(breakdown_index_entry->second);
-		auto& exported_ocd_object = reinterpret_cast<typename Format::Object&>(*data.data());
+		auto record_pos = pos;
+		auto record_used = false;
 		do
 		{
 			auto breakdown = begin(breakdown_list) + offset;
@@ -2583,10 +2678,20 @@ void OcdFileExport::exportPathObject(OcdFile<Format>& file, const PathObject* pa
 					continue;
 				}
 				
+				if (record_used)
+				{
+					// Not using append() which may read from reallocated memory.
+					record_pos = arena.data.size();
+					arena.data.resize(record_pos + size);
+					std::memcpy(arena.data.data() + record_pos, arena.data.constData() + pos, std::size_t(size));
+				}
+				record_used = true;
+				
+				auto& exported_ocd_object = reinterpret_cast<typename Format::Object&>(*(arena.data.data() + record_pos));
 				exported_ocd_object.symbol = entry.symbol = decltype(entry.symbol)(breakdown->number);
 				exported_ocd_object.type = decltype(exported_ocd_object.type)(breakdown->type);
 				handleObjectExtras(path, exported_ocd_object, entry);  // update entry.type if it exists
-				file.objects().insert(data, entry);
+				arena.records.push_back({ entry, record_pos, size });
 			}
 			
 			if (backlog.empty())
@@ -2604,7 +2709,7 @@ void OcdFileExport::exportPathObject(OcdFile<Format>& file, const PathObject* pa
 			PathObject split_line{part};
 			split_line.setSymbol(path->getSymbol(), true);
 			split_line.update();
-			exportPathObject(file, &split_line, true);
+			exportPathObject(arena, &split_line, true);
 		}
 	}
 	
@@ -2612,7 +2717,7 @@ void OcdFileExport::exportPathObject(OcdFile<Format>& file, const PathObject* pa
 
 
 template< class OcdObject >
-QByteArray OcdFileExport::exportTextObject(const TextObject* text, typename OcdObject::IndexEntryType& entry)
+void OcdFileExport::exportTextObject(const TextObject* text, typename OcdObject::IndexEntryType& entry, QByteArray& data)
 {
 	auto symbol = static_cast<const TextSymbol*>(text->getSymbol());
 	auto alignment = text->getHorizontalAlignment();
@@ -2625,12 +2730,12 @@ QByteArray OcdFileExport::exportTextObject(const TextObject* text, typename OcdO
 	ocd_object.type = text->hasSingleAnchor() ? 4 : 5;
 	ocd_object.symbol = entry.symbol = decltype(entry.symbol)(text_format->symbol_number);
 	ocd_object.angle = decltype(ocd_object.angle)(convertRotation(text->getRotation()));
-	return exportObjectCommon(text, ocd_object, entry);
+	exportObjectCommon(text, ocd_object, entry, data);
 }
 
 
 template< class OcdObject >
-QByteArray OcdFileExport::exportObjectCommon(const Object* object, OcdObject& ocd_object, typename OcdObject::IndexEntryType& entry)
+void OcdFileExport::exportObjectCommon(const Object* object, OcdObject& ocd_object, typename OcdObject::IndexEntryType& entry, QByteArray& data)
 {
 	const auto& coords = object->getRawCoordinateVector();
 	QByteArray text_data;
@@ -2659,35 +2764,38 @@ QByteArray OcdFileExport::exportObjectCommon(const Object* object, OcdObject& oc
 	handleObjectExtras(object, ocd_object, entry);
 	
 	auto bottom_left = MapCoord(object->getExtent().bottomLeft());
+	bottom_left -= area_offset;
 	auto top_right = MapCoord(object->getExtent().topRight());
+	top_right -= area_offset;
 	
 	auto header_size = int(sizeof(OcdObject) - sizeof(Ocd::OcdPoint32));
 	auto items_size = int((ocd_object.num_items + ocd_object.num_text) * sizeof(Ocd::OcdPoint32));
 	
-	QByteArray data;
-	data.reserve(header_size + items_size);
+	// The data is aligned, because each object's data is padded.
+	auto const pos = data.size();
+	FILEFORMAT_ASSERT(pos % 8 == 0);
 	data.append(reinterpret_cast<const char*>(&ocd_object), header_size);
 	if (ocd_object.num_items > 0)
 	{
 		switch(ocd_object.type)
 		{
 		case 4:
-			exportTextCoordinatesSingle(static_cast<const TextObject*>(object), data, bottom_left, top_right);
+			exportTextCoordinatesSingle(static_cast<const TextObject*>(object), data, bottom_left, top_right, area_offset);
 			data.append(text_data);
 			break;
 		case 5:
-			exportTextCoordinatesBox(static_cast<const TextObject*>(object), data, bottom_left, top_right);
+			exportTextCoordinatesBox(static_cast<const TextObject*>(object), data, bottom_left, top_right, area_offset);
 			data.append(text_data);
 			break;
 		default:
-			exportCoordinates(coords, object->getSymbol(), data, bottom_left, top_right);
+			exportCoordinates(coords, object->getSymbol(), data, bottom_left, top_right, area_offset);
 		}
 	}
-	FILEFORMAT_ASSERT(data.size() == header_size + items_size);
+	FILEFORMAT_ASSERT(data.size() - pos == header_size + items_size);
 	
 	entry.bottom_left_bound = convertPoint(bottom_left);
 	entry.top_right_bound = convertPoint(top_right);
-	entry.size = decltype(entry.size)((Ocd::addPadding(data).size()));
+	entry.size = decltype(entry.size)((Ocd::addPadding(data).size() - pos));
 	// According to OCD format 8 documentation, size (aka len) is in bytes
 	// for OCD version 6 and 7 files.
 	// However, in contrast to OCD format 9...12 documentation, size seems to be
@@ -2695,8 +2803,6 @@ QByteArray OcdFileExport::exportObjectCommon(const Object* object, OcdObject& oc
 	// unusable (due to "damaged objects") in OCD 9 and 10 software.
 	if (ocd_version == 8)
 		entry.size = (entry.size - decltype(entry.size)(header_size)) / sizeof(Ocd::OcdPoint32);
-	
-	return data;
 }
 
 
@@ -2924,14 +3030,16 @@ quint16 OcdFileExport::exportCoordinates(const MapCoordVector& coords, const Sym
 	return exportCoordinates(coords, symbol, byte_array, bottom_left, top_right);
 }
 
-quint16 OcdFileExport::exportCoordinates(const MapCoordVector& coords, const Symbol* symbol, QByteArray& byte_array, MapCoord& bottom_left, MapCoord& top_right)
+quint16 OcdFileExport::exportCoordinates(const MapCoordVector& coords, const Symbol* symbol, QByteArray& byte_array, MapCoord& bottom_left, MapCoord& top_right, const MapCoord& offset)
 {
 	quint16 num_points = 0;
 	bool curve_start = false;
 	bool hole_point = false;
 	bool curve_continue = false;
-	for (const auto& point : coords)
+	for (auto point : coords)
 	{
+		point -= offset;
+		
 		if (point.nativeX() < bottom_left.nativeX())
 			bottom_left.setNativeX(point.nativeX());
 		else if (point.nativeX() > top_right.nativeX())
@@ -2973,7 +3081,7 @@ quint16 OcdFileExport::exportCoordinates(const MapCoordVector& coords, const Sym
 }
 
 
-quint16 OcdFileExport::exportTextCoordinatesSingle(const TextObject* object, QByteArray& byte_array, MapCoord& bottom_left, MapCoord& top_right)
+quint16 OcdFileExport::exportTextCoordinatesSingle(const TextObject* object, QByteArray& byte_array, MapCoord& bottom_left, MapCoord& top_right, const MapCoord& offset)
 {
 	if (object->getNumLines() == 0)
 		return 0;
@@ -3006,8 +3114,10 @@ quint16 OcdFileExport::exportTextCoordinatesSingle(const TextObject* object, QBy
 	    MapCoord(text_to_map.map(bounding_box_text.topRight())),
 	    MapCoord(text_to_map.map(bounding_box_text.topLeft()))
 	};
-	for (const auto& point : coords)
+	for (auto point : coords)
 	{
+		point -= offset;
+		
 		if (point.nativeX() < bottom_left.nativeX())
 			bottom_left.setNativeX(point.nativeX());
 		else if (point.nativeX() > top_right.nativeX())
@@ -3025,7 +3135,7 @@ quint16 OcdFileExport::exportTextCoordinatesSingle(const TextObject* object, QBy
 }
 
 
-quint16 OcdFileExport::exportTextCoordinatesBox(const TextObject* object, QByteArray& byte_array, MapCoord& bottom_left, MapCoord& top_right)
+quint16 OcdFileExport::exportTextCoordinatesBox(const TextObject* object, QByteArray& byte_array, MapCoord& bottom_left, MapCoord& top_right, const MapCoord& offset)
 {
 	if (object->getNumLines() == 0)
 		return 0;
@@ -3049,8 +3159,10 @@ quint16 OcdFileExport::exportTextCoordinatesBox(const TextObject* object, QByteA
 	    MapCoord(transform.map(QPointF(object->getBoxWidth() / 2, new_top)) + object->getAnchorCoordF()),
 	    MapCoord(transform.map(QPointF(-object->getBoxWidth() / 2, new_top)) + object->getAnchorCoordF())
 	};
-	for (const auto& point : coords)
+	for (auto point : coords)
 	{
+		point -= offset;
+		
 		if (point.nativeX() < bottom_left.nativeX())
 			bottom_left.setNativeX(point.nativeX());
 		else if (point.nativeX() > top_right.nativeX())
@@ -3126,4 +3238,11 @@ quint32 OcdFileExport::makeUniqueSymbolNumber(quint32 initial_number) const
 }
 
 
+quint32 OcdFileExport::symbolNumber(const Symbol* symbol) const
+{
+	auto number = symbol_numbers.find(symbol);
+	return number != end(symbol_numbers) ? number->second : 0;
+}
+
+
 }  // namespace OpenOrienteering
@@ -251,23 +251,57 @@ protected:
 	        const LineSymbol* double_line );
 	
 	
+	/**
+	 * Serialized objects, waiting for insertion into the file.
+	 * 
+	 * The entity data of all records is appended to a single byte array, so
+	 * that serialization doesn't need an allocation per object. Arenas are
+	 * filled in worker threads, and inserted into the file in order.
+	 */
+	template< class Format >
+	struct ObjectArena
+	{
+		struct Record
+		{
+			typename Format::Object::IndexEntryType entry;
+			int pos;                          ///< The position of the entity data in the arena
+			int size;                         ///< The size of the entity data in the arena
+			const TextObject* text = nullptr; ///< A text object to be serialized on insertion
+		};
+		
+		QByteArray data;
+		std::vector<Record> records;
+		std::vector<QString> warnings;
+	};
+	
 	template< class Format >
 	void exportObjects(OcdFile<Format>& file);
 	
+	template< class Format >
+	void exportObjects(ObjectArena<Format>& arena, const Object* const* first, const Object* const* last);
+	
+	template< class Format >
+	void insertObjects(OcdFile<Format>& file, ObjectArena<Format>& arena);
+	
 	template< class OcdObject >
 	void handleObjectExtras(const Object* object, OcdObject& ocd_object, typename OcdObject::IndexEntryType& entry);
 	
 	template< class OcdObject >
-	QByteArray exportPointObject(const PointObject* point, typename OcdObject::IndexEntryType& entry);
+	void exportPointObject(const PointObject* point, typename OcdObject::IndexEntryType& entry, QByteArray& data);
 	
 	template< class Format >
-	void exportPathObject(OcdFile<Format>& file, const PathObject* path, bool lines_only = false);
+	void exportPathObject(ObjectArena<Format>& arena, const PathObject* path, bool lines_only = false);
 	
 	template< class OcdObject >
-	QByteArray exportTextObject(const TextObject* text, typename OcdObject::IndexEntryType& entry);
+	void exportTextObject(const TextObject* text, typename OcdObject::IndexEntryType& entry, QByteArray& data);
 	
+	/**
+	 * Appends the padded entity data of the given object to data.
+	 * 
+	 * The area offset is applied to the coordinates.
+	 */
 	template< class OcdObject >
-	QByteArray exportObjectCommon(const Object* object, OcdObject& ocd_object, typename OcdObject::IndexEntryType& entry);
+	void exportObjectCommon(const Object* object, OcdObject& ocd_object, typename OcdObject::IndexEntryType& entry, QByteArray& data);
 	
 	
 	template< class Format >
@@ -292,11 +326,11 @@ protected:
 	
 	quint16 exportCoordinates(const MapCoordVector& coords, const Symbol* symbol, QByteArray& byte_array);
 	
-	quint16 exportCoordinates(const MapCoordVector& coords, const Symbol* symbol, QByteArray& byte_array, MapCoord& bottom_left, MapCoord& top_right);
+	quint16 exportCoordinates(const MapCoordVector& coords, const Symbol* symbol, QByteArray& byte_array, MapCoord& bottom_left, MapCoord& top_right, const MapCoord& offset = {});
 	
-	quint16 exportTextCoordinatesSingle(const TextObject* object, QByteArray& byte_array, MapCoord& bottom_left, MapCoord& top_right);
+	quint16 exportTextCoordinatesSingle(const TextObject* object, QByteArray& byte_array, MapCoord& bottom_left, MapCoord& top_right, const MapCoord& offset = {});
 	
-	quint16 exportTextCoordinatesBox(const TextObject* object, QByteArray& byte_array, MapCoord& bottom_left, MapCoord& top_right);
+	quint16 exportTextCoordinatesBox(const TextObject* object, QByteArray& byte_array, MapCoord& bottom_left, MapCoord& top_right, const MapCoord& offset = {});
 	
 	QByteArray exportTextData(const TextObject* object, int chunk_size, int max_chunks);
 	
@@ -306,6 +340,13 @@ protected:
 	
 	quint32 makeUniqueSymbolNumber(quint32 initial_number) const;
 	
+	/**
+	 * Returns the number of the given symbol, or 0 if it is not exported.
+	 * 
+	 * In contrast to symbol_numbers[symbol], this is safe for concurrent use.
+	 */
+	quint32 symbolNumber(const Symbol* symbol) const;
+	
 	
 private:
 	/// The locale is used for number formatting.
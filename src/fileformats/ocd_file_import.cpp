@@ -39,6 +39,7 @@
 #include <QCoreApplication>
 #include <QDebug>
 #include <QDir>
+#include <QFile>
 #include <QFlags>
 #include <QFontMetricsF>
 #include <QIODevice>
@@ -48,6 +49,7 @@
 #include <QPointF>
 #include <QTextCodec>
 #include <QTextDecoder>
+#include <QThread>
 #include <QVariant>
 
 #include "settings.h"
@@ -77,6 +79,7 @@
 #include "templates/template.h"
 #include "templates/template_map.h"
 #include "templates/template_placeholder.h"
+#include "util/concurrency.h"
 #include "util/encoding.h"
 #include "util/util.h"
 
@@ -93,6 +96,36 @@ static QTextCodec* codecFromSettings()
 }	
 
 
+/// The name of the option which enables memory-mapping and concurrent decoding.
+QString concurrentImportOption()
+{
+	return QString::fromLatin1("Concurrent import");
+}
+
+/// The minimum number of objects for concurrent decoding.
+constexpr std::size_t min_concurrent_objects = 1024;
+
+
+/**
+ * Releases a file mapping, after resetting the buffer which refers to it.
+ */
+struct FileMapping
+{
+	QByteArray& buffer;
+	QFile* file = nullptr;
+	uchar* data = nullptr;
+	
+	~FileMapping()
+	{
+		if (data)
+		{
+			buffer = {};
+			file->unmap(data);
+		}
+	}
+};
+
+
 }  // namespace
 
 
@@ -106,6 +139,8 @@ OcdFileImport::OcdFileImport(const QString& path, Map* map, MapView* view)
  : Importer { path, map, view }
  , custom_8bit_encoding { codecFromSettings() }
 {
+	setOption(concurrentImportOption(), true);
+	
 	if (!custom_8bit_encoding)
 	{
 		addWarning(tr("Encoding '%1' is not available. Check the settings."));
@@ -851,14 +886,13 @@ void OcdFileImport::importObjects(const OcdFile<Ocd::FormatV8>& file)
 	MapPart* part = map->getCurrentPart();
 	FILEFORMAT_ASSERT(part);
 	
+	std::vector<const Ocd::FormatV8::Object*> ocd_objects;
 	for (auto ocd_object : file.objects())
 	{
 		if (ocd_object.entry->symbol)
-		{
-			if (auto object = importObject(*ocd_object.entity, part))
-				part->addObject(object, part->getNumObjects());
-		}
+			ocd_objects.push_back(ocd_object.entity);
 	}
+	importObjectList(ocd_objects, part);
 }
 
 template< class F >
@@ -867,16 +901,56 @@ void OcdFileImport::importObjects(const OcdFile< F >& file)
 	MapPart* part = map->getCurrentPart();
 	FILEFORMAT_ASSERT(part);
 	
+	std::vector<const typename F::Object*> ocd_objects;
 	for (auto ocd_object : file.objects())
 	{
 		if ( ocd_object.entry->symbol
 		     && ocd_object.entry->status != Ocd::ObjectDeleted
 		     && ocd_object.entry->status != Ocd::ObjectDeletedForUndo )
 		{
-			if (auto object = importObject(*ocd_object.entity, part))
-				part->addObject(object, part->getNumObjects());
+			ocd_objects.push_back(ocd_object.entity);
 		}
 	}
+	importObjectList(ocd_objects, part);
+}
+
+template< class O >
+void OcdFileImport::importObjectList(const std::vector<const O*>& ocd_objects, MapPart* part)
+{
+	// Objects decoded in worker threads, nullptr where the main thread must do it
+	std::vector<Object*> objects(ocd_objects.size(), nullptr);
+	
+	if (ocd_objects.size() >= min_concurrent_objects
+	    && QThread::idealThreadCount() > 1
+	    && option(concurrentImportOption()).toBool())
+	{
+		try
+		{
+			Util::forEachRangeConcurrently(ocd_objects.size(), [this, &ocd_objects, &objects](std::size_t first, std::size_t last) {
+				for (auto i = first; i < last; ++i)
+				{
+					if (canImportConcurrently(*ocd_objects[i]))
+						objects[i] = importObject(*ocd_objects[i], nullptr);
+				}
+			});
+		}
+		catch (...)
+		{
+			for (auto* object : objects)
+				delete object;
+			throw;
+		}
+	}
+	
+	// Insertion in index order, for deterministic output
+	for (std::size_t i = 0; i < ocd_objects.size(); ++i)
+	{
+		auto* object = objects[i];
+		if (!object)
+			object = importObject(*ocd_objects[i], part);
+		if (object)
+			part->addObject(object, part->getNumObjects());
+	}
 }
 
 
@@ -1885,7 +1959,7 @@ Object* OcdFileImport::importObject(const O& ocd_object, MapPart* part)
 	Symbol* symbol = nullptr;
 	if (ocd_object.symbol >= 0)
 	{
-		symbol = symbol_index[ocd_object.symbol];
+		symbol = symbol_index.value(ocd_object.symbol);
 	}
 	
 	if (!symbol)
@@ -1912,7 +1986,7 @@ Object* OcdFileImport::importObject(const O& ocd_object, MapPart* part)
 		
 	if (symbol->getType() == Symbol::Line && rectangle_info.contains(ocd_object.symbol))
 	{
-		Object* object = importRectangleObject(ocd_object, part, rectangle_info[ocd_object.symbol]);
+		Object* object = importRectangleObject(ocd_object, part, *rectangle_info.constFind(ocd_object.symbol));
 		if (!object)
 			addWarning(OcdFileImport::tr("Unable to import rectangle object"));
 		return object;
@@ -1978,6 +2052,36 @@ Object* OcdFileImport::importObject(const O& ocd_object, MapPart* part)
 	return nullptr;
 }
 
+template< class O >
+bool OcdFileImport::canImportConcurrently(const O& ocd_object) const
+{
+	if (ocd_object.symbol < 0)
+		return false;
+	
+	const auto* symbol = symbol_index.value(ocd_object.symbol);
+	if (!symbol)
+		return false;
+	
+	switch (symbol->getType())
+	{
+	case Symbol::Point:
+		// Otherwise, importObject() may need to make the symbol rotatable.
+		return ocd_object.angle == 0 || static_cast<const PointSymbol*>(symbol)->isRotatable();
+	case Symbol::Line:
+		// Rectangle objects add grid objects to the map part.
+		return !rectangle_info.contains(ocd_object.symbol);
+	case Symbol::Area:
+	case Symbol::Combined:
+		return true;
+	case Symbol::Text:
+	case Symbol::NoSymbol:
+	case Symbol::AllSymbols:
+		break;
+	}
+	return false;
+}
+
+
 QString OcdFileImport::getObjectText(const Ocd::ObjectV8& ocd_object) const
 {
 	auto input  = ocd_object.coords + ocd_object.num_items;
@@ -2383,7 +2487,21 @@ void OcdFileImport::setFraming(OcdFileImport::OcdImportedTextSymbol* symbol, con
 
 bool OcdFileImport::importImplementation()
 {
-	buffer = device()->readAll();
+	// Regular files are memory-mapped instead of being copied.
+	FileMapping mapping { buffer };
+	if (option(concurrentImportOption()).toBool())
+	{
+		mapping.file = qobject_cast<QFile*>(device());
+		if (mapping.file && mapping.file->pos() == 0
+		    && mapping.file->size() > 0 && mapping.file->size() <= std::numeric_limits<int>::max())
+		{
+			mapping.data = mapping.file->map(0, mapping.file->size());
+		}
+	}
+	if (mapping.data)
+		buffer = QByteArray::fromRawData(reinterpret_cast<const char*>(mapping.data), int(mapping.file->size()));
+	else
+		buffer = device()->readAll();
 	if (buffer.isEmpty())
 		throw FileFormatException(device()->errorString());
 	
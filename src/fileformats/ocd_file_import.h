@@ -60,6 +60,10 @@ class Symbol;
 
 /**
  * An map file importer for OC*D files.
+ * 
+ * With the option "Concurrent import" (enabled by default), regular files are
+ * memory-mapped instead of being copied, and objects are decoded by multiple
+ * threads. The resulting map is identical to the one from sequential import.
  */
 class OcdFileImport : public Importer
 {
@@ -212,6 +216,15 @@ protected:
 	template< class F >
 	void importObjects(const OcdFile< F >& file);
 	
+	/**
+	 * Imports the given objects into the map part, in the given order.
+	 * 
+	 * Depending on the options and on the number of objects, objects are
+	 * decoded concurrently, cf. canImportConcurrently().
+	 */
+	template< class O >
+	void importObjectList(const std::vector<const O*>& ocd_objects, MapPart* part);
+	
 	
 	template< class F >
 	void importTemplates(const OcdFile< F >& file);
@@ -304,6 +317,17 @@ protected:
 	template< class O >
 	Object* importObject(const O& ocd_object, MapPart* part);
 	
+	/**
+	 * Returns true if importObject() may be called for the given object in a
+	 * worker thread.
+	 * 
+	 * This is the case when the import neither modifies the symbol nor the
+	 * map part, and when it does not emit warnings. Other objects are imported
+	 * in the main thread.
+	 */
+	template< class O >
+	bool canImportConcurrently(const O& ocd_object) const;
+	
 	QString getObjectText(const Ocd::ObjectV8& ocd_object) const;
 	
 	template< class O >
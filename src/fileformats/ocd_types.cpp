@@ -483,7 +483,7 @@ typename OcdEntityIndex<F,T>::EntryType& OcdEntityIndex<F,T>::insert(const QByte
 {
 	auto& byte_array = Ocd::addPadding(file.byteArray());
 	IndexBlock* block;
-	auto next_block_pos = firstBlock<typename T::IndexEntryType>();
+	auto next_block_pos = last_block ? last_block : firstBlock<typename T::IndexEntryType>();
 	auto block_pos = decltype(next_block_pos)(0);
 	do
 	{
@@ -512,6 +512,8 @@ typename OcdEntityIndex<F,T>::EntryType& OcdEntityIndex<F,T>::insert(const QByte
 		index = 0;
 	}
 	
+	last_block = block_pos;
+	
 	auto entity_pos = decltype(block->entries[index].pos)(byte_array.size());
 	byte_array.append(entity_data); // May reallocate! Re-calculate block pointer:
 	block = Ocd::getBlockChecked<IndexBlock>(byte_array, block_pos);
@@ -501,6 +501,8 @@ public:
 	 * 
 	 *     auto& object_entry = object_index.insert(ocd_object, prototype);
 	 * 
+	 * The position of the last index block is cached, so that a sequence of
+	 * insertions doesn't need to follow the chain of index blocks each time.
 	 */
 	EntryType& insert(const QByteArray& entity_data, const EntryType& entry);
 	
@@ -530,6 +532,7 @@ private:
 	quint32 firstBlock() const;
 	
 	OcdFile<F>& file;
+	quint32 last_block = 0;
 };
 
 
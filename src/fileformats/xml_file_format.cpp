@@ -30,11 +30,13 @@
 #include <utility>
 
 #include <QtGlobal>
+#include <QBuffer>
 #include <QByteArray>
 #include <QDir>
 #include <QExplicitlySharedDataPointer>
 #include <QFileInfo>
 #include <QFlags>
+#include <QHash>
 #include <QIODevice>
 #include <QLatin1String>
 #include <QLocale>
@@ -56,11 +58,13 @@
 #include "core/map_part.h"
 #include "core/map_printer.h"  // IWYU pragma: keep
 #include "core/map_view.h"
+#include "core/objects/object.h"
 #include "core/symbols/line_symbol.h"
 #include "core/symbols/point_symbol.h"
 #include "core/symbols/symbol.h"
 #include "fileformats/file_import_export.h"
 #include "templates/template.h"
+#include "undo/undo.h"
 #include "undo/undo_manager.h"
 #include "util/xml_stream_util.h"
 
@@ -70,7 +74,9 @@ namespace OpenOrienteering {
 // ### XMLFileFormat definition ###
 
 constexpr int XMLFileFormat::minimum_version = 2;
-constexpr int XMLFileFormat::current_version = 9;
+constexpr int XMLFileFormat::current_version = 11;
+constexpr int XMLFileFormat::compact_coordinates_version;
+constexpr int XMLFileFormat::coordinates_undo_version;
 
 int XMLFileFormat::active_version = 5; // updated by XMLFileExporter::doExport()
 
@@ -189,6 +195,7 @@ namespace literal
 	
 	static const QLatin1String parts("parts");
 	static const QLatin1String part("part");
+	static const QLatin1String objects("objects");
 	
 	static const QLatin1String templates("templates");
 	static const QLatin1String template_string("template");
@@ -222,6 +229,11 @@ XMLFileExporter::XMLFileExporter(const QString& path, const Map* map, const MapV
 	// Determine auto-formatting default from filename, if possible.
 	bool auto_formatting = path.endsWith(QLatin1String(".xmap"));
 	setOption(QString::fromLatin1("autoFormatting"), auto_formatting);
+	// Compact coordinates raise the format version to 10, which cannot be
+	// read by Mapper versions before 0.9.6.
+	setOption(QString::fromLatin1("compactCoordinates"), false);
+	// Reuse the serialization of unmodified objects from the previous export.
+	setOption(QString::fromLatin1("objectCache"), false);
 }
 
 XMLFileExporter::~XMLFileExporter() = default;
@@ -247,6 +259,19 @@ bool XMLFileExporter::exportImplementation()
 #else
 	XMLFileFormat::active_version = XMLFileFormat::current_version;
 #endif
+	if (XMLFileFormat::active_version >= XMLFileFormat::coordinates_undo_version)
+	{
+		// Coordinates undo steps are guarded by the undo barrier only.
+		XMLFileFormat::active_version = XMLFileFormat::coordinates_undo_version - 1;
+	}
+	if (XMLFileFormat::active_version >= XMLFileFormat::compact_coordinates_version
+	    && (!option(QString::fromLatin1("compactCoordinates")).toBool() || xml.autoFormatting()))
+	{
+		// Without compact coordinates, the file is compatible with version 9.
+		XMLFileFormat::active_version = XMLFileFormat::compact_coordinates_version - 1;
+	}
+	auto const barrier_version = XMLFileFormat::active_version >= XMLFileFormat::compact_coordinates_version ? XMLFileFormat::compact_coordinates_version : 6;
+	auto const barrier_required = barrier_version == 6 ? "0.6.0" : "0.9.6";
 	
 	xml.writeDefaultNamespace(mapperNamespace());
 	xml.writeStartDocument();
@@ -269,10 +294,10 @@ bool XMLFileExporter::exportImplementation()
 		{
 			// Prevent Mapper versions < 0.6.0 from crashing
 			// when compatibility mode is NOT activated
-			// Incompatible feature: dense coordinates
+			// Incompatible feature: dense coordinates, compact coordinates
 			barrier = new XmlElementWriter(xml, literal::barrier);
-			barrier->writeAttribute(literal::version, 6);
-			barrier->writeAttribute(literal::required, "0.6.0");
+			barrier->writeAttribute(literal::version, barrier_version);
+			barrier->writeAttribute(literal::required, barrier_required);
 			writeLineBreak(xml);
 		}
 		exportSymbols();
@@ -290,13 +315,21 @@ bool XMLFileExporter::exportImplementation()
 		if (Settings::getInstance().getSetting(Settings::General_SaveUndoRedo).toBool()
 		    && (map->undoManager().canUndo() || map->undoManager().canRedo()) )
 		{
+			auto undo_barrier_version = barrier_version;
+			auto undo_barrier_required = barrier_required;
+			if (map->undoManager().containsStepType(UndoStep::ObjectCoordinatesUndoStepType))
+			{
+				undo_barrier_version = XMLFileFormat::coordinates_undo_version;
+				undo_barrier_required = "0.9.6";
+			}
+			
 			{
 				// Prevent Mapper versions < 0.6.0 from crashing
 				// when compatibility mode IS activated
-				// Incompatible feature: new undo step types
+				// Incompatible feature: new undo step types, compact coordinates
 				XmlElementWriter barrier(xml, literal::barrier);
-				barrier.writeAttribute(literal::version, 6);
-				barrier.writeAttribute(literal::required, "0.6.0");
+				barrier.writeAttribute(literal::version, undo_barrier_version);
+				barrier.writeAttribute(literal::required, undo_barrier_required);
 				writeLineBreak(xml);
 				exportUndo();
 				exportRedo();
@@ -426,10 +459,83 @@ void XMLFileExporter::exportMapParts()
 	auto num_parts = std::size_t(map->getNumParts());
 	parts_element.writeAttribute(literal::count, num_parts);
 	parts_element.writeAttribute(literal::current, map->current_part_index);
+	
+	// Cached fragments are written to the device directly, bypassing
+	// the auto-formatting of the stream writer.
+	auto* cache = map->xml_object_cache.data();
+	if (option(QString::fromLatin1("objectCache")).toBool() && !xml.autoFormatting())
+	{
+		if (!cache)
+		{
+			cache = new XmlObjectCache();
+			map->xml_object_cache.reset(cache);
+		}
+		if (cache->version != XMLFileFormat::active_version)
+		{
+			cache->entries.clear();
+			cache->version = XMLFileFormat::active_version;
+		}
+	}
+	else
+	{
+		cache = nullptr;
+	}
+	
+	XmlObjectCache::Entries next_entries;
 	for (auto i = 0lu; i < num_parts; ++i)
 	{
 		writeLineBreak(xml);
-		map->getPart(i)->save(xml);
+		if (cache)
+			exportMapPart(*map->getPart(i), *cache, next_entries);
+		else
+			map->getPart(i)->save(xml);
+	}
+	writeLineBreak(xml);
+	
+	// Entries of deleted objects are dropped.
+	if (cache)
+		cache->entries.swap(next_entries);
+}
+
+void XMLFileExporter::exportMapPart(const MapPart& part, XmlObjectCache& cache, XmlObjectCache::Entries& next_entries)
+{
+	XmlElementWriter part_element(xml, literal::part);
+	part_element.writeAttribute(literal::name, part.getName());
+	
+	XmlElementWriter objects_element(xml, literal::objects);
+	objects_element.writeAttribute(literal::count, part.getNumObjects());
+	
+	QHash<const Symbol*, int> symbol_indices;
+	symbol_indices.reserve(map->getNumSymbols());
+	for (int i = 0; i < map->getNumSymbols(); ++i)
+		symbol_indices.insert(map->getSymbol(i), i);
+	
+	for (int i = 0; i < part.getNumObjects(); ++i)
+	{
+		auto const* object = part.getObject(i);
+		auto const symbol_index = symbol_indices.value(object->getSymbol(), -1);
+		
+		XmlObjectCache::Entry entry;
+		auto cached = cache.entries.find(object);
+		if (cached != cache.entries.end()
+		    && cached->second.revision == object->revision()
+		    && cached->second.symbol_index == symbol_index)
+		{
+			entry = std::move(cached->second);
+		}
+		else
+		{
+			entry = { object->revision(), symbol_index, {} };
+			QBuffer buffer(&entry.xml);
+			buffer.open(QIODevice::WriteOnly);
+			QXmlStreamWriter fragment_writer(&buffer);
+			object->save(fragment_writer);
+		}
+		
+		// The line break also completes the pending start tag.
+		writeLineBreak(xml);
+		device()->write(entry.xml);
+		next_entries.emplace(object, std::move(entry));
 	}
 	writeLineBreak(xml);
 }
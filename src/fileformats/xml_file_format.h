@@ -67,6 +67,18 @@ public:
 	 */
 	static const int current_version;
 	
+	/** @brief The minimum XML file format version for compact coordinates.
+	 * 
+	 * \see XmlElementWriter::writeCompact()
+	 */
+	static constexpr int compact_coordinates_version = 10;
+	
+	/** @brief The minimum XML file format version for coordinates undo steps.
+	 * 
+	 * \see ObjectCoordinatesUndoStep
+	 */
+	static constexpr int coordinates_undo_version = 11;
+	
 	/** @brief The actual XML file format version to be written.
 	 * 
 	 * This value must be less than or equal to current_version.
@@ -91,13 +103,34 @@ public:
 
 \section changes Changes
 
-\subsection version-10 (Planned for) Version 10 (Mapper 1.0)
+\subsection version-12 (Planned for) Version 12 (Mapper 1.0)
 
 - For writing, drop compatibility with Mapper versions before 0.9.
 - Use the streaming variant when writing `barrier` elements.
 - Stop writing text object box sizes to the coordinates stream.
 
 
+\subsection version-11 Version 11
+
+- 2021-03-15 Added reading and writing of undo steps of type 11, recording
+             ranges of changed path object coordinates. When the saved undo
+             and redo steps contain such a step, the barrier before the `undo`
+             element is written with version 11. The map element keeps the
+             version of the map data, so previous versions still read the map
+             and skip the undo history.
+
+
+\subsection version-10 Version 10
+
+- 2021-03-01 Added reading and writing of a compact encoding for the `coords`
+             element of path objects: `<coords count="..." encoding="delta-base64">`.
+             The coordinates are delta-encoded as zigzag varints and written
+             as base64 text. This is written only when the `compactCoordinates`
+             export option is set, and never with auto-formatting (.xmap).
+             It raises the written version to 10. Otherwise, version 9 is
+             written.
+
+
 \subsection version-9  Version 9
 
 - 2019-10-01 Added reading of a streaming variant of the `barrier` element.
@@ -22,7 +22,10 @@
 #define OPENORIENTEERING_FILE_FORMAT_XML_P_H
 
 #include <functional>
+#include <unordered_map>
 
+#include <QtGlobal>
+#include <QByteArray>
 #include <QCoreApplication>
 #include <QXmlStreamReader>
 #include <QXmlStreamWriter>
@@ -32,6 +35,36 @@
 
 namespace OpenOrienteering {
 
+class MapPart;
+class Object;
+
+
+/**
+ * A cache of the XML serialization of map objects.
+ * 
+ * When a map is saved repeatedly, e.g. by autosaving, only the objects which
+ * were modified since the previous save need to be serialized again. Cache
+ * entries are validated by the object's revision and symbol index. The whole
+ * cache is invalidated when the file format version changes.
+ */
+class XmlObjectCache
+{
+public:
+	struct Entry
+	{
+		quint64 revision;   ///< The revision of the serialized object
+		int symbol_index;   ///< The symbol index in the serialized object
+		QByteArray xml;     ///< The serialized object, in UTF-8
+	};
+	
+	using Entries = std::unordered_map<const Object*, Entry>;
+	
+	int version = -1;   ///< The file format version of the entries
+	Entries entries;
+};
+
+
+
 /** Map exporter for the xml based map format. */
 class XMLFileExporter : public Exporter
 {
@@ -54,6 +87,14 @@ protected:
 	void exportColors();
 	void exportSymbols();
 	void exportMapParts();
+	
+	/**
+	 * Exports a map part, reusing the cached serialization of unmodified objects.
+	 * 
+	 * The entries which are used for this part are moved to next_entries.
+	 */
+	void exportMapPart(const MapPart& part, XmlObjectCache& cache, XmlObjectCache::Entries& next_entries);
+	
 	void exportTemplates();
 	void exportView();
 	void exportPrint();
@@ -28,6 +28,7 @@
 #include <QCoreApplication>
 #include <QImage>
 #include <QImageReader>
+#include <QRect>
 #include <QRgb>
 #include <QSize>
 #include <QString>
@@ -120,7 +121,19 @@ bool GdalImageReader::read(QImage* image)
 		return false;
 	}
 	
-	auto raster = readRasterInfo();
+	auto const raster = readRasterInfo();
+	return readRegion(raster, { {0, 0}, raster.size }, raster.size, image);
+}
+
+bool GdalImageReader::readRegion(const RasterInfo& raster, const QRect& source, const QSize& size, QImage* image)
+{
+	Q_ASSERT(image);
+	if (!image)
+	{
+		err = QImageReader::UnknownError;
+		return false;
+	}
+	
 	if (raster.image_format == QImage::Format_Invalid)
 	{
 		err = QImageReader::UnsupportedFormatError;
@@ -129,9 +142,9 @@ bool GdalImageReader::read(QImage* image)
 		return false;
 	}
 	
-	if (image->format() != raster.image_format || image->size() != raster.size)
+	if (image->format() != raster.image_format || image->size() != size)
 	{
-		*image = QImage(raster.size, raster.image_format);
+		*image = QImage(size, raster.image_format);
 	}
 	if (image->isNull())
 	{
@@ -139,19 +152,24 @@ bool GdalImageReader::read(QImage* image)
 		error_string = QCoreApplication::translate(
 		                   "OpenOrienteering::TemplateImage",
 		                   "Not enough free memory (image size: %1x%2 pixels)")
-		               .arg(raster.size.width()).arg(raster.size.height());
+		               .arg(size.width()).arg(size.height());
 		return false;
 	}
 	
 	image->fill(Qt::white);
-	auto const width = raster.size.width();
-	auto const height = raster.size.height();
+	
+	GDALRasterIOExtraArg extra_arg;
+	INIT_RASTERIO_EXTRA_ARG(extra_arg);
+	if (size != source.size() && raster.image_format != QImage::Format_Indexed8)
+		extra_arg.eResampleAlg = GRIORA_Average;
+	
 	CPLErrorReset();
-	auto result = GDALDatasetRasterIO(dataset, GF_Read, 
-	                                  0, 0, width, height,
-	                                  image->bits() + raster.band_offset, width, height,
-	                                  GDT_Byte, raster.bands.count(), raster.bands.data(),
-	                                  raster.pixel_space, image->bytesPerLine(), raster.band_space);
+	auto result = GDALDatasetRasterIOEx(dataset, GF_Read,
+	                                    source.x(), source.y(), source.width(), source.height(),
+	                                    image->bits() + raster.band_offset, size.width(), size.height(),
+	                                    GDT_Byte, raster.bands.count(), const_cast<int*>(raster.bands.data()),
+	                                    raster.pixel_space, image->bytesPerLine(), raster.band_space,
+	                                    &extra_arg);
 	if (result >= CE_Warning)
 	{
 		err = QImageReader::InvalidDataError;
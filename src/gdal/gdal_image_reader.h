@@ -26,6 +26,7 @@
 #include <QCoreApplication>
 #include <QImage>
 #include <QImageReader>
+#include <QRect>
 #include <QRgb>
 #include <QSize>
 #include <QString>
@@ -93,6 +94,17 @@ public:
 	
 	RasterInfo readRasterInfo() const;
 	
+	/**
+	 * Reads a region of the raster into an image of the given size.
+	 * 
+	 * The source rect is given in raster pixels. When the size is smaller
+	 * than the source rect, GDAL uses overviews if available, and resamples
+	 * the data otherwise. This allows reading large rasters tile by tile
+	 * and at reduced resolution.
+	 */
+	bool readRegion(const RasterInfo& raster, const QRect& source, const QSize& size, QImage* image);
+	
+	
 	QVector<QRgb> readColorTable(int band) const;
 	
 	/**
@@ -26,9 +26,12 @@
 #include <QtGlobal>
 #include <QByteArray>
 #include <QChar>
+#include <QImage>
 #include <QImageReader>
 #include <QPointF>
+#include <QRect>
 #include <QRectF>
+#include <QSize>
 #include <QString>
 #include <QVariant>
 
@@ -39,6 +42,7 @@
 #include "gdal/gdal_file.h"
 #include "gdal/gdal_image_reader.h"
 #include "gdal/gdal_manager.h"
+#include "templates/template_image_tiles.h"
 #include "util/transformation.h"
 #include "util/util.h"
 
@@ -59,6 +63,13 @@ const std::vector<QByteArray>& GdalTemplate::supportedExtensions()
 }
 
 
+// static
+qint64 GdalTemplate::tiledImageThreshold()
+{
+	return qint64(8192) * 8192;
+}
+
+
 // static
 const char* GdalTemplate::applyCornerPassPointsProperty()
 {
@@ -115,18 +126,34 @@ bool GdalTemplate::fileExists() const
 
 bool GdalTemplate::loadTemplateFileImpl()
 {
-	GdalImageReader reader(template_path);
-	if (!reader.canRead())
+	auto reader = std::make_shared<GdalImageReader>(template_path);
+	if (!reader->canRead())
 	{
-		setErrorString(reader.errorString());
+		setErrorString(reader->errorString());
 		return false;
 	}
 	
-	qDebug("GdalTemplate: Using GDAL driver '%s'", reader.format().constData());
+	qDebug("GdalTemplate: Using GDAL driver '%s'", reader->format().constData());
 	
-	if (!reader.read(&image))
+	auto const raster = reader->readRasterInfo();
+	if (raster.image_format != QImage::Format_Invalid
+	    && qint64(raster.size.width()) * raster.size.height() > tiledImageThreshold())
+	{
+		// Large raster: Decode tiles on demand, keeping the dataset open.
+		image = QImage();
+		tiles = std::make_shared<TemplateImageTiles>(raster.size, [reader, raster](const QRect& source, const QSize& size) {
+			QImage tile;
+			if (!reader->readRegion(raster, source, size, &tile))
+			{
+				qDebug("GdalTemplate: Failed to read tile: %s", qPrintable(reader->errorString()));
+				return QImage();
+			}
+			return tile;
+		});
+	}
+	else if (!reader->read(&image))
 	{
-		setErrorString(reader.errorString());
+		setErrorString(reader->errorString());
 		
 		QImageReader image_reader(template_path);
 		if (image_reader.canRead())
@@ -141,7 +168,7 @@ bool GdalTemplate::loadTemplateFileImpl()
 	}
 	
 	// Duplicated from TemplateImage, for compatibility
-	available_georef = findAvailableGeoreferencing(reader.readGeoTransform());
+	available_georef = findAvailableGeoreferencing(reader->readGeoTransform());
 	if (is_georeferenced)
 	{
 		if (!isGeoreferencingUsable())
@@ -22,6 +22,7 @@
 
 #include <vector>
 
+#include <QtGlobal>
 #include <QString>
 
 #include "templates/template.h"
@@ -44,6 +45,12 @@ public:
 	
 	static const std::vector<QByteArray>& supportedExtensions();
 	
+	/**
+	 * Returns the number of pixels above which rasters are not decoded
+	 * completely but drawn from tiles which are decoded on demand.
+	 */
+	static qint64 tiledImageThreshold();
+	
 	static const char* applyCornerPassPointsProperty();
 	
 	GdalTemplate(const QString& path, Map* map);
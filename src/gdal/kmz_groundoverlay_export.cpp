@@ -42,6 +42,7 @@
 #include <QPoint>
 #include <QPointF>
 #include <QProgressDialog>
+#include <QThread>
 #include <QTransform>
 
 #include "mapper_config.h"
@@ -52,6 +53,7 @@
 #include "core/map_printer.h"
 #include "fileformats/file_format.h"
 #include "gdal/gdal_file.h"
+#include "util/concurrency.h"
 #include "util/util.h"
 
 // IWYU pragma: no_forward_declare QRectF
@@ -267,9 +269,45 @@ try
 	writeKml(byte_array, tiles);
 	writeToVSI(doc_filepath_utf8, byte_array);
 	
-	// Create the tile files, reusing the same QImage allocation.
 	mkdir(basepath_utf8 + "/files");
 	
+	auto const declination = map.getGeoreferencing().getDeclination();
+	if (auto const draw_page = map_printer.concurrentPageDrawFunction())
+	{
+		// Render and encode batches of tiles concurrently, and write them in order.
+		auto const batch_size = std::size_t(std::max(1, QThread::idealThreadCount()));
+		std::vector<QByteArray> encoded(std::min(batch_size, tiles.size()));
+		auto progress = 0;
+		for (std::size_t batch_start = 0; batch_start < tiles.size(); batch_start += batch_size)
+		{
+			auto const batch_end = std::min(batch_start + batch_size, tiles.size());
+			Util::forEachRangeConcurrently(batch_end - batch_start, [&](std::size_t first, std::size_t last) {
+				QImage image(metrics.tile_size_px, QImage::Format_ARGB32_Premultiplied);
+				QImage buffer(metrics.tile_size_px, QImage::Format_RGB32);
+				for (auto i = first; i < last; ++i)
+				{
+					auto const& tile = tiles[batch_start + i];
+					image.fill(Qt::white);
+					buffer.fill(Qt::white);
+					QPainter painter(&image);
+					draw_page(&painter, tile.rect_map.adjusted(-5, -5, 5, 5), makeTileTransform(tile.rect_map, metrics, declination), &buffer);
+					painter.end();
+					saveToBuffer(image, encoded[i]);
+				}
+			}, 1);
+			
+			for (auto i = batch_start; i < batch_end; ++i)
+			{
+				writeToVSI(basepath_utf8 + '/' + tiles[i].filepath, encoded[i - batch_start]);
+				setProgress(++progress);
+				if (wasCanceled())
+					return true;
+			}
+		}
+		return true;
+	}
+	
+	// Create the tile files, reusing the same QImage allocation.
 	QImage image(metrics.tile_size_px, QImage::Format_ARGB32_Premultiplied);
 	QImage buffer(metrics.tile_size_px, QImage::Format_RGB32);
 	auto progress = 0;
@@ -278,7 +316,7 @@ try
 		image.fill(Qt::white);
 		buffer.fill(Qt::white);
 		QPainter painter(&image);
-		const auto tile_transform = makeTileTransform(tile.rect_map, metrics, map.getGeoreferencing().getDeclination());
+		const auto tile_transform = makeTileTransform(tile.rect_map, metrics, declination);
 		map_printer.drawPage(&painter, tile.rect_map.adjusted(-5, -5, 5, 5), tile_transform, &buffer);
 		saveToBuffer(image, byte_array);
 		writeToVSI(basepath_utf8 + '/' + tile.filepath, byte_array);
@@ -22,10 +22,13 @@
 
 #include <algorithm>
 #include <cmath>
+#include <condition_variable>
 #include <cstddef>
+#include <deque>
 #include <functional>
 #include <iterator>
 #include <memory>
+#include <mutex>
 #include <vector>
 #include <utility>
 
@@ -51,10 +54,12 @@
 #include <QRectF>
 #include <QRegularExpression>
 #include <QRegularExpressionMatch>
+#include <QRunnable>
 #include <QScopedValueRollback>
 #include <QString>
 #include <QStringList>
 #include <QStringRef>
+#include <QThreadPool>
 #include <QVariant>
 
 #include "core/georeferencing.h"
@@ -605,6 +610,112 @@ namespace {
 	};
 	
 	
+	/**
+	 * A utility for reading the features of a layer in a separate thread.
+	 * 
+	 * Reading features (parsing, decompression, I/O) is done while the
+	 * calling thread builds objects from the features of previous batches.
+	 * The number of batches in flight is limited. Destruction cancels reading
+	 * and waits for the thread to finish.
+	 * 
+	 * The layer must not be used by other threads while reading.
+	 */
+	class FeatureReader final : public QRunnable
+	{
+	public:
+		using Batch = std::vector<ogr::unique_feature>;
+		
+		static constexpr std::size_t batch_size = 256;
+		static constexpr std::size_t max_batches = 8;
+		
+		explicit FeatureReader(OGRLayerH layer)
+		: layer(layer)
+		{
+			setAutoDelete(false);
+			pool.setMaxThreadCount(1);
+			pool.start(this);
+		}
+		
+		FeatureReader(const FeatureReader&) = delete;
+		FeatureReader& operator=(const FeatureReader&) = delete;
+		
+		~FeatureReader() override
+		{
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				canceled = true;
+			}
+			condition.notify_all();
+			pool.waitForDone();
+		}
+		
+		/**
+		 * Returns the next batch of features.
+		 * 
+		 * An empty batch is returned when all features are read.
+		 */
+		Batch next()
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			condition.wait(lock, [this]() { return finished || !batches.empty(); });
+			Batch batch;
+			if (!batches.empty())
+			{
+				batch = std::move(batches.front());
+				batches.pop_front();
+			}
+			lock.unlock();
+			condition.notify_all();
+			return batch;
+		}
+		
+		void run() override
+		{
+			OGR_L_ResetReading(layer);
+			auto batch = Batch();
+			for (bool more = true; more; )
+			{
+				batch.reserve(batch_size);
+				while (batch.size() < batch_size)
+				{
+					auto feature = ogr::unique_feature(OGR_L_GetNextFeature(layer));
+					if (!feature)
+					{
+						more = false;
+						break;
+					}
+					batch.push_back(std::move(feature));
+				}
+				
+				std::unique_lock<std::mutex> lock(mutex);
+				condition.wait(lock, [this]() { return canceled || batches.size() < max_batches; });
+				if (canceled)
+					break;
+				if (!batch.empty())
+					batches.push_back(std::move(batch));
+				batch = Batch();
+				lock.unlock();
+				condition.notify_all();
+			}
+			
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				finished = true;
+			}
+			condition.notify_all();
+		}
+		
+	private:
+		OGRLayerH layer;
+		std::mutex mutex;
+		std::condition_variable condition;
+		std::deque<Batch> batches;
+		bool canceled = false;
+		bool finished = false;
+		QThreadPool pool;
+	};
+	
+	
 }  // namespace
 
 
@@ -1049,17 +1160,20 @@ void OgrFileImport::importLayer(MapPart* map_part, OGRLayerH layer)
 		clipping = getLayerClipping(layer);
 	}
 	
-	OGR_L_ResetReading(layer);
-	while (auto feature = ogr::unique_feature(OGR_L_GetNextFeature(layer)))
+	FeatureReader reader(layer);
+	for (auto batch = reader.next(); !batch.empty(); batch = reader.next())
 	{
-		auto geometry = OGR_F_GetGeometryRef(feature.get());
-		if (!geometry || OGR_G_IsEmpty(geometry))
+		for (auto const& feature : batch)
 		{
-			++empty_geometries;
-			continue;
+			auto geometry = OGR_F_GetGeometryRef(feature.get());
+			if (!geometry || OGR_G_IsEmpty(geometry))
+			{
+				++empty_geometries;
+				continue;
+			}
+			
+			importFeature(map_part, feature_definition, feature.get(), geometry, clipping.get());
 		}
-		
-		importFeature(map_part, feature_definition, feature.get(), geometry, clipping.get());
 	}
 }
 
@@ -1239,13 +1353,12 @@ PathObject* OgrFileImport::importLineStringGeometry(OGRFeatureH feature, OGRGeom
 		return nullptr;
 	}
 	
+	MapCoordVector coords;
+	coords.reserve(std::size_t(num_points));
+	appendCoordinates(geometry, coords);
+	
 	auto style = OGR_F_GetStyleString(feature);
-	auto object = new PathObject(getSymbol(Symbol::Line, style));
-	for (int i = 0; i < num_points; ++i)
-	{
-		object->addCoordinate(toMapCoord(OGR_G_GetX(geometry, i), OGR_G_GetY(geometry, i)));
-	}
-	return object;
+	return new PathObject(getSymbol(Symbol::Line, style), std::move(coords));
 }
 
 PathObject* OgrFileImport::importPolygonGeometry(OGRFeatureH feature, OGRGeometryH geometry)
@@ -1271,29 +1384,56 @@ PathObject* OgrFileImport::importPolygonGeometry(OGRFeatureH feature, OGRGeometr
 		return nullptr;
 	}
 	
-	auto style = OGR_F_GetStyleString(feature);
-	auto object = new PathObject(getSymbol(Symbol::Area, style));
-	for (int i = 0; i < num_points; ++i)
-	{
-		object->addCoordinate(toMapCoord(OGR_G_GetX(outline, i), OGR_G_GetY(outline, i)));
-	}
+	auto num_coords = std::size_t(num_points);
+	for (int g = 1; g < num_geometries; ++g)
+		num_coords += std::size_t(std::max(0, OGR_G_GetPointCount(OGR_G_GetGeometryRef(geometry, g))));
 	
+	MapCoordVector coords;
+	coords.reserve(num_coords);
+	appendCoordinates(outline, coords);
 	for (int g = 1; g < num_geometries; ++g)
 	{
-		bool start_new_part = true;
 		auto hole = /*OGR_G_ForceToLineString*/(OGR_G_GetGeometryRef(geometry, g));
-		auto num_points = OGR_G_GetPointCount(hole);
-		for (int i = 0; i < num_points; ++i)
+		if (OGR_G_GetPointCount(hole) > 0)
 		{
-			object->addCoordinate(toMapCoord(OGR_G_GetX(hole, i), OGR_G_GetY(hole, i)), start_new_part);
-			start_new_part = false;
+			coords.back().setHolePoint(true);
+			appendCoordinates(hole, coords);
 		}
 	}
 	
+	auto style = OGR_F_GetStyleString(feature);
+	auto object = new PathObject(getSymbol(Symbol::Area, style), std::move(coords));
 	object->closeAllParts();
 	return object;
 }
 
+void OgrFileImport::appendCoordinates(OGRGeometryH geometry, MapCoordVector& coords)
+{
+	auto const num_points = OGR_G_GetPointCount(geometry);
+	if (num_points <= 0)
+		return;
+	
+	auto const size = std::size_t(num_points);
+	if (x_buffer.size() < size)
+	{
+		x_buffer.resize(size);
+		y_buffer.resize(size);
+	}
+	if (OGR_G_GetPoints(geometry, x_buffer.data(), sizeof(double), y_buffer.data(), sizeof(double), nullptr, 0) != num_points)
+	{
+		// Not a simple curve
+		for (int i = 0; i < num_points; ++i)
+		{
+			x_buffer[std::size_t(i)] = OGR_G_GetX(geometry, i);
+			y_buffer[std::size_t(i)] = OGR_G_GetY(geometry, i);
+		}
+	}
+	
+	coords.reserve(coords.size() + size);
+	for (std::size_t i = 0; i < size; ++i)
+		coords.push_back(toMapCoord(x_buffer[i], y_buffer[i]));
+}
+
 std::unique_ptr<OgrFileImport::Clipping> OgrFileImport::getLayerClipping(OGRLayerH layer)
 {
 	OGREnvelope envelope;
@@ -297,6 +297,14 @@ protected:
 	
 	PathObject* importPolygonGeometry(OGRFeatureH feature, OGRGeometryH geometry);
 	
+	/**
+	 * Appends the map coordinates of the points of a curve geometry.
+	 * 
+	 * The points are fetched in bulk, via buffers which are reused for
+	 * subsequent geometries.
+	 */
+	void appendCoordinates(OGRGeometryH geometry, MapCoordVector& coords);
+	
 	std::unique_ptr<Clipping> getLayerClipping(OGRLayerH layer);
 	
 	
@@ -366,6 +374,9 @@ private:
 	
 	ogr::unique_stylemanager manager;
 	
+	std::vector<double> x_buffer;
+	std::vector<double> y_buffer;
+	
 	int empty_geometries = 0;
 	int no_transformation = 0;
 	int failed_transformation = 0;
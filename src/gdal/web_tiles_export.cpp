@@ -0,0 +1,609 @@
+/*
+ *    Copyright 2021 The OpenOrienteering developers
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "web_tiles_export.h"
+
+#include <algorithm>
+#include <cmath>
+#include <initializer_list>
+#include <iterator>
+#include <set>
+
+#include <cpl_vsi.h>
+#include <cpl_vsi_error.h>
+#include <gdal.h>
+#include <ogr_api.h>
+
+#include <Qt>
+#include <QtMath>
+#include <QApplication>
+#include <QBuffer>
+#include <QEventLoop>
+#include <QFileInfo>
+#include <QImage>
+#include <QIODevice>
+#include <QLatin1String>
+#include <QPainter>
+#include <QProgressDialog>
+#include <QRgb>
+#include <QThread>
+
+#include "mapper_config.h"
+#include "core/georeferencing.h"
+#include "core/latlon.h"
+#include "core/map.h"
+#include "core/map_coord.h"
+#include "core/map_printer.h"
+#include "fileformats/file_format.h"
+#include "gdal/gdal_file.h"
+#include "gdal/ogr_file_format_p.h"
+#include "util/concurrency.h"
+#include "util/util.h"
+
+// IWYU pragma: no_forward_declare QRectF
+
+
+namespace OpenOrienteering {
+
+namespace {
+
+static constexpr const char* format = "png";
+
+/// The maximum latitude of Web Mercator tiles.
+static constexpr qreal max_latitude = 85.0511287798;
+
+/// The circumference of the Web Mercator sphere at the equator, in meters.
+static constexpr qreal circumference = 40075016.686;
+
+
+/// Returns the image at half size, for the next lower zoom level.
+QImage downsampled(const QImage& image)
+{
+	return image.scaled(image.width() / 2, image.height() / 2, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+}
+
+
+QRectF boundingBoxLonLat(const Georeferencing& georef, const QRectF& extent_map)
+{
+	// Sampling the edges, for the curvature of the transformation
+	std::vector<MapCoordF> samples;
+	samples.reserve(20);
+	for (int i = 0; i <= 4; ++i)
+	{
+		auto const t = i / 4.0;
+		samples.emplace_back(extent_map.left() + t * extent_map.width(), extent_map.top());
+		samples.emplace_back(extent_map.left() + t * extent_map.width(), extent_map.bottom());
+		samples.emplace_back(extent_map.left(), extent_map.top() + t * extent_map.height());
+		samples.emplace_back(extent_map.right(), extent_map.top() + t * extent_map.height());
+	}
+	std::vector<LatLon> samples_latlon(samples.size());
+	georef.toGeographicCoords(samples.data(), samples_latlon.data(), samples.size());
+	
+	QRectF result;
+	for (auto const& latlon : samples_latlon)
+	{
+		auto const lonlat = QPointF(latlon.longitude(), latlon.latitude());
+		if (result.isNull())
+			result = QRectF(lonlat, lonlat);
+		else
+			rectInclude(result, lonlat);
+	}
+	return result;
+}
+
+
+}  // namespace
+
+
+
+// ### WebTilesExport::MBTiles ###
+
+/**
+ * The MBTiles (SQLite) output, written via GDAL's SQLite vector driver.
+ */
+struct WebTilesExport::MBTiles
+{
+	ogr::unique_datasource data_source;
+	OGRLayerH tiles_layer = nullptr;
+	
+	OGRLayerH createLayer(const char* name, std::initializer_list<std::pair<const char*, OGRFieldType>> fields)
+	{
+		auto* layer = GDALDatasetCreateLayer(data_source.get(), name, nullptr, wkbNone, nullptr);
+		if (!layer)
+			throw FileFormatException(tr("Failed to create layer: %1").arg(QString::fromUtf8(CPLGetLastErrorMsg())));
+		
+		for (auto const& field : fields)
+		{
+			auto field_definition = ogr::unique_fielddefn(OGR_Fld_Create(field.first, field.second));
+			if (OGR_L_CreateField(layer, field_definition.get(), 1) != OGRERR_NONE)
+				throw FileFormatException(tr("Failed to create layer: %1").arg(QString::fromUtf8(CPLGetLastErrorMsg())));
+		}
+		return layer;
+	}
+	
+	void createFeature(OGRLayerH layer, ogr::unique_feature& feature)
+	{
+		if (OGR_L_CreateFeature(layer, feature.get()) != OGRERR_NONE)
+			throw FileFormatException(tr("Failed to create feature in layer: %1").arg(QString::fromUtf8(CPLGetLastErrorMsg())));
+	}
+};
+
+
+
+// ### WebTilesExport ###
+
+WebTilesExport::~WebTilesExport() = default;
+
+WebTilesExport::WebTilesExport(const QString& path, const Map& map)
+: map(map)
+, basepath_utf8(QFileInfo(path).absoluteFilePath().toUtf8())
+, is_mbtiles(path.endsWith(QLatin1String(".mbtiles"), Qt::CaseInsensitive))
+{
+	// nothing else
+}
+
+
+void WebTilesExport::setProgressObserver(QProgressDialog* observer) noexcept
+{
+	progress_observer = observer;
+}
+
+QString WebTilesExport::errorString() const
+{
+	return error_message;
+}
+
+
+// static
+WebTilesExport::ZoomRange WebTilesExport::suggestedZoomRange(const Map& map, const MapPrinter& map_printer)
+{
+	auto const& georef = map.getGeoreferencing();
+	auto const& print_area = map_printer.getPrintArea();
+	auto const bounding_box_lonlat = boundingBoxLonLat(georef, print_area);
+	auto const latitude = qDegreesToRadians(qBound(-max_latitude, bounding_box_lonlat.center().y(), max_latitude));
+	
+	// Ground resolution of the printer, in meters per pixel
+	auto const resolution = map_printer.getOptions().resolution * map_printer.getScaleAdjustment();
+	auto const meters_per_px = 25.4 / resolution * georef.getScaleDenominator() / 1000;
+	auto const max_zoom = qBound(0, qCeil(std::log2(circumference * std::cos(latitude) / tile_size / meters_per_px)), max_zoom_level);
+	
+	auto min_zoom = max_zoom;
+	while (min_zoom > 0 && tileAt(min_zoom, bounding_box_lonlat.topLeft()) != tileAt(min_zoom, bounding_box_lonlat.bottomRight()))
+		--min_zoom;
+	
+	return { min_zoom, max_zoom };
+}
+
+
+bool WebTilesExport::doExport(const MapPrinter& map_printer, int min_zoom, int max_zoom)
+{
+	error_message.clear();
+	
+#ifdef QT_PRINTSUPPORT_LIB
+	auto const& georef = map.getGeoreferencing();
+	if (georef.getState() != Georeferencing::Geospatial)
+	{
+		error_message = tr("For web tiles export, the map must be georeferenced.");
+		return false;
+	}
+	
+	if (min_zoom < 0 || min_zoom > max_zoom || max_zoom > max_zoom_level)
+	{
+		error_message = tr("Invalid zoom levels: %1 to %2").arg(min_zoom).arg(max_zoom);
+		return false;
+	}
+	
+	auto const tiles = makeTiles(map_printer.getPrintArea(), max_zoom);
+	
+	// The number of tiles at each level is not larger than the number of
+	// parents of the tiles at the highest level.
+	auto num_tiles = int(tiles.size());
+	std::set<std::pair<int, int>> parents;
+	for (auto const& tile : tiles)
+		parents.emplace(tile.x, tile.y);
+	for (auto zoom = max_zoom - 1; zoom >= min_zoom; --zoom)
+	{
+		std::set<std::pair<int, int>> children;
+		children.swap(parents);
+		for (auto const& child : children)
+			parents.emplace(child.first / 2, child.second / 2);
+		num_tiles += int(parents.size());
+	}
+	setMaximumProgress(num_tiles);
+	
+	auto result = false;
+	try
+	{
+		openOutput(min_zoom, max_zoom, boundingBoxLonLat(georef, map_printer.getPrintArea()));
+		result = doExport(map_printer, tiles, min_zoom, max_zoom);
+		closeOutput();
+	}
+	catch (FileFormatException& e)
+	{
+		error_message = e.message();
+		mbtiles.reset();
+	}
+	
+	if (is_mbtiles && (!result || wasCanceled()))
+		VSIUnlink(basepath_utf8);
+	setProgress(maximumProgress());
+	return result;
+#else
+	Q_UNUSED(map_printer)
+	Q_UNUSED(min_zoom)
+	Q_UNUSED(max_zoom)
+	return false;
+#endif  // QT_PRINTSUPPORT_LIB
+}
+
+bool WebTilesExport::doExport(const MapPrinter& map_printer, const std::vector<Tile>& tiles, int min_zoom, int max_zoom)
+{
+#ifdef QT_PRINTSUPPORT_LIB
+	// Render the highest zoom level.
+	auto draw_page = map_printer.concurrentPageDrawFunction();
+	auto const concurrent = bool(draw_page);
+	if (!concurrent)
+	{
+		draw_page = [&map_printer](QPainter* device_painter, const QRectF& page_extent, const QTransform& page_extent_transform, QImage* page_buffer) {
+			map_printer.drawPage(device_painter, page_extent, page_extent_transform, page_buffer);
+		};
+	}
+	
+	// The images of each level are kept at half size, for the next lower level.
+	Level level;
+	auto make_tile = [&tiles, &draw_page, min_zoom, max_zoom](std::size_t index, TileData& data) {
+		auto const& tile = tiles[index];
+		QImage image(tile_size, tile_size, QImage::Format_ARGB32_Premultiplied);
+		image.fill(Qt::transparent);
+		QPainter painter(&image);
+		draw_page(&painter, tile.rect_map, tile.transform, &image);
+		painter.end();
+		data = {};
+		if (isEmpty(image))
+			return;
+		saveToBuffer(image, data.encoded);
+		if (min_zoom < max_zoom)
+			data.downsampled = downsampled(image);
+	};
+	auto take_tile = [this, &tiles, &level, max_zoom](std::size_t index, TileData& data) {
+		auto const& tile = tiles[index];
+		if (data.encoded.isEmpty())
+			return;
+		writeTile(max_zoom, tile.x, tile.y, data.encoded);
+		level.emplace(std::make_pair(tile.x, tile.y), std::move(data.downsampled));
+	};
+	if (!processTiles(tiles.size(), concurrent, make_tile, take_tile))
+		return true;
+	
+	// Build the lower zoom levels from the tiles of the next higher level.
+	for (auto zoom = max_zoom - 1; zoom >= min_zoom; --zoom)
+	{
+		std::set<std::pair<int, int>> parent_set;
+		for (auto const& child : level)
+			parent_set.emplace(child.first.first / 2, child.first.second / 2);
+		auto const parents = std::vector<std::pair<int, int>>(begin(parent_set), end(parent_set));
+		
+		auto const children = std::move(level);
+		level = {};
+		auto downsample = [&children, &parents, min_zoom, zoom](std::size_t index, TileData& data) {
+			auto const& parent = parents[index];
+			QImage image(tile_size, tile_size, QImage::Format_ARGB32_Premultiplied);
+			image.fill(Qt::transparent);
+			QPainter painter(&image);
+			for (int dy = 0; dy < 2; ++dy)
+			{
+				for (int dx = 0; dx < 2; ++dx)
+				{
+					auto const child = children.find({ 2 * parent.first + dx, 2 * parent.second + dy });
+					if (child == children.end())
+						continue;
+					
+					painter.drawImage(dx * tile_size / 2, dy * tile_size / 2, child->second);
+				}
+			}
+			painter.end();
+			data = {};
+			saveToBuffer(image, data.encoded);
+			if (min_zoom < zoom)
+				data.downsampled = downsampled(image);
+		};
+		auto take_parent = [this, &parents, &level, zoom](std::size_t index, TileData& data) {
+			auto const& parent = parents[index];
+			writeTile(zoom, parent.first, parent.second, data.encoded);
+			level.emplace(parent, std::move(data.downsampled));
+		};
+		if (!processTiles(parents.size(), true, downsample, take_parent))
+			return true;
+	}
+	return true;
+#else
+	Q_UNUSED(map_printer)
+	Q_UNUSED(tiles)
+	Q_UNUSED(min_zoom)
+	Q_UNUSED(max_zoom)
+	return false;
+#endif  // QT_PRINTSUPPORT_LIB
+}
+
+
+std::vector<WebTilesExport::Tile> WebTilesExport::makeTiles(const QRectF& extent_map, int zoom) const
+{
+	std::vector<Tile> tiles;
+	
+	auto const& georef = map.getGeoreferencing();
+	auto bounding_box_lonlat = boundingBoxLonLat(georef, extent_map);
+	bounding_box_lonlat.setTop(qMax(bounding_box_lonlat.top(), -max_latitude));
+	bounding_box_lonlat.setBottom(qMin(bounding_box_lonlat.bottom(), max_latitude));
+	
+	// Tile rows grow southwards.
+	auto const first = tileAt(zoom, QPointF(bounding_box_lonlat.left(), bounding_box_lonlat.bottom()));
+	auto const last = tileAt(zoom, QPointF(bounding_box_lonlat.right(), bounding_box_lonlat.top()));
+	
+	// Adjacent tiles share their corners, so the corners are projected once,
+	// in a single batch.
+	auto const columns = std::size_t(last.first - first.first + 2);
+	auto const rows = std::size_t(last.second - first.second + 2);
+	std::vector<LatLon> corners_latlon;
+	corners_latlon.reserve(columns * rows);
+	for (int y = first.second; y <= last.second + 1; ++y)
+	{
+		for (int x = first.first; x <= last.first + 1; ++x)
+		{
+			auto const lonlat = toLonLat(zoom, x * tile_size, y * tile_size);
+			corners_latlon.emplace_back(lonlat.y(), lonlat.x());
+		}
+	}
+	std::vector<MapCoordF> corners_map(corners_latlon.size());
+	georef.toMapCoordF(corners_latlon.data(), corners_map.data(), corners_map.size());
+	
+	for (int y = first.second; y <= last.second; ++y)
+	{
+		for (int x = first.first; x <= last.first; ++x)
+		{
+			auto const corner = std::size_t(y - first.second) * columns + std::size_t(x - first.first);
+			MapCoordF tile_map[] = {
+			    corners_map[corner],
+			    corners_map[corner + 1],
+			    corners_map[corner + columns + 1],
+			    corners_map[corner + columns]
+			};
+			auto rect_map = QRectF(tile_map[0], tile_map[0]);
+			using std::begin; using std::end;
+			std::for_each(begin(tile_map) + 1, end(tile_map), [&rect_map](auto& p) { rectInclude(rect_map, p); });
+			if (!rect_map.intersects(extent_map))
+				continue;
+			
+			// An affine approximation of the projection, from pixel to map coordinates
+			auto const pixel_to_map = QTransform(
+			    (tile_map[1].x() - tile_map[0].x()) / tile_size, (tile_map[1].y() - tile_map[0].y()) / tile_size,
+			    (tile_map[3].x() - tile_map[0].x()) / tile_size, (tile_map[3].y() - tile_map[0].y()) / tile_size,
+			    tile_map[0].x(), tile_map[0].y() );
+			// Like in KmzGroundOverlayExport, the extent has a margin of 5 mm.
+			tiles.push_back({x, y, rect_map.adjusted(-5, -5, 5, 5), pixel_to_map.inverted()});
+		}
+	}
+	return tiles;
+}
+
+
+bool WebTilesExport::processTiles(std::size_t count, bool concurrent,
+                                  const std::function<void (std::size_t, TileData&)>& make_tile,
+                                  const std::function<void (std::size_t, TileData&)>& take_tile)
+{
+	auto const batch_size = concurrent ? std::size_t(std::max(1, QThread::idealThreadCount())) : std::size_t(1);
+	std::vector<TileData> results(std::min(batch_size, count));
+	for (std::size_t batch_start = 0; batch_start < count; batch_start += batch_size)
+	{
+		auto const batch_end = std::min(batch_start + batch_size, count);
+		Util::forEachRangeConcurrently(batch_end - batch_start, [&](std::size_t first, std::size_t last) {
+			for (auto i = first; i < last; ++i)
+				make_tile(batch_start + i, results[i]);
+		}, 1);
+		
+		for (auto i = batch_start; i < batch_end; ++i)
+		{
+			take_tile(i, results[i - batch_start]);
+			if (progress_observer)
+				setProgress(progress_observer->value() + 1);
+			if (wasCanceled())
+				return false;
+		}
+	}
+	return true;
+}
+
+
+// static
+QPointF WebTilesExport::toLonLat(int zoom, qreal x_px, qreal y_px)
+{
+	auto const world_size = std::ldexp(qreal(tile_size), zoom);
+	return {
+		x_px / world_size * 360 - 180,
+		qRadiansToDegrees(std::atan(std::sinh(M_PI * (1 - 2 * y_px / world_size))))
+	};
+}
+
+// static
+std::pair<int, int> WebTilesExport::tileAt(int zoom, const QPointF& lonlat)
+{
+	auto const num_tiles = std::ldexp(1.0, zoom);
+	auto const latitude = qDegreesToRadians(qBound(-max_latitude, lonlat.y(), max_latitude));
+	auto const x = (lonlat.x() + 180) / 360 * num_tiles;
+	auto const y = (1 - std::asinh(std::tan(latitude)) / M_PI) / 2 * num_tiles;
+	auto const last = int(num_tiles) - 1;
+	return { qBound(0, int(std::floor(x)), last), qBound(0, int(std::floor(y)), last) };
+}
+
+// static
+bool WebTilesExport::isEmpty(const QImage& image)
+{
+	for (int y = 0; y < image.height(); ++y)
+	{
+		auto const* line = reinterpret_cast<const QRgb*>(image.constScanLine(y));
+		if (std::any_of(line, line + image.width(), [](QRgb pixel) { return qAlpha(pixel) != 0; }))
+			return false;
+	}
+	return true;
+}
+
+// static
+void WebTilesExport::saveToBuffer(const QImage& image, QByteArray& data)
+{
+	QBuffer buffer(&data);
+	buffer.open(QIODevice::WriteOnly | QIODevice::Truncate);
+	image.save(&buffer, format);
+	buffer.close();
+}
+
+
+void WebTilesExport::openOutput(int min_zoom, int max_zoom, const QRectF& bounds_lonlat)
+{
+	VSIErrorReset();
+	
+	if (!is_mbtiles)
+	{
+		if (!GdalFile::isDir(basepath_utf8) && !GdalFile::mkdir(basepath_utf8))
+			throw FileFormatException(QString::fromUtf8(VSIGetLastErrorMsg()));
+		return;
+	}
+	
+	auto* driver = OGRGetDriverByName("SQLite");
+	if (!driver)
+		throw FileFormatException(::OpenOrienteering::ImportExport::tr("Cannot find a vector data export driver named '%1'")
+		                          .arg(QLatin1String("SQLite")));
+	
+	// The file dialog already asked for overwriting.
+	if (GdalFile::exists(basepath_utf8))
+		VSIUnlink(basepath_utf8);
+	
+	const char* options[] = { "METADATA=NO", nullptr };
+	mbtiles.reset(new MBTiles());
+	mbtiles->data_source = ogr::unique_datasource(OGR_Dr_CreateDataSource(driver, basepath_utf8, const_cast<char**>(options)));
+	if (!mbtiles->data_source)
+		throw FileFormatException(tr("Failed to create dataset: %1").arg(QString::fromUtf8(CPLGetLastErrorMsg())));
+	
+	auto* metadata_layer = mbtiles->createLayer("metadata", { {"name", OFTString}, {"value", OFTString} });
+	auto const name = QFileInfo(QString::fromUtf8(basepath_utf8)).completeBaseName().toUtf8();
+	auto const bounds = QByteArray::number(bounds_lonlat.left(), 'f', 7) + ','
+	                    + QByteArray::number(qMax(bounds_lonlat.top(), -max_latitude), 'f', 7) + ','
+	                    + QByteArray::number(bounds_lonlat.right(), 'f', 7) + ','
+	                    + QByteArray::number(qMin(bounds_lonlat.bottom(), max_latitude), 'f', 7);
+	std::pair<const char*, QByteArray> const metadata[] = {
+	    { "name", name },
+	    { "type", "overlay" },
+	    { "version", "1.0" },
+	    { "description", "Generator: OpenOrienteering Mapper " APP_VERSION },
+	    { "format", format },
+	    { "bounds", bounds },
+	    { "minzoom", QByteArray::number(min_zoom) },
+	    { "maxzoom", QByteArray::number(max_zoom) },
+	};
+	for (auto const& item : metadata)
+	{
+		auto feature = ogr::unique_feature(OGR_F_Create(OGR_L_GetLayerDefn(metadata_layer)));
+		OGR_F_SetFieldString(feature.get(), 0, item.first);
+		OGR_F_SetFieldString(feature.get(), 1, item.second.constData());
+		mbtiles->createFeature(metadata_layer, feature);
+	}
+	
+	mbtiles->tiles_layer = mbtiles->createLayer("tiles", {
+	    {"zoom_level", OFTInteger},
+	    {"tile_column", OFTInteger},
+	    {"tile_row", OFTInteger},
+	    {"tile_data", OFTBinary},
+	});
+	auto* result = GDALDatasetExecuteSQL(mbtiles->data_source.get(), "CREATE UNIQUE INDEX tile_index ON tiles (zoom_level, tile_column, tile_row)", nullptr, nullptr);
+	if (result)
+		GDALDatasetReleaseResultSet(mbtiles->data_source.get(), result);
+	
+	if (OGR_L_StartTransaction(mbtiles->tiles_layer) != OGRERR_NONE)
+		throw FileFormatException(QString::fromUtf8(CPLGetLastErrorMsg()));
+}
+
+void WebTilesExport::writeTile(int zoom, int x, int y, const QByteArray& data)
+{
+	if (!mbtiles)
+	{
+		auto const zoom_dir = basepath_utf8 + '/' + QByteArray::number(zoom);
+		auto const column_dir = zoom_dir + '/' + QByteArray::number(x);
+		for (auto const& dir : { zoom_dir, column_dir })
+		{
+			if (!GdalFile::isDir(dir) && !GdalFile::mkdir(dir))
+				throw FileFormatException(QString::fromUtf8(VSIGetLastErrorMsg()));
+		}
+		
+		auto const filepath = column_dir + '/' + QByteArray::number(y) + '.' + format;
+		auto* file = VSIFOpenL(filepath, "wb");
+		if (!file)
+			throw FileFormatException(QString::fromUtf8(VSIGetLastErrorMsg()));
+		VSIFWriteL(data, 1, data.size(), file);
+		VSIFCloseL(file);
+		return;
+	}
+	
+	// MBTiles use the TMS scheme, with rows growing northwards.
+	auto const row = (1 << zoom) - 1 - y;
+	auto feature = ogr::unique_feature(OGR_F_Create(OGR_L_GetLayerDefn(mbtiles->tiles_layer)));
+	OGR_F_SetFieldInteger(feature.get(), 0, zoom);
+	OGR_F_SetFieldInteger(feature.get(), 1, x);
+	OGR_F_SetFieldInteger(feature.get(), 2, row);
+	OGR_F_SetFieldBinary(feature.get(), 3, data.size(), reinterpret_cast<GByte*>(const_cast<char*>(data.constData())));
+	mbtiles->createFeature(mbtiles->tiles_layer, feature);
+}
+
+void WebTilesExport::closeOutput()
+{
+	if (mbtiles)
+	{
+		if (OGR_L_CommitTransaction(mbtiles->tiles_layer) != OGRERR_NONE)
+			throw FileFormatException(QString::fromUtf8(CPLGetLastErrorMsg()));
+		mbtiles.reset();
+	}
+}
+
+
+void WebTilesExport::setMaximumProgress(int value) const
+{
+	if (progress_observer)
+	{
+		progress_observer->setMaximum(value);
+	}
+}
+
+int WebTilesExport::maximumProgress() const
+{
+	return progress_observer ? progress_observer->maximum() : 100;
+}
+
+void WebTilesExport::setProgress(int value) const
+{
+	if (progress_observer)
+	{
+		progress_observer->setValue(value);
+		QApplication::processEvents(QEventLoop::ExcludeUserInputEvents, 100 /* ms */); // Drawing and Cancel events
+	}
+}
+
+bool WebTilesExport::wasCanceled() const
+{
+	return progress_observer && progress_observer->wasCanceled();
+}
+
+
+}  // namespace OpenOrienteering
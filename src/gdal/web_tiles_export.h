@@ -0,0 +1,171 @@
+/*
+ *    Copyright 2021 The OpenOrienteering developers
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OPENORIENTEERING_WEB_TILES_EXPORT_H
+#define OPENORIENTEERING_WEB_TILES_EXPORT_H
+
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <QtGlobal>
+#include <QByteArray>
+#include <QCoreApplication>
+#include <QImage>
+#include <QPointF>
+#include <QRectF>
+#include <QString>
+#include <QTransform>
+
+class QProgressDialog;
+
+// IWYU pragma: no_forward_declare QRectF
+
+namespace OpenOrienteering {
+
+class Map;
+class MapPrinter;
+
+
+/**
+ * A class which generates raster tiles for web maps.
+ *
+ * The tiles follow the common XYZ scheme of Web Mercator (EPSG:3857) tiles
+ * with 256x256 pixel. They are written either to a directory, as
+ * z/x/y.png files, or to an MBTiles file (SQLite), depending on the
+ * extension of the given path.
+ *
+ * Only the tiles of the highest zoom level are rendered by the MapPrinter.
+ * The tiles of lower zoom levels are created by downsampling. Tiles which
+ * do not contain any map content are not written.
+ */
+class WebTilesExport
+{
+	Q_DECLARE_TR_FUNCTIONS(OpenOrienteering::WebTilesExport)
+	
+	struct Tile
+	{
+		int x;
+		int y;
+		QRectF rect_map;
+		QTransform transform;
+	};
+	
+	/// The result of creating a tile
+	struct TileData
+	{
+		QByteArray encoded;  ///< The encoded image, empty for tiles without content
+		QImage downsampled;  ///< The image at half size, for the next lower zoom level
+	};
+	
+	/// Downsampled tile images, by column and row
+	using Level = std::map<std::pair<int, int>, QImage>;
+	
+public:
+	/// The width and height of tiles, in pixels.
+	static constexpr int tile_size = 256;
+	
+	/// The highest supported zoom level.
+	static constexpr int max_zoom_level = 24;
+	
+	struct ZoomRange
+	{
+		int min_zoom;
+		int max_zoom;
+	};
+	
+	~WebTilesExport();
+	
+	WebTilesExport(const QString& path, const Map& map);
+	
+	void setProgressObserver(QProgressDialog* observer) noexcept;
+	
+	QString errorString() const;
+	
+	/**
+	 * Returns a zoom range for the map printer's print area.
+	 *
+	 * The highest zoom level roughly matches the resolution of the map
+	 * printer. The lowest zoom level is the highest level which covers the
+	 * print area with a single tile.
+	 */
+	static ZoomRange suggestedZoomRange(const Map& map, const MapPrinter& map_printer);
+	
+	bool doExport(const MapPrinter& map_printer, int min_zoom, int max_zoom);
+	
+	
+protected:
+	bool doExport(const MapPrinter& map_printer, const std::vector<Tile>& tiles, int min_zoom, int max_zoom);
+	
+	std::vector<Tile> makeTiles(const QRectF& extent_map, int zoom) const;
+	
+	/**
+	 * Creates batches of tiles concurrently, and takes them in order.
+	 *
+	 * Returns false if the export was canceled.
+	 */
+	bool processTiles(std::size_t count, bool concurrent,
+	                  const std::function<void (std::size_t index, TileData& data)>& make_tile,
+	                  const std::function<void (std::size_t index, TileData& data)>& take_tile);
+	
+	/** Returns the geographic coordinates of a pixel at the given zoom level, as longitude and latitude. */
+	static QPointF toLonLat(int zoom, qreal x_px, qreal y_px);
+	
+	/** Returns the tile column and row of the given longitude and latitude. */
+	static std::pair<int, int> tileAt(int zoom, const QPointF& lonlat);
+	
+	static bool isEmpty(const QImage& image);
+	
+	static void saveToBuffer(const QImage& image, QByteArray& data);
+	
+	
+	void openOutput(int min_zoom, int max_zoom, const QRectF& bounds_lonlat);
+	
+	void writeTile(int zoom, int x, int y, const QByteArray& data);
+	
+	void closeOutput();
+	
+	
+	void setMaximumProgress(int value) const;
+	
+	int maximumProgress() const;
+	
+	void setProgress(int value) const;
+	
+	bool wasCanceled() const;
+	
+private:
+	struct MBTiles;
+	
+	const Map& map;
+	QProgressDialog* progress_observer = nullptr;
+	QByteArray basepath_utf8;
+	QString error_message;
+	std::unique_ptr<MBTiles> mbtiles;
+	bool is_mbtiles = false;
+	
+};
+
+
+}  // namespace OpenOrienteering
+
+#endif // OPENORIENTEERING_WEB_TILES_EXPORT_H
@@ -22,6 +22,7 @@
 #include "main_window.h"
 
 #include <QApplication>
+#include <QByteArray>
 #include <QCloseEvent>
 #include <QDialogButtonBox>
 #include <QDesktopServices>
@@ -1101,8 +1102,9 @@ void MainWindow::setHasAutosaveConflict(bool value)
 	}
 }
 
-bool MainWindow::removeAutosaveFile() const
+bool MainWindow::removeAutosaveFile()
 {
+	waitForAutosaveFile();
 	if (!currentPath().isEmpty() && !has_autosave_conflict)
 	{
 		QFile autosave_file(autosavePath(currentPath()));
@@ -1119,17 +1121,19 @@ Autosave::AutosaveResult MainWindow::autosave()
 	{
 		return Autosave::PermanentFailure;
 	}
-	else if (controller->isEditingInProgress())
+	else if (controller->isEditingInProgress() || isWritingAutosaveFile())
 	{
 		return Autosave::TemporaryFailure;
 	}
 	else
 	{
 		showStatusBarMessageImmediately(tr("Autosaving..."), 0);
-		if (controller->exportTo(autosavePath(currentPath()), *autosave_format))
+		auto const autosave_path = autosavePath(currentPath());
+		QByteArray data;
+		if (controller->autosaveTo(autosave_path, *autosave_format, data))
 		{
-			// Success
-			clearStatusBarMessage();
+			// Success, cf. autosaveFileWritten()
+			writeAutosaveFile(autosave_path, data);
 			return Autosave::Success;
 		}
 		else
@@ -1141,6 +1145,14 @@ Autosave::AutosaveResult MainWindow::autosave()
 	}
 }
 
+void MainWindow::autosaveFileWritten(const QString& /*path*/, bool success)
+{
+	if (success)
+		clearStatusBarMessage();
+	else
+		showStatusBarMessage(tr("Autosaving failed!"), 6000);
+}
+
 bool MainWindow::save()
 {
 	auto path = currentPath();
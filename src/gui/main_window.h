@@ -361,6 +361,10 @@ public slots:
 	 */
 	Autosave::AutosaveResult autosave() override;
 	
+	/** Reports the result of writing the autosave file.
+	 */
+	void autosaveFileWritten(const QString& path, bool success) override;
+	
 	/**
 	 * Close the file currently opened.
 	 * 
@@ -478,9 +482,10 @@ protected:
 	/**
 	 * Removes the autosave file if it exists.
 	 * 
+	 * Pending writes of the autosave file are completed before.
 	 * Returns true if the file was removed or didn't exist, false otherwise.
 	 */
-	bool removeAutosaveFile() const;
+	bool removeAutosaveFile();
 	
 	bool event(QEvent* event) override;
 	void closeEvent(QCloseEvent *event) override;
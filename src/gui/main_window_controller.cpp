@@ -83,6 +83,11 @@ bool MainWindowController::exportTo(const QString& /*path*/, const FileFormat& /
 	return false;
 }
 
+bool MainWindowController::autosaveTo(const QString& /*path*/, const FileFormat& /*format*/, QByteArray& /*data*/)
+{
+	return false;
+}
+
 bool MainWindowController::loadFrom(const QString& /*path*/, const FileFormat& /*format*/, QWidget* /*dialog_parent*/)
 {
 	return false;
@@ -25,6 +25,7 @@
 #include <QObject>
 #include <QString>
 
+class QByteArray;
 class QKeyEvent;
 class QWidget;
 
@@ -85,6 +86,17 @@ public:
 	 */
 	virtual bool exportTo(const QString& path, const FileFormat& format);
 
+	/** Serialize the content for autosaving, but don't change modified state
+	 *  with regard to the original file.
+	 *  Implementations may reuse data from previous invocations, so that
+	 *  the cost depends on the changes since the last autosave.
+	 *  @param path the path of the autosave file
+	 *  @param format the file format
+	 *  @param data receives the serialized content
+	 *  @return true if serialization was successful, false on errors
+	 */
+	virtual bool autosaveTo(const QString& path, const FileFormat& format, QByteArray& data);
+
 	/** Load from a file.
 	 *  @param path the path to load from
 	 *  @param dialog_parent Alternative parent widget for all dialogs.
@@ -0,0 +1,219 @@
+/*
+ *    Copyright 2021 The OpenOrienteering developers
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "map_cache_renderer.h"
+
+#include <algorithm>
+#include <set>
+#include <utility>
+
+#include <Qt>
+#include <QtGlobal>
+#include <QMetaObject>
+#include <QPainter>
+#include <QPoint>
+#include <QRectF>
+#include <QRunnable>
+
+
+namespace OpenOrienteering {
+
+/**
+ * A runnable which renders a single tile.
+ */
+class MapCacheRenderer::Job : public QRunnable
+{
+public:
+	Job(MapCacheRenderer* renderer, int id, const QRect& rect, const QTransform& viewport_transform,
+	    bool use_background, DrawFunction draw, std::shared_ptr<QAtomicInt> cancelled)
+	: renderer(renderer)
+	, id(id)
+	, rect(rect)
+	, viewport_transform(viewport_transform)
+	, use_background(use_background)
+	, draw(std::move(draw))
+	, cancelled(std::move(cancelled))
+	{
+		setAutoDelete(true);
+	}
+
+	void run() override
+	{
+		if (cancelled->load())
+			return;
+
+		QImage image(rect.size(), QImage::Format_ARGB32_Premultiplied);
+		image.fill(use_background ? Qt::white : Qt::transparent);
+		{
+			QPainter painter(&image);
+			painter.translate(-rect.topLeft());
+			painter.setWorldTransform(viewport_transform, true);
+			draw(&painter, viewport_transform.inverted().mapRect(QRectF(rect)));
+		}
+
+		if (cancelled->load())
+			return;
+
+		QMetaObject::invokeMethod(renderer, "finishTile", Qt::QueuedConnection,
+		                          Q_ARG(int, id), Q_ARG(QImage, image));
+	}
+
+private:
+	MapCacheRenderer* const renderer;
+	const int id;
+	const QRect rect;
+	const QTransform viewport_transform;
+	const bool use_background;
+	const DrawFunction draw;
+	const std::shared_ptr<QAtomicInt> cancelled;
+};
+
+
+
+MapCacheRenderer::MapCacheRenderer(QObject* parent)
+: QObject(parent)
+{
+	// nothing else
+}
+
+MapCacheRenderer::~MapCacheRenderer()
+{
+	cancelAll();
+	pool.waitForDone();
+}
+
+
+// static
+QRect MapCacheRenderer::tileAlignedRect(const QRect& rect, const QRect& bounds)
+{
+	auto const visible = rect.intersected(bounds);
+	if (visible.isEmpty())
+		return {};
+
+	auto const left   = (visible.left() / tile_size) * tile_size;
+	auto const top    = (visible.top() / tile_size) * tile_size;
+	auto const right  = (visible.right() / tile_size + 1) * tile_size - 1;
+	auto const bottom = (visible.bottom() / tile_size + 1) * tile_size - 1;
+	return QRect(QPoint(left, top), QPoint(right, bottom)).intersected(bounds);
+}
+
+
+void MapCacheRenderer::render(Layer layer, const QRect& dirty_rect, const QRect& bounds,
+                              const QTransform& viewport_transform, bool use_background, DrawFunction draw)
+{
+	render(layer, std::vector<QRect>{ dirty_rect }, bounds, viewport_transform, use_background, std::move(draw));
+}
+
+void MapCacheRenderer::render(Layer layer, const std::vector<QRect>& dirty_rects, const QRect& bounds,
+                              const QTransform& viewport_transform, bool use_background, DrawFunction draw)
+{
+	// The rects may overlap, but each tile is to be rendered once.
+	std::set<std::pair<int, int>> tiles;
+	for (auto const& dirty_rect : dirty_rects)
+	{
+		auto const area = tileAlignedRect(dirty_rect, bounds);
+		if (area.isEmpty())
+			continue;
+
+		for (int y = area.top() / tile_size; y <= area.bottom() / tile_size; ++y)
+		{
+			for (int x = area.left() / tile_size; x <= area.right() / tile_size; ++x)
+				tiles.emplace(x, y);
+		}
+	}
+
+	for (auto const& tile : tiles)
+	{
+		auto const x = tile.first;
+		auto const y = tile.second;
+		auto const key = TileKey { layer, x, y };
+		auto pending = pending_tiles.find(key);
+		if (pending != pending_tiles.end())
+		{
+			// Replace the pending request.
+			pending->second.cancelled->store(1);
+			pending_ids.erase(pending->second.id);
+			pending_tiles.erase(pending);
+		}
+
+		auto const rect = QRect(x * tile_size, y * tile_size, tile_size, tile_size).intersected(bounds);
+		auto const id = ++last_id;
+		auto cancelled = std::make_shared<QAtomicInt>(0);
+		pending_tiles.emplace(key, PendingTile{ id, rect, cancelled });
+		pending_ids.emplace(id, key);
+		pool.start(new Job(this, id, rect, viewport_transform, use_background, draw, std::move(cancelled)));
+	}
+}
+
+
+QRect MapCacheRenderer::cancel(Layer layer)
+{
+	QRect cancelled_rect;
+	for (auto pending = pending_tiles.begin(); pending != pending_tiles.end(); )
+	{
+		if (std::get<0>(pending->first) == layer)
+		{
+			pending->second.cancelled->store(1);
+			cancelled_rect = cancelled_rect.united(pending->second.rect);
+			pending_ids.erase(pending->second.id);
+			pending = pending_tiles.erase(pending);
+		}
+		else
+		{
+			++pending;
+		}
+	}
+	return cancelled_rect;
+}
+
+void MapCacheRenderer::cancelAll()
+{
+	for (auto& pending : pending_tiles)
+		pending.second.cancelled->store(1);
+	pending_tiles.clear();
+	pending_ids.clear();
+}
+
+bool MapCacheRenderer::isPending(Layer layer) const
+{
+	return std::any_of(pending_tiles.begin(), pending_tiles.end(), [layer](auto const& pending) {
+		return std::get<0>(pending.first) == layer;
+	});
+}
+
+
+void MapCacheRenderer::finishTile(int id, const QImage& image)
+{
+	auto found = pending_ids.find(id);
+	if (found == pending_ids.end())
+		return;  // cancelled or replaced
+
+	auto const key = found->second;
+	pending_ids.erase(found);
+	auto pending = pending_tiles.find(key);
+	Q_ASSERT(pending != pending_tiles.end());
+	auto const rect = pending->second.rect;
+	pending_tiles.erase(pending);
+
+	emit tileFinished(Layer(std::get<0>(key)), rect, image);
+}
+
+
+}  // namespace OpenOrienteering
@@ -0,0 +1,174 @@
+/*
+ *    Copyright 2021 The OpenOrienteering developers
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef OPENORIENTEERING_MAP_CACHE_RENDERER_H
+#define OPENORIENTEERING_MAP_CACHE_RENDERER_H
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+#include <QAtomicInt>
+#include <QImage>
+#include <QObject>
+#include <QRect>
+#include <QThreadPool>
+#include <QTransform>
+
+class QPainter;
+class QRectF;
+
+namespace OpenOrienteering {
+
+
+/**
+ * Renders tiles of the MapWidget's caches in worker threads.
+ *
+ * A request covers a dirty rect in viewport coordinates. It is split into
+ * tiles on a fixed grid, and each tile is rendered into a separate QImage
+ * by a thread pool. The draw function must not access mutable state of the
+ * map or of the templates, cf. Map::renderablesSnapshot() and
+ * Map::concurrentTemplatesDrawFunction(). Finished tiles are delivered in the
+ * GUI thread by the tileFinished() signal.
+ *
+ * A new request for a tile replaces the pending request for the same tile.
+ * When the viewport changes, the pending tiles must be cancelled.
+ */
+class MapCacheRenderer : public QObject
+{
+Q_OBJECT
+public:
+	/**
+	 * The caches of the MapWidget.
+	 */
+	enum Layer
+	{
+		BelowTemplates = 0,
+		MapLayer       = 1,
+		AboveTemplates = 2,
+	};
+
+	/**
+	 * A function which draws a layer.
+	 *
+	 * The painter is set up for map coordinates, and the rect is the area
+	 * to be drawn, in map coordinates.
+	 */
+	using DrawFunction = std::function<void (QPainter* painter, const QRectF& map_rect)>;
+
+	/// The width and height of tiles, in pixels.
+	static constexpr int tile_size = 256;
+
+	explicit MapCacheRenderer(QObject* parent = nullptr);
+
+	MapCacheRenderer(const MapCacheRenderer&) = delete;
+	MapCacheRenderer& operator=(const MapCacheRenderer&) = delete;
+
+	/**
+	 * Cancels all pending tiles, and waits for running tiles to finish.
+	 */
+	~MapCacheRenderer() override;
+
+	/**
+	 * Returns the union of the tiles which intersect the rect, limited to the
+	 * bounds.
+	 *
+	 * Tiles are always rendered completely, so draw functions must cover this
+	 * area.
+	 */
+	static QRect tileAlignedRect(const QRect& rect, const QRect& bounds);
+
+	/**
+	 * Requests rendering of the tiles which intersect the dirty rect.
+	 *
+	 * @param layer               The cache to be rendered.
+	 * @param dirty_rect          The area to be rendered, in viewport coordinates.
+	 * @param bounds              The viewport rect.
+	 * @param viewport_transform  The transformation from map coordinates to viewport coordinates.
+	 * @param use_background      If true, tiles are filled with white, else with transparent.
+	 * @param draw                The function which draws the layer.
+	 */
+	void render(Layer layer, const QRect& dirty_rect, const QRect& bounds,
+	            const QTransform& viewport_transform, bool use_background, DrawFunction draw);
+
+	/**
+	 * Requests rendering of the tiles which intersect any of the dirty rects.
+	 *
+	 * Each tile is requested only once, even if it intersects multiple rects.
+	 */
+	void render(Layer layer, const std::vector<QRect>& dirty_rects, const QRect& bounds,
+	            const QTransform& viewport_transform, bool use_background, DrawFunction draw);
+
+	/**
+	 * Cancels the pending tiles of the given layer.
+	 *
+	 * Returns the union of the cancelled tiles, in viewport coordinates.
+	 */
+	QRect cancel(Layer layer);
+
+	/**
+	 * Cancels the pending tiles of all layers.
+	 */
+	void cancelAll();
+
+	/**
+	 * Returns true if there are pending tiles for the given layer.
+	 */
+	bool isPending(Layer layer) const;
+
+
+signals:
+	/**
+	 * Reports a finished tile, in viewport coordinates.
+	 */
+	void tileFinished(OpenOrienteering::MapCacheRenderer::Layer layer, const QRect& rect, const QImage& image);
+
+
+private slots:
+	void finishTile(int id, const QImage& image);
+
+
+private:
+	class Job;
+
+	struct PendingTile
+	{
+		int id;
+		QRect rect;
+		std::shared_ptr<QAtomicInt> cancelled;
+	};
+
+	/// Layer, tile column, tile row
+	using TileKey = std::tuple<int, int, int>;
+
+	std::map<TileKey, PendingTile> pending_tiles;
+	std::unordered_map<int, TileKey> pending_ids;
+	int last_id = 0;
+
+	QThreadPool pool;
+};
+
+
+}  // namespace OpenOrienteering
+
+#endif // OPENORIENTEERING_MAP_CACHE_RENDERER_H
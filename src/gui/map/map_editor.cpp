@@ -636,6 +636,22 @@ bool MapEditorController::exportTo(const QString& path, const FileFormat& format
 	return true;
 }
 
+bool MapEditorController::autosaveTo(const QString& path, const FileFormat& format, QByteArray& data)
+{
+	if (!map || editing_in_progress)
+		return false;
+	
+	auto exporter = format.makeExporter(path, map, main_view);
+	if (!exporter || !exporter->supportsQIODevice())
+		return false;
+	
+	// Unmodified objects are not serialized again.
+	exporter->setOption(QString::fromLatin1("objectCache"), true);
+	QBuffer buffer(&data);
+	exporter->setDevice(&buffer);
+	return exporter->doExport();
+}
+
 
 bool MapEditorController::loadFrom(const QString& path, const FileFormat& format, QWidget* dialog_parent)
 {
@@ -236,6 +236,8 @@ public:
 	/** Override from MainWindowController */
 	bool exportTo(const QString& path, const FileFormat& format) override;
 	/** Override from MainWindowController */
+	bool autosaveTo(const QString& path, const FileFormat& format, QByteArray& data) override;
+	/** Override from MainWindowController */
 	bool loadFrom(const QString& path, const FileFormat& format, QWidget* dialog_parent = nullptr) override;
 	
 	/** Override from MainWindowController */
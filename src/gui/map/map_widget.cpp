@@ -22,7 +22,9 @@
 #include "map_widget.h"
 
 #include <cmath>
+#include <initializer_list>
 #include <stdexcept>
+#include <utility>
 
 #include <QApplication>
 #include <QColor>
@@ -46,6 +48,7 @@
 #include <QPointer>
 #include <QResizeEvent>
 #include <QSizePolicy>
+#include <QThread>
 #include <QTimer>
 #include <QToolTip>
 #include <QTouchEvent>
@@ -96,7 +99,9 @@ MapWidget::MapWidget(bool show_help, bool force_antialiasing, QWidget* parent)
  , pinching_factor(1.0)
  , below_template_cache_dirty_rect(rect())
  , above_template_cache_dirty_rect(rect())
- , map_cache_dirty_rect(rect())
+ , map_cache_dirty_region(rect())
+ , cache_renderer(new MapCacheRenderer(this))
+ , concurrent_rendering(QThread::idealThreadCount() > 1)
  , drawing_dirty_rect_border(0)
  , activity_dirty_rect_border(0)
  , last_mouse_release_time(QTime::currentTime())
@@ -115,6 +120,8 @@ MapWidget::MapWidget(bool show_help, bool force_antialiasing, QWidget* parent)
 	setMouseTracking(true);
 	setFocusPolicy(Qt::ClickFocus);
 	setSizePolicy(QSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding));
+	
+	connect(cache_renderer, &MapCacheRenderer::tileFinished, this, &MapWidget::cacheTileFinished);
 }
 
 MapWidget::~MapWidget()
@@ -279,6 +286,7 @@ QRectF MapWidget::mapToViewport(const QRectF& input) const
 
 void MapWidget::viewChanged(MapView::ChangeFlags changes)
 {
+	transformCaches();
 	setDrawingBoundingBox(drawing_dirty_rect_map, drawing_dirty_rect_border, true);
 	setActivityBoundingBox(activity_dirty_rect_map, activity_dirty_rect_border, true);
 	updateEverything();
@@ -325,7 +333,7 @@ void MapWidget::visibilityChanged(MapView::VisibilityFeature feature, bool activ
 		
 	case MapView::VisibilityFeature::GridVisible:
 	case MapView::VisibilityFeature::MapVisible:
-		map_cache_dirty_rect = rect();
+		map_cache_dirty_region = DirtyRegion(rect());
 		Q_FALLTHROUGH();
 	case MapView::VisibilityFeature::AllTemplatesHidden:
 		update();
@@ -508,7 +516,12 @@ void MapWidget::markTemplateCacheDirty(const QRectF& view_rect, int pixel_border
 
 void MapWidget::markObjectAreaDirty(const QRectF& map_rect)
 {
-	updateMapRect(map_rect, 0, map_cache_dirty_rect);
+	QRect viewport_rect = calculateViewportBoundingBox(map_rect, 0);
+	if (viewport_rect.intersects(rect()))
+	{
+		map_cache_dirty_region.add(viewport_rect);
+		update(viewport_rect);
+	}
 }
 
 void MapWidget::setDrawingBoundingBox(QRectF map_rect, int pixel_border, bool do_update)
@@ -607,15 +620,15 @@ void MapWidget::updateDrawingLaterSlot()
 
 void MapWidget::updateEverything()
 {
-	map_cache_dirty_rect = rect();
-	below_template_cache_dirty_rect = map_cache_dirty_rect;
-	above_template_cache_dirty_rect = map_cache_dirty_rect;
-	update(map_cache_dirty_rect);
+	map_cache_dirty_region = DirtyRegion(rect());
+	below_template_cache_dirty_rect = rect();
+	above_template_cache_dirty_rect = rect();
+	update();
 }
 
 void MapWidget::updateEverythingInRect(const QRect& dirty_rect)
 {
-	rectIncludeSafe(map_cache_dirty_rect, dirty_rect);
+	map_cache_dirty_region.add(dirty_rect);
 	rectIncludeSafe(below_template_cache_dirty_rect, dirty_rect);
 	rectIncludeSafe(above_template_cache_dirty_rect, dirty_rect);
 	update(dirty_rect);
@@ -866,7 +879,6 @@ void MapWidget::paintEvent(QPaintEvent* event)
 	QTransform transform = painter.worldTransform();
 	
 	// Update all dirty caches
-	// TODO: It would be an idea to do these updates in a background thread and use the old caches in the meantime
 	updateAllDirtyCaches();
 	
 	QRect target = exposed;
@@ -955,12 +967,13 @@ void MapWidget::paintEvent(QPaintEvent* event)
 
 void MapWidget::resizeEvent(QResizeEvent* event)
 {
-	map_cache_dirty_rect = rect();
-	below_template_cache_dirty_rect = map_cache_dirty_rect;
-	above_template_cache_dirty_rect = map_cache_dirty_rect;
+	transformCaches();
+	map_cache_dirty_region = DirtyRegion(rect());
+	below_template_cache_dirty_rect = rect();
+	above_template_cache_dirty_rect = rect();
 	
-	if (map_cache.width() < map_cache_dirty_rect.width() ||
-	    map_cache.height() < map_cache_dirty_rect.height())
+	if (map_cache.width() < width() ||
+	    map_cache.height() < height())
 	{
 		map_cache = QImage();
 		below_template_cache = QImage();
@@ -1351,31 +1364,17 @@ void MapWidget::updateMapCache(bool use_background)
 	{
 		// Lazy allocation of cache image
 		map_cache = QImage(size(), QImage::Format_ARGB32_Premultiplied);
-		map_cache_dirty_rect = rect();
+		map_cache_dirty_region = DirtyRegion(rect());
 	}
 	else
 	{
 		// Make sure not to use a bigger draw rect than necessary
-		map_cache_dirty_rect = map_cache_dirty_rect.intersected(rect());
+		map_cache_dirty_region.intersect(rect());
 	}
 	
 	// Start drawing
 	QPainter painter;
 	painter.begin(&map_cache);
-	painter.setClipRect(map_cache_dirty_rect);
-	
-	// Fill with background color (TODO: make configurable)
-	if (use_background)
-	{
-		painter.fillRect(map_cache_dirty_rect, Qt::white);
-	}
-	else
-	{
-		QPainter::CompositionMode mode = painter.compositionMode();
-		painter.setCompositionMode(QPainter::CompositionMode_Clear);
-		painter.fillRect(map_cache_dirty_rect, Qt::transparent);
-		painter.setCompositionMode(mode);
-	}
 	
 	RenderConfig::Options options(RenderConfig::Screen | RenderConfig::HelperSymbols);
 	bool use_antialiasing = force_antialiasing || Settings::getInstance().getSettingCached(Settings::MapDisplay_Antialiasing).toBool();
@@ -1385,41 +1384,210 @@ void MapWidget::updateMapCache(bool use_background)
 		options |= RenderConfig::DisableAntialiasing | RenderConfig::ForceMinSize;
 		
 	Map* map = view->getMap();
-	QRectF map_view_rect = view->calculateViewedRect(viewportToView(map_cache_dirty_rect));
-
-	RenderConfig config = { *map, map_view_rect, view->calculateFinalZoomFactor(), options, 1.0 };
+	auto const scaling = view->calculateFinalZoomFactor();
 	
-	painter.translate(width() / 2.0, height() / 2.0);
-	painter.setWorldTransform(view->worldTransform(), true);
+	// Each dirty rect is drawn separately, with its own bounding box.
+	for (auto const& dirty_rect : map_cache_dirty_region.rects())
+	{
+		painter.resetTransform();
+		painter.setClipRect(dirty_rect);
+		
+		// Fill with background color (TODO: make configurable)
+		if (use_background)
+		{
+			painter.fillRect(dirty_rect, Qt::white);
+		}
+		else
+		{
+			QPainter::CompositionMode mode = painter.compositionMode();
+			painter.setCompositionMode(QPainter::CompositionMode_Clear);
+			painter.fillRect(dirty_rect, Qt::transparent);
+			painter.setCompositionMode(mode);
+		}
+		
+		QRectF map_view_rect = view->calculateViewedRect(viewportToView(dirty_rect));
+		RenderConfig config = { *map, map_view_rect, scaling, options, 1.0 };
+		
+		painter.translate(width() / 2.0, height() / 2.0);
+		painter.setWorldTransform(view->worldTransform(), true);
 #ifndef Q_OS_ANDROID
-	if (view->isOverprintingSimulationEnabled())
-		map->drawOverprintingSimulation(&painter, config);
-	else
+		if (view->isOverprintingSimulationEnabled())
+			map->drawOverprintingSimulation(&painter, config);
+		else
 #endif
-		map->draw(&painter, config);
-	
-	if (view->isGridVisible())
-		map->drawGrid(&painter, map_view_rect);
+			map->draw(&painter, config);
+		
+		if (view->isGridVisible())
+			map->drawGrid(&painter, map_view_rect);
+	}
 	
 	// Finish drawing
 	painter.end();
 	
-	map_cache_dirty_rect.setWidth(-1); // => !map_cache_dirty_rect.isValid()
+	map_cache_dirty_region.clear();
+}
+
+bool MapWidget::renderMapCacheConcurrently()
+{
+	if (!concurrent_rendering || view->isOverprintingSimulationEnabled())
+		return false;
+	
+	if (map_cache.isNull())
+	{
+		// Lazy allocation of cache image
+		map_cache = QImage(size(), QImage::Format_ARGB32_Premultiplied);
+		map_cache.fill(Qt::transparent);
+		map_cache_dirty_region = DirtyRegion(rect());
+	}
+	
+	auto const dirty_rects = map_cache_dirty_region.rects();
+	map_cache_dirty_region.clear();
+	QRect snapshot_rect;
+	for (auto const& dirty_rect : dirty_rects)
+		snapshot_rect = snapshot_rect.united(MapCacheRenderer::tileAlignedRect(dirty_rect, rect()));
+	if (snapshot_rect.isEmpty())
+		return true;
+	
+	RenderConfig::Options options(RenderConfig::Screen | RenderConfig::HelperSymbols);
+	bool use_antialiasing = force_antialiasing || Settings::getInstance().getSettingCached(Settings::MapDisplay_Antialiasing).toBool();
+	if (!use_antialiasing)
+		options |= RenderConfig::DisableAntialiasing | RenderConfig::ForceMinSize;
+	
+	// The snapshot must cover the full tiles.
+	Map* map = view->getMap();
+	auto snapshot = map->renderablesSnapshot(view->calculateViewedRect(viewportToView(snapshot_rect)));
+	auto const scaling = view->calculateFinalZoomFactor();
+	cache_renderer->render(MapCacheRenderer::MapLayer, dirty_rects, rect(), viewportTransform(), false,
+	                       [map, snapshot, scaling, options, use_antialiasing](QPainter* painter, const QRectF& map_rect) {
+		if (use_antialiasing)
+			painter->setRenderHint(QPainter::Antialiasing);
+		RenderConfig config = { *map, map_rect, scaling, options, 1.0 };
+		snapshot->draw(painter, config);
+	});
+	return true;
+}
+
+bool MapWidget::renderTemplateCacheConcurrently(QImage& cache, QRect& dirty_rect, int first_template, int last_template, bool use_background, MapCacheRenderer::Layer layer)
+{
+	if (!concurrent_rendering)
+		return false;
+	
+	auto draw = view->getMap()->concurrentTemplatesDrawFunction(first_template, last_template, view, true);
+	if (!draw)
+		return false;
+	
+	if (cache.isNull())
+	{
+		// Lazy allocation of cache image
+		cache = QImage(size(), QImage::Format_ARGB32_Premultiplied);
+		cache.fill(use_background ? Qt::white : Qt::transparent);
+		dirty_rect = rect();
+	}
+	
+	auto const area = MapCacheRenderer::tileAlignedRect(dirty_rect, rect());
+	dirty_rect.setWidth(-1); // => !dirty_rect.isValid()
+	if (!area.isEmpty())
+		cache_renderer->render(layer, area, rect(), viewportTransform(), use_background, std::move(draw));
+	return true;
+}
+
+void MapWidget::cacheTileFinished(MapCacheRenderer::Layer layer, const QRect& rect, const QImage& image)
+{
+	QImage* cache = nullptr;
+	switch (layer)
+	{
+	case MapCacheRenderer::BelowTemplates:
+		cache = &below_template_cache;
+		break;
+	case MapCacheRenderer::MapLayer:
+		cache = &map_cache;
+		break;
+	case MapCacheRenderer::AboveTemplates:
+		cache = &above_template_cache;
+		break;
+	}
+	if (!cache || cache->isNull())
+		return;
+	
+	QPainter painter(cache);
+	painter.setCompositionMode(QPainter::CompositionMode_Source);
+	painter.drawImage(rect.topLeft(), image);
+	
+	if (layer == MapCacheRenderer::MapLayer && view->isGridVisible())
+	{
+		// The grid is cheap, and it depends on mutable map state.
+		painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
+		painter.setClipRect(rect);
+		painter.translate(width() / 2.0, height() / 2.0);
+		painter.setWorldTransform(view->worldTransform(), true);
+		view->getMap()->drawGrid(&painter, view->calculateViewedRect(viewportToView(rect)));
+	}
+	painter.end();
+	
+	update(rect);
+}
+
+void MapWidget::transformCaches()
+{
+	if (!concurrent_rendering)
+		return;
+	
+	cache_renderer->cancelAll();
+	
+	auto const transform = cache_transform.inverted() * viewportTransform();
+	for (auto* cache : { &below_template_cache, &map_cache, &above_template_cache })
+	{
+		if (cache->isNull())
+			continue;
+		
+		QImage new_cache(size(), cache->format());
+		new_cache.fill(cache == &below_template_cache ? Qt::white : Qt::transparent);
+		QPainter painter(&new_cache);
+		painter.setRenderHint(QPainter::SmoothPixmapTransform);
+		painter.setTransform(transform);
+		painter.drawImage(0, 0, *cache);
+		painter.end();
+		*cache = new_cache;
+	}
+	cache_transform = viewportTransform();
+}
+
+QTransform MapWidget::viewportTransform() const
+{
+	return view->worldTransform() * QTransform::fromTranslate(width() / 2.0, height() / 2.0);
 }
 
 void MapWidget::updateAllDirtyCaches()
 {
-	if (map_cache_dirty_rect.isValid())
+	if (!map_cache_dirty_region.isEmpty() && !renderMapCacheConcurrently())
+	{
+		map_cache_dirty_region.add(cache_renderer->cancel(MapCacheRenderer::MapLayer));
 		updateMapCache(false);
+	}
 	
 	if (!view->areAllTemplatesHidden())
 	{
-		if (below_template_cache_dirty_rect.isValid() && isBelowTemplateVisible())
-			updateTemplateCache(below_template_cache, below_template_cache_dirty_rect, 0, view->getMap()->getFirstFrontTemplate() - 1, true);
+		auto const first_front_template = view->getMap()->getFirstFrontTemplate();
+		if (below_template_cache_dirty_rect.isValid() && isBelowTemplateVisible()
+		    && !renderTemplateCacheConcurrently(below_template_cache, below_template_cache_dirty_rect, 0, first_front_template - 1, true, MapCacheRenderer::BelowTemplates))
+		{
+			auto const cancelled = cache_renderer->cancel(MapCacheRenderer::BelowTemplates);
+			if (cancelled.isValid())
+				rectIncludeSafe(below_template_cache_dirty_rect, cancelled);
+			updateTemplateCache(below_template_cache, below_template_cache_dirty_rect, 0, first_front_template - 1, true);
+		}
 		
-		if (above_template_cache_dirty_rect.isValid() && isAboveTemplateVisible())
-			updateTemplateCache(above_template_cache, above_template_cache_dirty_rect, view->getMap()->getFirstFrontTemplate(), view->getMap()->getNumTemplates() - 1, false);
+		if (above_template_cache_dirty_rect.isValid() && isAboveTemplateVisible()
+		    && !renderTemplateCacheConcurrently(above_template_cache, above_template_cache_dirty_rect, first_front_template, view->getMap()->getNumTemplates() - 1, false, MapCacheRenderer::AboveTemplates))
+		{
+			auto const cancelled = cache_renderer->cancel(MapCacheRenderer::AboveTemplates);
+			if (cancelled.isValid())
+				rectIncludeSafe(above_template_cache_dirty_rect, cancelled);
+			updateTemplateCache(above_template_cache, above_template_cache_dirty_rect, first_front_template, view->getMap()->getNumTemplates() - 1, false);
+		}
 	}
+	
+	cache_transform = viewportTransform();
 }
 
 void MapWidget::shiftCache(int sx, int sy, QImage& cache)
@@ -37,11 +37,14 @@
 #include <QSize>
 #include <QString>
 #include <QTime>
+#include <QTransform>
 #include <QVariant>
 #include <QWidget>
 
 #include "core/map_coord.h"
 #include "core/map_view.h"
+#include "gui/map/map_cache_renderer.h"
+#include "util/dirty_region.h"
 
 class QContextMenuEvent;
 class QEvent;
@@ -257,6 +260,11 @@ public:
 	 * of the widget, if needed.
 	 */
 	void clearDrawingBoundingBox();
+	/**
+	 * Returns the bounding box of the current drawing, in map coordinates.
+	 * The rect is invalid when there is no current drawing.
+	 */
+	QRectF drawingBoundingBox() const { return drawing_dirty_rect_map; }
 	
 	/** Analogon to setDrawingBoundingBox() for activities. */
 	void setActivityBoundingBox(QRectF map_rect, int pixel_border, bool do_update);  // clazy:exclude=function-args-by-ref
@@ -415,6 +423,29 @@ private:
 	 *     drawing the map, else makes it transparent.
 	 */
 	void updateMapCache(bool use_background);
+	/**
+	 * Requests rendering of the map cache dirty rect in worker threads.
+	 * 
+	 * Returns false if the map cache must be updated by updateMapCache().
+	 */
+	bool renderMapCacheConcurrently();
+	/**
+	 * Requests rendering of a template cache dirty rect in worker threads.
+	 * 
+	 * Returns false if the template cache must be updated by updateTemplateCache().
+	 */
+	bool renderTemplateCacheConcurrently(QImage& cache, QRect& dirty_rect, int first_template, int last_template, bool use_background, MapCacheRenderer::Layer layer);
+	/** Copies a tile rendered in a worker thread into its cache. */
+	void cacheTileFinished(MapCacheRenderer::Layer layer, const QRect& rect, const QImage& image);
+	/**
+	 * Transforms the content of the caches to the current viewport.
+	 * 
+	 * This provides scaled or shifted content while the caches are rendered
+	 * in worker threads. Pending tiles are cancelled.
+	 */
+	void transformCaches();
+	/** Returns the transformation from map coordinates to viewport coordinates. */
+	QTransform viewportTransform() const;
 	/** Redraws all dirty caches. */
 	void updateAllDirtyCaches();
 	/** Shifts the content in the cache by the given amount of pixels. */
@@ -507,7 +538,15 @@ private:
 	
 	/** Map layer cache  */
 	QImage map_cache;
-	QRect map_cache_dirty_rect;
+	/** The areas of the map layer cache which need to be redrawn */
+	DirtyRegion map_cache_dirty_region;
+	
+	/** Renders the caches in worker threads, if enabled. */
+	MapCacheRenderer* cache_renderer;
+	/** The viewport transform which was used for rendering the caches. */
+	QTransform cache_transform;
+	/** Indicates whether the caches are rendered in worker threads. */
+	bool concurrent_rendering;
 	
 	// Dirty regions for drawings (tools) and activities
 	/** Dirty rect for the current tool, in viewport coordinates (pixels). */
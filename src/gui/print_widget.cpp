@@ -51,7 +51,6 @@
 #include <QMargins>
 #include <QMessageBox>
 #include <QPageSize>
-#include <QPainter>
 #include <QPointF>
 #include <QPrinter>
 #include <QPrinterInfo>
@@ -100,6 +99,7 @@
 
 #ifdef MAPPER_USE_GDAL
 #  include "gdal/kmz_groundoverlay_export.h"
+#  include "gdal/web_tiles_export.h"
 #endif
 
 
@@ -1231,17 +1231,23 @@ void PrintWidget::exportToKmz()
 	static const QString filter_template(QString::fromLatin1("%1 (%2)"));
 	QStringList filters = { filter_template.arg(tr("KMZ"), QString::fromLatin1("*.kmz")),
 	                        filter_template.arg(tr("KML"), QString::fromLatin1("*.kml")),
+	                        filter_template.arg(tr("MBTiles"), QString::fromLatin1("*.mbtiles")),
+	                        filter_template.arg(tr("XYZ tiles directory"), QString::fromLatin1("*")),
 	                        tr("All files (*.*)") };
 	QString selected_filter;
 	QString path = FileDialog::getSaveFileName(this, tr("Export map ..."), {}, filters.join(QString::fromLatin1(";;")), &selected_filter);
 	if (path.isEmpty())
 		return;
 	
-	if (!path.endsWith(QLatin1String(".kmz"), Qt::CaseInsensitive)
+	if (selected_filter != filters[3]
+	    && !path.endsWith(QLatin1String(".mbtiles"), Qt::CaseInsensitive)
+	    && !path.endsWith(QLatin1String(".kmz"), Qt::CaseInsensitive)
 	    && !path.endsWith(QLatin1String(".kml"), Qt::CaseInsensitive))
 	{
 		if (selected_filter == filters[1])
 			path.append(QString::fromLatin1(".kml"));
+		else if (selected_filter == filters[2])
+			path.append(QString::fromLatin1(".mbtiles"));
 		else
 			path.append(QString::fromLatin1(".kmz"));
 	}
@@ -1252,6 +1258,28 @@ void PrintWidget::exportToKmz()
 	progress.setMinimumDuration(500);
 	progress.setAutoClose(true);
 	
+	auto const is_web_tiles = selected_filter == filters[3]
+	                          || path.endsWith(QLatin1String(".mbtiles"), Qt::CaseInsensitive);
+	if (is_web_tiles)
+	{
+		// The highest zoom level is chosen according to the resolution.
+		auto const zoom_range = WebTilesExport::suggestedZoomRange(*map, *map_printer);
+		WebTilesExport exporter(path, *map);
+		exporter.setProgressObserver(&progress);
+		if (!exporter.doExport(*map_printer, zoom_range.min_zoom, zoom_range.max_zoom))
+		{
+			progress.cancel();
+			QMessageBox::warning(this, tr("Error"), tr("Failed to save the image:\n%1").arg(exporter.errorString()));
+			main_window->showStatusBarMessage(tr("Canceled."), 4000);
+		}
+		else
+		{
+			main_window->showStatusBarMessage(tr("Exported successfully to %1").arg(path), 4000);
+			emit finished(0);
+		}
+		return;
+	}
+	
 	KmzGroundOverlayExport exporter(path, *map);
 	exporter.setProgressObserver(&progress);
 	if (!exporter.doExport(*map_printer, tile_size_combo->currentData().toInt()))
@@ -1310,9 +1338,7 @@ void PrintWidget::exportToImage()
 #endif
 	
 	// Export the map
-	QPainter p(&image);
-	map_printer->drawPage(&p, map_printer->getPrintArea(), &image);
-	p.end();
+	map_printer->drawPageToImage(image, map_printer->getPrintArea());
 	if (!image.save(path))
 	{
 		QMessageBox::warning(this, tr("Error"), tr("Failed to save the image. Does the path exist? Do you have sufficient rights?"));
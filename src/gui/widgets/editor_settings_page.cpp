@@ -112,6 +112,12 @@ EditorSettingsPage::EditorSettingsPage(QWidget* parent)
 	rectangle_preview_line_width = new QCheckBox(tr("Preview the width of lines with helper cross"));
 	layout->addRow(rectangle_preview_line_width);
 	
+	layout->addItem(Util::SpacerItem::create(this));
+	layout->addRow(Util::Headline::create(tr("Fill tool:")));
+	
+	fill_vector_mode = new QCheckBox(tr("Fill up to the center lines of lines, without rasterizing the map"));
+	layout->addRow(fill_vector_mode);
+	
 	
 	connect(antialiasing, &QAbstractButton::toggled, text_antialiasing, &QCheckBox::setEnabled);
 	
@@ -147,6 +153,7 @@ void EditorSettingsPage::apply()
 	setSetting(Settings::EditTool_DeleteBezierPointActionAlternative, edit_tool_delete_bezier_point_action_alternative->currentData());
 	setSetting(Settings::RectangleTool_HelperCrossRadiusMM, rectangle_helper_cross_radius->value());
 	setSetting(Settings::RectangleTool_PreviewLineWidth, rectangle_preview_line_width->isChecked());
+	setSetting(Settings::FillTool_VectorMode, fill_vector_mode->isChecked());
 }
 
 void EditorSettingsPage::reset()
@@ -176,6 +183,8 @@ void EditorSettingsPage::updateWidgets()
 	
 	rectangle_helper_cross_radius->setValue(getSetting(Settings::RectangleTool_HelperCrossRadiusMM).toInt());
 	rectangle_preview_line_width->setChecked(getSetting(Settings::RectangleTool_PreviewLineWidth).toBool());
+	
+	fill_vector_mode->setChecked(getSetting(Settings::FillTool_VectorMode).toBool());
 }
 
 
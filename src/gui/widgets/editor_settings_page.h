@@ -71,6 +71,8 @@ private:
 	
 	QSpinBox* rectangle_helper_cross_radius;
 	QCheckBox* rectangle_preview_line_width;
+	
+	QCheckBox* fill_vector_mode;
 };
 
 
@@ -487,8 +487,11 @@ void TemplateListWidget::updateButtons()
 				georef_enabled = temp->canChangeTemplateGeoreferenced();
 				custom_enabled = !is_georeferenced;
 				import_enabled = bool(qobject_cast<TemplateMap*>(temp));
-				vectorize_enabled = qobject_cast<TemplateImage*>(temp)
-									&& temp->getTemplateState() == Template::Loaded;
+				// Tiled images cannot be vectorized, there is no full image.
+				auto const* image_template = qobject_cast<TemplateImage*>(temp);
+				vectorize_enabled = image_template
+									&& image_template->getTemplateState() == Template::Loaded
+									&& !image_template->isTiled();
 			}
 		}
 		else if (current_row >= 0)
@@ -988,6 +991,8 @@ void TemplateListWidget::vectorizeClicked()
 #ifdef WITH_COVE
 	cove::CoveRunner cr;
 	auto* templ = qobject_cast<TemplateImage*>(currentTemplate());
+	if (!templ || templ->getImage().isNull())
+		return;
 	cr.run(controller.getWindow(), &map, templ);
 #endif /* WITH_COVE */
 }
@@ -60,6 +60,7 @@ public:
 		EditTool_DeleteBezierPointActionAlternative,
 		RectangleTool_HelperCrossRadiusMM,
 		RectangleTool_PreviewLineWidth,
+		FillTool_VectorMode,
 		Templates_KeepSettingsOfClosed,
 		SymbolWidget_IconSizeMM,
 		SymbolWidget_ShowCustomIcons,
@@ -735,24 +735,36 @@ bool Template::trySetTemplateGeoreferenced(bool value, QWidget* /*dialog_parent*
 }
 
 
+Template::DrawFunction Template::concurrentDrawFunction() const
+{
+	return {};
+}
+
 void Template::applyTemplateTransform(QPainter* painter) const
 {
-	painter->translate(transform.template_x / 1000.0, transform.template_y / 1000.0);
+	painter->setWorldTransform(templateTransform(), true);
+}
+
+QTransform Template::templateTransform() const
+{
+	QTransform result;
+	result.translate(transform.template_x / 1000.0, transform.template_y / 1000.0);
 	// Rotate counter-clockwise.
-	painter->rotate(-transform.template_rotation * (180 / M_PI));
+	result.rotate(-transform.template_rotation * (180 / M_PI));
 
 	// Scale
 	if (qFuzzyIsNull(transform.template_shear))
 	{
-		painter->scale(transform.template_scale_x, transform.template_scale_y);
+		result.scale(transform.template_scale_x, transform.template_scale_y);
 	}
 	else
 	{
 		QTransform scaling(transform.template_scale_x, transform.template_shear,
 		                   transform.template_shear, transform.template_scale_y,
 		                   0, 0);
-		painter->setTransform(scaling, true);
+		result = scaling * result;
 	}
+	return result;
 }
 
 QRectF Template::getTemplateExtent() const
@@ -379,6 +379,22 @@ public:
 	 */
     virtual void drawTemplate(QPainter* painter, const QRectF& clip_rect, double scale, bool on_screen, qreal opacity) const = 0;
 	
+	/**
+	 * A function which draws a template, with the parameters of drawTemplate().
+	 */
+	using DrawFunction = std::function<void (QPainter* painter, const QRectF& clip_rect, double scale, bool on_screen, qreal opacity)>;
+	
+	/**
+	 * Returns a function which draws the template in its current state like
+	 * drawTemplate(), but which may be called from another thread.
+	 * 
+	 * The function must not access the template object, and it must remain
+	 * valid when the template is modified, unloaded or deleted.
+	 * The default implementation returns an empty function, indicating that
+	 * the template can be drawn only by drawTemplate().
+	 */
+	virtual DrawFunction concurrentDrawFunction() const;
+	
 	
 	/** 
 	 * Calculates the template's bounding box in map coordinates.
@@ -445,6 +461,12 @@ public:
 	 */
 	void applyTemplateTransform(QPainter* painter) const;
 	
+	/**
+	 * Returns the transformation from template coordinates to map coordinates
+	 * which is applied by applyTemplateTransform().
+	 */
+	QTransform templateTransform() const;
+	
 	/**
 	 * Returns the extent of the template in template coordinates.
 	 * 
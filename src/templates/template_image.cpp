@@ -22,6 +22,7 @@
 #include "template_image.h"
 
 #include <algorithm>
+#include <cmath>
 #include <iosfwd>
 #include <iterator>
 #include <utility>
@@ -44,6 +45,7 @@
 #include <QRect>
 #include <QSaveFile>
 #include <QSize>
+#include <QSizeF>
 #include <QStringRef>
 #include <QTransform>
 #include <QXmlStreamReader>
@@ -59,6 +61,7 @@
 #include "printsupport/advanced_pdf_printer.h"
 #endif
 #include "templates/template_image_open_dialog.h"
+#include "templates/template_image_tiles.h"
 #include "templates/world_file.h"
 #include "util/transformation.h"
 #include "util/util.h"
@@ -89,6 +92,34 @@ QByteArray findExportFormat(const QString& filename)
 	return {};
 }
 
+/**
+ * Draws the image, or the visible tiles, in template coordinates.
+ * 
+ * map_transform is the painter's world transform for map coordinates, and
+ * clip_rect is given in map coordinates.
+ */
+void drawImage(QPainter* painter, const QTransform& map_transform, const QImage& image, TemplateImageTiles* tiles, const QRectF& clip_rect)
+{
+	if (tiles)
+	{
+		// Draw only the visible tiles, at the level matching the resolution.
+		auto const size = tiles->size();
+		painter->translate(-size.width() * 0.5, -size.height() * 0.5);
+		auto rect = QRectF(QPointF(0, 0), QSizeF(size));
+		if (clip_rect.isValid())
+		{
+			auto const map_to_pixels = map_transform * painter->worldTransform().inverted();
+			rect = map_to_pixels.mapRect(clip_rect);
+		}
+		auto const resolution = std::sqrt(std::abs(painter->combinedTransform().determinant()));
+		tiles->draw(painter, rect, tiles->levelForResolution(resolution));
+	}
+	else
+	{
+		painter->drawImage(QPointF(-image.width() * 0.5, -image.height() * 0.5), image);
+	}
+}
+
 }
 
 
@@ -117,6 +148,7 @@ TemplateImage::TemplateImage(const QString& path, Map* map)
 TemplateImage::TemplateImage(const TemplateImage& proto)
 : Template(proto)
 , image(proto.image)
+, tiles(proto.tiles)
 // not copied: undo_steps
 // not copied: undo_index
 , available_georef(proto.available_georef)
@@ -273,7 +305,7 @@ bool TemplateImage::postLoadSetup(QWidget* dialog_parent, bool& out_center_in_vi
 			{
 				// Use the center coordinates of the image as initial reference point.
 				calculateGeoreferencing();
-				auto const center_pixel = MapCoordF(0.5 * (image.width() - 1), 0.5 * (image.height() - 1));
+				auto const center_pixel = MapCoordF(0.5 * (imageSize().width() - 1), 0.5 * (imageSize().height() - 1));
 				initial_georef.setProjectedRefPoint(georef->toProjectedCoords(center_pixel));
 				initial_georef.setCombinedScaleFactor(1.0);
 				initial_georef.setGrivation(0.0);
@@ -336,10 +368,12 @@ bool TemplateImage::postLoadSetup(QWidget* dialog_parent, bool& out_center_in_vi
 void TemplateImage::unloadTemplateFileImpl()
 {
 	image = QImage();
+	tiles.reset();
 }
 
-void TemplateImage::drawTemplate(QPainter* painter, const QRectF& /*clip_rect*/, double /*scale*/, bool /*on_screen*/, qreal opacity) const
+void TemplateImage::drawTemplate(QPainter* painter, const QRectF& clip_rect, double /*scale*/, bool /*on_screen*/, qreal opacity) const
 {
+	auto const map_transform = painter->worldTransform();
 	applyTemplateTransform(painter);
 	
 	painter->setRenderHint(QPainter::SmoothPixmapTransform);
@@ -360,29 +394,57 @@ void TemplateImage::drawTemplate(QPainter* painter, const QRectF& /*clip_rect*/,
 			painter->setBrush(Qt::white);
 	}
 #endif
-	painter->drawImage(QPointF(-image.width() * 0.5, -image.height() * 0.5), image);
+	drawImage(painter, map_transform, image, tiles.get(), clip_rect);
 	painter->setRenderHint(QPainter::SmoothPixmapTransform, false);
 }
+
+Template::DrawFunction TemplateImage::concurrentDrawFunction() const
+{
+	// The image is implicitly shared, and the tiles are thread-safe.
+	return [image = image, tiles = tiles, template_transform = templateTransform()]
+	       (QPainter* painter, const QRectF& clip_rect, double /*scale*/, bool /*on_screen*/, qreal opacity)
+	{
+		auto const map_transform = painter->worldTransform();
+		painter->setWorldTransform(template_transform, true);
+		painter->setRenderHint(QPainter::SmoothPixmapTransform);
+		painter->setOpacity(opacity);
+		drawImage(painter, map_transform, image, tiles.get(), clip_rect);
+		painter->setRenderHint(QPainter::SmoothPixmapTransform, false);
+	};
+}
+
 QRectF TemplateImage::getTemplateExtent() const
 {
-    // If the image is invalid, the extent is an empty rectangle.
-    if (image.isNull())
+	// If the image is invalid, the extent is an empty rectangle.
+	auto const size = imageSize();
+	if (size.isEmpty())
 		return QRectF();
-	return QRectF(-image.width() * 0.5, -image.height() * 0.5, image.width(), image.height());
+	return QRectF(-size.width() * 0.5, -size.height() * 0.5, size.width(), size.height());
+}
+
+QSize TemplateImage::imageSize() const
+{
+	return tiles ? tiles->size() : image.size();
 }
 
 QPointF TemplateImage::calcCenterOfGravity(QRgb background_color)
 {
+	// For tiled images, a reduced resolution is good enough.
+	auto const source = tiles ? tiles->readReduced(QSize(2048, 2048)) : image;
+	auto const size = imageSize();
+	if (source.isNull())
+		return {};
+	
 	int num_points = 0;
 	QPointF center = QPointF(0, 0);
-	int width = image.width();
-	int height = image.height();
+	int width = source.width();
+	int height = source.height();
 	
 	for (int x = 0; x < width; ++x)
 	{
 		for (int y = 0; y < height; ++y)
 		{
-			QRgb pixel = image.pixel(x, y);
+			QRgb pixel = source.pixel(x, y);
 			if (qAlpha(pixel) < 127 || pixel == background_color)
 				continue;
 			
@@ -393,7 +455,10 @@ QPointF TemplateImage::calcCenterOfGravity(QRgb background_color)
 	
 	if (num_points > 0)
 		center = QPointF(center.x() / num_points, center.y() / num_points);
-	center -= QPointF(image.width() * 0.5 - 0.5, image.height() * 0.5 - 0.5);
+	if (source.size() != size)
+		center = QPointF((center.x() + 0.5) * size.width() / width - 0.5,
+		                 (center.y() + 0.5) * size.height() / height - 0.5);
+	center -= QPointF(size.width() * 0.5 - 0.5, size.height() * 0.5 - 0.5);
 	
 	return center;
 }
@@ -703,13 +768,13 @@ void TemplateImage::updatePosFromGeoreferencing()
 		qDebug("%s failed", Q_FUNC_INFO);
 		return; // TODO: proper error message?
 	}
-	MapCoordF top_right = map->getGeoreferencing().toMapCoordF(georef.get(), MapCoordF(image.width(), 0.0), &ok);
+	MapCoordF top_right = map->getGeoreferencing().toMapCoordF(georef.get(), MapCoordF(imageSize().width(), 0.0), &ok);
 	if (!ok)
 	{
 		qDebug("%s failed", Q_FUNC_INFO);
 		return; // TODO: proper error message?
 	}
-	MapCoordF bottom_left = map->getGeoreferencing().toMapCoordF(georef.get(), MapCoordF(0.0, image.height()), &ok);
+	MapCoordF bottom_left = map->getGeoreferencing().toMapCoordF(georef.get(), MapCoordF(0.0, imageSize().height()), &ok);
 	if (!ok)
 	{
 		qDebug("%s failed", Q_FUNC_INFO);
@@ -720,13 +785,13 @@ void TemplateImage::updatePosFromGeoreferencing()
 	PassPointList pp_list;
 	
 	PassPoint pp;
-	pp.src_coords = MapCoordF(-0.5 * image.width(), -0.5 * image.height());
+	pp.src_coords = MapCoordF(-0.5 * imageSize().width(), -0.5 * imageSize().height());
 	pp.dest_coords = top_left;
 	pp_list.push_back(pp);
-	pp.src_coords = MapCoordF(0.5 * image.width(), -0.5 * image.height());
+	pp.src_coords = MapCoordF(0.5 * imageSize().width(), -0.5 * imageSize().height());
 	pp.dest_coords = top_right;
 	pp_list.push_back(pp);
-	pp.src_coords = MapCoordF(-0.5 * image.width(), 0.5 * image.height());
+	pp.src_coords = MapCoordF(-0.5 * imageSize().width(), 0.5 * imageSize().height());
 	pp.dest_coords = bottom_left;
 	pp_list.push_back(pp);
 	
@@ -33,6 +33,7 @@
 #include <QPointF>
 #include <QRectF>
 #include <QRgb>
+#include <QSize>
 #include <QString>
 #include <QTransform>
 
@@ -50,6 +51,7 @@ namespace OpenOrienteering {
 class Georeferencing;
 class Map;
 class MapCoordF;
+class TemplateImageTiles;
 
 
 /**
@@ -115,6 +117,7 @@ public:
 	void unloadTemplateFileImpl() override;
 	
     void drawTemplate(QPainter* painter, const QRectF& clip_rect, double scale, bool on_screen, qreal opacity) const override;
+	DrawFunction concurrentDrawFunction() const override;
 	QRectF getTemplateExtent() const override;
 	bool canBeDrawnOnto() const override { return drawable; }
 
@@ -124,9 +127,25 @@ public:
 	 */
 	QPointF calcCenterOfGravity(QRgb background_color);
 	
-	/** Returns the internal QImage. */
+	/**
+	 * Returns the internal QImage.
+	 * 
+	 * The image is null when the template is drawn from tiles.
+	 */
 	inline const QImage& getImage() const {return image;}
 	
+	/**
+	 * Returns true if the template is drawn from tiles, without a full image.
+	 */
+	inline bool isTiled() const {return bool(tiles);}
+	
+	/**
+	 * Returns the size of the image, in pixels.
+	 * 
+	 * Unlike getImage().size(), this is valid for tiled images, too.
+	 */
+	QSize imageSize() const;
+	
 	/**
 	 * Returns which georeferencing methods are known to be available.
 	 * 
@@ -188,6 +207,9 @@ protected:
 
 	QImage image;
 	
+	/// A tile pyramid which replaces the image for large rasters.
+	std::shared_ptr<TemplateImageTiles> tiles;
+	
 	std::vector< DrawOnImageUndoStep > undo_steps;
 	/// Current index in undo_steps, where 0 means before the first item.
 	int undo_index = 0;
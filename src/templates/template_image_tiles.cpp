@@ -0,0 +1,221 @@
+/*
+ *    Copyright 2021 The OpenOrienteering developers
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "template_image_tiles.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+#include <QMutexLocker>
+#include <QPainter>
+#include <QPoint>
+#include <QPointF>
+#include <QRectF>
+#include <QSizeF>
+
+
+namespace OpenOrienteering {
+
+namespace {
+
+/**
+ * Returns the size of the given length at the given level, rounded up.
+ */
+constexpr int reduced(int length, int level)
+{
+	return (length + (1 << level) - 1) >> level;
+}
+
+std::size_t byteSize(const QImage& image)
+{
+	return std::size_t(image.bytesPerLine()) * std::size_t(image.height());
+}
+
+}  // namespace
+
+
+
+TemplateImageTiles::TemplateImageTiles(const QSize& size, ReadFunction read, std::size_t cache_limit)
+: image_size(size)
+, read(std::move(read))
+, cache_limit(cache_limit)
+{
+	while (num_levels < 30
+	       && (reduced(image_size.width(), num_levels - 1) > tile_size
+	           || reduced(image_size.height(), num_levels - 1) > tile_size))
+	{
+		++num_levels;
+	}
+}
+
+TemplateImageTiles::~TemplateImageTiles() = default;
+
+
+int TemplateImageTiles::levelForResolution(qreal resolution) const
+{
+	if (!(resolution > 0))
+		return num_levels - 1;
+
+	// Level n has a resolution of 1/2^n full resolution pixels.
+	auto const level = int(std::floor(-std::log2(resolution)));
+	return qBound(0, level, num_levels - 1);
+}
+
+
+QRect TemplateImageTiles::tileRect(const TileKey& key) const
+{
+	auto const length = tile_size << key.level;
+	return QRect(key.x * length, key.y * length, length, length)
+	       .intersected(QRect(QPoint(0, 0), image_size));
+}
+
+
+void TemplateImageTiles::draw(QPainter* painter, const QRectF& rect, int level)
+{
+	level = qBound(0, level, num_levels - 1);
+	auto const visible = rect.intersected(QRectF(QPointF(0, 0), QSizeF(image_size)));
+	if (visible.isEmpty())
+		return;
+
+	auto const length = qreal(tile_size << level);
+	auto const first_x = std::max(0, int(std::floor(visible.left() / length)));
+	auto const first_y = std::max(0, int(std::floor(visible.top() / length)));
+	auto const last_x  = std::min(reduced(image_size.width(), level) / tile_size, int(std::floor(visible.right() / length)));
+	auto const last_y  = std::min(reduced(image_size.height(), level) / tile_size, int(std::floor(visible.bottom() / length)));
+
+	// Fetch the cached tiles, then decode and draw without holding the lock.
+	std::vector<std::pair<TileKey, QImage>> visible_tiles;
+	visible_tiles.reserve(std::size_t((last_x - first_x + 1) * (last_y - first_y + 1)));
+	std::vector<std::size_t> missing_tiles;
+	{
+		QMutexLocker locker(&mutex);
+		for (int y = first_y; y <= last_y; ++y)
+		{
+			for (int x = first_x; x <= last_x; ++x)
+			{
+				auto const key = TileKey { level, x, y };
+				if (tileRect(key).isEmpty())
+					continue;
+				visible_tiles.emplace_back(key, QImage());
+				if (!findTile(key, visible_tiles.back().second))
+					missing_tiles.push_back(visible_tiles.size() - 1);
+			}
+		}
+	}
+
+	for (auto index : missing_tiles)
+	{
+		auto& item = visible_tiles[index];
+		QMutexLocker read_locker(&read_mutex);
+		{
+			// Another thread may have decoded the tile in the meantime.
+			QMutexLocker locker(&mutex);
+			if (findTile(item.first, item.second))
+				continue;
+		}
+		item.second = decodeTile(item.first);
+		QMutexLocker locker(&mutex);
+		insertTile(item.first, item.second);
+		trimCache(visible_tiles.size());
+	}
+
+	for (auto const& item : visible_tiles)
+	{
+		if (!item.second.isNull())
+			painter->drawImage(QRectF(tileRect(item.first)), item.second, QRectF(item.second.rect()));
+	}
+}
+
+
+QImage TemplateImageTiles::readReduced(const QSize& max_size)
+{
+	auto level = 0;
+	while (level + 1 < num_levels
+	       && (reduced(image_size.width(), level) > max_size.width()
+	           || reduced(image_size.height(), level) > max_size.height()))
+	{
+		++level;
+	}
+
+	QMutexLocker locker(&read_mutex);
+	return read(QRect(QPoint(0, 0), image_size),
+	            QSize(reduced(image_size.width(), level), reduced(image_size.height(), level)));
+}
+
+
+std::size_t TemplateImageTiles::cacheSize() const
+{
+	QMutexLocker locker(&mutex);
+	return cache_size;
+}
+
+void TemplateImageTiles::clearCache()
+{
+	QMutexLocker locker(&mutex);
+	tiles.clear();
+	tile_index.clear();
+	cache_size = 0;
+}
+
+
+bool TemplateImageTiles::findTile(const TileKey& key, QImage& image)
+{
+	auto found = tile_index.find(key);
+	if (found == tile_index.end())
+		return false;
+
+	// Move to front
+	tiles.splice(tiles.begin(), tiles, found->second);
+	image = found->second->second;
+	return true;
+}
+
+void TemplateImageTiles::insertTile(const TileKey& key, const QImage& image)
+{
+	if (tile_index.count(key))
+		return;
+
+	tiles.emplace_front(key, image);
+	tile_index.emplace(key, tiles.begin());
+	cache_size += byteSize(image);
+}
+
+QImage TemplateImageTiles::decodeTile(const TileKey& key) const
+{
+	auto const source = tileRect(key);
+	auto const size = QSize(reduced(source.width(), key.level), reduced(source.height(), key.level));
+	return read(source, size);
+}
+
+void TemplateImageTiles::trimCache(std::size_t keep)
+{
+	while (cache_size > cache_limit && tiles.size() > keep)
+	{
+		auto const& last = tiles.back();
+		cache_size -= byteSize(last.second);
+		tile_index.erase(last.first);
+		tiles.pop_back();
+	}
+}
+
+
+}  // namespace OpenOrienteering
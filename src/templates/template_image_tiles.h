@@ -0,0 +1,199 @@
+/*
+ *    Copyright 2021 The OpenOrienteering developers
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef OPENORIENTEERING_TEMPLATE_IMAGE_TILES_H
+#define OPENORIENTEERING_TEMPLATE_IMAGE_TILES_H
+
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+#include <QtGlobal>
+#include <QImage>
+#include <QMutex>
+#include <QRect>
+#include <QSize>
+
+class QPainter;
+class QRectF;
+
+namespace OpenOrienteering {
+
+
+/**
+ * A multi-resolution tile pyramid for large raster images.
+ *
+ * Instead of holding the full image in memory, this class decodes square
+ * tiles on demand via a read function, and keeps the most recently used tiles
+ * in a cache of limited size. Level 0 is the full resolution, each further
+ * level halves the resolution, up to the level where the image fits into a
+ * single tile.
+ *
+ * Pixel coordinates used by this class always refer to level 0, with the
+ * origin at the top left corner of the image.
+ *
+ * All member functions are thread-safe.
+ */
+class TemplateImageTiles
+{
+public:
+	/**
+	 * A function which reads the source rectangle (in full resolution pixels)
+	 * into an image of the given size. It returns a null image on error.
+	 */
+	using ReadFunction = std::function<QImage (const QRect& /*source*/, const QSize& /*size*/)>;
+
+	/// The width and height of tiles, in pixels of the tile's level.
+	static constexpr int tile_size = 256;
+
+	/// The default limit of the cache size, in bytes.
+	static constexpr std::size_t default_cache_limit = std::size_t(128) << 20;
+
+	TemplateImageTiles(const QSize& size, ReadFunction read, std::size_t cache_limit = default_cache_limit);
+
+	TemplateImageTiles(const TemplateImageTiles&) = delete;
+	TemplateImageTiles& operator=(const TemplateImageTiles&) = delete;
+
+	~TemplateImageTiles();
+
+	/**
+	 * Returns the full resolution size of the image.
+	 */
+	QSize size() const { return image_size; }
+
+	/**
+	 * Returns the number of levels in the pyramid.
+	 */
+	int levels() const { return num_levels; }
+
+	/**
+	 * Returns the level matching the given resolution.
+	 *
+	 * The resolution is the number of output pixels per full resolution pixel.
+	 * The returned level has at least this resolution, unless limited by the
+	 * number of levels.
+	 */
+	int levelForResolution(qreal resolution) const;
+
+	/**
+	 * Draws the tiles of the given level which intersect the rect.
+	 *
+	 * The painter must be set up for level 0 pixel coordinates.
+	 * Tiles are decoded as needed. Decoding doesn't block other threads
+	 * which draw cached tiles.
+	 */
+	void draw(QPainter* painter, const QRectF& rect, int level);
+
+	/**
+	 * Returns the full image at the lowest level which is not larger than
+	 * max_size, bypassing the cache.
+	 */
+	QImage readReduced(const QSize& max_size);
+
+	/**
+	 * Returns the current size of the cache, in bytes.
+	 */
+	std::size_t cacheSize() const;
+
+	/**
+	 * Removes all tiles from the cache.
+	 */
+	void clearCache();
+
+
+private:
+	struct TileKey
+	{
+		int level;
+		int x;
+		int y;
+
+		bool operator==(const TileKey& other) const
+		{
+			return level == other.level && x == other.x && y == other.y;
+		}
+	};
+
+	struct TileKeyHash
+	{
+		std::size_t operator()(const TileKey& key) const
+		{
+			return std::hash<quint64>()((quint64(quint32(key.level)) << 58)
+			                            ^ (quint64(quint32(key.y)) << 29)
+			                            ^ quint64(quint32(key.x)));
+		}
+	};
+
+	using TileList = std::list<std::pair<TileKey, QImage>>;
+
+	/**
+	 * Returns the level 0 pixel rect covered by the tile.
+	 */
+	QRect tileRect(const TileKey& key) const;
+
+	/**
+	 * Looks up the tile in the cache, and marks it as most recently used.
+	 *
+	 * Returns false if the tile is not in the cache.
+	 * Must be called with the mutex locked.
+	 */
+	bool findTile(const TileKey& key, QImage& image);
+
+	/**
+	 * Adds the tile to the cache, as most recently used.
+	 *
+	 * Must be called with the mutex locked.
+	 */
+	void insertTile(const TileKey& key, const QImage& image);
+
+	/**
+	 * Decodes the tile.
+	 *
+	 * Must be called with the read mutex locked.
+	 */
+	QImage decodeTile(const TileKey& key) const;
+
+	/**
+	 * Removes least recently used tiles until the cache size is within the
+	 * limit, keeping at least the given number of most recently used tiles.
+	 *
+	 * Must be called with the mutex locked.
+	 */
+	void trimCache(std::size_t keep);
+
+	QSize image_size;
+	ReadFunction read;
+	std::size_t cache_limit;
+	std::size_t cache_size = 0;
+	int num_levels = 1;
+
+	TileList tiles;  ///< Cached tiles, most recently used first.
+	std::unordered_map<TileKey, TileList::iterator, TileKeyHash> tile_index;
+
+	mutable QMutex mutex;       ///< Protects the cache.
+	mutable QMutex read_mutex;  ///< Serializes calls of the read function.
+};
+
+
+}  // namespace OpenOrienteering
+
+#endif // OPENORIENTEERING_TEMPLATE_IMAGE_TILES_H
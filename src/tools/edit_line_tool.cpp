@@ -38,6 +38,7 @@
 #include <QPointF>
 #include <QPointer>
 #include <QString>
+#include <QTransform>
 
 #include "core/map.h"
 #include "core/map_view.h"
@@ -297,6 +298,11 @@ void EditLineTool::dragMove()
 			highlight_renderables->insertRenderablesOfObject(highlight_object);
 		}
 		
+		if (object_mover->movesObjectsOnly() && isPreviewTransformRecommended())
+		{
+			auto const offset = object_mover->offset();
+			setPreviewTransform(QTransform::fromTranslate(offset.x(), offset.y()));
+		}
 		updatePreviewObjectsAsynchronously();
 	}
 	else if (box_selection)
@@ -428,7 +434,7 @@ int EditLineTool::updateDirtyRectImpl(QRectF& rect)
 	bool show_object_points = map()->selectedObjects().size() <= max_objects_for_handle_display;
 	
 	selection_extent = QRectF();
-	map()->includeSelectionRect(selection_extent);
+	includeSelectionRect(selection_extent);
 
 	const auto frame_extension = 0.001 * cur_map_widget->getMapView()
 	                             ->pixelToLength(clickTolerance()); // in mm
@@ -39,6 +39,7 @@
 #include <QPoint>
 #include <QPointF>
 #include <QToolButton>
+#include <QTransform>
 
 #include "settings.h"
 #include "core/map.h"
@@ -366,6 +367,11 @@ void EditPointTool::dragMove()
 		
 		object_mover->move(constrained_pos_map, 
 		                   moveOppositeHandle() ? ObjectMover::HandleOpMode::Click : ObjectMover::HandleOpMode::Never);
+		if (object_mover->movesObjectsOnly() && isPreviewTransformRecommended())
+		{
+			auto const offset = object_mover->offset();
+			setPreviewTransform(QTransform::fromTranslate(offset.x(), offset.y()));
+		}
 		updatePreviewObjectsAsynchronously();
 	}
 	else if (box_selection)
@@ -570,7 +576,7 @@ int EditPointTool::updateDirtyRectImpl(QRectF& rect)
 	bool show_object_points = map()->selectedObjects().size() <= max_objects_for_handle_display;
 	
 	selection_extent = QRectF();
-	map()->includeSelectionRect(selection_extent);
+	includeSelectionRect(selection_extent);
 
 	const auto frame_extension = 0.001 * cur_map_widget->getMapView()
 	                             ->pixelToLength(clickTolerance()); // in mm
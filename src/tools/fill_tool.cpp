@@ -41,7 +41,11 @@
 #include <QRgb>
 #include <QSize>
 #include <QString>
+#include <QVariant>
 
+#include <clipper.hpp>
+
+#include "settings.h"
 #include "core/map.h"
 #include "core/map_color.h"
 #include "core/map_coord.h"
@@ -87,6 +91,59 @@ struct PathSection
 
 constexpr auto background = QRgb(0xffffffffu);
 
+
+/**
+ * The half width of the band around paths which bounds the vector fill,
+ * in native map coordinates.
+ * 
+ * Gaps between objects which are smaller than the band are closed.
+ * The fill is grown by the same width in the end, so that it reaches
+ * the paths again.
+ */
+constexpr auto vector_fill_tolerance = 50.0;  // 0.05 mm
+
+/**
+ * Returns the polygonal approximation of a path part, in native map coordinates.
+ */
+ClipperLib::Path toPolygon(const PathPart& part)
+{
+	const auto& path_coords = part.path_coords;
+	auto size = path_coords.size();
+	if (part.isClosed() && size > 1)
+		--size;
+	
+	ClipperLib::Path polygon;
+	polygon.reserve(size);
+	for (std::size_t i = 0; i < size; ++i)
+	{
+		auto const coord = MapCoord { path_coords[i].pos };
+		polygon.emplace_back(coord.nativeX(), coord.nativeY());
+	}
+	return polygon;
+}
+
+/**
+ * Returns the innermost outer polygon which contains the point, or nullptr.
+ * 
+ * The point must not be inside one of the holes of the returned polygon.
+ */
+const ClipperLib::PolyNode* findFace(const ClipperLib::PolyNode& parent, const ClipperLib::IntPoint& point)
+{
+	for (const auto* outer : parent.Childs)
+	{
+		if (ClipperLib::PointInPolygon(point, outer->Contour) != 1)
+			continue;
+		
+		for (const auto* hole : outer->Childs)
+		{
+			if (ClipperLib::PointInPolygon(point, hole->Contour) != 0)
+				return findFace(*hole, point);
+		}
+		return outer;
+	}
+	return nullptr;
+}
+
 }  // namespace
 
 
@@ -145,6 +202,130 @@ void FillTool::clickPress()
 }
 
 int FillTool::fill(const QRectF& extent)
+{
+	if (Settings::getInstance().getSettingCached(Settings::FillTool_VectorMode).toBool())
+		return fillVector(extent);
+	return fillRaster(extent);
+}
+
+int FillTool::fillVector(const QRectF& extent)
+{
+	// The margin separates the faces at the border from the objects there.
+	auto const bounds = extent.adjusted(-1, -1, 1, 1);
+	auto const click_pos_map = cur_map_widget->viewportToMapF(click_pos);
+	if (!bounds.contains(click_pos_map))
+		return 0;
+	
+	std::vector<Object*> objects;
+	map()->getCurrentPart()->findObjectsAtBox(MapCoordF(bounds.topLeft()), MapCoordF(bounds.bottomRight()), false, true, objects);
+	
+	// Collect the obstacles: bands around all paths, and the areas of area objects.
+	ClipperLib::ClipperOffset bands;
+	ClipperLib::Paths areas;
+	for (auto* object : objects)
+	{
+		if (object->getType() != Object::Path)
+			continue;
+		
+		auto const* path = object->asPath();
+		path->update();
+		auto const is_area = path->getSymbol()->getContainedTypes().testFlag(Symbol::Area);
+		for (const auto& part : path->parts())
+		{
+			auto polygon = toPolygon(part);
+			if (polygon.size() < 2)
+				continue;
+			
+			bands.AddPath(polygon, ClipperLib::jtMiter, part.isClosed() ? ClipperLib::etClosedLine : ClipperLib::etOpenSquare);
+			if (is_area && polygon.size() >= 3)
+			{
+				if ((&part == &path->parts().front()) != ClipperLib::Orientation(polygon))
+					std::reverse(polygon.begin(), polygon.end());
+				areas.push_back(std::move(polygon));
+			}
+		}
+	}
+	ClipperLib::Paths obstacles;
+	bands.Execute(obstacles, vector_fill_tolerance);
+	
+	// Subtract the obstacles from the bounds, giving the free faces.
+	auto const top_left = MapCoord { bounds.topLeft() };
+	auto const bottom_right = MapCoord { bounds.bottomRight() };
+	auto const bounds_polygon = ClipperLib::Path {
+	    { top_left.nativeX(), top_left.nativeY() },
+	    { bottom_right.nativeX(), top_left.nativeY() },
+	    { bottom_right.nativeX(), bottom_right.nativeY() },
+	    { top_left.nativeX(), bottom_right.nativeY() },
+	};
+	ClipperLib::Clipper clipper;
+	clipper.AddPath(bounds_polygon, ClipperLib::ptSubject, true);
+	clipper.AddPaths(obstacles, ClipperLib::ptClip, true);
+	clipper.AddPaths(areas, ClipperLib::ptClip, true);
+	ClipperLib::PolyTree faces;
+	if (!clipper.Execute(ClipperLib::ctDifference, faces, ClipperLib::pftNonZero, ClipperLib::pftNonZero))
+		return 0;
+	
+	auto const click_coord = MapCoord { click_pos_map };
+	auto const* face = findFace(faces, { click_coord.nativeX(), click_coord.nativeY() });
+	if (!face)
+	{
+		QMessageBox::warning(
+			window(),
+			tr("Error"),
+			tr("The clicked position is not free, cannot use the fill tool there.")
+		);
+		return -1;
+	}
+	
+	// A face which reaches the bounds is not bounded by objects.
+	auto const touches_bounds = std::any_of(begin(face->Contour), end(face->Contour), [&](const auto& point) {
+		return point.X <= top_left.nativeX() || point.X >= bottom_right.nativeX()
+		       || point.Y <= top_left.nativeY() || point.Y >= bottom_right.nativeY();
+	});
+	if (touches_bounds)
+		return 0;
+	
+	// Grow the face back to the paths.
+	ClipperLib::ClipperOffset growth;
+	growth.AddPath(face->Contour, ClipperLib::jtMiter, ClipperLib::etClosedPolygon);
+	for (const auto* hole : face->Childs)
+		growth.AddPath(hole->Contour, ClipperLib::jtMiter, ClipperLib::etClosedPolygon);
+	ClipperLib::PolyTree result;
+	growth.Execute(result, vector_fill_tolerance);
+	
+	auto path = new PathObject(drawing_symbol);
+	for (const auto* outer : result.Childs)
+	{
+		auto polygons = ClipperLib::Paths { outer->Contour };
+		for (const auto* hole : outer->Childs)
+			polygons.push_back(hole->Contour);
+		ClipperLib::CleanPolygons(polygons);
+		for (const auto& polygon : polygons)
+		{
+			if (polygon.size() < 3)
+				continue;
+			for (std::size_t i = 0; i < polygon.size(); ++i)
+				path->addCoordinate(MapCoord::fromNative64(polygon[i].X, polygon[i].Y), i == 0);
+		}
+	}
+	
+	if (path->getCoordinateCount() < 3)
+	{
+		delete path;
+		QMessageBox::warning(
+			window(),
+			tr("Error"),
+			tr("Failed to create the fill object.")
+		);
+		return -1;
+	}
+	
+	path->closeAllParts();
+	addFillObject(path);
+	return 1;
+}
+
+int FillTool::fillRaster(const QRectF& extent)
 {
 	constexpr auto extent_area_warning_threshold = qreal(600 * 600); // 60 cm x 60 cm
 	
@@ -524,6 +705,12 @@ bool FillTool::fillBoundary(const QImage& image, const std::vector<QPoint>& boun
 	//   const auto simplify_epsilon = 1e-2;
 	//   path->simplify(nullptr, simplify_epsilon);
 	
+	addFillObject(path);
+	return true;
+}
+
+void FillTool::addFillObject(PathObject* path)
+{
 	int index = map()->addObject(path);
 	map()->clearObjectSelection(false);
 	map()->addObjectToSelection(path, true);
@@ -534,8 +721,6 @@ bool FillTool::fillBoundary(const QImage& image, const std::vector<QPoint>& boun
 	
 	map()->setObjectsDirty();
 	updateDirtyRect();
-	
-	return true;
 }
 
 
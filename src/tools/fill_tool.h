@@ -41,6 +41,7 @@ namespace OpenOrienteering {
 
 class Map;
 class MapEditorController;
+class PathObject;
 class RenderConfig;
 class Symbol;
 
@@ -66,11 +67,36 @@ protected:
 	
 	/**
 	 * Tries to apply the fill tool at the current click position,
-	 * rasterizing the given extent of the map.
+	 * considering the objects in the given extent of the map.
+	 * 
+	 * Depending on the settings, this uses fillVector() or fillRaster().
 	 * Returns -1 for abort, 0 for unsuccessful, 1 for successful.
 	 */
 	int fill(const QRectF& extent);
 	
+	/**
+	 * Tries to apply the fill tool at the current click position,
+	 * using the vector geometry of the objects in the given extent.
+	 * 
+	 * The objects are found by a spatial query. Their paths, with a small
+	 * tolerance for gaps, and the areas of area objects are subtracted from
+	 * the extent with Clipper. The fill object is the resulting face which
+	 * contains the click position, including holes for enclosed objects.
+	 * Unlike in fillRaster(), the fill object extends to the center lines of
+	 * line objects, not to their rendered edges. The result does not depend
+	 * on the zoom level.
+	 * 
+	 * Returns -1 for abort, 0 for unsuccessful, 1 for successful.
+	 */
+	int fillVector(const QRectF& extent);
+	
+	/**
+	 * Tries to apply the fill tool at the current click position,
+	 * rasterizing the given extent of the map.
+	 * Returns -1 for abort, 0 for unsuccessful, 1 for successful.
+	 */
+	int fillRaster(const QRectF& extent);
+	
 	/**
 	 * Rasterizes an area of the current map part with the given extent into an image.
 	 * 
@@ -105,6 +131,11 @@ protected:
 	 */
 	bool fillBoundary(const QImage& image, const std::vector<QPoint>& boundary, const QTransform& image_to_map);
 	
+	/**
+	 * Adds the given fill object to the map, selects it, and adds an undo step.
+	 */
+	void addFillObject(PathObject* path);
+	
 	const Symbol* drawing_symbol;
 };
 
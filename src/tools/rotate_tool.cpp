@@ -35,6 +35,7 @@
 #include <QPointF>
 #include <QRectF>
 #include <QString>
+#include <QTransform>
 
 #include "core/map.h"
 #include "core/map_view.h"
@@ -99,7 +100,12 @@ void RotateTool::dragStart()
 void RotateTool::dragMove()
 {
 	current_rotation = (constrained_pos_map - rotation_center).angle() - original_rotation;
-	cur_map_widget->update();
+	QTransform transform;
+	transform.translate(rotation_center.x(), rotation_center.y());
+	transform.rotate(qRadiansToDegrees(current_rotation));
+	transform.translate(-rotation_center.x(), -rotation_center.y());
+	setPreviewTransform(transform);
+	updateDirtyRect();
 	updateStatusText();
 }
 
@@ -151,15 +157,7 @@ void RotateTool::drawImpl(QPainter* painter, MapWidget* widget)
 {
 	const auto center = widget->mapToViewport(rotation_center);
 	
-	painter->save();
-	if (isDragging())
-	{
-		painter->translate(center);
-		painter->rotate(qRadiansToDegrees(current_rotation));
-		painter->translate(-center);
-	}
-	map()->drawSelection(painter, true, widget);
-	painter->restore();
+	drawSelectionOrPreviewObjects(painter, widget);
 	
 	Util::Marker::drawCenterMarker(painter, center);
 }
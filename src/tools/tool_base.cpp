@@ -22,6 +22,7 @@
 #include "tool_base.h"
 
 #include <algorithm>
+#include <cstddef>
 #include <cstdlib>  // IWYU pragma: keep
 #include <iterator>
 #include <type_traits>
@@ -35,6 +36,7 @@
 #include <QRectF>
 
 #include "core/map.h"
+#include "core/map_part.h"
 #include "core/objects/object.h"
 #include "core/renderables/renderable.h"
 #include "gui/map/map_editor.h"
@@ -42,6 +44,8 @@
 #include "gui/widgets/key_button_bar.h"  // IWYU pragma: keep
 #include "tools/tool_helpers.h"
 #include "undo/object_undo.h"
+#include "undo/undo.h"
+#include "util/util.h"
 
 
 #ifdef __clang_analyzer__
@@ -51,6 +55,15 @@
 
 namespace OpenOrienteering {
 
+namespace {
+
+/// The number of edited objects from which on a preview transform is recommended.
+constexpr std::size_t preview_transform_threshold = 100;
+
+}  // namespace
+
+
+
 // ### MapEditorToolBase::EditedItem ###
 
 MapEditorToolBase::EditedItem::EditedItem(Object* active_object)
@@ -330,7 +343,7 @@ void MapEditorToolBase::updateDirtyRect()
 	int pixel_border = 0;
 	QRectF rect;
 	
-	map()->includeSelectionRect(rect);
+	includeSelectionRect(rect);
 	if (angle_helper->isActive())
 	{
 		angle_helper->includeDirtyRect(rect);
@@ -463,6 +476,12 @@ void MapEditorToolBase::updatePreviewObjects()
 		qWarning("MapEditorToolBase::updatePreviewObjects() called but editing == false");
 		return;
 	}
+	if (preview_transform_active)
+	{
+		// The selection renderables are drawn with the preview transform.
+		updateDirtyRect();
+		return;
+	}
 	for (auto object : editedObjects())
 	{
 		object->forceUpdate(); /// @todo get rid of force if possible;
@@ -489,7 +508,32 @@ void MapEditorToolBase::updatePreviewObjectsAsynchronously()
 
 void MapEditorToolBase::drawSelectionOrPreviewObjects(QPainter* painter, MapWidget* widget, bool draw_opaque)
 {
-	map()->drawSelection(painter, true, widget, renderables->empty() ? nullptr : renderables.get(), draw_opaque);
+	if (preview_transform_active)
+		map()->drawSelection(painter, true, widget, nullptr, draw_opaque, preview_transform);
+	else
+		map()->drawSelection(painter, true, widget, renderables->empty() ? nullptr : renderables.get(), draw_opaque);
+}
+
+void MapEditorToolBase::setPreviewTransform(const QTransform& transform)
+{
+	Q_ASSERT(editingInProgress());
+	Q_ASSERT(preview_transform_active || renderables->empty());
+	preview_transform = transform;
+	preview_transform_active = true;
+}
+
+bool MapEditorToolBase::isPreviewTransformRecommended() const
+{
+	return edited_items.size() >= preview_transform_threshold;
+}
+
+void MapEditorToolBase::includeSelectionRect(QRectF& rect) const
+{
+	QRectF selection_rect;
+	map()->includeSelectionRect(selection_rect);
+	if (preview_transform_active && selection_rect.isValid())
+		selection_rect = preview_transform.mapRect(selection_rect);
+	rectIncludeSafe(rect, selection_rect);
 }
 
 
@@ -557,6 +601,8 @@ void MapEditorToolBase::abortEditing()
 	edited_items.clear();
 	renderables->clear();
 	old_renderables->clear(true);
+	preview_transform_active = false;
+	preview_transform.reset();
 	MapEditorTool::setEditingInProgress(false);
 }
 
@@ -567,19 +613,44 @@ void MapEditorToolBase::finishEditing()
 	
 	if (!edited_items.empty())
 	{
-		auto undo_step = new ReplaceObjectsUndoStep(map());
+		// Changes which are limited to coordinates are recorded as deltas,
+		// other changes by keeping the original objects.
+		auto coordinates_step = new ObjectCoordinatesUndoStep(map());
+		auto replace_step = new ReplaceObjectsUndoStep(map());
+		auto const* part = map()->getCurrentPart();
 		for (auto& edited_item : edited_items)
 		{
 			auto object = edited_item.active_object;
 			object->setMap(map());
 			object->update();
-			undo_step->addObject(object, edited_item.duplicate.release());
+			auto const index = part->findObjectIndex(object);
+			if (!coordinates_step->addObject(index, *edited_item.duplicate))
+				replace_step->addObject(index, edited_item.duplicate.release());
 		}
 		edited_items.clear();
-		map()->push(undo_step);
+		
+		if (coordinates_step->isEmpty())
+		{
+			delete coordinates_step;
+			map()->push(replace_step);
+		}
+		else if (replace_step->isEmpty())
+		{
+			delete replace_step;
+			map()->push(coordinates_step);
+		}
+		else
+		{
+			auto combined_step = new CombinedUndoStep(map());
+			combined_step->push(replace_step);
+			combined_step->push(coordinates_step);
+			map()->push(combined_step);
+		}
 	}
 	renderables->clear();
 	old_renderables->clear(true);
+	preview_transform_active = false;
+	preview_transform.reset();
 	
 	MapEditorTool::finishEditing();
 	map()->setObjectsDirty();
@@ -33,6 +33,7 @@
 #include <QPoint>
 #include <QPointF>
 #include <QString>
+#include <QTransform>
 
 #include <QPointer>
 
@@ -237,6 +238,7 @@ protected:
 	void resetEditedObjects();
 	
 	/// Call this to display changes to the preview objects between startEditing() and finish/abortEditing().
+	/// While a preview transform is set, the renderables are not regenerated.
 	virtual void updatePreviewObjects();
 	
 	/// Call this to display changes to the preview objects between startEditing() and finish/abortEditing().
@@ -247,6 +249,30 @@ protected:
 	/// else draws the renderables of the selected map objects.
 	void drawSelectionOrPreviewObjects(QPainter* painter, MapWidget* widget, bool draw_opaque = false);
 	
+	/**
+	 * Sets a transformation for previewing the edited objects.
+	 * 
+	 * Regenerating the renderables of many objects on every preview update is
+	 * expensive. When the edited objects are only moved or rotated as a whole,
+	 * the tool may set the corresponding transformation (in map coordinates)
+	 * instead. While a preview transform is set, updatePreviewObjects() does
+	 * not regenerate the renderables, and the renderables of the selection
+	 * are drawn with this transformation. The renderables are regenerated
+	 * once in finishEditing().
+	 * 
+	 * The preview transform must be set before any regular preview update,
+	 * and it is cleared by finishEditing() and abortEditing().
+	 */
+	void setPreviewTransform(const QTransform& transform);
+	
+	/// Returns true if moving or rotating the edited objects as a whole
+	/// should be previewed with setPreviewTransform().
+	bool isPreviewTransformRecommended() const;
+	
+	/// Includes the extent of the selected objects in the rect,
+	/// with the preview transform applied if it is set.
+	void includeSelectionRect(QRectF& rect) const;
+	
 	/// Activates or deactivates the angle helper, recalculates (un-)constrained cursor position,
 	/// and calls mouseMove() or dragMove() to update the tool.
 	void activateAngleHelperWhileEditing(bool enable = true);
@@ -338,6 +364,8 @@ private:
 	bool preview_update_triggered = false;
 	bool dragging                 = false;
 	bool dragging_canceled        = false;
+	bool preview_transform_active = false;
+	QTransform preview_transform;
 	std::unique_ptr<MapRenderables> renderables;
 	std::unique_ptr<MapRenderables> old_renderables;
 	std::vector<EditedItem> edited_items;
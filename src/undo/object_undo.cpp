@@ -22,6 +22,11 @@
 #include "object_undo.h"
 
 #include <algorithm>
+#include <iterator>
+
+#include <QLatin1Char>
+#include <QString>
+#include <QStringList>
 
 #include "core/map.h"
 #include "core/objects/object.h"
@@ -36,6 +41,7 @@ namespace literal
 	const QLatin1String source("source");
 	const QLatin1String part("part");
 	const QLatin1String reverse("reverse");
+	const QLatin1String ranges("ranges");
 }
 
 
@@ -737,4 +743,194 @@ void ObjectTagsUndoStep::loadObject(XmlElementReader& xml, int index)
 }
 
 
+
+// ### ObjectCoordinatesUndoStep ###
+
+namespace {
+
+/**
+ * Unchanged coordinates between changed ones are included in a single range
+ * unless there are at least this many of them.
+ */
+constexpr MapCoordVector::size_type min_ranges_gap = 8;
+
+}  // namespace
+
+
+ObjectCoordinatesUndoStep::ObjectCoordinatesUndoStep(Map* map)
+: ObjectModifyingUndoStep(ObjectCoordinatesUndoStepType, map)
+{
+	; // nothing else
+}
+
+ObjectCoordinatesUndoStep::~ObjectCoordinatesUndoStep()
+{
+	; // nothing
+}
+
+void ObjectCoordinatesUndoStep::addObject(int)
+{
+	qWarning("This implementation must not be called");
+}
+
+bool ObjectCoordinatesUndoStep::addObject(int index, const Object& original)
+{
+	MapPart* const map_part = map->getPart(getPartIndex());
+	const Object* object = map_part->getObject(index);
+	if (!isCoordinatesChange(original, *object))
+		return false;
+	
+	ObjectModifyingUndoStep::addObject(index);
+	object_ranges_map[index] = makeRanges(original.getRawCoordinateVector(), object->getRawCoordinateVector());
+	return true;
+}
+
+// static
+bool ObjectCoordinatesUndoStep::isCoordinatesChange(const Object& original, const Object& modified)
+{
+	if (original.getType() != Object::Path
+	    || modified.getType() != Object::Path
+	    || original.getSymbol() != modified.getSymbol()
+	    || original.getRotation() != modified.getRotation()
+	    || original.tags() != modified.tags())
+		return false;
+	
+	auto const* original_path = original.asPath();
+	auto const* modified_path = modified.asPath();
+	return original_path->getPatternRotation() == modified_path->getPatternRotation()
+	       && original_path->getPatternOrigin() == modified_path->getPatternOrigin();
+}
+
+// static
+ObjectCoordinatesUndoStep::CoordinatesRanges ObjectCoordinatesUndoStep::makeRanges(const MapCoordVector& original, const MapCoordVector& current)
+{
+	CoordinatesRanges ranges;
+	
+	auto const original_size = original.size();
+	auto const current_size = current.size();
+	auto const min_size = std::min(original_size, current_size);
+	auto prefix = MapCoordVector::size_type(0);
+	while (prefix < min_size && original[prefix] == current[prefix])
+		++prefix;
+	if (prefix == original_size && prefix == current_size)
+		return ranges;
+	
+	auto suffix = MapCoordVector::size_type(0);
+	while (suffix < min_size - prefix && original[original_size - 1 - suffix] == current[current_size - 1 - suffix])
+		++suffix;
+	
+	auto const original_begin = begin(original);
+	if (original_size != current_size)
+	{
+		// Coordinates were added or removed: a single range.
+		ranges.push_back({ prefix, current_size - prefix - suffix,
+		                   MapCoordVector(original_begin + MapCoordVector::difference_type(prefix),
+		                                  end(original) - MapCoordVector::difference_type(suffix)) });
+		return ranges;
+	}
+	
+	// Coordinates were modified in place: one range per run of changes.
+	auto const last = original_size - suffix;
+	for (auto first = prefix; first < last; )
+	{
+		auto range_end = first + 1;
+		for (auto i = range_end; i < last && i - range_end < min_ranges_gap; ++i)
+		{
+			if (!(original[i] == current[i]))
+				range_end = i + 1;
+		}
+		ranges.push_back({ first, range_end - first,
+		                   MapCoordVector(original_begin + MapCoordVector::difference_type(first),
+		                                  original_begin + MapCoordVector::difference_type(range_end)) });
+		
+		first = range_end;
+		while (first < last && original[first] == current[first])
+			++first;
+	}
+	return ranges;
+}
+
+UndoStep* ObjectCoordinatesUndoStep::undo()
+{
+	int const part_index = getPartIndex();
+	
+	ObjectCoordinatesUndoStep* redo_step = new ObjectCoordinatesUndoStep(map);
+	MapPart* const map_part = map->getPart(part_index);
+	
+	redo_step->setPartIndex(part_index);
+	for (const auto& object_ranges : object_ranges_map)
+	{
+		auto* object = map_part->getObject(object_ranges.first)->asPath();
+		auto const& coords = object->getRawCoordinateVector();
+		
+		// The redo ranges refer to the coordinates after this step.
+		auto& redo_ranges = redo_step->object_ranges_map[object_ranges.first];
+		redo_ranges.reserve(object_ranges.second.size());
+		auto shift = MapCoordVector::difference_type(0);
+		for (const auto& range : object_ranges.second)
+		{
+			Q_ASSERT(range.index + range.count <= coords.size());
+			auto const first = begin(coords) + MapCoordVector::difference_type(range.index);
+			redo_ranges.push_back({ MapCoordVector::size_type(MapCoordVector::difference_type(range.index) + shift),
+			                        range.coords.size(),
+			                        MapCoordVector(first, first + MapCoordVector::difference_type(range.count)) });
+			shift += MapCoordVector::difference_type(range.coords.size()) - MapCoordVector::difference_type(range.count);
+		}
+		
+		// Replacing in reverse order keeps the indices of the other ranges valid.
+		for (auto range = object_ranges.second.rbegin(); range != object_ranges.second.rend(); ++range)
+			object->replaceCoordinates(range->index, range->count, begin(range->coords), end(range->coords));
+		object->update();
+		
+		redo_step->ObjectModifyingUndoStep::addObject(object_ranges.first);
+	}
+	
+	return redo_step;
+}
+
+// override
+void ObjectCoordinatesUndoStep::saveObject(XmlElementWriter& xml, int index) const
+{
+	// Per range: index, number of replaced coordinates, number of replacement coordinates
+	QString ranges_value;
+	MapCoordVector coords;
+	for (const auto& range : object_ranges_map.at(index))
+	{
+		if (!ranges_value.isEmpty())
+			ranges_value.append(QLatin1Char(' '));
+		ranges_value.append(QString::number(range.index) + QLatin1Char(':')
+		                    + QString::number(range.count) + QLatin1Char(':')
+		                    + QString::number(range.coords.size()));
+		coords.insert(end(coords), begin(range.coords), end(range.coords));
+	}
+	xml.writeAttribute(literal::ranges, ranges_value);
+	xml.writeCompact(coords);
+}
+
+// override
+void ObjectCoordinatesUndoStep::loadObject(XmlElementReader& xml, int index)
+{
+	auto const ranges_value = xml.attribute<QString>(literal::ranges);
+	MapCoordVector coords;
+	xml.read(coords);
+	
+	auto& ranges = object_ranges_map[index];
+	auto next = begin(coords);
+	auto const items = ranges_value.isEmpty() ? QStringList() : ranges_value.split(QLatin1Char(' '));
+	for (const auto& item : items)
+	{
+		auto const values = item.split(QLatin1Char(':'));
+		auto ok = values.size() == 3;
+		auto const range_index = ok ? values[0].toUInt(&ok) : 0u;
+		auto const count = ok ? values[1].toUInt(&ok) : 0u;
+		auto const size = ok ? values[2].toUInt(&ok) : 0u;
+		if (!ok || size > std::size_t(std::distance(next, end(coords))))
+			throw FileFormatException(::OpenOrienteering::ImportExport::tr("Could not parse the coordinates."));
+		
+		ranges.push_back({ range_index, count, MapCoordVector(next, next + size) });
+		next += size;
+	}
+}
+
+
 }  // namespace OpenOrienteering
@@ -429,6 +429,75 @@ protected:
 };
 
 
+
+/**
+ * Undo step which restores ranges of coordinates of path objects.
+ * 
+ * Unlike ReplaceObjectsUndoStep, this step doesn't keep copies of the
+ * objects, but only the original values of the coordinates which were
+ * changed. Editing a few vertices of a large path needs little memory.
+ */
+class ObjectCoordinatesUndoStep : public ObjectModifyingUndoStep
+{
+public:
+	ObjectCoordinatesUndoStep(Map* map);
+	
+	~ObjectCoordinatesUndoStep() override;
+	
+	/**
+	 * Must not be called.
+	 * 
+	 * Use addObject(int, const Object&) instead.
+	 */
+	void addObject(int index) override;
+	
+	/**
+	 * Adds the object with the given index.
+	 * 
+	 * The step records the coordinates of the original object which differ
+	 * from the current object in the map. Returns false, and doesn't add the
+	 * object, if the objects differ in more than coordinates.
+	 */
+	bool addObject(int index, const Object& original);
+	
+	/**
+	 * Returns true if the objects are path objects which differ only in their
+	 * coordinates.
+	 */
+	static bool isCoordinatesChange(const Object& original, const Object& modified);
+	
+	UndoStep* undo() override;
+	
+protected:
+	void saveObject(XmlElementWriter& xml, int index) const override;
+	
+	void loadObject(XmlElementReader& xml, int index) override;
+	
+	/**
+	 * A range of coordinates to be replaced.
+	 */
+	struct CoordinatesRange
+	{
+		MapCoordVector::size_type index;  ///< The index of the first coordinate to be replaced
+		MapCoordVector::size_type count;  ///< The number of coordinates to be replaced
+		MapCoordVector coords;            ///< The replacement coordinates
+	};
+	
+	typedef std::vector<CoordinatesRange> CoordinatesRanges;
+	
+	/**
+	 * Returns the ranges which turn the current coordinates into the original ones.
+	 * 
+	 * The ranges are ordered by index and do not overlap.
+	 */
+	static CoordinatesRanges makeRanges(const MapCoordVector& original, const MapCoordVector& current);
+	
+	typedef std::map<int, CoordinatesRanges> ObjectRangesMap;
+	
+	ObjectRangesMap object_ranges_map;
+};
+
+
 // ### ObjectModifyingUndoStep inline code ###
 
 inline
@@ -77,6 +77,9 @@ UndoStep* UndoStep::getUndoStepForType(Type type, Map* map)
 	case MapPartUndoStepType:
 		return new MapPartUndoStep(map);
 		
+	case ObjectCoordinatesUndoStepType:
+		return new ObjectCoordinatesUndoStep(map);
+		
 	default:
 		qWarning("Undefined undo step type");
 		Q_FALLTHROUGH();
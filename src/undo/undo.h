@@ -67,6 +67,7 @@ public:
 		MapPartUndoStepType        =   8,
 		SwitchPartUndoStepTypeV0   =   9,
 		SwitchPartUndoStepType     =  10,
+		ObjectCoordinatesUndoStepType = 11,
 		InvalidUndoStepType        = 999
 	};
 	
@@ -259,6 +260,11 @@ public:
 	 */
 	UndoStep* getSubStep(int i);
 	
+	/** 
+	 * Returns the i-th sub step.
+	 */
+	const UndoStep* getSubStep(int i) const;
+	
 	
 protected:
 	/**
@@ -351,6 +357,12 @@ UndoStep* CombinedUndoStep::getSubStep(int i)
 	return steps[i];
 }
 
+inline
+const UndoStep* CombinedUndoStep::getSubStep(int i) const
+{
+	return steps[i];
+}
+
 
 }  // namespace OpenOrienteering
 
@@ -44,6 +44,29 @@ namespace OpenOrienteering {
 Q_STATIC_ASSERT(UndoManager::max_undo_steps < std::numeric_limits<int>::max());
 
 
+namespace {
+
+bool hasStepType(const UndoStep& step, UndoStep::Type type)
+{
+	if (step.getType() == type)
+		return true;
+	
+	if (step.getType() == UndoStep::CombinedUndoStepType)
+	{
+		auto const& combined_step = static_cast<const CombinedUndoStep&>(step);
+		for (int i = 0; i < combined_step.getNumSubSteps(); ++i)
+		{
+			if (hasStepType(*combined_step.getSubStep(i), type))
+				return true;
+		}
+	}
+	return false;
+}
+
+}  // namespace
+
+
+
 // ### UndoManager::State ###
 
 UndoManager::State::State(UndoManager const *manager)
@@ -383,6 +406,14 @@ void UndoManager::emitChangedSignals(const UndoManager::State& old_state)
 
 
 
+bool UndoManager::containsStepType(UndoStep::Type type) const
+{
+	return std::any_of(begin(undo_steps), end(undo_steps), [type](auto& step) {
+		return hasStepType(*step, type);
+	});
+}
+
+
 void UndoManager::saveUndo(QXmlStreamWriter& xml) const
 {
 	auto count = undoStepCount();
@@ -31,6 +31,7 @@
 #include <QString>
 
 #include "core/symbols/symbol.h"
+#include "undo/undo.h"
 
 class QWidget;
 class QXmlStreamReader;
@@ -39,7 +40,6 @@ class QXmlStreamWriter;
 namespace OpenOrienteering {
 
 class Map;
-class UndoStep;
 
 
 /**
@@ -170,6 +170,13 @@ public:
 	UndoStep* nextRedoStep() const;
 	
 	
+	/**
+	 * Returns true if any undo or redo step, or any of their sub steps,
+	 * has the given type.
+	 */
+	bool containsStepType(UndoStep::Type type) const;
+	
+	
 	/**
 	 * Saves the undo steps to the file in xml format.
 	 */
@@ -0,0 +1,142 @@
+/*
+ *    Copyright 2021 The OpenOrienteering developers
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "concurrency.h"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <vector>
+
+#include <QRunnable>
+#include <QSemaphore>
+#include <QThread>
+#include <QThreadPool>
+
+
+namespace OpenOrienteering {
+
+namespace {
+
+/**
+ * The state of a forEachRangeConcurrently() call.
+ * 
+ * The calling thread and the runnables take ranges until all ranges are
+ * processed. Exceptions are captured for rethrowing in the calling thread.
+ */
+struct RangeTask
+{
+	RangeTask(const std::function<void (std::size_t, std::size_t)>& function, std::size_t size, std::size_t num_ranges)
+	: function(function)
+	, size(size)
+	, num_ranges(num_ranges)
+	, exceptions(num_ranges)
+	{}
+	
+	void processRanges()
+	{
+		for (auto i = next_range++; i < num_ranges; i = next_range++)
+		{
+			try
+			{
+				function(size * i / num_ranges, size * (i + 1) / num_ranges);
+			}
+			catch (...)
+			{
+				exceptions[i] = std::current_exception();
+			}
+		}
+	}
+	
+	const std::function<void (std::size_t, std::size_t)>& function;
+	const std::size_t size;
+	const std::size_t num_ranges;
+	std::atomic<std::size_t> next_range = { 0 };
+	std::vector<std::exception_ptr> exceptions;
+	QSemaphore finished_runnables;
+};
+
+
+/**
+ * A runnable which helps processing the ranges of a task.
+ */
+class RangeRunnable : public QRunnable
+{
+public:
+	RangeRunnable(std::shared_ptr<RangeTask> task)
+	: task(std::move(task))
+	{
+		setAutoDelete(true);
+	}
+	
+	void run() override
+	{
+		task->processRanges();
+		task->finished_runnables.release();
+	}
+	
+private:
+	std::shared_ptr<RangeTask> task;
+};
+
+}  // namespace
+
+
+
+namespace Util {
+
+void forEachRangeConcurrently(std::size_t size, const std::function<void (std::size_t, std::size_t)>& function, std::size_t min_range_size)
+{
+	auto const num_threads = std::size_t(std::max(1, QThread::idealThreadCount()));
+	auto const num_ranges = std::min(4 * num_threads, std::max(std::size_t(1), size / std::max(std::size_t(1), min_range_size)));
+	if (num_ranges == 1 || num_threads == 1)
+	{
+		if (size > 0)
+			function(0, size);
+		return;
+	}
+	
+	// The global thread pool is shared with other concurrent work. The
+	// calling thread processes ranges, too, so progress does not depend on
+	// free threads in the pool.
+	auto task = std::make_shared<RangeTask>(function, size, num_ranges);
+	auto* pool = QThreadPool::globalInstance();
+	auto const num_runnables = int(std::min(num_threads, num_ranges) - 1);
+	for (int i = 0; i < num_runnables; ++i)
+		pool->start(new RangeRunnable(task));
+	task->processRanges();
+	
+	// Let the pool use this thread's slot while waiting, for nested calls.
+	pool->releaseThread();
+	task->finished_runnables.acquire(num_runnables);
+	pool->reserveThread();
+	
+	for (auto const& exception : task->exceptions)
+	{
+		if (exception)
+			std::rethrow_exception(exception);
+	}
+}
+
+
+}  // namespace Util
+
+}  // namespace OpenOrienteering
@@ -0,0 +1,50 @@
+/*
+ *    Copyright 2021 The OpenOrienteering developers
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef OPENORIENTEERING_UTIL_CONCURRENCY_H
+#define OPENORIENTEERING_UTIL_CONCURRENCY_H
+
+#include <cstddef>
+#include <functional>
+
+
+namespace OpenOrienteering {
+
+namespace Util {
+
+/**
+ * Calls the function for consecutive ranges [first, last) which cover
+ * [0, size), using multiple threads, and waits for completion.
+ * 
+ * Ranges are not smaller than min_range_size unless size is smaller.
+ * If there is only a single range, or only a single core, the function is
+ * called in the calling thread.
+ * 
+ * An exception thrown by the function is rethrown in the calling thread,
+ * after all ranges are finished.
+ */
+void forEachRangeConcurrently(std::size_t size, const std::function<void (std::size_t first, std::size_t last)>& function, std::size_t min_range_size = 256);
+
+
+}  // namespace Util
+
+}  // namespace OpenOrienteering
+
+#endif
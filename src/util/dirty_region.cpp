@@ -0,0 +1,121 @@
+/*
+ *    Copyright 2021 The OpenOrienteering developers
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "dirty_region.h"
+
+#include <algorithm>
+#include <iterator>
+#include <limits>
+
+
+namespace OpenOrienteering {
+
+namespace {
+
+qint64 area(const QRect& rect)
+{
+	return rect.isValid() ? qint64(rect.width()) * rect.height() : 0;
+}
+
+}  // namespace
+
+
+
+DirtyRegion::DirtyRegion(const QRect& rect)
+{
+	add(rect);
+}
+
+
+// static
+qint64 DirtyRegion::mergeCost(const QRect& a, const QRect& b)
+{
+	auto const separate = area(a) + area(b) - area(a.intersected(b));
+	return area(a.united(b)) - separate - rect_overhead;
+}
+
+
+void DirtyRegion::add(const QRect& rect)
+{
+	if (!rect.isValid())
+		return;
+	
+	// Merging may make further merges beneficial.
+	auto merged = rect;
+	for (auto found = true; found; )
+	{
+		found = false;
+		for (auto it = dirty_rects.begin(); it != dirty_rects.end(); ++it)
+		{
+			if (mergeCost(*it, merged) <= 0)
+			{
+				merged = merged.united(*it);
+				dirty_rects.erase(it);
+				found = true;
+				break;
+			}
+		}
+	}
+	dirty_rects.push_back(merged);
+	
+	while (dirty_rects.size() > max_rects)
+	{
+		auto best_cost = std::numeric_limits<qint64>::max();
+		auto best_a = dirty_rects.begin();
+		auto best_b = best_a + 1;
+		for (auto a = dirty_rects.begin(); a != dirty_rects.end(); ++a)
+		{
+			for (auto b = a + 1; b != dirty_rects.end(); ++b)
+			{
+				auto const cost = mergeCost(*a, *b);
+				if (cost < best_cost)
+				{
+					best_cost = cost;
+					best_a = a;
+					best_b = b;
+				}
+			}
+		}
+		*best_a = best_a->united(*best_b);
+		dirty_rects.erase(best_b);
+	}
+}
+
+
+void DirtyRegion::intersect(const QRect& bounds)
+{
+	for (auto& rect : dirty_rects)
+		rect = rect.intersected(bounds);
+	dirty_rects.erase(std::remove_if(begin(dirty_rects), end(dirty_rects), [](const QRect& rect) {
+		return !rect.isValid();
+	}), end(dirty_rects));
+}
+
+
+QRect DirtyRegion::boundingRect() const
+{
+	QRect result;
+	for (auto const& rect : dirty_rects)
+		result = result.united(rect);
+	return result;
+}
+
+
+}  // namespace OpenOrienteering
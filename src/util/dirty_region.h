@@ -0,0 +1,92 @@
+/*
+ *    Copyright 2021 The OpenOrienteering developers
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef OPENORIENTEERING_UTIL_DIRTY_REGION_H
+#define OPENORIENTEERING_UTIL_DIRTY_REGION_H
+
+#include <cstddef>
+#include <vector>
+
+#include <QRect>
+
+
+namespace OpenOrienteering {
+
+/**
+ * A set of rectangles which need to be redrawn.
+ * 
+ * Unlike QRegion, this class does not try to represent the exact union of
+ * the added rectangles. Instead, it keeps a small number of rectangles which
+ * cover the added rectangles. A new rectangle is merged with an existing one
+ * when the merged rectangle is not much more expensive to redraw than the
+ * two separate rectangles, given a fixed overhead per redrawn rectangle.
+ * When the number of rectangles exceeds max_rects, the pair with the lowest
+ * merge cost is merged.
+ * 
+ * The rectangles may overlap.
+ */
+class DirtyRegion
+{
+public:
+	/// The maximum number of rectangles.
+	static constexpr std::size_t max_rects = 8;
+	
+	/// The estimated overhead of redrawing one more rectangle, in pixels.
+	static constexpr qint64 rect_overhead = 128 * 128;
+	
+	DirtyRegion() noexcept = default;
+	
+	explicit DirtyRegion(const QRect& rect);
+	
+	/** Returns true if there are no rectangles. */
+	bool isEmpty() const noexcept { return dirty_rects.empty(); }
+	
+	/** Removes all rectangles. */
+	void clear() noexcept { dirty_rects.clear(); }
+	
+	/** Adds a rectangle. Invalid rectangles are ignored. */
+	void add(const QRect& rect);
+	
+	/** Restricts all rectangles to the given bounds. */
+	void intersect(const QRect& bounds);
+	
+	/** Returns the bounding rectangle of all rectangles. */
+	QRect boundingRect() const;
+	
+	/** Returns the rectangles. */
+	const std::vector<QRect>& rects() const noexcept { return dirty_rects; }
+	
+	/**
+	 * Returns the additional pixels to be redrawn when merging two rectangles,
+	 * reduced by the overhead of one rectangle.
+	 * 
+	 * A negative or zero cost means that merging is beneficial.
+	 */
+	static qint64 mergeCost(const QRect& a, const QRect& b);
+	
+private:
+	std::vector<QRect> dirty_rects;
+	
+};
+
+
+}  // namespace OpenOrienteering
+
+#endif // OPENORIENTEERING_UTIL_DIRTY_REGION_H
@@ -45,6 +45,49 @@
 
 namespace OpenOrienteering {
 
+namespace {
+
+/**
+ * Maps signed values to unsigned values, with small magnitudes mapping
+ * to small values.
+ */
+constexpr quint64 zigzagEncode(qint64 value)
+{
+	return (quint64(value) << 1) ^ quint64(value >> 63);
+}
+
+constexpr qint64 zigzagDecode(quint64 value)
+{
+	return qint64(value >> 1) ^ -qint64(value & 1);
+}
+
+void appendVarint(QByteArray& data, quint64 value)
+{
+	while (value >= 0x80)
+	{
+		data.append(char((value & 0x7f) | 0x80));
+		value >>= 7;
+	}
+	data.append(char(value));
+}
+
+quint64 readVarint(const char*& current, const char* end)
+{
+	quint64 value = 0;
+	for (int shift = 0; current != end && shift < 64; shift += 7)
+	{
+		auto const byte = quint64(quint8(*current++));
+		value |= (byte & 0x7f) << shift;
+		if (byte < 0x80)
+			return value;
+	}
+	throw FileFormatException(::OpenOrienteering::ImportExport::tr("Could not parse the coordinates."));
+}
+
+}  // namespace
+
+
+
 void writeLineBreak(QXmlStreamWriter& xml)
 {
 	if (!xml.autoFormatting())
@@ -203,6 +246,41 @@ void XmlElementWriter::write(const MapCoordVector& coords)
 	}
 }
 
+void XmlElementWriter::writeCompact(const MapCoordVector& coords)
+{
+	namespace literal = XmlStreamLiteral;
+	
+	if (XMLFileFormat::active_version < XMLFileFormat::compact_coordinates_version || xml.autoFormatting())
+	{
+		write(coords);
+		return;
+	}
+	
+	writeAttribute(literal::count, coords.size());
+	writeAttribute(literal::encoding, literal::delta_base64);
+	
+	// Per coordinate:
+	// - varint: zigzag(x - previous x) << 1 | (flags ? 1 : 0)
+	// - flags byte, if non-zero
+	// - varint: zigzag(y - previous y)
+	QByteArray data;
+	data.reserve(int(coords.size()) * 6);
+	qint64 x = 0;
+	qint64 y = 0;
+	for (auto& coord : coords)
+	{
+		auto const flags = MapCoord::Flags::Int(coord.flags());
+		appendVarint(data, zigzagEncode(coord.nativeX() - x) << 1 | (flags ? 1 : 0));
+		if (flags)
+			data.append(char(flags));
+		appendVarint(data, zigzagEncode(coord.nativeY() - y));
+		x = coord.nativeX();
+		y = coord.nativeY();
+	}
+	
+	xml.writeCharacters(QString::fromLatin1(data.toBase64()));
+}
+
 void OpenOrienteering::XmlElementWriter::write(const KeyValueContainer& tags)
 {
 	namespace literal = XmlStreamLiteral;
@@ -228,6 +306,12 @@ void XmlElementReader::read(MapCoordVector& coords)
 	const auto num_coords = attribute<unsigned int>(literal::count);
 	coords.reserve(std::min(num_coords, 500000u));
 	
+	if (attributes.value(literal::encoding) == literal::delta_base64)
+	{
+		readCompact(coords, num_coords);
+		return;
+	}
+	
 	try
 	{
 		for( xml.readNext(); xml.tokenType() != QXmlStreamReader::EndElement; xml.readNext() )
@@ -280,6 +364,54 @@ void XmlElementReader::read(MapCoordVector& coords)
 }
 
 
+void XmlElementReader::readCompact(MapCoordVector& coords, unsigned int num_coords)
+{
+	QByteArray base64;
+	for (xml.readNext(); xml.tokenType() != QXmlStreamReader::EndElement; xml.readNext())
+	{
+		const QXmlStreamReader::TokenType token = xml.tokenType();
+		if (xml.error() || token == QXmlStreamReader::EndDocument)
+			throw FileFormatException(::OpenOrienteering::ImportExport::tr("Could not parse the coordinates."));
+		else if (token == QXmlStreamReader::Characters)
+			base64.append(xml.text().toLatin1());
+		else if (token == QXmlStreamReader::StartElement)
+			xml.skipCurrentElement();
+	}
+	
+	auto const data = QByteArray::fromBase64(base64);
+	auto const* current = data.constData();
+	auto const* const end = current + data.size();
+	qint64 x = 0;
+	qint64 y = 0;
+	try
+	{
+		while (current != end)
+		{
+			auto const x_value = readVarint(current, end);
+			auto flags = MapCoord::Flags::Int(0);
+			if (x_value & 1)
+			{
+				if (current == end)
+					break;
+				flags = MapCoord::Flags::Int(quint8(*current++));
+			}
+			x += zigzagDecode(x_value >> 1);
+			y += zigzagDecode(readVarint(current, end));
+			coords.emplace_back(MapCoord::loadNative(x, y, MapCoord::Flags{flags}));
+		}
+	}
+	catch (std::range_error &e)
+	{
+		throw FileFormatException(::OpenOrienteering::MapCoord::tr(e.what()));
+	}
+	
+	if (coords.size() != num_coords)
+	{
+		throw FileFormatException(::OpenOrienteering::ImportExport::tr("Expected %1 coordinates, found %2.").arg(num_coords).arg(coords.size()));
+	}
+}
+
+
 void XmlElementReader::readForText(MapCoordVector& coords)
 {
 	namespace literal = XmlStreamLiteral;
@@ -247,6 +247,16 @@ public:
 	 */
 	void write(const MapCoordVector& coords);
 	
+	/**
+	 * Writes the coordinates vector in a compact binary encoding.
+	 * 
+	 * The coordinates are delta-encoded as variable length integers, and the
+	 * resulting bytes are written as base64 text. This encoding requires
+	 * XMLFileFormat::compact_coordinates_version. For older versions, and with
+	 * auto-formatting enabled, this function falls back to write().
+	 */
+	void writeCompact(const MapCoordVector& coords);
+	
 	/**
 	 * Writes tags.
 	 */
@@ -342,6 +352,9 @@ public:
 	/**
 	 * Reads the coordinates vector from a simple text format.
 	 * This is much more efficient than loading each coordinate from rich XML.
+	 * 
+	 * This function also reads the compact encoding.
+	 * \see XmlElementWriter::writeCompact()
 	 */
 	void read(MapCoordVector& coords);
 	
@@ -364,6 +377,11 @@ public:
 	void read(KeyValueContainer& tags);
 	
 private:
+	/**
+	 * Reads the coordinates vector from the compact encoding.
+	 */
+	void readCompact(MapCoordVector& coords, unsigned int num_coords);
+	
 	QXmlStreamReader& xml;
 	const QXmlStreamAttributes attributes; // implicitly shared QVector
 };
@@ -425,6 +443,8 @@ namespace XmlStreamLiteral
 	static const QLatin1String height("height");
 	
 	static const QLatin1String count("count");
+	static const QLatin1String encoding("encoding");
+	static const QLatin1String delta_base64("delta-base64");
 	
 	static const QLatin1String object("object");
 	static const QLatin1String t("t");
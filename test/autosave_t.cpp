@@ -21,9 +21,14 @@
 
 #include <QtGlobal>
 #include <QtTest>
+#include <QByteArray>
 #include <QCoreApplication>
+#include <QFile>
+#include <QIODevice>
+#include <QLatin1String>
 #include <QMetaObject>
 #include <QString>
+#include <QTemporaryDir>
 
 #include "settings.h"
 
@@ -65,6 +70,12 @@ int AutosaveTestDocument::autosaveCount() const
 	return autosave_count;
 }
 
+void AutosaveTestDocument::autosaveFileWritten(const QString& /*path*/, bool success)
+{
+	++written_count;
+	last_write_succeeded = success;
+}
+
 
 //### AutosaveTest ###
 
@@ -243,6 +254,62 @@ void AutosaveTest::autosaveStopTest()
 	}
 }
 
+void AutosaveTest::writeAutosaveFileTest()
+{
+	QTemporaryDir dir;
+	QVERIFY(dir.isValid());
+	auto const path = dir.path() + QLatin1String("/test.omap.autosave");
+	
+	AutosaveTestDocument doc(Autosave::Success);
+	QVERIFY(!doc.isWritingAutosaveFile());
+	doc.writeAutosaveFile(path, QByteArray("first"));
+	QVERIFY(doc.isWritingAutosaveFile());
+	
+	// A new write completes the pending one first.
+	doc.writeAutosaveFile(path, QByteArray("second"));
+	QCOMPARE(doc.writtenCount(), 1);
+	QVERIFY(doc.lastWriteSucceeded());
+	
+	QTRY_COMPARE_WITH_TIMEOUT((doc.writtenCount()), 2, 2000);
+	QVERIFY(doc.lastWriteSucceeded());
+	QVERIFY(!doc.isWritingAutosaveFile());
+	{
+		QFile file(path);
+		QVERIFY(file.open(QIODevice::ReadOnly));
+		QCOMPARE(file.readAll(), QByteArray("second"));
+	}
+	
+	// Failures are reported, too.
+	doc.writeAutosaveFile(dir.path() + QLatin1String("/missing/test.omap.autosave"), QByteArray("third"));
+	doc.waitForAutosaveFile();
+	QCOMPARE(doc.writtenCount(), 3);
+	QVERIFY(!doc.lastWriteSucceeded());
+	QVERIFY(!doc.isWritingAutosaveFile());
+}
+
+void AutosaveTest::writeFailureTest()
+{
+	QTemporaryDir dir;
+	QVERIFY(dir.isValid());
+	
+	AutosaveTestDocument doc(Autosave::Success);
+	
+	// Enable Autosave, and let a write fail
+	doc.setAutosaveNeeded(true);
+	doc.writeAutosaveFile(dir.path() + QLatin1String("/missing/test.omap.autosave"), QByteArray("data"));
+	doc.waitForAutosaveFile();
+	QCOMPARE(doc.writtenCount(), 1);
+	QVERIFY(!doc.lastWriteSucceeded());
+	
+	// Verify that Autosave does not trigger at the regular interval
+	QTest::qWait(4000);
+	QCOMPARE(doc.autosaveCount(), 0);
+	
+	// Verify that Autosave does trigger quickly, as after a temporary failure
+	QTest::qWait(1000);
+	QTRY_COMPARE_WITH_TIMEOUT((doc.autosaveCount()), 1, 2000);
+}
+
 /*
  * We don't need a real GUI window.
  */
@@ -21,6 +21,7 @@
 #define OPENORIENTEERING_AUTO_SAVE_T_H
 
 #include <QObject>
+#include <QString>
 
 #include "core/autosave.h"
 
@@ -54,6 +55,25 @@ public:
 	 */
 	int autosaveCount() const;
 	
+	using Autosave::writeAutosaveFile;
+	using Autosave::isWritingAutosaveFile;
+	using Autosave::waitForAutosaveFile;
+	
+	/**
+	 * @brief Records the result of writing an autosave file.
+	 */
+	void autosaveFileWritten(const QString& path, bool success) override;
+	
+	/**
+	 * @brief Returns the number of invocations of autosaveFileWritten().
+	 */
+	int writtenCount() const { return written_count; }
+	
+	/**
+	 * @brief Returns the success parameter of the last autosaveFileWritten().
+	 */
+	bool lastWriteSucceeded() const { return last_write_succeeded; }
+	
 private:
 	/**
 	 * @brief The result to be returned from the next invocation of autosave().
@@ -64,6 +84,9 @@ private:
 	 * @brief The number of invocations of autosave().
 	 */
 	int autosave_count;
+	
+	int written_count = 0;
+	bool last_write_succeeded = false;
 };
 
 
@@ -95,6 +118,12 @@ private slots:
 	/** @brief Tests autosave stopping on normal saving. */
 	void autosaveStopTest();
 	
+	/** @brief Tests writing autosave files in the background. */
+	void writeAutosaveFileTest();
+	
+	/** @brief Tests autosave retrying after a failed background write. */
+	void writeFailureTest();
+	
 protected:
 	/** @brief The autosave interval, unit: minutes. */
 	const double autosave_interval;
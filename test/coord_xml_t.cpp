@@ -371,6 +371,33 @@ void CoordXmlTest::writeFastImplementation()
 }
 
 
+void CoordXmlTest::writeCompactImplementation_data()
+{
+	common_data();
+}
+
+void CoordXmlTest::writeCompactImplementation()
+{
+	buffer.open(QBuffer::ReadWrite);
+	QXmlStreamWriter xml(&buffer);
+	xml.setAutoFormatting(false);
+	xml.writeStartDocument();
+	
+	XMLFileFormat::active_version = XMLFileFormat::compact_coordinates_version;
+	XmlElementWriter element(xml, QLatin1String("root"));
+	
+	QFETCH(int, num_coords);
+	MapCoordVector coords(num_coords, proto_coord);
+	QBENCHMARK
+	{
+		element.writeCompact(coords);
+	}
+	
+	xml.writeEndDocument();
+	buffer.close();
+}
+
+
 void CoordXmlTest::readXml_data()
 {
 	common_data();
@@ -1062,6 +1089,90 @@ void CoordXmlTest::readFastImplementation()
 }
 
 
+void CoordXmlTest::readCompactImplementation_data()
+{
+	common_data();
+}
+
+void CoordXmlTest::readCompactImplementation()
+{
+	QFETCH(int, num_coords);
+	MapCoordVector coords(num_coords, proto_coord);
+	
+	// The size of the fast text format, for comparison
+	QBuffer text_buffer;
+	{
+		text_buffer.open(QBuffer::ReadWrite);
+		QXmlStreamWriter xml(&text_buffer);
+		XMLFileFormat::active_version = 6; // Activate fast text format.
+		XmlElementWriter element(xml, QLatin1String("coords"));
+		element.write(coords);
+	}
+	
+	buffer.buffer().truncate(0);
+	QBuffer header;
+	{
+		QXmlStreamWriter xml(&header);
+		
+		header.open(QBuffer::ReadWrite);
+		xml.setAutoFormatting(false);
+		xml.writeStartDocument();
+		
+		XMLFileFormat::active_version = XMLFileFormat::compact_coordinates_version;
+		
+		xml.writeStartElement(QString::fromLatin1("root"));
+		xml.writeCharacters(QString{}); // flush root start element
+		
+		buffer.open(QBuffer::ReadWrite);
+		xml.setDevice(&buffer);
+		{
+			XmlElementWriter element(xml, QLatin1String("coords"));
+			element.writeCompact(coords);
+		}
+		
+		xml.setDevice(nullptr);
+		
+		buffer.close();
+		header.close();
+	}
+	QVERIFY(buffer.data().contains("delta-base64"));
+	if (num_coords > 5)
+		QVERIFY(buffer.data().size() < text_buffer.data().size());
+	
+	header.open(QBuffer::ReadOnly);
+	buffer.open(QBuffer::ReadOnly);
+	QXmlStreamReader xml;
+	xml.addData(header.buffer());
+	xml.readNextStartElement();
+	QCOMPARE(xml.name().toString(), QString::fromLatin1("root"));
+	
+	bool failed = false;
+	QBENCHMARK
+	{
+		// benchmark iteration overhead
+		coords.clear();
+		xml.addData(buffer.data());
+		
+		xml.readNextStartElement();
+		if (xml.name() != QLatin1String("coords"))
+		{
+			failed = true;
+			break;
+		}
+		
+		XmlElementReader element(xml);
+		element.read(coords);
+	}
+		
+	QVERIFY(!failed);
+	QCOMPARE((int)coords.size(), num_coords);
+	QVERIFY(compare_all(coords, proto_coord));
+	
+	header.close();
+	buffer.close();
+}
+
+
 bool CoordXmlTest::compare_all(MapCoordVector& coords, MapCoord& expected) const
 {
 	return std::all_of(begin(coords), end(coords), [expected](const MapCoord& coord){ return coord == expected; });
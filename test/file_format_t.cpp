@@ -21,6 +21,7 @@
 #include "file_format_t.h"
 
 #include <array>
+#include <cstddef>
 #include <initializer_list>
 #include <limits>
 #include <memory>
@@ -78,6 +79,7 @@
 #include "fileformats/simple_course_export.h"
 #include "fileformats/xml_file_format.h"
 #include "templates/template.h"
+#include "undo/object_undo.h"
 #include "undo/undo.h"
 #include "undo/undo_manager.h"
 #include "util/backports.h"  // IWYU pragma: keep
@@ -955,6 +957,203 @@ void FileFormatTest::pristineMapTest()
 
 
 
+void FileFormatTest::ocdConcurrentImportTest()
+{
+#ifdef MAPPER_BIG_ENDIAN
+	QSKIP("OCD export is not supported on big endian systems");
+#else
+	Map original;
+	QVERIFY(original.loadFrom(QStringLiteral("data:/examples/forest sample.omap")));
+	// Enough objects for concurrent import
+	auto* part = original.getPart(0);
+	for (auto count = part->getNumObjects(); part->getNumObjects() < 2048; )
+	{
+		for (int i = 0; i < count; ++i)
+			part->addObject(part->getObject(i)->duplicate());
+	}
+	
+	QTemporaryDir temp_dir;
+	QVERIFY(temp_dir.isValid());
+	auto const path = temp_dir.filePath(QStringLiteral("forest sample.ocd"));
+	auto const* format = FileFormats.findFormat("OCD");
+	QVERIFY(format);
+	auto exporter = format->makeExporter(path, &original, nullptr);
+	QVERIFY(exporter);
+	QVERIFY(exporter->doExport());
+	
+	auto load = [format, &path](bool concurrent) {
+		auto map = std::make_unique<Map>();
+		auto importer = format->makeImporter(path, map.get(), nullptr);
+		if (!importer)
+			return std::unique_ptr<Map>();
+		importer->setOption(QStringLiteral("Concurrent import"), concurrent);
+		if (!importer->doImport())
+			map.reset();
+		return map;
+	};
+	
+	auto sequential = load(false);
+	QVERIFY(bool(sequential));
+	auto concurrent = load(true);
+	QVERIFY(bool(concurrent));
+	QVERIFY(concurrent->getNumObjects() > 0);
+	QCOMPARE(concurrent->getNumObjects(), sequential->getNumObjects());
+	compareMaps(*concurrent, *sequential);
+#endif
+}
+
+
+void FileFormatTest::ocdConcurrentExportTest_data()
+{
+	QTest::addColumn<int>("version");
+	QTest::newRow("v8")  << 8;
+	QTest::newRow("v9")  << 9;
+	QTest::newRow("v12") << 12;
+}
+
+void FileFormatTest::ocdConcurrentExportTest()
+{
+#ifdef MAPPER_BIG_ENDIAN
+	QSKIP("OCD export is not supported on big endian systems");
+#else
+	QFETCH(int, version);
+	
+	Map original;
+	QVERIFY(original.loadFrom(QStringLiteral("data:/examples/forest sample.omap")));
+	// Enough objects for concurrent export
+	auto* part = original.getPart(0);
+	for (auto count = part->getNumObjects(); part->getNumObjects() < 2048; )
+	{
+		for (int i = 0; i < count; ++i)
+			part->addObject(part->getObject(i)->duplicate());
+	}
+	
+	auto save = [&original, version](bool concurrent) {
+		QBuffer buffer;
+		buffer.open(QIODevice::WriteOnly);
+		OcdFileExport exporter({}, &original, nullptr, quint16(version));
+		exporter.setOption(QStringLiteral("Concurrent export"), concurrent);
+		exporter.setDevice(&buffer);
+		if (!exporter.doExport())
+			return QByteArray();
+		return buffer.data();
+	};
+	
+	auto const sequential = save(false);
+	QVERIFY(!sequential.isEmpty());
+	auto const concurrent = save(true);
+	QCOMPARE(concurrent.size(), sequential.size());
+	QVERIFY(concurrent == sequential);
+#endif
+}
+
+
+
+void FileFormatTest::xmlCompactCoordinatesTest()
+{
+	Map original;
+	QVERIFY(original.loadFrom(QStringLiteral("data:/examples/complete map.omap")));
+	
+	auto const* format = FileFormats.findFormat("XML");
+	QVERIFY(format);
+	
+	// Compact coordinates must be requested explicitly.
+	QVERIFY(!format->makeExporter(QStringLiteral("test.omap"), &original, nullptr)->option(QStringLiteral("compactCoordinates")).toBool());
+	QVERIFY(!format->makeExporter(QStringLiteral("test.xmap"), &original, nullptr)->option(QStringLiteral("compactCoordinates")).toBool());
+	
+	QBuffer buffer;
+	QVERIFY(buffer.open(QIODevice::ReadWrite));
+	auto exporter = format->makeExporter({}, &original, nullptr);
+	QVERIFY(exporter);
+	exporter->setOption(QStringLiteral("compactCoordinates"), true);
+	exporter->setDevice(&buffer);
+	QVERIFY(exporter->doExport());
+	QVERIFY(buffer.data().contains("encoding=\"delta-base64\""));
+	QVERIFY(buffer.data().contains("version=\"10\""));
+	
+	Map loaded;
+	auto importer = format->makeImporter({}, &loaded, nullptr);
+	QVERIFY(importer);
+	importer->setDevice(&buffer);
+	QVERIFY(buffer.seek(0));
+	QVERIFY(importer->doImport());
+	compareMaps(loaded, original);
+}
+
+void FileFormatTest::xmlCoordinatesUndoTest()
+{
+	Map original;
+	auto* symbol = new LineSymbol();
+	original.addSymbol(symbol, 0);
+	auto* object = new PathObject(symbol, { MapCoord(0.0, 0.0), MapCoord(10.0, 0.0), MapCoord(10.0, 10.0) });
+	original.addObject(object);
+	auto const unmodified = std::unique_ptr<Object>(object->duplicate());
+	object->setCoordinate(1, MapCoord(10.0, 5.0));
+	
+	auto step = std::make_unique<ObjectCoordinatesUndoStep>(&original);
+	QVERIFY(step->addObject(0, *unmodified));
+	original.undoManager().push(std::move(step));
+	QVERIFY(original.undoManager().containsStepType(UndoStep::ObjectCoordinatesUndoStepType));
+	
+	auto const* format = FileFormats.findFormat("XML");
+	QVERIFY(format);
+	
+	QBuffer buffer;
+	QVERIFY(buffer.open(QIODevice::ReadWrite));
+	auto exporter = format->makeExporter({}, &original, nullptr);
+	QVERIFY(exporter);
+	exporter->setDevice(&buffer);
+	QVERIFY(exporter->doExport());
+	
+	// The map data doesn't need version 11, but the undo steps do.
+	QVERIFY(buffer.data().contains("/mapper/xml/v2\" version=\"9\">"));
+	QVERIFY(buffer.data().contains("<barrier version=\"11\""));
+	
+	Map loaded;
+	auto importer = format->makeImporter({}, &loaded, nullptr);
+	QVERIFY(importer);
+	importer->setDevice(&buffer);
+	QVERIFY(buffer.seek(0));
+	QVERIFY(importer->doImport());
+	QVERIFY(loaded.undoManager().canUndo());
+	QVERIFY(loaded.undoManager().containsStepType(UndoStep::ObjectCoordinatesUndoStepType));
+}
+
+void FileFormatTest::xmlObjectCacheTest()
+{
+	Map original;
+	QVERIFY(original.loadFrom(QStringLiteral("data:/examples/complete map.omap")));
+	
+	auto const* format = FileFormats.findFormat("XML");
+	QVERIFY(format);
+	
+	auto save = [&original, format](bool object_cache) {
+		QBuffer buffer;
+		buffer.open(QIODevice::WriteOnly);
+		auto exporter = format->makeExporter({}, &original, nullptr);
+		exporter->setOption(QStringLiteral("objectCache"), object_cache);
+		exporter->setDevice(&buffer);
+		if (!exporter->doExport())
+			return QByteArray();
+		return buffer.data();
+	};
+	
+	auto const uncached = save(false);
+	QVERIFY(!uncached.isEmpty());
+	QCOMPARE(save(true), uncached);  // populating the cache
+	QCOMPARE(save(true), uncached);  // using the cache
+	
+	auto* part = original.getPart(0);
+	QVERIFY(part->getNumObjects() > 2);
+	part->getObject(0)->move(MapCoord(1.0, 1.0));
+	part->getObject(1)->setTag(QStringLiteral("name"), QStringLiteral("modified"));
+	part->deleteObject(2);
+	part->addObject(part->getObject(0)->duplicate());
+	QCOMPARE(save(true), save(false));
+}
+
+
+
 void FileFormatTest::ogrExportTest_data()
 {
 	QTest::addColumn<QString>("map_filepath");
@@ -1017,6 +1216,63 @@ void FileFormatTest::ogrExportTest()
 }
 
 
+void FileFormatTest::ogrImportTest()
+{
+#ifdef MAPPER_USE_GDAL
+	QTemporaryDir dir;
+	QVERIFY(dir.isValid());
+	auto const ogr_filepath = QString {dir.path() + QLatin1String("/ogrimport.geojson")};
+	
+	// More features than fit into a single batch of the reader
+	auto const num_lines = 1000;
+	{
+		QFile file(ogr_filepath);
+		QVERIFY(file.open(QIODevice::WriteOnly));
+		file.write("{ \"type\": \"FeatureCollection\", \"features\": [\n");
+		for (int i = 0; i < num_lines; ++i)
+		{
+			auto const lon = QByteArray::number(9 + i / 100000.0, 'f', 6);
+			file.write("{ \"type\": \"Feature\", \"properties\": { }, \"geometry\": "
+			           "{ \"type\": \"LineString\", \"coordinates\": [ [" + lon + ", 50.0], [" + lon + ", 50.001], [" + lon + ", 50.002] ] } },\n");
+		}
+		file.write("{ \"type\": \"Feature\", \"properties\": { }, \"geometry\": "
+		           "{ \"type\": \"Polygon\", \"coordinates\": [ "
+		           "[ [9.0, 50.0], [9.01, 50.0], [9.01, 50.01], [9.0, 50.01], [9.0, 50.0] ], "
+		           "[ [9.002, 50.002], [9.002, 50.004], [9.004, 50.004], [9.004, 50.002], [9.002, 50.002] ] "
+		           "] } }\n");
+		file.write("] }\n");
+	}
+	
+	Map map;
+	auto const* format = FileFormats.findFormat("OGR");
+	QVERIFY(format);
+	auto importer = format->makeImporter(ogr_filepath, &map, nullptr);
+	QVERIFY(bool(importer));
+	QVERIFY(importer->doImport());
+	QCOMPARE(map.getNumObjects(), num_lines + 1);
+	
+	auto const* part = map.getCurrentPart();
+	for (int i = 0; i < num_lines; ++i)
+	{
+		auto const* line = part->getObject(i)->asPath();
+		QCOMPARE(line->getSymbol()->getType(), Symbol::Line);
+		QCOMPARE(line->getCoordinateCount(), std::size_t(3));
+		QCOMPARE(line->parts().size(), std::size_t(1));
+	}
+	
+	auto const* area = part->getObject(num_lines)->asPath();
+	QCOMPARE(area->getSymbol()->getType(), Symbol::Area);
+	QCOMPARE(area->getCoordinateCount(), std::size_t(10));
+	QCOMPARE(area->parts().size(), std::size_t(2));
+	for (auto const& path_part : area->parts())
+	{
+		QVERIFY(path_part.isClosed());
+		QCOMPARE(path_part.size(), std::size_t(5));
+	}
+#endif  // MAPPER_USE_GDAL
+}
+
+
 void FileFormatTest::kmlCourseExportTest()
 {
 	QTemporaryDir dir;
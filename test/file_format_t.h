@@ -88,12 +88,46 @@ private slots:
 	 */
 	void pristineMapTest();
 	
+	/**
+	 * Tests that concurrent, memory-mapped OCD import gives the same result
+	 * as sequential import.
+	 */
+	void ocdConcurrentImportTest();
+	
+	/**
+	 * Tests that concurrent OCD export gives the same result as sequential
+	 * export.
+	 */
+	void ocdConcurrentExportTest_data();
+	void ocdConcurrentExportTest();
+	
+	/**
+	 * Tests saving and loading XML files with compact coordinates.
+	 */
+	void xmlCompactCoordinatesTest();
+	
+	/**
+	 * Tests the barrier version of saved coordinates undo steps.
+	 */
+	void xmlCoordinatesUndoTest();
+	
+	/**
+	 * Tests that XML export with the object cache gives the same result as
+	 * export without the cache, also after modifications.
+	 */
+	void xmlObjectCacheTest();
+	
 	/**
 	 * Tests export of geospatial vector data via OGR.
 	 */
 	void ogrExportTest();
 	void ogrExportTest_data();
 	
+	/**
+	 * Tests the import of many features and of polygons with holes.
+	 */
+	void ogrImportTest();
+	
 	/**
 	 * Tests the export of KML courses.
 	 */
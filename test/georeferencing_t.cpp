@@ -21,6 +21,7 @@
 
 #include <cmath>
 #include <cstddef>
+#include <vector>
 
 #include <QtMath>
 #include <QtTest>
@@ -517,6 +518,57 @@ void GeoreferencingTest::testProjection()
 }
 
 
+void GeoreferencingTest::testBatchProjection_data()
+{
+	testProjection_data();
+}
+
+void GeoreferencingTest::testBatchProjection()
+{
+	QFETCH(QString, proj);
+	QFETCH(double, latitude);
+	QFETCH(double, longitude);
+	
+	Georeferencing georef;
+	QVERIFY2(georef.setProjectedCRS(proj, proj), proj.toLatin1());
+	georef.setGeographicRefPoint({latitude, longitude});
+	
+	std::vector<LatLon> lat_lon;
+	for (int i = -2; i <= 2; ++i)
+	{
+		for (int j = -2; j <= 2; ++j)
+			lat_lon.emplace_back(latitude + 0.01 * i, longitude + 0.01 * j);
+	}
+	
+	// geographic to map
+	std::vector<MapCoordF> map_coords(lat_lon.size());
+	QVERIFY(georef.toMapCoordF(lat_lon.data(), map_coords.data(), lat_lon.size()));
+	for (std::size_t i = 0; i < lat_lon.size(); ++i)
+	{
+		bool ok;
+		auto const expected = georef.toMapCoordF(lat_lon[i], &ok);
+		QVERIFY(ok);
+		QVERIFY(QLineF(map_coords[i], expected).length() < 0.000001);
+	}
+	
+	// map to geographic
+	std::vector<LatLon> result(map_coords.size());
+	QVERIFY(georef.toGeographicCoords(map_coords.data(), result.data(), map_coords.size()));
+	for (std::size_t i = 0; i < map_coords.size(); ++i)
+	{
+		bool ok;
+		auto const expected = georef.toGeographicCoords(map_coords[i], &ok);
+		QVERIFY(ok);
+		QCOMPARE(result[i].latitude(), expected.latitude());
+		QCOMPARE(result[i].longitude(), expected.longitude());
+	}
+	
+	// empty input
+	QVERIFY(georef.toMapCoordF(lat_lon.data(), map_coords.data(), 0));
+	QVERIFY(georef.toGeographicCoords(map_coords.data(), result.data(), 0));
+}
+
+
 
 #ifndef ACCEPT_USE_OF_DEPRECATED_PROJ_API_H
 
@@ -74,6 +74,14 @@ private slots:
 	
 	void testProjection_data();
 	
+	/**
+	 * Tests whether the batch transformations match the transformation
+	 * of single points.
+	 */
+	void testBatchProjection();
+	
+	void testBatchProjection_data();
+	
 #ifndef ACCEPT_USE_OF_DEPRECATED_PROJ_API_H
 	/**
 	 * Tests whether the `proj_context_set_file_finder()` function is working.
@@ -20,11 +20,21 @@
 
 #include <QtGlobal>
 #include <QtTest>
+#include <QColor>
+#include <QDir>
+#include <QImage>
 #include <QObject>
+#include <QPainter>
 #include <QPrinterInfo>
+#include <QRgb>
 #include <QString>
 
+#include "test_config.h"
+
+#include "global.h"
+#include "core/map.h"
 #include "core/map_printer.h"
+#include "core/map_view.h"
 
 using namespace OpenOrienteering;
 
@@ -36,6 +46,12 @@ class MapPrinterTest : public QObject
 {
 Q_OBJECT
 private slots:
+	void initTestCase()
+	{
+		Q_INIT_RESOURCE(resources);
+		doStaticInitializations();
+	}
+	
 	void isPrinterTest()
 	{
 		QPrinterInfo printer_info;
@@ -45,6 +61,51 @@ private slots:
 		QCOMPARE(MapPrinter::isPrinter(MapPrinter::pdfTarget()), false);
 	}
 	
+	void drawPageToImageTest()
+	{
+		auto const examples_dir = QDir(QString::fromUtf8(MAPPER_TEST_SOURCE_DIR)).absoluteFilePath(QStringLiteral("../examples"));
+		Map map;
+		MapView view{ &map };
+		QVERIFY(map.loadFrom(QDir(examples_dir).absoluteFilePath(QStringLiteral("forest sample.omap")), &view));
+		
+		MapPrinter map_printer(map, &view);
+		map_printer.setTarget(MapPrinter::imageTarget());
+		map_printer.setMode(MapPrinterOptions::Raster);
+		map_printer.setResolution(150);
+		map_printer.setPrintTemplates(false);
+		map_printer.setPrintArea(map.calculateExtent());
+		QVERIFY(map_printer.concurrentPageDrawFunction());
+		
+		auto const pixel_per_mm = map_printer.getOptions().resolution / 25.4;
+		auto const size = map_printer.getPrintAreaPaperSize() * pixel_per_mm;
+		auto image = QImage(qRound(size.width()), qRound(size.height()), QImage::Format_ARGB32_Premultiplied);
+		image.fill(QColor(Qt::white));
+		auto expected = image.copy();
+		
+		{
+			QPainter painter(&expected);
+			map_printer.drawPage(&painter, map_printer.getPrintArea(), &expected);
+		}
+		map_printer.drawPageToImage(image, map_printer.getPrintArea());
+		
+		// Stripes may differ from the reference only by rounding.
+		auto const fuzzy = [](int a, int b) { return qAbs(a - b) <= 2; };
+		for (int y = 0; y < image.height(); ++y)
+		{
+			for (int x = 0; x < image.width(); ++x)
+			{
+				auto const actual_pixel = image.pixel(x, y);
+				auto const expected_pixel = expected.pixel(x, y);
+				if (!fuzzy(qRed(actual_pixel), qRed(expected_pixel))
+				    || !fuzzy(qGreen(actual_pixel), qGreen(expected_pixel))
+				    || !fuzzy(qBlue(actual_pixel), qBlue(expected_pixel)))
+				{
+					QFAIL(qPrintable(QString::fromLatin1("Pixel (%1, %2) differs").arg(x).arg(y)));
+				}
+			}
+		}
+	}
+	
 };
 
 
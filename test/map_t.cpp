@@ -19,21 +19,34 @@
 
 #include "map_t.h"
 
+#include <algorithm>
+#include <memory>
+#include <vector>
+
 #include <QtTest>
 #include <QBuffer>
+#include <QImage>
 #include <QMessageBox>
+#include <QPainter>
+#include <QRgb>
 #include <QTextStream>
+#include <QTransform>
 
 #include "test_config.h"
 
 #include "global.h"
 #include "core/map.h"
 #include "core/map_color.h"
+#include "core/map_coord.h"
+#include "core/map_part.h"
 #include "core/map_printer.h" // IWYU pragma: keep
+#include "core/image_transparency_fixup.h"
 #include "core/map_view.h"
 #include "core/objects/object.h"
 #include "core/objects/symbol_rule_set.h"
+#include "core/renderables/renderable.h"
 #include "core/symbols/symbol.h"
+#include "core/symbols/line_symbol.h"
 #include "core/symbols/point_symbol.h"
 
 using namespace OpenOrienteering;
@@ -43,6 +56,22 @@ namespace
 {
 	QDir examples_dir;    // clazy:exclude=non-pod-global-static
 	QDir symbol_set_dir;  // clazy:exclude=non-pod-global-static
+	
+	/// A path object which counts the generation of its renderables.
+	class CountingPathObject : public PathObject  // clazy:exclude=copyable-polymorphic
+	{
+	public:
+		using PathObject::PathObject;
+		
+		mutable int num_updates = 0;
+		
+	protected:
+		void updateEvent() const override
+		{
+			++num_updates;
+			PathObject::updateEvent();
+		}
+	};
 }
 
 
@@ -221,6 +250,304 @@ void MapTest::importTest()
 
 
 
+void MapTest::findObjectsTest()
+{
+	Map map;
+	auto const* symbol = Map::getUndefinedLine();
+	auto* a = new PathObject(symbol, { MapCoord(0.0, 0.0), MapCoord(10.0, 0.0) });
+	auto* b = new PathObject(symbol, { MapCoord(100.0, 100.0), MapCoord(110.0, 100.0) });
+	auto* c = new PathObject(symbol, { MapCoord(0.0, 5.0), MapCoord(10.0, 5.0) });
+	map.addObject(a);
+	map.addObject(b);
+	map.addObject(c);
+	QCOMPARE(map.getNumObjects(), 3);
+	
+	// Results are in the order of the map part.
+	std::vector<Object*> found;
+	map.findObjectsAtBox(MapCoordF(-1, -1), MapCoordF(11, 6), true, true, found);
+	QCOMPARE(found, (std::vector<Object*>{ a, c }));
+	
+	SelectionInfoVector at;
+	map.findObjectsAt(MapCoordF(105, 100), 0.1, false, false, true, true, at);
+	QCOMPARE(int(at.size()), 1);
+	QCOMPARE(at.front().second, static_cast<Object*>(b));
+	
+	// The index follows modified objects, even before they are updated explicitly.
+	b->move(MapCoord(-50.0, -50.0));
+	at.clear();
+	map.findObjectsAt(MapCoordF(105, 100), 0.1, false, false, true, true, at);
+	QVERIFY(at.empty());
+	map.findObjectsAt(MapCoordF(55, 50), 0.1, false, false, true, true, at);
+	QCOMPARE(int(at.size()), 1);
+	QCOMPARE(at.front().second, static_cast<Object*>(b));
+	
+	QCOMPARE(map.countObjectsInRect(QRectF(-10, -10, 200, 200), true), 3);
+	QCOMPARE(map.countObjectsInRect(QRectF(40, 40, 20, 20), true), 1);
+	
+	// Released objects are no longer found.
+	map.deleteObject(a);
+	found.clear();
+	map.findObjectsAtBox(MapCoordF(-1, -1), MapCoordF(11, 6), true, true, found);
+	QCOMPARE(found, (std::vector<Object*>{ c }));
+	
+	// Inserted objects keep the order of the map part,
+	// also when the sequence numbers must be renumbered.
+	auto* part = map.getCurrentPart();
+	for (int i = 0; i < 40; ++i)
+	{
+		auto* object = new PathObject(symbol, { MapCoord(0.0, 1.0), MapCoord(10.0, 1.0) });
+		part->addObject(object, i % 2 ? 0 : 1);
+	}
+	part->setObject(new PathObject(symbol, { MapCoord(0.0, 2.0), MapCoord(10.0, 2.0) }), 5, true);
+	std::vector<Object*> expected;
+	for (int i = 0; i < part->getNumObjects(); ++i)
+	{
+		if (part->getObject(i) != b)
+			expected.push_back(part->getObject(i));
+	}
+	found.clear();
+	map.findObjectsAtBox(MapCoordF(-1, -1), MapCoordF(11, 6), true, true, found);
+	QCOMPARE(found, expected);
+}
+
+
+void MapTest::spatialIndexDrawTest()
+{
+	Map map;
+	MapView view{ &map };
+	QVERIFY(map.loadFrom(examples_dir.absoluteFilePath(QStringLiteral("complete map.omap")), &view));
+	
+	auto const extent = map.calculateExtent();
+	QVERIFY(extent.isValid());
+	
+	// Tiles of 1/8 of the extent are small enough for drawing via the spatial
+	// index, while the full extent makes drawing scan all objects.
+	auto const num_tiles = 8;
+	auto const tile_pixels = 50;
+	auto const scaling = num_tiles * tile_pixels / std::max(extent.width(), extent.height());
+	auto const tile_size = tile_pixels / scaling;
+	auto const margin = 1 / scaling;
+	
+	auto render = [&map, scaling, tile_pixels](const QRectF& tile, const QRectF& bounding_box) {
+		QImage image(QSize(tile_pixels, tile_pixels), QImage::Format_ARGB32_Premultiplied);
+		image.fill(Qt::transparent);
+		QPainter painter(&image);
+		painter.scale(scaling, scaling);
+		painter.translate(-tile.topLeft());
+		map.draw(&painter, RenderConfig{ map, bounding_box, scaling, RenderConfig::Screen, 1.0 });
+		painter.end();
+		return image;
+	};
+	auto compare_tiles = [&]() {
+		for (int row = 0; row < num_tiles; ++row)
+		{
+			for (int column = 0; column < num_tiles; ++column)
+			{
+				auto const tile = QRectF(extent.left() + column * tile_size, extent.top() + row * tile_size,
+				                         tile_size, tile_size);
+				auto const expected = render(tile, extent);
+				auto const actual = render(tile, tile.adjusted(-margin, -margin, margin, margin));
+				if (actual != expected)
+					return false;
+			}
+		}
+		return true;
+	};
+	
+	QVERIFY(compare_tiles());
+	
+	// The index follows modified objects.
+	auto* part = map.getPart(0);
+	for (int i = 0; i < part->getNumObjects(); i += 7)
+		part->getObject(i)->move(MapCoord(extent.width() / 3, extent.height() / 5));
+	part->deleteObject(1);
+	map.updateObjects();
+	QVERIFY(compare_tiles());
+}
+
+void MapTest::renderablesSnapshotTest()
+{
+	Map map;
+	MapView view{ &map };
+	QVERIFY(map.loadFrom(examples_dir.absoluteFilePath(QStringLiteral("complete map.omap")), &view));
+	
+	auto const extent = map.calculateExtent();
+	QVERIFY(extent.isValid());
+	auto const scaling = 200.0 / std::max(extent.width(), extent.height());
+	
+	auto render = [&](auto draw) {
+		QImage image(QSize(200, 200), QImage::Format_ARGB32_Premultiplied);
+		image.fill(Qt::transparent);
+		QPainter painter(&image);
+		painter.scale(scaling, scaling);
+		painter.translate(-extent.topLeft());
+		draw(&painter, RenderConfig{ map, extent, scaling, RenderConfig::Screen, 1.0 });
+		painter.end();
+		return image;
+	};
+	
+	auto const expected = render([&map](QPainter* painter, const RenderConfig& config) {
+		map.draw(painter, config);
+	});
+	auto const snapshot = map.renderablesSnapshot(extent);
+	QVERIFY(bool(snapshot));
+	auto const actual = render([&snapshot](QPainter* painter, const RenderConfig& config) {
+		snapshot->draw(painter, config);
+	});
+	QCOMPARE(actual, expected);
+	
+	// The snapshot is not affected by later modifications of the map.
+	map.getPart(0)->deleteObject(0);
+	map.updateObjects();
+	QCOMPARE(render([&snapshot](QPainter* painter, const RenderConfig& config) {
+		snapshot->draw(painter, config);
+	}), expected);
+}
+
+void MapTest::updateAllObjectsConcurrentlyTest()
+{
+	Map map;
+	MapView view{ &map };
+	QVERIFY(map.loadFrom(examples_dir.absoluteFilePath(QStringLiteral("complete map.omap")), &view));
+	
+	auto const extent = map.calculateExtent();
+	auto render = [&map, &extent]() {
+		QImage image(QSize(200, 200), QImage::Format_ARGB32_Premultiplied);
+		image.fill(Qt::transparent);
+		QPainter painter(&image);
+		auto const scaling = 200.0 / std::max(extent.width(), extent.height());
+		painter.scale(scaling, scaling);
+		painter.translate(-extent.topLeft());
+		map.draw(&painter, RenderConfig{ map, extent, scaling, RenderConfig::Screen, 1.0 });
+		painter.end();
+		return image;
+	};
+	
+	map.updateAllObjects();
+	std::vector<QRectF> expected_extents;
+	map.applyOnAllObjects([&expected_extents](Object* object) {
+		expected_extents.push_back(object->getExtent());
+	});
+	auto const expected = render();
+	
+	map.updateAllObjectsConcurrently();
+	std::vector<QRectF> actual_extents;
+	map.applyOnAllObjects([&actual_extents](Object* object) {
+		QVERIFY(!object->isOutputDirty());
+		actual_extents.push_back(object->getExtent());
+	});
+	QCOMPARE(actual_extents, expected_extents);
+	QCOMPARE(map.calculateExtent(), extent);
+	QCOMPARE(render(), expected);
+	
+	// forceUpdate() discards prepared output, e.g. after symbol changes.
+	auto* symbol = new LineSymbol();
+	symbol->setLineWidth(1.0);
+	map.addSymbol(symbol, 0);
+	auto* object = new PathObject(symbol, { MapCoord(0.0, 0.0), MapCoord(10.0, 0.0) });
+	map.addObject(object);
+	QCOMPARE(object->getExtent().height(), 1.0);
+	object->prepareUpdate();
+	symbol->setLineWidth(2.0);
+	object->forceUpdate();
+	QCOMPARE(object->getExtent().height(), 2.0);
+	
+	// The concurrent update generates the renderables only once.
+	auto* counting_object = new CountingPathObject(symbol, { MapCoord(0.0, 5.0), MapCoord(10.0, 5.0) });
+	map.addObject(counting_object);
+	counting_object->update();
+	counting_object->num_updates = 0;
+	map.updateAllObjectsConcurrently();
+	QCOMPARE(counting_object->num_updates, 1);
+	QVERIFY(!counting_object->isOutputDirty());
+	QCOMPARE(counting_object->getExtent().height(), 2.0);
+}
+
+void MapTest::overprintingSimulationTest()
+{
+	Map map;
+	MapView view{ &map };
+	QVERIFY(map.loadFrom(examples_dir.absoluteFilePath(QStringLiteral("overprinting.omap")), &view));
+	
+	auto const extent = map.calculateExtent();
+	QVERIFY(extent.isValid());
+	auto const scaling = 200.0 / std::max(extent.width(), extent.height());
+	auto render = [&](const QRect& clip) {
+		QImage image(QSize(200, 200), QImage::Format_ARGB32_Premultiplied);
+		image.fill(Qt::white);
+		QPainter painter(&image);
+		if (clip.isValid())
+			painter.setClipRect(clip);
+		painter.scale(scaling, scaling);
+		painter.translate(-extent.topLeft());
+		map.drawOverprintingSimulation(&painter, RenderConfig{ map, extent, scaling, RenderConfig::NoOptions, 1.0 });
+		painter.end();
+		return image;
+	};
+	
+	auto blank = QImage(QSize(200, 200), QImage::Format_ARGB32_Premultiplied);
+	blank.fill(Qt::white);
+	auto const full = render({});
+	QVERIFY(full != blank);
+	
+	// The result is identical to composing the separations with QPainter's
+	// CompositionMode_Multiply and ImageTransparencyFixup, followed by the
+	// default overprinting correction.
+	auto reference = blank.copy();
+	{
+		auto const config = RenderConfig{ map, extent, scaling, RenderConfig::NoOptions, 1.0 };
+		auto const transform = QTransform::fromScale(scaling, scaling).translate(-extent.left(), -extent.top());
+		QPainter painter(&reference);
+		ImageTransparencyFixup fixup(&reference);
+		QImage separation(reference.size(), QImage::Format_ARGB32_Premultiplied);
+		for (auto i = map.getNumColors() - 1; i >= 0; --i)
+		{
+			auto const* color = map.getColor(i);
+			if (color->getSpotColorMethod() != MapColor::SpotColor)
+				continue;
+			separation.fill(Qt::transparent);
+			QPainter p(&separation);
+			p.setWorldTransform(transform);
+			map.drawColorSeparation(&p, config, color, true);
+			p.end();
+			painter.setCompositionMode(QPainter::CompositionMode_Multiply);
+			painter.drawImage(0, 0, separation);
+			fixup();
+		}
+		painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
+		
+		separation.fill(Qt::transparent);
+		QPainter p(&separation);
+		p.setWorldTransform(transform);
+		auto config_copy = config;
+		config_copy.options |= RenderConfig::RequireSpotColor;
+		map.draw(&p, config_copy);
+		p.end();
+		for (int y = 0; y < separation.height(); ++y)
+		{
+			auto* line = reinterpret_cast<QRgb*>(separation.scanLine(y));
+			std::transform(line, line + separation.width(), line, [](QRgb px) { return (px >> 2) & 0x3f3f3f3f; });
+		}
+		painter.drawImage(0, 0, separation);
+	}
+	QCOMPARE(full, reference);
+	
+	// Drawing with a clip affects only the clipped area, with the same result.
+	auto const clip = QRect(37, 51, 100, 80);
+	auto const clipped = render(clip);
+	QCOMPARE(clipped.copy(clip), full.copy(clip));
+	auto outside = clipped;
+	QPainter(&outside).fillRect(clip, Qt::white);
+	QCOMPARE(outside, blank);
+	
+	// Separation buffers are reused, without content from previous frames.
+	QCOMPARE(render(clip), clipped);
+	QCOMPARE(render({}), full);
+	QCOMPARE(render({}), full);
+}
+
+
+
 void MapTest::hasAlpha()
 {
 	Map map;
@@ -48,6 +48,21 @@ private slots:
 	void importTest_data();
 	void importTest();
 	
+	/** Tests spatial object queries, including index updates. */
+	void findObjectsTest();
+	
+	/** Tests that drawing small areas via the spatial index draws like scanning all objects. */
+	void spatialIndexDrawTest();
+	
+	/** Tests that renderables snapshots draw like the map. */
+	void renderablesSnapshotTest();
+	
+	/** Tests that concurrently updated objects draw like sequentially updated objects. */
+	void updateAllObjectsConcurrentlyTest();
+	
+	/** Tests the concurrent overprinting simulation against QPainter composition, with and without clipping. */
+	void overprintingSimulationTest();
+	
 	/** Tests hasAlpha() functions. */
 	void hasAlpha();
 	
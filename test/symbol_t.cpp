@@ -17,6 +17,7 @@
  *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
 #include <initializer_list>
 #include <memory>
 
@@ -28,11 +29,15 @@
 #include <QDir>
 #include <QFile>  // IWYU pragma: keep
 #include <QFileInfo>
+#include <QFont>
 #include <QImage>
 #include <QLatin1String>
 #include <QObject>
 #include <QPainter>
+#include <QPainterPath>
 #include <QPoint>
+#include <QPointF>
+#include <QPolygonF>
 #include <QRect>
 #include <QRectF>
 #include <QRgb>
@@ -43,10 +48,16 @@
 #include "test_config.h"
 #include "core/map.h"
 #include "core/map_color.h"
+#include "core/map_coord.h"
+#include "core/objects/object.h"
 #include "core/renderables/renderable.h"
+#include "core/renderables/renderable_implementation.h"
+#include "core/renderables/text_path_cache.h"
+#include "core/symbols/area_symbol.h"
 #include "core/symbols/line_symbol.h"
 #include "core/symbols/point_symbol.h"
 #include "core/symbols/symbol.h"
+#include "core/symbols/text_symbol.h"
 
 using namespace OpenOrienteering;
 
@@ -382,6 +393,224 @@ private slots:
 		l.cleanupPointSymbols();
 		QVERIFY(clone->equals(&l));
 	}
+	
+	
+	void pointInstancingTest()
+	{
+		Map map;
+		auto* color = new MapColor(QStringLiteral("black"), 0);
+		map.addColor(color, 0);
+		
+		PointSymbol symbol;
+		symbol.setInnerColor(color);
+		symbol.setInnerRadius(500);
+		symbol.setOuterColor(color);
+		symbol.setOuterWidth(200);
+		
+		auto const position = MapCoordF(10, 20);
+		PointObject direct_object(&symbol);
+		ObjectRenderables direct(direct_object);
+		symbol.createRenderablesScaled(position, 0, direct);
+		
+		PointObject instanced_object(&symbol);
+		ObjectRenderables instanced(instanced_object);
+		{
+			PointSymbol::InstancingScope scope;
+			symbol.createInstancedRenderables(position, 0, instanced);
+			
+			// Same prototypes for another instance
+			PointObject other_object(&symbol);
+			ObjectRenderables other(other_object);
+			symbol.createInstancedRenderables(position + MapCoordF(1, 1), 0, other);
+			QCOMPARE(other.getExtent(), instanced.getExtent().translated(1, 1));
+			
+			// Only repeated rotations are instanced.
+			auto countInstances = [&symbol](qreal rotation) {
+				PointObject object(&symbol);
+				ObjectRenderables renderables(object);
+				symbol.createInstancedRenderables(MapCoordF(0, 0), rotation, renderables);
+				RenderableVector released;
+				if (!renderables.releaseRenderables(released))
+					return -1;
+				auto const count = std::count_if(begin(released), end(released), [](const Renderable* renderable) {
+					return dynamic_cast<const InstancedRenderable*>(renderable) != nullptr;
+				});
+				for (auto* renderable : released)
+					delete renderable;
+				return int(count);
+			};
+			QCOMPARE(countInstances(1.5), 0);
+			QCOMPARE(countInstances(1.25), 0);
+			QCOMPARE(countInstances(1.5), 2);
+			QCOMPARE(countInstances(1.5), 2);
+		}
+		QCOMPARE(instanced.getExtent(), direct.getExtent());
+		
+		auto render = [&map, position](const ObjectRenderables& renderables) {
+			QImage image(100, 100, QImage::Format_ARGB32_Premultiplied);
+			image.fill(Qt::white);
+			QPainter painter(&image);
+			painter.setRenderHint(QPainter::Antialiasing);
+			painter.translate(50, 50);
+			painter.scale(10, 10);
+			painter.translate(-position);
+			auto const config = RenderConfig { map, QRectF(position.x() - 5, position.y() - 5, 10, 10), 10, RenderConfig::NoOptions, 1.0 };
+			renderables.draw(0, Qt::black, &painter, config);
+			painter.end();
+			return image;
+		};
+		auto const expected = render(direct);
+		auto const actual = render(instanced);
+		QCOMPARE(actual.pixel(50, 50), qRgb(0, 0, 0));
+		for (int y = 0; y < expected.height(); ++y)
+		{
+			for (int x = 0; x < expected.width(); ++x)
+			{
+				// Allow for rounding differences in antialiasing
+				if (!fuzzyComparePixel(actual, x, y, x + 1, y + 1, expected.pixel(x, y)))
+					QCOMPARE(actual.pixel(x, y), expected.pixel(x, y));
+			}
+		}
+	}
+	
+	
+	void patternInstancingTest_data()
+	{
+		QTest::addColumn<qreal>("scale");
+		QTest::addColumn<QPointF>("center");
+		
+		QTest::newRow("full")    <<  5.0 << QPointF(10, 10);
+		QTest::newRow("partial") << 20.0 << QPointF(17, 4);
+	}
+	
+	void patternInstancingTest()
+	{
+		QFETCH(qreal, scale);
+		QFETCH(QPointF, center);
+		
+		// A rotated, clipped point pattern, with point symbol elements in two colors.
+		// The instanced pattern is compared with individual points which are
+		// not clipped by the area, but by the painter.
+		auto const coords = MapCoordVector { {0, 0}, {20, 2}, {18, 20}, {4, 16}, {0, 0} };
+		auto make_map = [&coords](AreaSymbol::FillPattern::Options clipping) {
+			auto map = std::make_unique<Map>();
+			auto* black = new MapColor(QStringLiteral("black"), 0);
+			map->addColor(black, 0);
+			auto* green = new MapColor(QStringLiteral("green"), 1);
+			green->setCmyk({0.8f, 0.0f, 1.0f, 0.0f});
+			green->setRgbFromCmyk();
+			map->addColor(green, 1);
+			
+			auto* point = new PointSymbol();
+			point->setInnerColor(black);
+			point->setInnerRadius(300);
+			point->setOuterColor(green);
+			point->setOuterWidth(200);
+			
+			auto* area = new AreaSymbol();
+			area->setNumFillPatterns(1);
+			auto& pattern = area->getFillPattern(0);
+			pattern.type = AreaSymbol::FillPattern::PointPattern;
+			pattern.angle = 0.3;
+			pattern.line_spacing = 2000;
+			pattern.line_offset = 300;
+			pattern.offset_along_line = 500;
+			pattern.point_distance = 1500;
+			pattern.point = point;
+			pattern.setRotatable(true);
+			pattern.setClipping(clipping);
+			map->addSymbol(area, 0);
+			
+			auto* object = new PathObject(area, coords);
+			object->closeAllParts();
+			object->setPatternRotation(0.5);
+			map->addObject(object);
+			return map;
+		};
+		
+		auto render = [&coords, scale, center](Map& map, bool clip) {
+			QImage image(200, 200, QImage::Format_ARGB32_Premultiplied);
+			image.fill(Qt::white);
+			QPainter painter(&image);
+			painter.translate(100, 100);
+			painter.scale(scale, scale);
+			painter.translate(-center);
+			if (clip)
+			{
+				QPolygonF polygon;
+				for (auto const& coord : coords)
+					polygon << QPointF(coord.x(), coord.y());
+				QPainterPath path;
+				path.addPolygon(polygon);
+				painter.setClipPath(path);
+			}
+			auto const visible = QRectF(center.x() - 100 / scale, center.y() - 100 / scale, 200 / scale, 200 / scale);
+			map.draw(&painter, RenderConfig { map, visible, scale, RenderConfig::NoOptions, 1.0 });
+			painter.end();
+			return image;
+		};
+		
+		auto instanced_map = make_map(AreaSymbol::FillPattern::Default);
+		auto reference_map = make_map(AreaSymbol::FillPattern::NoClippingIfPartiallyInside);
+		auto const actual = render(*instanced_map, false);
+		auto const expected = render(*reference_map, true);
+		
+		auto blank = QImage(actual.size(), actual.format());
+		blank.fill(Qt::white);
+		QVERIFY(expected != blank);
+		QCOMPARE(fuzzyDifference(actual, expected), QPoint(-1, -1));
+	}
+	
+	
+	void textPathCacheTest_data()
+	{
+		QTest::addColumn<QString>("text");
+		QTest::addColumn<bool>("underline");
+		
+		QTest::newRow("empty")      << QString() << false;
+		QTest::newRow("number")     << QStringLiteral("123") << false;
+		QTest::newRow("words")      << QStringLiteral("Ab cd.") << false;
+		QTest::newRow("underlined") << QStringLiteral("Ab cd.") << true;
+	}
+	
+	void textPathCacheTest()
+	{
+		QFETCH(QString, text);
+		QFETCH(bool, underline);
+		
+		// Cf. TextSymbol::updateQFont()
+		QFont font;
+		font.setUnderline(underline);
+		font.setPixelSize(int(TextSymbol::internal_point_size));
+		font.setHintingPreference(QFont::PreferNoHinting);
+		font.setStyleStrategy(QFont::ForceOutline);
+		
+		QPainterPath expected;
+		expected.setFillRule(Qt::WindingFill);
+		expected.addText(0, 0, font, text);
+		
+		TextPathCache::clear();
+		auto const path = TextPathCache::path(font, text);
+		QCOMPARE(path.fillRule(), Qt::WindingFill);
+		QCOMPARE(path.isEmpty(), expected.isEmpty());
+		if (underline)
+			QCOMPARE(path, expected);
+		
+		auto const expected_rect = expected.controlPointRect();
+		auto const rect = path.controlPointRect();
+		QVERIFY(qAbs(rect.left() - expected_rect.left()) < 0.5);
+		QVERIFY(qAbs(rect.top() - expected_rect.top()) < 0.5);
+		QVERIFY(qAbs(rect.right() - expected_rect.right()) < 0.5);
+		QVERIFY(qAbs(rect.bottom() - expected_rect.bottom()) < 0.5);
+		
+		// Cached
+		QCOMPARE(TextPathCache::path(font, text), path);
+		
+		// Different spacing
+		font.setLetterSpacing(QFont::AbsoluteSpacing, 10);
+		if (text.length() > 1)
+			QVERIFY(TextPathCache::path(font, text).controlPointRect().width() > rect.width());
+	}
 };
 
 
@@ -18,6 +18,7 @@
  */
 
 
+#include <atomic>
 #include <cmath>
 #include <iosfwd>
 #include <memory>
@@ -35,18 +36,24 @@
 #include <QFile>
 #include <QFileDevice>
 #include <QFileInfo>
+#include <QImage>
 #include <QImageWriter>
 #include <QIODevice>
 #include <QLineF>
 #include <QList>
 #include <QMetaObject>
 #include <QObject>
+#include <QPainter>
 #include <QPointF>
+#include <QRect>
 #include <QRectF>
+#include <QSemaphore>
 #include <QSignalSpy>  // IWYU pragma: keep
+#include <QSize>
 #include <QString>
 #include <QStringList>
 #include <QTemporaryDir>
+#include <QThread>
 #include <QTransform>
 
 #ifdef ACCEPT_USE_OF_DEPRECATED_PROJ_API_H
@@ -71,6 +78,7 @@
 #include "gdal/gdal_manager.h"
 #include "templates/template.h"
 #include "templates/template_image.h"
+#include "templates/template_image_tiles.h"
 #include "templates/template_table_model.h"
 #include "templates/template_track.h"
 #include "templates/world_file.h"
@@ -352,6 +360,105 @@ private slots:
 #endif  // Qt 5.9
 	}
 	
+	void templateImageTilesTest()
+	{
+		auto num_reads = 0;
+		auto read = [&num_reads](const QRect& source, const QSize& size) {
+			++num_reads;
+			auto tile = QImage(size, QImage::Format_RGB32);
+			tile.fill(source.x() == 0 ? Qt::red : Qt::blue);
+			return tile;
+		};
+		TemplateImageTiles tiles(QSize(1000, 600), read, 0);
+		QCOMPARE(tiles.size(), QSize(1000, 600));
+		QCOMPARE(tiles.levels(), 3);
+		QCOMPARE(tiles.levelForResolution(2.0), 0);
+		QCOMPARE(tiles.levelForResolution(1.0), 0);
+		QCOMPARE(tiles.levelForResolution(0.5), 1);
+		QCOMPARE(tiles.levelForResolution(0.3), 1);
+		QCOMPARE(tiles.levelForResolution(0.01), 2);
+		
+		QImage canvas(1000, 600, QImage::Format_RGB32);
+		canvas.fill(Qt::white);
+		QPainter painter(&canvas);
+		
+		// Only the visible tiles are read.
+		tiles.draw(&painter, QRectF(10, 10, 300, 200), 0);
+		QCOMPARE(num_reads, 2);
+		QCOMPARE(canvas.pixel(10, 10), QColor(Qt::red).rgb());
+		QCOMPARE(canvas.pixel(300, 10), QColor(Qt::blue).rgb());
+		QCOMPARE(canvas.pixel(600, 10), QColor(Qt::white).rgb());
+		
+		// Visible tiles are kept in the cache.
+		tiles.draw(&painter, QRectF(10, 10, 300, 200), 0);
+		QCOMPARE(num_reads, 2);
+		QCOMPARE(tiles.cacheSize(), std::size_t(2 * 256 * 256 * 4));
+		
+		// Other tiles replace the visible tiles when the cache is full.
+		tiles.draw(&painter, QRectF(0, 0, 1000, 600), 2);
+		QCOMPARE(num_reads, 3);
+		QCOMPARE(tiles.cacheSize(), std::size_t(250 * 150 * 4));
+		tiles.draw(&painter, QRectF(10, 10, 300, 200), 0);
+		QCOMPARE(num_reads, 5);
+		
+		tiles.clearCache();
+		QCOMPARE(tiles.cacheSize(), std::size_t(0));
+		
+		auto const reduced = tiles.readReduced(QSize(300, 300));
+		QCOMPARE(reduced.size(), QSize(250, 150));
+		QCOMPARE(num_reads, 6);
+	}
+	
+	void templateImageTilesConcurrencyTest()
+	{
+		QSemaphore decoding;
+		QSemaphore proceed;
+		std::atomic<bool> read_finished { false };
+		auto read = [&](const QRect& source, const QSize& size) {
+			if (source.x() > 0)
+			{
+				decoding.release();
+				proceed.tryAcquire(1, 5000);
+				read_finished = true;
+			}
+			auto tile = QImage(size, QImage::Format_RGB32);
+			tile.fill(Qt::green);
+			return tile;
+		};
+		TemplateImageTiles tiles(QSize(1000, 600), read);
+		
+		QImage canvas(1000, 600, QImage::Format_RGB32);
+		canvas.fill(Qt::white);
+		QPainter painter(&canvas);
+		tiles.draw(&painter, QRectF(10, 10, 100, 100), 0);
+		
+		struct Decoder : public QThread
+		{
+			TemplateImageTiles& tiles;
+			
+			explicit Decoder(TemplateImageTiles& tiles) : tiles(tiles) {}
+			
+			void run() override
+			{
+				QImage canvas(1000, 600, QImage::Format_RGB32);
+				QPainter painter(&canvas);
+				tiles.draw(&painter, QRectF(300, 10, 100, 100), 0);
+			}
+		} decoder(tiles);
+		decoder.start();
+		auto const decoding_started = decoding.tryAcquire(1, 5000);
+		
+		// Drawing cached tiles doesn't wait for the decoding thread.
+		tiles.draw(&painter, QRectF(10, 10, 100, 100), 0);
+		auto const drawn_while_decoding = !read_finished;
+		
+		proceed.release();
+		decoder.wait();
+		QVERIFY(decoding_started);
+		QVERIFY(drawn_while_decoding);
+		QCOMPARE(canvas.pixel(50, 50), QColor(Qt::green).rgb());
+	}
+	
 	void geoTiffTemplateTest()
 	{
 		Map map;
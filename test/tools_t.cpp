@@ -21,28 +21,37 @@
 
 #include "tools_t.h"
 
+#include <cstddef>
+#include <vector>
+
 #include <Qt>
 #include <QtGlobal>
 #include <QtTest>
 #include <QApplication>
 #include <QEvent>
+#include <QMetaObject>
 #include <QMouseEvent>
 #include <QPoint>
 #include <QPointF>
+#include <QRectF>
 #include <QString>
 
 #include "core/map.h"
 #include "core/map_color.h"
 #include "core/map_coord.h"
 #include "core/objects/object.h"
+#include "core/symbols/area_symbol.h"
 #include "core/symbols/line_symbol.h"
 #include "global.h"
+#include "settings.h"
 #include "gui/main_window.h"
 #include "gui/map/map_editor.h"
 #include "gui/map/map_widget.h"
+#include "gui/widgets/symbol_widget.h"
 #include "templates/paint_on_template_feature.h"
 #include "tools/edit_point_tool.h"
 #include "tools/edit_tool.h"
+#include "tools/fill_tool.h"
 
 using namespace OpenOrienteering;
 
@@ -205,6 +214,146 @@ void ToolsTest::editTool()
 	editor.editor->setTool(nullptr);
 }
 
+void ToolsTest::editToolMoveManyObjects()
+{
+	// Initialization
+	TestMap map;
+	TestMapEditor editor(map.map);
+	
+	// Enough objects for a transform-only preview while dragging
+	std::vector<PathObject*> objects;
+	for (int i = 0; i < 150; ++i)
+	{
+		auto* object = new PathObject(map.line_symbol);
+		object->addCoordinate(MapCoord(10 + 0.1 * i, 30));
+		object->addCoordinate(MapCoord(10 + 0.1 * i, 35));
+		map.map->addObject(object);
+		objects.push_back(object);
+	}
+	map.map->updateAllObjects();
+	
+	std::vector<MapCoordF> original_coords;
+	std::vector<QRectF> original_extents;
+	map.map->clearObjectSelection(false);
+	for (auto* object : objects)
+	{
+		original_coords.push_back(MapCoordF(object->getCoordinate(0)));
+		original_extents.push_back(object->getExtent());
+		map.map->addObjectToSelection(object, false);
+	}
+	map.map->emitSelectionChanged();
+	
+	EditTool* tool = new EditPointTool(editor.editor, nullptr);
+	editor.editor->setTool(tool);
+	
+	// Drag the selection at its frame
+	const MapWidget* map_widget = editor.map_widget;
+	QRectF selection_extent;
+	map.map->includeSelectionRect(selection_extent);
+	auto const drag_start_pos = map_widget->mapToViewport(selection_extent.topLeft()).toPoint();
+	auto const drag_end_pos = drag_start_pos + QPoint(40, 30);
+	QTest::mousePress(editor.map_widget, Qt::LeftButton, {}, drag_start_pos);
+	QMouseEvent event(QEvent::MouseMove, drag_end_pos, editor.map_widget->mapToGlobal(drag_end_pos), Qt::NoButton, Qt::LeftButton, Qt::NoModifier);
+	QApplication::sendEvent(editor.map_widget, &event);
+	// Run the asynchronous preview update now, instead of waiting for its timer.
+	QVERIFY(QMetaObject::invokeMethod(tool, "updatePreviewObjectsSlot", Qt::DirectConnection));
+	
+	// While dragging, the renderables are not regenerated,
+	// and the dirty rect is the transformed selection rect
+	// (plus the tool's frame margin).
+	auto const drag_offset = MapCoordF(objects.front()->getCoordinate(0)) - original_coords.front();
+	QVERIFY(drag_offset.length() > 0);
+	for (std::size_t i = 0; i < objects.size(); ++i)
+		QCOMPARE(objects[i]->getExtent(), original_extents[i]);
+	auto const dirty_rect = map_widget->drawingBoundingBox();
+	auto const moved_selection_extent = selection_extent.translated(drag_offset);
+	QVERIFY(dirty_rect.contains(moved_selection_extent));
+	QCOMPARE(dirty_rect.center(), moved_selection_extent.center());
+	QVERIFY(!dirty_rect.contains(selection_extent.topLeft()));
+	
+	QTest::mouseRelease(editor.map_widget, Qt::LeftButton, {}, drag_end_pos);
+	
+	// All objects are moved, and their renderables are regenerated.
+	for (std::size_t i = 0; i < objects.size(); ++i)
+	{
+		auto const* object = objects[i];
+		QPointF difference = map_widget->mapToViewport(object->getCoordinate(0))
+		                     - map_widget->mapToViewport(original_coords[i]) - QPointF(40, 30);
+		QCOMPARE(qMax(qAbs(difference.x()), 0.1), 0.1);
+		QCOMPARE(qMax(qAbs(difference.y()), 0.1), 0.1);
+		
+		auto const offset = MapCoordF(object->getCoordinate(0)) - original_coords[i];
+		QCOMPARE(object->getExtent(), original_extents[i].translated(offset));
+	}
+	
+	// Cleanup
+	editor.editor->setTool(nullptr);
+}
+
+void ToolsTest::fillToolVectorMode()
+{
+	// Initialization
+	TestMap map;
+	
+	auto* area_symbol = new AreaSymbol();
+	area_symbol->setColor(map.map->getColor(0));
+	map.map->addSymbol(area_symbol, 1);
+	
+	// A square of lines, with a gap which is closed by the fill tolerance,
+	// and a small closed line inside, which becomes a hole.
+	auto* square_left = new PathObject(map.line_symbol);
+	square_left->addCoordinate(MapCoord(0, -10));
+	square_left->addCoordinate(MapCoord(-10, -10));
+	square_left->addCoordinate(MapCoord(-10, 10));
+	square_left->addCoordinate(MapCoord(0, 10));
+	map.map->addObject(square_left);
+	auto* square_right = new PathObject(map.line_symbol);
+	square_right->addCoordinate(MapCoord(0.02, 10));
+	square_right->addCoordinate(MapCoord(10, 10));
+	square_right->addCoordinate(MapCoord(10, -10));
+	square_right->addCoordinate(MapCoord(0, -10));
+	map.map->addObject(square_right);
+	auto* island = new PathObject(map.line_symbol);
+	island->addCoordinate(MapCoord(4, 4));
+	island->addCoordinate(MapCoord(6, 4));
+	island->addCoordinate(MapCoord(6, 6));
+	island->addCoordinate(MapCoord(4, 6));
+	island->closeAllParts();
+	map.map->addObject(island);
+	map.map->updateAllObjects();
+	
+	TestMapEditor editor(map.map);
+	auto const vector_mode = Settings::getInstance().getSettingCached(Settings::FillTool_VectorMode);
+	Settings::getInstance().setSettingInCache(Settings::FillTool_VectorMode, true);
+	auto* symbol_widget = editor.editor->getSymbolWidget();
+	QVERIFY(symbol_widget);
+	symbol_widget->selectSingleSymbol(area_symbol);
+	QCOMPARE(editor.editor->activeSymbol(), area_symbol);
+	editor.editor->setTool(new FillTool(editor.editor, nullptr));
+	
+	// Click into the square
+	auto const num_objects = map.map->getNumObjects();
+	editor.simulateClick(editor.map_widget->mapToViewport(MapCoordF(-3, -2)));
+	QCOMPARE(map.map->getNumObjects(), num_objects + 1);
+	
+	// The fill object reaches the lines, and it has the island as a hole.
+	auto const* fill = map.map->getFirstSelectedObject();
+	QVERIFY(fill);
+	QCOMPARE(fill->getSymbol(), area_symbol);
+	auto const extent = fill->getExtent();
+	QCOMPARE(qRound(extent.left() * 100), -1000);
+	QCOMPARE(qRound(extent.top() * 100), -1000);
+	QCOMPARE(qRound(extent.right() * 100), 1000);
+	QCOMPARE(qRound(extent.bottom() * 100), 1000);
+	QCOMPARE(fill->asPath()->parts().size(), std::size_t(2));
+	QVERIFY(!fill->asPath()->isPointInsideArea(MapCoordF(5, 5)));
+	QVERIFY(fill->asPath()->isPointInsideArea(MapCoordF(-3, -2)));
+	
+	// Cleanup
+	editor.editor->setTool(nullptr);
+	Settings::getInstance().setSettingInCache(Settings::FillTool_VectorMode, vector_mode);
+}
+
 
 
 void ToolsTest::paintOnTemplateFeature()
@@ -35,6 +35,10 @@ private slots:
 	
 	void editTool();
 	
+	void editToolMoveManyObjects();
+	
+	void fillToolVectorMode();
+	
 	void paintOnTemplateFeature();
 };
 
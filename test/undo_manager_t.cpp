@@ -19,16 +19,34 @@
 
 #include "undo_manager_t.h"
 
+#include <memory>
+
 #include <QtTest>
+#include <QBuffer>
+#include <QIODevice>
+#include <QString>
+#include <QXmlStreamReader>
+#include <QXmlStreamWriter>
 
+#include "global.h"
+#include "core/map.h"
+#include "core/map_coord.h"
+#include "core/objects/object.h"
+#include "core/symbols/line_symbol.h"
+#include "core/symbols/symbol.h"
+#include "undo/object_undo.h"
 #include "undo/undo.h"
 #include "undo/undo_manager.h"
 
-namespace OpenOrienteering { class Map; }
-
 using namespace OpenOrienteering;
 
 
+void UndoManagerTest::initTestCase()
+{
+	doStaticInitializations();
+}
+
+
 // test
 void UndoManagerTest::testUndoRedo()
 {
@@ -207,6 +225,85 @@ void UndoManagerTest::testUndoRedo()
 	QVERIFY(!undo_manager.canRedo());
 }
 
+void UndoManagerTest::testObjectCoordinatesUndoStep_data()
+{
+	QTest::addColumn<int>("change");
+	
+	QTest::newRow("modified") << 0;
+	QTest::newRow("added")    << 1;
+	QTest::newRow("removed")  << 2;
+}
+
+void UndoManagerTest::testObjectCoordinatesUndoStep()
+{
+	QFETCH(int, change);
+	
+	Map map;
+	auto* symbol = new LineSymbol();
+	map.addSymbol(symbol, 0);
+	
+	MapCoordVector coords;
+	for (int i = 0; i < 100; ++i)
+		coords.emplace_back(0.5 * i, 0.5 * (i % 7));
+	auto* object = new PathObject(symbol, coords, &map);
+	map.addObject(object);
+	auto const original = std::unique_ptr<Object>(object->duplicate());
+	
+	switch (change)
+	{
+	case 0:
+		object->setCoordinate(3, MapCoord(1.5, 10.0));
+		object->setCoordinate(50, MapCoord(25.0, 10.0));
+		object->setCoordinate(53, MapCoord(26.5, 10.0));
+		break;
+	case 1:
+		object->addCoordinate(40, MapCoord(20.0, 10.0));
+		break;
+	case 2:
+		object->deleteCoordinate(40, false);
+		break;
+	}
+	auto const modified = object->getRawCoordinateVector();
+	QVERIFY(modified != original->getRawCoordinateVector());
+	
+	// Changes of other properties are not covered by this step.
+	{
+		auto const tagged = std::unique_ptr<Object>(original->duplicate());
+		tagged->setTag(QStringLiteral("name"), QStringLiteral("tagged"));
+		ObjectCoordinatesUndoStep step(&map);
+		QVERIFY(!step.addObject(0, *tagged));
+		QVERIFY(step.isEmpty());
+	}
+	
+	// Save and load
+	ObjectCoordinatesUndoStep step(&map);
+	QVERIFY(step.addObject(0, *original));
+	QBuffer buffer;
+	QVERIFY(buffer.open(QIODevice::ReadWrite));
+	{
+		QXmlStreamWriter writer(&buffer);
+		step.save(writer);
+	}
+	QVERIFY(buffer.seek(0));
+	QXmlStreamReader reader(&buffer);
+	QVERIFY(reader.readNextStartElement());
+	SymbolDictionary symbol_dict;
+	auto const loaded = std::unique_ptr<UndoStep>(UndoStep::load(reader, &map, symbol_dict));
+	QCOMPARE(loaded->getType(), UndoStep::ObjectCoordinatesUndoStepType);
+	
+	// Undo and redo
+	auto const redo_step = std::unique_ptr<UndoStep>(loaded->undo());
+	QVERIFY(object->getRawCoordinateVector() == original->getRawCoordinateVector());
+	QCOMPARE(object->parts().size(), original->asPath()->parts().size());
+	
+	auto const undo_step = std::unique_ptr<UndoStep>(redo_step->undo());
+	QVERIFY(object->getRawCoordinateVector() == modified);
+	
+	auto const redo_step_2 = std::unique_ptr<UndoStep>(undo_step->undo());
+	QVERIFY(object->getRawCoordinateVector() == original->getRawCoordinateVector());
+}
+
+
 void UndoManagerTest::resetAllChanged()
 {
 	loaded_changed   = false;
@@ -31,11 +31,19 @@ class UndoManagerTest : public QObject
 	Q_OBJECT
 	
 private slots:
+	void initTestCase();
+	
 	/**
 	 * Performs actions on an UndoManager and observes its behaviour.
 	 */
 	void testUndoRedo();
 	
+	/**
+	 * Tests undo, redo, saving and loading of coordinate changes.
+	 */
+	void testObjectCoordinatesUndoStep_data();
+	void testObjectCoordinatesUndoStep();
+	
 private:
 	bool clean_changed;
 	bool clean;
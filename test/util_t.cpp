@@ -18,12 +18,18 @@
  */
 
 
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+
 #include <QtTest>
 #include <QObject>
 #include <QPointF>
+#include <QRect>
 #include <QRectF>
 
 #include "core/map_coord.h"
+#include "util/dirty_region.h"
 #include "util/util.h"
 
 using namespace OpenOrienteering;
@@ -43,6 +49,7 @@ private slots:
 	void rectIncludeSafeTest();
 	void pointsFormCorner_data();
 	void pointsFormCorner();
+	void dirtyRegionTest();
 };
 
 
@@ -177,5 +184,53 @@ void UtilTest::pointsFormCorner()
 }
 
 
+void UtilTest::dirtyRegionTest()
+{
+	DirtyRegion region;
+	QVERIFY(region.isEmpty());
+	
+	region.add(QRect());
+	QVERIFY(region.isEmpty());
+	
+	// Nearby rects are merged.
+	region.add({ 0, 0, 10, 10 });
+	region.add({ 20, 0, 10, 10 });
+	QCOMPARE(region.rects().size(), std::size_t(1));
+	QCOMPARE(region.boundingRect(), QRect(0, 0, 30, 10));
+	
+	// Distant rects are kept separate.
+	region.add({ 1000, 1000, 10, 10 });
+	QCOMPARE(region.rects().size(), std::size_t(2));
+	QCOMPARE(region.boundingRect(), QRect(0, 0, 1010, 1010));
+	
+	// A rect which covers both rects absorbs them.
+	region.add({ 0, 0, 1010, 1010 });
+	QCOMPARE(region.rects().size(), std::size_t(1));
+	
+	// The number of rects is limited, and all added rects remain covered.
+	region.clear();
+	QVERIFY(region.isEmpty());
+	auto const added = { QRect(0, 0, 100, 100), QRect(1000, 0, 100, 100), QRect(2000, 0, 100, 100),
+	                     QRect(0, 1000, 100, 100), QRect(1000, 1000, 100, 100), QRect(2000, 1000, 100, 100),
+	                     QRect(0, 2000, 100, 100), QRect(1000, 2000, 100, 100), QRect(2000, 2000, 100, 100),
+	                     QRect(5000, 5000, 100, 100) };
+	for (auto const& rect : added)
+		region.add(rect);
+	QCOMPARE(region.rects().size(), std::size_t(DirtyRegion::max_rects));
+	for (auto const& rect : added)
+	{
+		auto const& rects = region.rects();
+		QVERIFY(std::any_of(begin(rects), end(rects), [&rect](auto const& r) { return r.contains(rect); }));
+	}
+	
+	// Intersection drops rects outside of the bounds.
+	region.intersect({ 0, 0, 1100, 1100 });
+	QCOMPARE(region.boundingRect(), QRect(0, 0, 1100, 1100));
+	region.intersect({ 3000, 3000, 100, 100 });
+	QVERIFY(region.isEmpty());
+}
+
+
+
 QTEST_APPLESS_MAIN(UtilTest)
 #include "util_t.moc"  // IWYU pragma: keep
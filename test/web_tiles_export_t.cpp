@@ -0,0 +1,223 @@
+/*
+ *    Copyright 2021 The OpenOrienteering developers
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <utility>
+
+#include <QtGlobal>
+#include <QtTest>
+#include <QObject>
+#include <QPointF>
+#include <QRectF>
+#include <QString>
+
+#include "global.h"
+#include "core/georeferencing.h"
+#include "core/latlon.h"
+#include "core/map.h"
+#include "core/map_coord.h"
+#include "core/map_printer.h"
+#include "gdal/web_tiles_export.h"
+
+using namespace OpenOrienteering;
+
+
+namespace {
+
+/**
+ * Provides access to the internals of WebTilesExport.
+ */
+class TestWebTilesExport : public WebTilesExport
+{
+public:
+	using WebTilesExport::WebTilesExport;
+	using WebTilesExport::makeTiles;
+	using WebTilesExport::tileAt;
+	using WebTilesExport::toLonLat;
+};
+
+using TileNumber = std::pair<int, int>;
+
+/// Georeferences the map near the Brandenburg Gate, Berlin, at 1:10000.
+void setupGeoreferencing(Map& map)
+{
+	Georeferencing georef;
+	georef.setScaleDenominator(10000);
+	georef.setProjectedCRS({}, QStringLiteral("+proj=utm +zone=33 +datum=WGS84 +no_defs"));
+	georef.setGeographicRefPoint({52.5163, 13.3777});
+	map.setGeoreferencing(georef);
+}
+
+/// Returns the longitude and latitude of the given map coordinates.
+QPointF toLonLat(const Map& map, const QPointF& map_coord)
+{
+	auto const latlon = map.getGeoreferencing().toGeographicCoords(MapCoordF(map_coord));
+	return { latlon.longitude(), latlon.latitude() };
+}
+
+}  // namespace
+
+Q_DECLARE_METATYPE(TileNumber)
+
+
+
+/**
+ * @test Tests the generation of XYZ web tiles.
+ */
+class WebTilesExportTest : public QObject
+{
+Q_OBJECT
+private slots:
+	void initTestCase()
+	{
+		Q_INIT_RESOURCE(resources);
+		doStaticInitializations();
+	}
+	
+	void tileAtTest_data()
+	{
+		QTest::addColumn<int>("zoom");
+		QTest::addColumn<QPointF>("lonlat");
+		QTest::addColumn<TileNumber>("tile");
+		
+		QTest::newRow("z0")          <<  0 << QPointF(13.3777, 52.5163) << TileNumber(0, 0);
+		QTest::newRow("z1 nw")       <<  1 << QPointF(-1.0, 1.0) << TileNumber(0, 0);
+		QTest::newRow("z1 se")       <<  1 << QPointF(1.0, -1.0) << TileNumber(1, 1);
+		QTest::newRow("z1 clamped")  <<  1 << QPointF(180.0, -90.0) << TileNumber(1, 1);
+		QTest::newRow("z10 Berlin")  << 10 << QPointF(13.3777, 52.5163) << TileNumber(550, 335);
+		QTest::newRow("z16 Berlin")  << 16 << QPointF(13.3777, 52.5163) << TileNumber(35203, 21493);
+		QTest::newRow("z12 Sydney")  << 12 << QPointF(151.2093, -33.8688) << TileNumber(3768, 2457);
+	}
+	
+	void tileAtTest()
+	{
+		QFETCH(int, zoom);
+		QFETCH(QPointF, lonlat);
+		QFETCH(TileNumber, tile);
+		QCOMPARE(TestWebTilesExport::tileAt(zoom, lonlat), tile);
+	}
+	
+	void toLonLatTest()
+	{
+		auto const max_latitude = 85.0511287798;
+		QCOMPARE(TestWebTilesExport::toLonLat(0, 0, 0), QPointF(-180, max_latitude));
+		QCOMPARE(TestWebTilesExport::toLonLat(0, 256, 256), QPointF(180, -max_latitude));
+		auto const origin = TestWebTilesExport::toLonLat(0, 128, 128);
+		QVERIFY(std::abs(origin.x()) < 1e-9);
+		QVERIFY(std::abs(origin.y()) < 1e-9);
+		
+		// The north-west corner of tile 10/550/335
+		auto const corner = TestWebTilesExport::toLonLat(10, 550 * 256, 335 * 256);
+		QCOMPARE(corner.x(), 13.359375);
+		QVERIFY(std::abs(corner.y() - 52.69636) < 0.00001);
+		
+		// The center of a tile is inside the tile.
+		auto const center = TestWebTilesExport::toLonLat(10, 550.5 * 256, 335.5 * 256);
+		QCOMPARE(TestWebTilesExport::tileAt(10, center), TileNumber(550, 335));
+	}
+	
+	void makeTilesTest()
+	{
+		Map map;
+		setupGeoreferencing(map);
+		QCOMPARE(map.getGeoreferencing().getState(), Georeferencing::Geospatial);
+		
+		auto const zoom = 17;
+		auto const extent = QRectF(-20, -20, 40, 40);  // 400 m x 400 m
+		TestWebTilesExport exporter(QStringLiteral("tiles"), map);
+		auto const tiles = exporter.makeTiles(extent, zoom);
+		QVERIFY(!tiles.empty());
+		
+		// The tiles at the corners of the extent are included,
+		// and all tiles are within the range of the corner tiles.
+		auto first = TileNumber(1 << zoom, 1 << zoom);
+		auto last = TileNumber(-1, -1);
+		for (auto const& corner : { extent.topLeft(), extent.topRight(), extent.bottomLeft(), extent.bottomRight() })
+		{
+			auto const corner_tile = TestWebTilesExport::tileAt(zoom, toLonLat(map, corner));
+			QVERIFY(std::any_of(begin(tiles), end(tiles), [corner_tile](auto const& tile) {
+				return tile.x == corner_tile.first && tile.y == corner_tile.second;
+			}));
+			first = { std::min(first.first, corner_tile.first), std::min(first.second, corner_tile.second) };
+			last = { std::max(last.first, corner_tile.first), std::max(last.second, corner_tile.second) };
+		}
+		QVERIFY(last != first);
+		for (auto const& tile : tiles)
+		{
+			QVERIFY(tile.x >= first.first && tile.x <= last.first);
+			QVERIFY(tile.y >= first.second && tile.y <= last.second);
+			QVERIFY(tile.rect_map.intersects(extent));
+		}
+		
+		// The map reference point is mapped to its pixel in the tile.
+		auto const ref_lonlat = QPointF(13.3777, 52.5163);
+		auto const ref_tile = TestWebTilesExport::tileAt(zoom, ref_lonlat);
+		auto const ref = std::find_if(begin(tiles), end(tiles), [ref_tile](auto const& tile) {
+			return tile.x == ref_tile.first && tile.y == ref_tile.second;
+		});
+		QVERIFY(ref != end(tiles));
+		auto const world_size = std::ldexp(256.0, zoom);
+		auto const latitude = qDegreesToRadians(ref_lonlat.y());
+		auto const expected = QPointF(
+		    (ref_lonlat.x() + 180) / 360 * world_size - ref->x * 256,
+		    (1 - std::asinh(std::tan(latitude)) / M_PI) / 2 * world_size - ref->y * 256 );
+		auto const actual = ref->transform.map(QPointF(0, 0));
+		QVERIFY2(std::abs(actual.x() - expected.x()) < 1, qPrintable(QString::number(actual.x() - expected.x())));
+		QVERIFY2(std::abs(actual.y() - expected.y()) < 1, qPrintable(QString::number(actual.y() - expected.y())));
+	}
+	
+	void suggestedZoomRangeTest()
+	{
+		Map map;
+		setupGeoreferencing(map);
+		
+		MapPrinter map_printer(map, nullptr);
+		map_printer.setResolution(254);  // 0.1 mm, i.e. 1 m at 1:10000
+		map_printer.setPrintArea(QRectF(-20, -20, 40, 40));
+		
+		// 40075016.686 m * cos(52.5163°) / 256 px / (1 m/px) = 2^16.54
+		auto const zoom_range = WebTilesExport::suggestedZoomRange(map, map_printer);
+		QCOMPARE(zoom_range.max_zoom, 17);
+		QVERIFY(zoom_range.min_zoom <= zoom_range.max_zoom);
+		
+		// The lowest zoom level covers the print area with a single tile.
+		auto const top_left = toLonLat(map, QPointF(-20, -20));
+		auto const bottom_right = toLonLat(map, QPointF(20, 20));
+		auto const min_zoom = zoom_range.min_zoom;
+		QCOMPARE(TestWebTilesExport::tileAt(min_zoom, top_left), TestWebTilesExport::tileAt(min_zoom, bottom_right));
+		QVERIFY(TestWebTilesExport::tileAt(min_zoom + 1, top_left) != TestWebTilesExport::tileAt(min_zoom + 1, bottom_right));
+	}
+	
+};
+
+
+
+/*
+ * We don't need a real GUI window.
+ */
+namespace  {
+	auto Q_DECL_UNUSED qpa_selected = qputenv("QT_QPA_PLATFORM", "minimal");  // clazy:exclude=non-pod-global-static
+}
+
+
+QTEST_MAIN(WebTilesExportTest)
+#include "web_tiles_export_t.moc"  // IWYU pragma: keep